@@ -0,0 +1,99 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include "../include/System/Threading/Barrier.hpp"
+
+using namespace System::Threading;
+
+// Measures barrier phase latency: N threads call signal_and_wait in a loop, and
+// the result is the wall time per completed phase, for N = 2, 4, 16 and 64.
+//
+// "mutex barrier" reproduces the previous Barrier (one mutex, a condition
+// variable and notify_all per phase); "Barrier flat" and "Barrier tree" are the
+// sense-reversing barrier in its two release modes.
+
+namespace {
+
+class MutexBarrier {
+public:
+    explicit MutexBarrier(int participants)
+        : participants_(participants), remaining_(participants) {}
+
+    void signal_and_wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        long long phase = phase_;
+        if (--remaining_ == 0) {
+            remaining_ = participants_;
+            ++phase_;
+            condition_.notify_all();
+            return;
+        }
+        condition_.wait(lock, [this, phase]() { return phase_ > phase; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    int participants_;
+    int remaining_;
+    long long phase_ = 0;
+};
+
+template<typename TBarrier>
+double run_phases(TBarrier& barrier, int participants, int phases) {
+    std::atomic<bool> start{false};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < participants; ++i) {
+        threads.emplace_back([&barrier, &start, phases]() {
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (int phase = 0; phase < phases; ++phase) {
+                barrier.signal_and_wait();
+            }
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - begin;
+    return elapsed.count() / phases;
+}
+
+void report(const char* name, int participants, double microseconds_per_phase) {
+    std::cout << std::left << std::setw(16) << name
+              << std::right << std::setw(4) << participants << " threads"
+              << std::setw(14) << std::fixed << std::setprecision(2)
+              << microseconds_per_phase << " us/phase" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int phases = argc > 1 ? std::atoi(argv[1]) : 2000;
+
+    std::cout << "Barrier phase latency benchmark (" << phases << " phases per run)" << std::endl;
+    std::cout << "==========================================================" << std::endl;
+
+    for (int participants : {2, 4, 16, 64}) {
+        MutexBarrier mutex_barrier(participants);
+        report("mutex barrier", participants, run_phases(mutex_barrier, participants, phases));
+
+        Barrier flat(participants, nullptr, BarrierMode::Flat);
+        report("Barrier flat", participants, run_phases(flat, participants, phases));
+
+        Barrier tree(participants, nullptr, BarrierMode::Tree);
+        report("Barrier tree", participants, run_phases(tree, participants, phases));
+    }
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include "../include/System/Threading/CancellationToken.hpp"
+
+using namespace System::Threading;
+
+// Measures what every layer of a request path pays for its token: copying
+// CancellationToken::none(), copying a real token, and registering a callback
+// and disposing it again. Then cancels a tree of 64 x 64 linked sources, linked
+// either with callbacks that cancel the child source, as callers had to chain
+// them by hand, or with create_linked_token_source.
+//
+// "shared_ptr token" reproduces the previous CancellationToken (three
+// shared_ptrs per token, a mutex-guarded vector of registrations);
+// "CancellationToken" is the intrusive one.
+
+namespace {
+
+class SharedPtrToken {
+public:
+    struct Registration {
+        std::function<void()> callback;
+    };
+
+    SharedPtrToken()
+        : canceled_(std::make_shared<std::atomic<bool>>(false))
+        , mutex_(std::make_shared<std::mutex>())
+        , callbacks_(std::make_shared<std::vector<std::shared_ptr<Registration>>>()) {}
+
+    static SharedPtrToken none() {
+        static SharedPtrToken never_canceled;
+        return never_canceled;
+    }
+
+    bool is_cancellation_requested() const {
+        return canceled_->load();
+    }
+
+    std::shared_ptr<Registration> register_callback(std::function<void()> callback) const {
+        auto registration = std::make_shared<Registration>(Registration{std::move(callback)});
+        std::lock_guard<std::mutex> lock(*mutex_);
+        callbacks_->push_back(registration);
+        return registration;
+    }
+
+    void unregister(const std::shared_ptr<Registration>& registration) const {
+        std::lock_guard<std::mutex> lock(*mutex_);
+        auto it = std::find(callbacks_->begin(), callbacks_->end(), registration);
+        if (it != callbacks_->end()) {
+            callbacks_->erase(it);
+        }
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> canceled_;
+    std::shared_ptr<std::mutex> mutex_;
+    std::shared_ptr<std::vector<std::shared_ptr<Registration>>> callbacks_;
+};
+
+// Passed by value through a chain of calls, as tokens are through request layers
+template<typename TToken>
+__attribute__((noinline)) bool pass_down(TToken token, int depth) {
+    if (depth == 0) {
+        return token.is_cancellation_requested();
+    }
+    return pass_down(token, depth - 1);
+}
+
+constexpr int Layers = 8;
+constexpr int Fanout = 64;
+constexpr int TreeRounds = 50;
+
+// Nanoseconds per source to cancel the whole tree from its root
+template<typename TLink>
+double cancel_tree(TLink&& link) {
+    double total = 0;
+    for (int round = 0; round < TreeRounds; ++round) {
+        CancellationTokenSource root;
+        std::vector<std::unique_ptr<CancellationTokenSource>> sources;
+        std::vector<CancellationTokenRegistration> registrations;
+        for (int i = 0; i < Fanout; ++i) {
+            sources.push_back(link(root, registrations));
+            CancellationTokenSource& child = *sources.back();
+            for (int j = 0; j < Fanout; ++j) {
+                sources.push_back(link(child, registrations));
+            }
+        }
+        auto begin = std::chrono::steady_clock::now();
+        root.cancel();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+        total += elapsed.count();
+    }
+    return total / (static_cast<double>(TreeRounds) * Fanout * (Fanout + 1));
+}
+
+template<typename TAction>
+double time_per_op(int iterations, TAction&& action) {
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        action();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+    return elapsed.count() / iterations;
+}
+
+void report(const char* name, const char* operation, double nanoseconds) {
+    std::cout << std::left << std::setw(20) << name
+              << std::setw(24) << operation
+              << std::right << std::setw(10) << std::fixed << std::setprecision(2)
+              << nanoseconds << " ns/op" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 2000000;
+
+    // libstdc++ drops to non-atomic shared_ptr counts until a second thread
+    // exists; a server always has one
+    std::thread([]() {}).join();
+
+    std::cout << "CancellationToken benchmark (" << iterations << " operations, "
+              << Layers << " layers per pass)" << std::endl;
+    std::cout << "==========================================================" << std::endl;
+
+    long sink = 0;
+
+    report("shared_ptr token", "pass none() down", time_per_op(iterations, [&]() {
+        sink += pass_down(SharedPtrToken::none(), Layers);
+    }));
+    report("CancellationToken", "pass none() down", time_per_op(iterations, [&]() {
+        sink += pass_down(CancellationToken::none(), Layers);
+    }));
+
+    SharedPtrToken shared_token;
+    report("shared_ptr token", "pass real token down", time_per_op(iterations, [&]() {
+        sink += pass_down(shared_token, Layers);
+    }));
+    CancellationTokenSource source;
+    CancellationToken token = source.get_token();
+    report("CancellationToken", "pass real token down", time_per_op(iterations, [&]() {
+        sink += pass_down(token, Layers);
+    }));
+
+    // A few long-lived registrations, as a shared shutdown token would carry
+    std::vector<std::shared_ptr<SharedPtrToken::Registration>> shared_kept;
+    std::vector<CancellationTokenRegistration> kept;
+    for (int i = 0; i < 64; ++i) {
+        shared_kept.push_back(shared_token.register_callback([]() {}));
+        kept.push_back(token.register_callback([]() {}));
+    }
+    report("shared_ptr token", "register + dispose", time_per_op(iterations, [&]() {
+        shared_token.unregister(shared_token.register_callback([&sink]() { ++sink; }));
+    }));
+    report("CancellationToken", "register + dispose", time_per_op(iterations, [&]() {
+        token.register_callback([&sink]() { ++sink; }).dispose();
+    }));
+
+    report("callback links", "cancel tree", cancel_tree([](CancellationTokenSource& parent,
+                                                          std::vector<CancellationTokenRegistration>& registrations) {
+        auto child = std::make_unique<CancellationTokenSource>();
+        CancellationTokenSource* target = child.get();
+        registrations.push_back(parent.get_token().register_callback([target]() { target->cancel(); }));
+        return child;
+    }));
+    report("linked sources", "cancel tree", cancel_tree([](CancellationTokenSource& parent,
+                                                          std::vector<CancellationTokenRegistration>&) {
+        return std::make_unique<CancellationTokenSource>(
+            CancellationTokenSource::create_linked_token_source(parent.get_token()));
+    }));
+
+    if (sink < 0) {
+        std::cout << sink << std::endl;
+    }
+    return 0;
+}
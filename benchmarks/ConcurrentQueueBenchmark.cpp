@@ -0,0 +1,108 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <queue>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include "../include/System/Collections/Concurrent/ConcurrentQueue.h"
+
+using namespace System::Collections::Concurrent;
+
+// Measures enqueue+dequeue throughput with N producer threads handing items to
+// N consumer threads, for N = 1, 4, 16 and 64.
+//
+// "mutex queue" reproduces the previous ConcurrentQueue (std::queue behind one
+// std::mutex); "ConcurrentQueue" is the lock-free segmented queue.
+
+namespace {
+
+class MutexQueue {
+public:
+    void Enqueue(long long item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push(item);
+    }
+
+    bool TryDequeue(long long& result) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty()) {
+            return false;
+        }
+        result = queue_.front();
+        queue_.pop();
+        return true;
+    }
+
+private:
+    std::queue<long long> queue_;
+    std::mutex mutex_;
+};
+
+template<typename TQueue>
+double run_pairs(int pairs, int items_per_producer) {
+    TQueue queue;
+    std::atomic<long long> remaining{static_cast<long long>(pairs) * items_per_producer};
+    std::atomic<bool> start{false};
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < pairs; ++p) {
+        threads.emplace_back([&queue, &start, items_per_producer]() {
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (int i = 0; i < items_per_producer; ++i) {
+                queue.Enqueue(i);
+            }
+        });
+        threads.emplace_back([&queue, &start, &remaining]() {
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            long long item;
+            while (remaining.load(std::memory_order_relaxed) > 0) {
+                if (queue.TryDequeue(item)) {
+                    remaining.fetch_sub(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+    // One operation = one enqueue plus its dequeue
+    return static_cast<double>(pairs) * items_per_producer / elapsed.count();
+}
+
+void report(const char* name, int pairs, double ops_per_second) {
+    std::cout << std::left << std::setw(18) << name
+              << std::right << std::setw(4) << pairs << " pairs"
+              << std::setw(16) << std::fixed << std::setprecision(0)
+              << ops_per_second << " ops/s" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int total_items = argc > 1 ? std::atoi(argv[1]) : 4000000;
+
+    std::cout << "ConcurrentQueue throughput benchmark (" << total_items << " items per run)" << std::endl;
+    std::cout << "==========================================================" << std::endl;
+
+    for (int pairs : {1, 4, 16, 64}) {
+        int items_per_producer = total_items / pairs;
+        report("mutex queue", pairs, run_pairs<MutexQueue>(pairs, items_per_producer));
+        report("ConcurrentQueue", pairs, run_pairs<ConcurrentQueue<long long>>(pairs, items_per_producer));
+    }
+
+    return 0;
+}
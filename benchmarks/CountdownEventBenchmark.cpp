@@ -0,0 +1,96 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include "../include/System/Threading/CountdownEvent.hpp"
+
+using namespace System::Threading;
+
+// Measures fan-in: W worker threads each signal their share of N work items
+// into one countdown while the main thread waits for it, for W = 1, 2, 4 and 8.
+// The result is the wall time per signal.
+//
+// "mutex countdown" reproduces the previous CountdownEvent (mutex_ taken on
+// every signal, condition variable wait); "CountdownEvent" is the atomic one.
+
+namespace {
+
+class MutexCountdown {
+public:
+    explicit MutexCountdown(int count) : count_(count) {}
+
+    bool signal() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (count_ <= 0) {
+            return false;
+        }
+        if (--count_ == 0) {
+            condition_.notify_all();
+        }
+        return true;
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() { return count_ == 0; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    int count_;
+};
+
+template<typename TCountdown>
+double run_fan_in(int items, int workers_count) {
+    TCountdown countdown(items);
+    std::atomic<bool> start{false};
+    std::vector<std::thread> workers;
+    for (int w = 0; w < workers_count; ++w) {
+        workers.emplace_back([&countdown, &start, items, workers_count, w]() {
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (int i = w; i < items; i += workers_count) {
+                countdown.signal();
+            }
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    countdown.wait();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return elapsed.count() / items;
+}
+
+void report(const char* name, int workers_count, double nanoseconds_per_signal) {
+    std::cout << std::left << std::setw(18) << name
+              << std::right << std::setw(4) << workers_count << " workers"
+              << std::setw(14) << std::fixed << std::setprecision(2)
+              << nanoseconds_per_signal << " ns/signal" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int items = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+    std::cout << "CountdownEvent fan-in benchmark (" << items << " items per run)" << std::endl;
+    std::cout << "==========================================================" << std::endl;
+
+    for (int workers_count : {1, 2, 4, 8}) {
+        report("mutex countdown", workers_count, run_fan_in<MutexCountdown>(items, workers_count));
+        report("CountdownEvent", workers_count, run_fan_in<CountdownEvent>(items, workers_count));
+    }
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <atomic>
+#include "../include/System/Threading/Tasks/Parallel.h"
+
+using namespace System::Threading::Tasks;
+
+// Measures a tight numeric loop (out[i] = sqrt(in[i]) * 0.5 + 1) over N elements:
+// a plain sequential loop, Parallel::For with the body passed as a
+// std::function (the previous, type-erased signature) and with a lambda (the
+// templated overload), at MaxDegreeOfParallelism 1, 2, 4 and 8. Speedup is
+// against the sequential loop.
+//
+// The aggregation half sums the same array into one total: through a shared
+// std::atomic from a plain Parallel::For body, and through TransformReduce, whose
+// per-worker accumulators are only combined at the end.
+
+namespace {
+
+template<typename TRun>
+double time_ms(TRun&& run, int repetitions) {
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; ++r) {
+        run();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+    return elapsed.count() / repetitions;
+}
+
+void report(const char* name, int degree, double milliseconds, double sequential_ms) {
+    std::cout << std::left << std::setw(24) << name
+              << std::right << std::setw(3) << degree << " workers"
+              << std::setw(12) << std::fixed << std::setprecision(2) << milliseconds << " ms"
+              << std::setw(10) << std::setprecision(2) << sequential_ms / milliseconds << "x" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? std::atoi(argv[1]) : 20000000;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::vector<double> in(static_cast<std::size_t>(count));
+    std::vector<double> out(static_cast<std::size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        in[i] = static_cast<double>(i);
+    }
+
+    std::cout << "Parallel::For benchmark (" << count << " elements, " << repetitions << " repetitions)" << std::endl;
+    std::cout << "==========================================================" << std::endl;
+
+    double sequential_ms = time_ms([&]() {
+        for (int i = 0; i < count; ++i) {
+            out[i] = std::sqrt(in[i]) * 0.5 + 1.0;
+        }
+    }, repetitions);
+    report("sequential", 1, sequential_ms, sequential_ms);
+
+    for (int degree : {1, 2, 4, 8}) {
+        ParallelOptions options;
+        options.SetMaxDegreeOfParallelism(degree);
+
+        std::function<void(int)> erased = [&](int i) {
+            out[i] = std::sqrt(in[i]) * 0.5 + 1.0;
+        };
+        report("For std::function body", degree, time_ms([&]() {
+            Parallel::For(0, count, options, erased);
+        }, repetitions), sequential_ms);
+
+        report("For lambda body", degree, time_ms([&]() {
+            Parallel::For(0, count, options, [&](int i) {
+                out[i] = std::sqrt(in[i]) * 0.5 + 1.0;
+            });
+        }, repetitions), sequential_ms);
+    }
+
+    std::cout << std::endl;
+    double sequential_sum_ms = time_ms([&]() {
+        double total = 0;
+        for (int i = 0; i < count; ++i) {
+            total += in[i];
+        }
+        out[0] = total;
+    }, repetitions);
+    report("sequential sum", 1, sequential_sum_ms, sequential_sum_ms);
+
+    for (int degree : {1, 2, 4, 8}) {
+        ParallelOptions options;
+        options.SetMaxDegreeOfParallelism(degree);
+
+        report("shared atomic sum", degree, time_ms([&]() {
+            std::atomic<long long> total{0};
+            Parallel::For(0, count, options, [&](int i) {
+                total.fetch_add(static_cast<long long>(in[i]), std::memory_order_relaxed);
+            });
+            out[0] = static_cast<double>(total.load());
+        }, repetitions), sequential_sum_ms);
+
+        report("TransformReduce sum", degree, time_ms([&]() {
+            out[0] = Parallel::TransformReduce(0, count, options, 0.0, std::plus<>(), [&](long i) {
+                return in[i];
+            });
+        }, repetitions), sequential_sum_ms);
+    }
+
+    return 0;
+}
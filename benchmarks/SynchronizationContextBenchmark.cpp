@@ -0,0 +1,143 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include "../include/System/Threading/SingleThreadSynchronizationContext.h"
+
+using namespace System::Threading;
+
+// Measures posting to a context that runs everything on one thread: a callback
+// that posts the next one, as a chain of coroutine continuations resumed on their
+// owner does, and 1 and 4 producer threads posting while the owner drains.
+//
+// "mutex queue" is the usual event loop: a mutex-guarded deque, a condition
+// variable notified on every post, and one callback taken per lock.
+// "single thread" is SingleThreadSynchronizationContext.
+
+namespace {
+
+class MutexQueueContext : public SynchronizationContext {
+public:
+    void Post(std::function<void(void*)> callback, void* state) override {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.emplace_back(std::move(callback), state);
+        }
+        m_available.notify_one();
+    }
+
+    void Complete() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_completed = true;
+        }
+        m_available.notify_one();
+    }
+
+    void Run() {
+        for (;;) {
+            std::pair<std::function<void(void*)>, void*> item;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_available.wait(lock, [this]() { return m_completed || !m_queue.empty(); });
+                if (m_queue.empty()) {
+                    return;
+                }
+                item = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+            item.first(item.second);
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_available;
+    std::deque<std::pair<std::function<void(void*)>, void*>> m_queue;
+    bool m_completed{false};
+};
+
+template<typename TContext>
+void post_chain(TContext& context, int remaining) {
+    context.Post([&context, remaining](void*) {
+        if (remaining > 1) {
+            post_chain(context, remaining - 1);
+        } else {
+            context.Complete();
+        }
+    }, nullptr);
+}
+
+// Nanoseconds per callback for a chain where each callback posts the next
+template<typename TContext>
+double chain(std::shared_ptr<TContext> context, int iterations) {
+    auto begin = std::chrono::steady_clock::now();
+    post_chain(*context, iterations);
+    context->Run();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+    return elapsed.count() / iterations;
+}
+
+// Nanoseconds per callback with producers posting from their own threads
+template<typename TContext>
+double producers(std::shared_ptr<TContext> context, int producer_count, int iterations) {
+    int per_producer = iterations / producer_count;
+    long ran = 0;
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producer_count; ++p) {
+        threads.emplace_back([context, per_producer, &ran]() {
+            for (int i = 0; i < per_producer; ++i) {
+                context->Post([&ran](void*) { ++ran; }, nullptr);
+            }
+        });
+    }
+    std::thread completer([&threads, context]() {
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        context->Complete();
+    });
+    context->Run();
+    completer.join();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+    return elapsed.count() / ran;
+}
+
+void report(const char* name, const char* operation, double nanoseconds) {
+    std::cout << std::left << std::setw(16) << name
+              << std::setw(16) << operation
+              << std::right << std::setw(10) << std::fixed << std::setprecision(2)
+              << nanoseconds << " ns/op" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 2000000;
+
+    std::cout << "SynchronizationContext benchmark (" << iterations << " callbacks, "
+              << std::thread::hardware_concurrency() << " hardware threads)" << std::endl;
+    std::cout << "==========================================================" << std::endl;
+
+    report("mutex queue", "chain", chain(std::make_shared<MutexQueueContext>(), iterations));
+    report("single thread", "chain", chain(std::make_shared<SingleThreadSynchronizationContext>(), iterations));
+
+    for (int producer_count : {1, 4}) {
+        const char* operation = producer_count == 1 ? "1 producer" : "4 producers";
+        report("mutex queue", operation,
+               producers(std::make_shared<MutexQueueContext>(), producer_count, iterations));
+        report("single thread", operation,
+               producers(std::make_shared<SingleThreadSynchronizationContext>(), producer_count, iterations));
+    }
+
+    return 0;
+}
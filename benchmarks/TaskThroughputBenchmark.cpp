@@ -0,0 +1,83 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <future>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include "../include/System/Threading/Task.hpp"
+
+using namespace System::Threading;
+
+// Measures how many small tasks per second can be started and awaited.
+//
+// "detached threads" reproduces the previous Task::run strategy (one
+// std::thread(...).detach() per task); "Task::run" goes through the default
+// ThreadPool-backed TaskScheduler.
+
+namespace {
+
+std::atomic<long long> g_sink{0};
+
+void small_work(int i) {
+    g_sink.fetch_add(i, std::memory_order_relaxed);
+}
+
+double run_detached_threads(int task_count) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::shared_future<void>> futures;
+    futures.reserve(task_count);
+    for (int i = 0; i < task_count; ++i) {
+        auto promise = std::make_shared<std::promise<void>>();
+        futures.push_back(promise->get_future().share());
+        std::thread([promise, i]() {
+            small_work(i);
+            promise->set_value();
+        }).detach();
+    }
+    for (auto& future : futures) {
+        future.wait();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return task_count / elapsed.count();
+}
+
+double run_scheduled_tasks(int task_count) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<Task> tasks;
+    tasks.reserve(task_count);
+    for (int i = 0; i < task_count; ++i) {
+        tasks.push_back(Task::run([i]() { small_work(i); }));
+    }
+    Task::wait_all(tasks);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return task_count / elapsed.count();
+}
+
+void report(const char* name, double tasks_per_second) {
+    std::cout << std::left << std::setw(20) << name
+              << std::right << std::setw(14) << std::fixed << std::setprecision(0)
+              << tasks_per_second << " tasks/s" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int task_count = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+    std::cout << "Task throughput benchmark (" << task_count << " tasks)" << std::endl;
+    std::cout << "==========================================" << std::endl;
+
+    // Warm up the pool so thread creation is not part of the measurement
+    run_scheduled_tasks(1000);
+
+    report("detached threads", run_detached_threads(task_count));
+    report("Task::run", run_scheduled_tasks(task_count));
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <memory>
+#include <unordered_map>
+#include <chrono>
+#include <cstdlib>
+#include "../include/System/Threading/ThreadLocal.hpp"
+
+using namespace System::Threading;
+
+// Measures ThreadLocal<T>::get on a value that already exists, from 1, 4 and 16
+// threads, each reading eight instances in turn.
+//
+// "map ThreadLocal" reproduces the previous ThreadLocal (a thread_local
+// unordered_map from instance address to shared_ptr<T>); "ThreadLocal" is the
+// slot-indexed one.
+
+namespace {
+
+template<typename T>
+class MapThreadLocal {
+public:
+    T& get() {
+        auto it = storage.find(this);
+        if (it != storage.end() && it->second) {
+            return *it->second;
+        }
+        storage[this] = std::make_shared<T>();
+        return *storage[this];
+    }
+
+private:
+    static thread_local std::unordered_map<void*, std::shared_ptr<T>> storage;
+};
+
+template<typename T>
+thread_local std::unordered_map<void*, std::shared_ptr<T>> MapThreadLocal<T>::storage;
+
+constexpr int Instances = 8;
+
+template<typename TLocal>
+double run_gets(std::vector<TLocal>& locals, int threads_count, int iterations) {
+    std::vector<std::thread> threads;
+    auto begin = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads_count; ++t) {
+        threads.emplace_back([&locals, iterations]() {
+            for (auto& local : locals) {
+                local.get() = 0;
+            }
+            for (int i = 0; i < iterations; ++i) {
+                ++locals[i % Instances].get();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+    return elapsed.count() / (static_cast<double>(iterations) * threads_count);
+}
+
+void report(const char* name, int threads_count, double nanoseconds_per_get) {
+    std::cout << std::left << std::setw(16) << name
+              << std::right << std::setw(4) << threads_count << " threads"
+              << std::setw(12) << std::fixed << std::setprecision(2)
+              << nanoseconds_per_get << " ns/get" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20000000;
+
+    std::cout << "ThreadLocal get benchmark (" << iterations << " gets per thread)" << std::endl;
+    std::cout << "==========================================================" << std::endl;
+
+    for (int threads_count : {1, 4, 16}) {
+        std::vector<MapThreadLocal<long>> map_locals(Instances);
+        report("map ThreadLocal", threads_count, run_gets(map_locals, threads_count, iterations));
+
+        std::vector<ThreadLocal<long>> slot_locals(Instances);
+        report("ThreadLocal", threads_count, run_gets(slot_locals, threads_count, iterations));
+    }
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include "../include/System/Threading/ThreadPool.h"
+#include "../include/System/Threading/CpuTopology.h"
+
+using namespace System::Threading;
+
+// Measures memory bandwidth when pool workers sum buffers that live on one NUMA
+// node. Each node's buffer is first touched by work items queued to that node,
+// so the kernel places its pages there. The buffers are then summed three ways:
+//
+// "node-local"   items queued to the buffer's node (the default Node affinity)
+// "cross-node"   items queued to the next node, so every read crosses sockets
+// "unplaced"     WorkerAffinity::None and QueueUserWorkItem, as the pool ran before
+//                it knew about nodes: workers land wherever the scheduler puts them
+//
+// On a single-node machine the three runs read local memory and should match.
+
+namespace {
+
+using Buffer = std::unique_ptr<std::uint64_t[]>;
+
+constexpr int ChunksPerCpu = 4;
+
+// Runs chunks items, each given its index, and waits for all of them; node -1
+// queues them anywhere
+void run_chunks(int node, int chunks, const std::function<void(int)>& chunk) {
+    std::atomic<int> remaining{chunks};
+    for (int c = 0; c < chunks; ++c) {
+        auto item = [&chunk, &remaining, c](System::Object*) {
+            chunk(c);
+            if (remaining.fetch_sub(1) == 1) {
+                remaining.notify_all();
+            }
+        };
+        if (node >= 0) {
+            ThreadPool::QueueUserWorkItemOnNode(item, nullptr, node);
+        } else {
+            ThreadPool::QueueUserWorkItem(item);
+        }
+    }
+    for (int left = remaining.load(); left != 0; left = remaining.load()) {
+        remaining.wait(left);
+    }
+}
+
+std::uint64_t sum(const std::uint64_t* begin, const std::uint64_t* end) {
+    std::uint64_t a = 0, b = 0, c = 0, d = 0;
+    for (; begin + 4 <= end; begin += 4) {
+        a += begin[0];
+        b += begin[1];
+        c += begin[2];
+        d += begin[3];
+    }
+    for (; begin < end; ++begin) {
+        a += *begin;
+    }
+    return a + b + c + d;
+}
+
+// GB/s reading every buffer passes times; target(owner) picks the node that reads
+// the buffer first touched on owner
+double bandwidth(std::vector<Buffer>& buffers, std::size_t words, int passes,
+                 const std::function<int(int)>& target, std::atomic<std::uint64_t>& sink) {
+    const CpuTopology& topology = CpuTopology::GetCurrent();
+    auto begin = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (int owner = 0; owner < static_cast<int>(buffers.size()); ++owner) {
+            int node = target(owner);
+            int chunks = ChunksPerCpu * static_cast<int>(topology.GetNode(node < 0 ? owner : node).cpus.size());
+            std::size_t chunk_words = (words + static_cast<std::size_t>(chunks) - 1) / static_cast<std::size_t>(chunks);
+            const std::uint64_t* data = buffers[static_cast<std::size_t>(owner)].get();
+            run_chunks(node, chunks, [&, data](int c) {
+                std::size_t from = std::min(words, static_cast<std::size_t>(c) * chunk_words);
+                std::size_t to = std::min(words, from + chunk_words);
+                sink.fetch_add(sum(data + from, data + to), std::memory_order_relaxed);
+            });
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    double bytes = static_cast<double>(words) * sizeof(std::uint64_t) * static_cast<double>(buffers.size()) * passes;
+    return bytes / elapsed.count() / 1e9;
+}
+
+void report(const char* name, double gigabytes_per_second) {
+    std::cout << std::left << std::setw(16) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(2)
+              << gigabytes_per_second << " GB/s" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int megabytes = argc > 1 ? std::atoi(argv[1]) : 256;
+    int passes = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    const CpuTopology& topology = CpuTopology::GetCurrent();
+    int nodes = ThreadPool::GetNodeCount();
+    std::size_t words = static_cast<std::size_t>(megabytes) * 1024 * 1024 / sizeof(std::uint64_t);
+
+    std::cout << "ThreadPool placement benchmark (" << nodes << " nodes, "
+              << topology.GetProcessorCount() << " CPUs, " << megabytes << " MB per node, "
+              << passes << " passes)" << std::endl;
+    std::cout << "==========================================================" << std::endl;
+
+    // First touch on the owning node places the pages there
+    std::vector<Buffer> buffers;
+    for (int node = 0; node < nodes; ++node) {
+        buffers.emplace_back(new std::uint64_t[words]);
+        std::uint64_t* data = buffers.back().get();
+        int chunks = ChunksPerCpu * static_cast<int>(topology.GetNode(node).cpus.size());
+        std::size_t chunk_words = (words + static_cast<std::size_t>(chunks) - 1) / static_cast<std::size_t>(chunks);
+        run_chunks(node, chunks, [&, data](int c) {
+            std::size_t from = std::min(words, static_cast<std::size_t>(c) * chunk_words);
+            std::size_t to = std::min(words, from + chunk_words);
+            for (std::size_t i = from; i < to; ++i) {
+                data[i] = i;
+            }
+        });
+    }
+
+    std::atomic<std::uint64_t> sink{0};
+    // An unreported run first: the first one measured trails the rest even on one node
+    bandwidth(buffers, words, passes, [](int owner) { return owner; }, sink);
+    report("node-local", bandwidth(buffers, words, passes, [](int owner) { return owner; }, sink));
+    report("cross-node", bandwidth(buffers, words, passes, [nodes](int owner) { return (owner + 1) % nodes; }, sink));
+    ThreadPool::SetWorkerAffinity(ThreadPool::WorkerAffinity::None);
+    report("unplaced", bandwidth(buffers, words, passes, [](int) { return -1; }, sink));
+    ThreadPool::SetWorkerAffinity(ThreadPool::WorkerAffinity::Node);
+
+    if (sink.load() == 0) {
+        std::cout << std::endl;
+    }
+    return 0;
+}
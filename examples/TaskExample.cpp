@@ -36,7 +36,7 @@ int main() {
     
     // Example 3: Task continuation
     std::cout << "\n3. Task Continuation:" << std::endl;
-    auto continuation_task = fibonacci_task.continue_with<std::string>([](Task<int>& antecedent) {
+    auto continuation_task = fibonacci_task.continue_with<std::string>([](TaskOf<int>& antecedent) {
         int fib_result = antecedent.get_result();
         return "The result was: " + std::to_string(fib_result);
     });
@@ -46,7 +46,7 @@ int main() {
     
     // Example 4: Multiple tasks
     std::cout << "\n4. Multiple Tasks:" << std::endl;
-    std::vector<Task<int>> tasks;
+    std::vector<TaskOf<int>> tasks;
     
     for (int i = 5; i <= 8; ++i) {
         tasks.push_back(Task::run<int>([i]() {
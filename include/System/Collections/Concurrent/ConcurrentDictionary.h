@@ -1,48 +1,637 @@
-
 #pragma once
 
 #include "System/Object.h"
+#include "System/Threading/EpochReclaimer.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
 #include <unordered_map>
-#include <shared_mutex>
+#include <utility>
 #include <vector>
-#include <functional>
 
 namespace System::Collections::Concurrent
 {
+    // Concurrent hash table with lock-free reads and striped write locks.
+    //
+    // Buckets are singly linked chains of immutable nodes; an update replaces the
+    // node rather than writing to it. Readers walk the chains under an EpochReclaimer
+    // guard without taking any lock or writing shared memory, and removed nodes are
+    // retired rather than freed. Writers lock one stripe, chosen by the low bits of the
+    // key's hash, so every table size maps a key to the same stripe.
+    //
+    // Growing allocates a table twice the size and migrates it a chunk of buckets at a
+    // time, each writer helping with the next chunk. A migrated bucket holds a
+    // forwarding marker that sends readers and writers on to the new table, so
+    // neither ever waits for the whole table to move. Value factories passed to
+    // GetOrAdd and AddOrUpdate run outside every lock and outside the reclamation
+    // guard, so a slow factory holds up neither writers nor reclamation, and may run
+    // more than once under contention, as in .NET.
     template<typename K, typename V>
     class ConcurrentDictionary : public System::Object
     {
     private:
-        std::unordered_map<K, V> dictionary;
-        mutable std::shared_mutex rwMutex;
+        static constexpr std::size_t CacheLineSize = 64;
+        static constexpr std::size_t MinimumBucketCount = 32;
+        static constexpr std::size_t MigrationChunk = 16;
+        // Average chain length that triggers growth
+        static constexpr std::size_t MaxLoadFactor = 2;
+
+        struct Node
+        {
+            const K key;
+            const V value;
+            const std::size_t hash;
+            std::atomic<Node*> next;
+
+            Node(const K& key, const V& value, std::size_t hash, Node* next)
+                : key(key), value(value), hash(hash), next(next) {}
+        };
+
+        struct Table
+        {
+            const std::size_t mask;
+            std::unique_ptr<std::atomic<Node*>[]> buckets;
+            std::atomic<Table*> next{nullptr};
+            std::atomic<std::size_t> migrationCursor{0};
+            std::atomic<std::size_t> migratedBuckets{0};
+
+            explicit Table(std::size_t size)
+                : mask(size - 1), buckets(new std::atomic<Node*>[size])
+            {
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    buckets[i].store(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+            ~Table()
+            {
+                for (std::size_t i = 0; i <= mask; ++i)
+                {
+                    Node* node = buckets[i].load(std::memory_order_relaxed);
+                    if (node == Moved())
+                    {
+                        continue;
+                    }
+                    while (node)
+                    {
+                        Node* next = node->next.load(std::memory_order_relaxed);
+                        delete node;
+                        node = next;
+                    }
+                }
+            }
+
+            std::size_t GetSize() const { return mask + 1; }
+        };
+
+        struct alignas(CacheLineSize) Stripe
+        {
+            std::mutex lock;
+            // Written under lock, read without it by GetCount
+            std::atomic<std::size_t> count{0};
+        };
+
+        std::atomic<Table*> root;
+        std::size_t lockMask;
+        std::unique_ptr<Stripe[]> stripes;
+
+        // Marks a migrated bucket; never dereferenced
+        static Node* Moved()
+        {
+            alignas(Node) static const unsigned char marker[1] = {};
+            return reinterpret_cast<Node*>(const_cast<unsigned char*>(marker));
+        }
+
+        static std::size_t RoundUpToPowerOfTwo(std::size_t value)
+        {
+            std::size_t result = 1;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        // std::hash is often the identity; mix so the low bits used for buckets and stripes vary
+        static std::size_t Hash(const K& key)
+        {
+            std::uint64_t hash = static_cast<std::uint64_t>(std::hash<K>{}(key));
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53ULL;
+            hash ^= hash >> 33;
+            return static_cast<std::size_t>(hash);
+        }
 
     public:
-        ConcurrentDictionary() = default;
-        ConcurrentDictionary(const std::unordered_map<K, V>& dictionary);
+        ConcurrentDictionary()
+            : ConcurrentDictionary(static_cast<int>(std::thread::hardware_concurrency()) * 4, static_cast<int>(MinimumBucketCount))
+        {
+        }
+
+        ConcurrentDictionary(int concurrencyLevel, int capacity)
+        {
+            if (concurrencyLevel < 1)
+            {
+                concurrencyLevel = 1;
+            }
+            std::size_t lockCount = RoundUpToPowerOfTwo(static_cast<std::size_t>(concurrencyLevel));
+            lockMask = lockCount - 1;
+            stripes.reset(new Stripe[lockCount]);
+
+            // Every table is at least as large as the stripe count, so a key's stripe
+            // does not change when the table grows
+            std::size_t bucketCount = std::max({RoundUpToPowerOfTwo(static_cast<std::size_t>(std::max(capacity, 1))), lockCount, MinimumBucketCount});
+            root.store(new Table(bucketCount), std::memory_order_relaxed);
+        }
+
+        ConcurrentDictionary(const std::unordered_map<K, V>& dictionary)
+            : ConcurrentDictionary()
+        {
+            for (const auto& entry : dictionary)
+            {
+                TryAdd(entry.first, entry.second);
+            }
+        }
+
+        ~ConcurrentDictionary()
+        {
+            Table* table = root.load(std::memory_order_relaxed);
+            while (table)
+            {
+                Table* next = table->next.load(std::memory_order_relaxed);
+                delete table;
+                table = next;
+            }
+        }
+
+        ConcurrentDictionary(const ConcurrentDictionary&) = delete;
+        ConcurrentDictionary& operator=(const ConcurrentDictionary&) = delete;
+
+        // Access: throws std::out_of_range if the key is missing. Nodes are immutable,
+        // so the value is returned by copy; use SetItem to store one.
+        V operator[](const K& key) const
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            Node* node = Find(key, Hash(key));
+            if (!node)
+            {
+                throw std::out_of_range("The given key was not present in the dictionary");
+            }
+            return node->value;
+        }
 
-        // Access
-        V& operator[](const K& key);
-        const V& operator[](const K& key) const;
+        // Adds the key or overwrites its value
+        void SetItem(const K& key, const V& value)
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            std::size_t hash = Hash(key);
+            Table* table = WithBucket(hash, [&](std::atomic<Node*>& bucket, Node* head, Stripe& stripe) {
+                Node* previous = nullptr;
+                for (Node* node = head; node; previous = node, node = node->next.load(std::memory_order_relaxed))
+                {
+                    if (node->hash == hash && node->key == key)
+                    {
+                        Replace(bucket, previous, node, value);
+                        return;
+                    }
+                }
+                bucket.store(new Node(key, value, hash, head), std::memory_order_release);
+                stripe.count.fetch_add(1, std::memory_order_relaxed);
+            });
+            AfterWrite(table, hash);
+        }
 
         // Modification
-        bool TryAdd(const K& key, const V& value);
-        bool TryGetValue(const K& key, V& value) const;
-        bool TryUpdate(const K& key, const V& newValue, const V& comparisonValue);
-        bool TryRemove(const K& key, V& value);
-        V AddOrUpdate(const K& key, const V& addValue, std::function<V(const K&, const V&)> updateValueFactory);
-        V AddOrUpdate(const K& key, std::function<V(const K&)> addValueFactory, std::function<V(const K&, const V&)> updateValueFactory);
-        V GetOrAdd(const K& key, const V& value);
-        V GetOrAdd(const K& key, std::function<V(const K&)> valueFactory);
+        bool TryAdd(const K& key, const V& value)
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            std::size_t hash = Hash(key);
+            return GetOrAddNode(key, hash, value).second;
+        }
+
+        bool TryGetValue(const K& key, V& value) const
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            Node* node = Find(key, Hash(key));
+            if (!node)
+            {
+                return false;
+            }
+            value = node->value;
+            return true;
+        }
+
+        bool TryUpdate(const K& key, const V& newValue, const V& comparisonValue)
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            return TryReplaceValue(key, Hash(key), comparisonValue, newValue);
+        }
+
+        bool TryRemove(const K& key, V& value)
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            std::size_t hash = Hash(key);
+            bool removed = false;
+            WithBucket(hash, [&](std::atomic<Node*>& bucket, Node* head, Stripe& stripe) {
+                Node* previous = nullptr;
+                for (Node* node = head; node; previous = node, node = node->next.load(std::memory_order_relaxed))
+                {
+                    if (node->hash == hash && node->key == key)
+                    {
+                        Node* next = node->next.load(std::memory_order_relaxed);
+                        if (previous)
+                        {
+                            previous->next.store(next, std::memory_order_release);
+                        }
+                        else
+                        {
+                            bucket.store(next, std::memory_order_release);
+                        }
+                        stripe.count.fetch_sub(1, std::memory_order_relaxed);
+                        value = node->value;
+                        System::Threading::EpochReclaimer::Retire(node);
+                        removed = true;
+                        break;
+                    }
+                }
+            });
+            return removed;
+        }
+
+        V AddOrUpdate(const K& key, const V& addValue, std::function<V(const K&, const V&)> updateValueFactory)
+        {
+            return AddOrUpdate(key, [&addValue](const K&) { return addValue; }, std::move(updateValueFactory));
+        }
+
+        // The update only lands if the value the factory saw is still current, which
+        // is compared with == as in TryUpdate: the node it was read from may have been
+        // freed by the time the factory returns
+        V AddOrUpdate(const K& key, std::function<V(const K&)> addValueFactory, std::function<V(const K&, const V&)> updateValueFactory)
+        {
+            std::size_t hash = Hash(key);
+            for (;;)
+            {
+                if (std::optional<V> existing = FindValue(key, hash))
+                {
+                    V updated = updateValueFactory(key, *existing);
+                    System::Threading::EpochReclaimer::Guard guard;
+                    if (TryReplaceValue(key, hash, *existing, updated))
+                    {
+                        return updated;
+                    }
+                }
+                else
+                {
+                    V added = addValueFactory(key);
+                    System::Threading::EpochReclaimer::Guard guard;
+                    if (GetOrAddNode(key, hash, added).second)
+                    {
+                        return added;
+                    }
+                }
+            }
+        }
+
+        V GetOrAdd(const K& key, const V& value)
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            return GetOrAddNode(key, Hash(key), value).first->value;
+        }
+
+        V GetOrAdd(const K& key, std::function<V(const K&)> valueFactory)
+        {
+            std::size_t hash = Hash(key);
+            if (std::optional<V> existing = FindValue(key, hash))
+            {
+                return *std::move(existing);
+            }
+            V value = valueFactory(key);
+            System::Threading::EpochReclaimer::Guard guard;
+            return GetOrAddNode(key, hash, value).first->value;
+        }
 
         // Properties
-        int GetCount() const;
-        bool GetIsEmpty() const;
-        std::vector<K> GetKeys() const;
-        std::vector<V> GetValues() const;
+        int GetCount() const
+        {
+            std::size_t count = 0;
+            for (std::size_t i = 0; i <= lockMask; ++i)
+            {
+                count += stripes[i].count.load(std::memory_order_relaxed);
+            }
+            return static_cast<int>(count);
+        }
+
+        bool GetIsEmpty() const
+        {
+            return GetCount() == 0;
+        }
+
+        std::vector<K> GetKeys() const
+        {
+            std::vector<K> keys;
+            ForEach([&keys](const Node& node) { keys.push_back(node.key); });
+            return keys;
+        }
+
+        std::vector<V> GetValues() const
+        {
+            std::vector<V> values;
+            ForEach([&values](const Node& node) { values.push_back(node.value); });
+            return values;
+        }
 
         // IEnumerable
-        std::vector<std::pair<K, V>> ToArray();
-        bool ContainsKey(const K& key) const;
-        void Clear();
+        std::vector<std::pair<K, V>> ToArray()
+        {
+            std::vector<std::pair<K, V>> items;
+            ForEach([&items](const Node& node) { items.emplace_back(node.key, node.value); });
+            return items;
+        }
+
+        bool ContainsKey(const K& key) const
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            return Find(key, Hash(key)) != nullptr;
+        }
+
+        void Clear()
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            std::vector<std::unique_lock<std::mutex>> locks;
+            locks.reserve(lockMask + 1);
+            for (std::size_t i = 0; i <= lockMask; ++i)
+            {
+                locks.emplace_back(stripes[i].lock);
+            }
+
+            // Forward every bucket of the old table(s) to a fresh one, so a writer still
+            // holding an old table follows the markers instead of writing into it. The
+            // root is swapped first: a migration finishing meanwhile then loses its CAS on
+            // it and leaves retiring the tables to this walk.
+            Table* fresh = new Table(std::max(lockMask + 1, MinimumBucketCount));
+            Table* old = root.exchange(fresh, std::memory_order_acq_rel);
+            for (Table* table = old; table;)
+            {
+                for (std::size_t i = 0; i < table->GetSize(); ++i)
+                {
+                    Node* node = table->buckets[i].exchange(Moved(), std::memory_order_acq_rel);
+                    while (node && node != Moved())
+                    {
+                        Node* following = node->next.load(std::memory_order_relaxed);
+                        System::Threading::EpochReclaimer::Retire(node);
+                        node = following;
+                    }
+                }
+                // A writer outside the locks may install a grown table meanwhile;
+                // the CAS picks it up rather than losing it
+                Table* next = nullptr;
+                table->next.compare_exchange_strong(next, fresh, std::memory_order_acq_rel);
+                System::Threading::EpochReclaimer::Retire(table, sizeof(Table) + (table->mask + 1) * sizeof(std::atomic<Node*>));
+                table = next;
+            }
+
+            for (std::size_t i = 0; i <= lockMask; ++i)
+            {
+                stripes[i].count.store(0, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        // Caller holds a guard
+        Node* Find(const K& key, std::size_t hash) const
+        {
+            Table* table = root.load(std::memory_order_acquire);
+            for (;;)
+            {
+                Node* node = table->buckets[hash & table->mask].load(std::memory_order_acquire);
+                if (node == Moved())
+                {
+                    table = table->next.load(std::memory_order_acquire);
+                    continue;
+                }
+                for (; node; node = node->next.load(std::memory_order_acquire))
+                {
+                    if (node->hash == hash && node->key == key)
+                    {
+                        return node;
+                    }
+                }
+                return nullptr;
+            }
+        }
+
+        // Locks the stripe of the bucket that currently owns hash, following
+        // forwarding markers, and runs op(bucket, head, stripe) under it. Returns
+        // the table the bucket belongs to.
+        template<typename Op>
+        Table* WithBucket(std::size_t hash, Op&& op)
+        {
+            Stripe& stripe = stripes[hash & lockMask];
+            Table* table = root.load(std::memory_order_acquire);
+            for (;;)
+            {
+                std::lock_guard<std::mutex> lock(stripe.lock);
+                std::atomic<Node*>& bucket = table->buckets[hash & table->mask];
+                Node* head = bucket.load(std::memory_order_acquire);
+                if (head == Moved())
+                {
+                    table = table->next.load(std::memory_order_acquire);
+                    continue;
+                }
+                op(bucket, head, stripe);
+                return table;
+            }
+        }
+
+        // Returns the node now holding key and whether it was added by this call
+        std::pair<Node*, bool> GetOrAddNode(const K& key, std::size_t hash, const V& value)
+        {
+            std::pair<Node*, bool> result{nullptr, false};
+            Table* table = WithBucket(hash, [&](std::atomic<Node*>& bucket, Node* head, Stripe& stripe) {
+                for (Node* node = head; node; node = node->next.load(std::memory_order_relaxed))
+                {
+                    if (node->hash == hash && node->key == key)
+                    {
+                        result.first = node;
+                        return;
+                    }
+                }
+                result = {new Node(key, value, hash, head), true};
+                bucket.store(result.first, std::memory_order_release);
+                stripe.count.fetch_add(1, std::memory_order_relaxed);
+            });
+            if (result.second)
+            {
+                AfterWrite(table, hash);
+            }
+            return result;
+        }
+
+        // Copies the key's value out under a guard of its own
+        std::optional<V> FindValue(const K& key, std::size_t hash) const
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            Node* node = Find(key, hash);
+            return node ? std::optional<V>(node->value) : std::nullopt;
+        }
+
+        // Replaces the key's value with value if it still equals expected
+        bool TryReplaceValue(const K& key, std::size_t hash, const V& expected, const V& value)
+        {
+            bool replaced = false;
+            WithBucket(hash, [&](std::atomic<Node*>& bucket, Node* head, Stripe&) {
+                Node* previous = nullptr;
+                for (Node* node = head; node; previous = node, node = node->next.load(std::memory_order_relaxed))
+                {
+                    if (node->hash == hash && node->key == key)
+                    {
+                        if (node->value == expected)
+                        {
+                            Replace(bucket, previous, node, value);
+                            replaced = true;
+                        }
+                        break;
+                    }
+                }
+            });
+            return replaced;
+        }
+
+        // Caller holds the stripe lock
+        static void Replace(std::atomic<Node*>& bucket, Node* previous, Node* node, const V& value)
+        {
+            Node* replacement = new Node(node->key, value, node->hash, node->next.load(std::memory_order_relaxed));
+            if (previous)
+            {
+                previous->next.store(replacement, std::memory_order_release);
+            }
+            else
+            {
+                bucket.store(replacement, std::memory_order_release);
+            }
+            System::Threading::EpochReclaimer::Retire(node);
+        }
+
+        // Starts growing once the stripe written to suggests the average chain is too
+        // long, and lends a hand to any migration in progress
+        void AfterWrite(Table* table, std::size_t hash)
+        {
+            std::size_t stripeCount = stripes[hash & lockMask].count.load(std::memory_order_relaxed);
+            if (stripeCount * (lockMask + 1) > table->GetSize() * MaxLoadFactor &&
+                table == root.load(std::memory_order_acquire) &&
+                !table->next.load(std::memory_order_acquire))
+            {
+                Table* grown = new Table(table->GetSize() * 2);
+                Table* expected = nullptr;
+                if (!table->next.compare_exchange_strong(expected, grown, std::memory_order_acq_rel))
+                {
+                    delete grown;
+                }
+            }
+
+            Table* current = root.load(std::memory_order_acquire);
+            if (current->next.load(std::memory_order_acquire))
+            {
+                HelpMigrate(current);
+            }
+        }
+
+        void HelpMigrate(Table* table)
+        {
+            std::size_t size = table->GetSize();
+            std::size_t start = table->migrationCursor.fetch_add(MigrationChunk, std::memory_order_relaxed);
+            if (start >= size)
+            {
+                return;
+            }
+
+            std::size_t end = std::min(start + MigrationChunk, size);
+            for (std::size_t i = start; i < end; ++i)
+            {
+                MigrateBucket(table, i);
+            }
+
+            std::size_t done = end - start;
+            if (table->migratedBuckets.fetch_add(done, std::memory_order_acq_rel) + done == size)
+            {
+                // Fails only if Clear has taken the root, and with it the table
+                Table* expected = table;
+                if (root.compare_exchange_strong(expected, table->next.load(std::memory_order_acquire), std::memory_order_acq_rel))
+                {
+                    System::Threading::EpochReclaimer::Retire(table, sizeof(Table) + (table->mask + 1) * sizeof(std::atomic<Node*>));
+                }
+            }
+        }
+
+        // Copies a bucket's chain into the next table, then forwards the bucket there.
+        // The stripe lock covers both: source and target buckets share their low bits.
+        void MigrateBucket(Table* table, std::size_t index)
+        {
+            std::lock_guard<std::mutex> lock(stripes[index & lockMask].lock);
+            std::atomic<Node*>& bucket = table->buckets[index];
+            Node* node = bucket.load(std::memory_order_acquire);
+            if (node == Moved())
+            {
+                // Cleared meanwhile
+                return;
+            }
+
+            // Readers may be walking the old chain, so its nodes are copied, not relinked
+            Table* next = table->next.load(std::memory_order_acquire);
+            for (Node* source = node; source; source = source->next.load(std::memory_order_relaxed))
+            {
+                std::atomic<Node*>& target = next->buckets[source->hash & next->mask];
+                target.store(new Node(source->key, source->value, source->hash, target.load(std::memory_order_relaxed)), std::memory_order_release);
+            }
+            bucket.store(Moved(), std::memory_order_release);
+
+            while (node)
+            {
+                Node* following = node->next.load(std::memory_order_relaxed);
+                System::Threading::EpochReclaimer::Retire(node);
+                node = following;
+            }
+        }
+
+        template<typename Visitor>
+        void ForEach(Visitor&& visitor) const
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            Table* table = root.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < table->GetSize(); ++i)
+            {
+                VisitBucket(table, i, visitor);
+            }
+        }
+
+        template<typename Visitor>
+        static void VisitBucket(Table* table, std::size_t index, Visitor& visitor)
+        {
+            Node* node = table->buckets[index].load(std::memory_order_acquire);
+            if (node == Moved())
+            {
+                // The bucket split into index and index + size of the next table
+                Table* next = table->next.load(std::memory_order_acquire);
+                for (std::size_t target = index; target < next->GetSize(); target += table->GetSize())
+                {
+                    VisitBucket(next, target, visitor);
+                }
+                return;
+            }
+            for (; node; node = node->next.load(std::memory_order_acquire))
+            {
+                visitor(*node);
+            }
+        }
     };
 }
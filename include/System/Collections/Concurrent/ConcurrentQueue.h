@@ -1,34 +1,451 @@
-
 #pragma once
 
 #include "System/Object.h"
-#include <queue>
+#include "System/Threading/EpochReclaimer.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace System::Collections::Concurrent
 {
+    // Lock-free multi-producer, multi-consumer FIFO queue.
+    //
+    // Follows .NET's ConcurrentQueue: items live in a linked list of fixed-size ring
+    // segments. Each slot carries a sequence number that tells producers and consumers
+    // whether it is free for the current lap, so enqueue and dequeue are one CAS on the
+    // segment's tail or head index, each on its own cache line. When the tail segment
+    // fills up it is frozen and a segment twice its size is appended; only that step,
+    // and dropping an emptied head segment, take the cross-segment lock. Retired
+    // segments are freed through the EpochReclaimer.
+    //
+    // Observers (TryPeek, ToArray) mark segments as preserved: consumers then copy items
+    // out instead of destroying them, so a snapshot can read them without a lock.
     template<typename T>
     class ConcurrentQueue : public System::Object
     {
     private:
-        std::queue<T> queue;
-        mutable std::mutex mutex;
+        static constexpr std::size_t CacheLineSize = 64;
+        static constexpr std::int64_t InitialSegmentLength = 32;
+        static constexpr std::int64_t MaxSegmentLength = 1024 * 1024;
+
+        struct Slot
+        {
+            std::atomic<std::int64_t> sequenceNumber;
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            T* Item() { return std::launder(reinterpret_cast<T*>(storage)); }
+        };
+
+        class Segment
+        {
+        public:
+            // Set in the tail index when freezing; every later enqueue then sees "full"
+            static constexpr std::int64_t FrozenBit = std::int64_t{1} << 62;
+
+            const std::int64_t length;
+            const std::int64_t mask;
+            std::unique_ptr<Slot[]> slots;
+
+            alignas(CacheLineSize) std::atomic<std::int64_t> headIndex{0};
+            alignas(CacheLineSize) std::atomic<std::int64_t> tailIndex{0};
+            alignas(CacheLineSize) std::atomic<bool> preservedForObservation{false};
+            std::atomic<Segment*> nextSegment{nullptr};
+
+            explicit Segment(std::int64_t length)
+                : length(length), mask(length - 1), slots(new Slot[static_cast<std::size_t>(length)])
+            {
+                for (std::int64_t i = 0; i < length; ++i)
+                {
+                    slots[i].sequenceNumber.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            // Only runs once no thread can reach the segment
+            ~Segment()
+            {
+                for (std::int64_t i = 0; i < length; ++i)
+                {
+                    if (IsFull(i, slots[i].sequenceNumber.load(std::memory_order_relaxed)))
+                    {
+                        slots[i].Item()->~T();
+                    }
+                }
+            }
+
+            Segment(const Segment&) = delete;
+            Segment& operator=(const Segment&) = delete;
+
+            // A slot written for lap position p carries p + 1
+            bool IsFull(std::int64_t slotIndex, std::int64_t sequenceNumber) const
+            {
+                return ((sequenceNumber - 1) & mask) == slotIndex;
+            }
+
+            // Tail without the frozen bit
+            std::int64_t GetEffectiveTail() const
+            {
+                return tailIndex.load(std::memory_order_acquire) & ~FrozenBit;
+            }
+
+            std::int64_t GetCount() const
+            {
+                std::int64_t head = headIndex.load(std::memory_order_acquire);
+                std::int64_t tail = GetEffectiveTail();
+                return tail > head ? tail - head : 0;
+            }
+
+            void EnsureFrozenForEnqueues()
+            {
+                tailIndex.fetch_or(FrozenBit, std::memory_order_acq_rel);
+            }
+
+            template<typename U>
+            bool TryEnqueue(U&& item)
+            {
+                for (;;)
+                {
+                    std::int64_t tail = tailIndex.load(std::memory_order_acquire);
+                    Slot& slot = slots[tail & mask];
+                    std::int64_t diff = slot.sequenceNumber.load(std::memory_order_acquire) - tail;
+                    if (diff == 0)
+                    {
+                        if (tailIndex.compare_exchange_weak(tail, tail + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                        {
+                            ::new (static_cast<void*>(slot.storage)) T(std::forward<U>(item));
+                            slot.sequenceNumber.store(tail + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (diff < 0)
+                    {
+                        // Full, or frozen
+                        return false;
+                    }
+                    // diff > 0: another producer took this position; retry
+                }
+            }
+
+            // Claims up to count consecutive items from the head with one CAS and hands
+            // each to sink. Returns how many were taken.
+            template<typename Sink>
+            std::int64_t TryDequeueRange(std::int64_t count, Sink&& sink)
+            {
+                for (;;)
+                {
+                    std::int64_t head = headIndex.load(std::memory_order_acquire);
+                    std::int64_t available = 0;
+                    while (available < count)
+                    {
+                        std::int64_t position = head + available;
+                        if (slots[position & mask].sequenceNumber.load(std::memory_order_acquire) != position + 1)
+                        {
+                            break;
+                        }
+                        ++available;
+                    }
+
+                    if (available == 0)
+                    {
+                        std::int64_t sequenceNumber = slots[head & mask].sequenceNumber.load(std::memory_order_acquire);
+                        if (sequenceNumber - (head + 1) > 0)
+                        {
+                            // Another consumer took it; retry
+                            continue;
+                        }
+                        if (GetEffectiveTail() - head <= 0)
+                        {
+                            return 0;
+                        }
+                        // A producer claimed the slot but has not written it yet
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    if (!headIndex.compare_exchange_weak(head, head + available, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    {
+                        continue;
+                    }
+
+                    // Read after the CAS: an observer that set the flag first either sees
+                    // the new head or makes this consumer leave the items in place
+                    bool preserved = preservedForObservation.load(std::memory_order_seq_cst);
+                    for (std::int64_t i = 0; i < available; ++i)
+                    {
+                        std::int64_t position = head + i;
+                        Slot& slot = slots[position & mask];
+                        if (preserved)
+                        {
+                            sink(static_cast<const T&>(*slot.Item()));
+                        }
+                        else
+                        {
+                            sink(std::move(*slot.Item()));
+                            slot.Item()->~T();
+                            slot.sequenceNumber.store(position + length, std::memory_order_release);
+                        }
+                    }
+                    return available;
+                }
+            }
+
+            // Caller has marked the segment preserved
+            bool TryPeek(T& result)
+            {
+                for (;;)
+                {
+                    std::int64_t head = headIndex.load(std::memory_order_seq_cst);
+                    Slot& slot = slots[head & mask];
+                    std::int64_t diff = slot.sequenceNumber.load(std::memory_order_acquire) - (head + 1);
+                    if (diff == 0)
+                    {
+                        result = *slot.Item();
+                        return true;
+                    }
+                    if (diff < 0)
+                    {
+                        if (GetEffectiveTail() - head <= 0)
+                        {
+                            return false;
+                        }
+                        std::this_thread::yield();
+                    }
+                }
+            }
+
+            // Caller has marked the segment preserved and frozen it
+            void CopyPreserved(std::vector<T>& items)
+            {
+                std::int64_t head = headIndex.load(std::memory_order_seq_cst);
+                std::int64_t tail = GetEffectiveTail();
+                for (std::int64_t position = head; position < tail; ++position)
+                {
+                    Slot& slot = slots[position & mask];
+                    // Wait out a producer that claimed the position but has not written it
+                    while (slot.sequenceNumber.load(std::memory_order_acquire) != position + 1)
+                    {
+                        std::this_thread::yield();
+                    }
+                    items.push_back(*slot.Item());
+                }
+            }
+        };
+
+        alignas(CacheLineSize) std::atomic<Segment*> head;
+        alignas(CacheLineSize) std::atomic<Segment*> tail;
+        alignas(CacheLineSize) std::mutex crossSegmentLock;
 
     public:
-        ConcurrentQueue() = default;
-        ConcurrentQueue(const std::vector<T>& collection);
+        ConcurrentQueue()
+        {
+            Segment* segment = new Segment(InitialSegmentLength);
+            head.store(segment, std::memory_order_relaxed);
+            tail.store(segment, std::memory_order_relaxed);
+        }
+
+        ConcurrentQueue(const std::vector<T>& collection)
+            : ConcurrentQueue()
+        {
+            for (const T& item : collection)
+            {
+                Enqueue(item);
+            }
+        }
+
+        ~ConcurrentQueue()
+        {
+            Segment* segment = head.load(std::memory_order_relaxed);
+            while (segment)
+            {
+                Segment* next = segment->nextSegment.load(std::memory_order_relaxed);
+                delete segment;
+                segment = next;
+            }
+        }
+
+        ConcurrentQueue(const ConcurrentQueue&) = delete;
+        ConcurrentQueue& operator=(const ConcurrentQueue&) = delete;
+
+        void Enqueue(const T& item)
+        {
+            EnqueueItem(item);
+        }
 
-        void Enqueue(const T& item);
-        bool TryDequeue(T& result);
-        bool TryPeek(T& result);
+        void Enqueue(T&& item)
+        {
+            EnqueueItem(std::move(item));
+        }
+
+        bool TryDequeue(T& result)
+        {
+            return TryDequeueRange(1, [&result](auto&& item) { result = std::forward<decltype(item)>(item); }) == 1;
+        }
+
+        // Moves up to items.size() items into items, oldest first, claiming whole runs
+        // of a segment with a single CAS. Returns how many were dequeued.
+        int TryDequeue(std::span<T> items)
+        {
+            std::size_t filled = 0;
+            TryDequeueRange(static_cast<std::int64_t>(items.size()), [&items, &filled](auto&& item) {
+                items[filled++] = std::forward<decltype(item)>(item);
+            });
+            return static_cast<int>(filled);
+        }
+
+        bool TryPeek(T& result)
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            for (Segment* segment = head.load(std::memory_order_acquire); segment;)
+            {
+                Segment* next = segment->nextSegment.load(std::memory_order_acquire);
+                segment->preservedForObservation.store(true, std::memory_order_seq_cst);
+                if (segment->TryPeek(result))
+                {
+                    return true;
+                }
+                if (!next)
+                {
+                    // The segment may have gained a successor (and items) after next was read
+                    next = segment->nextSegment.load(std::memory_order_acquire);
+                }
+                segment = next;
+            }
+            return false;
+        }
 
         // Properties
-        bool GetIsEmpty() const;
-        int GetCount() const;
+        bool GetIsEmpty() const
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            for (Segment* segment = head.load(std::memory_order_acquire); segment; segment = segment->nextSegment.load(std::memory_order_acquire))
+            {
+                if (segment->GetCount() > 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // A moment-in-time estimate while other threads are enqueuing or dequeuing
+        int GetCount() const
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            std::int64_t count = 0;
+            for (Segment* segment = head.load(std::memory_order_acquire); segment; segment = segment->nextSegment.load(std::memory_order_acquire))
+            {
+                count += segment->GetCount();
+            }
+            return static_cast<int>(count);
+        }
 
         // IEnumerable
-        std::vector<T> ToArray();
-        void CopyTo(std::vector<T>& array, int index);
+        std::vector<T> ToArray()
+        {
+            std::vector<T> items;
+            System::Threading::EpochReclaimer::Guard guard;
+
+            // Preserve and freeze every segment up to the current tail. Freezing fixes
+            // where the snapshot ends; later items go to a fresh segment.
+            std::vector<Segment*> segments;
+            for (Segment* segment = head.load(std::memory_order_acquire); segment;)
+            {
+                segment->preservedForObservation.store(true, std::memory_order_seq_cst);
+                segment->EnsureFrozenForEnqueues();
+                segments.push_back(segment);
+                segment = segment->nextSegment.load(std::memory_order_acquire);
+            }
+
+            for (Segment* segment : segments)
+            {
+                segment->CopyPreserved(items);
+            }
+            return items;
+        }
+
+        void CopyTo(std::vector<T>& array, int index)
+        {
+            if (index < 0 || static_cast<std::size_t>(index) > array.size())
+            {
+                throw std::out_of_range("index");
+            }
+
+            std::vector<T> items = ToArray();
+            if (items.size() > array.size() - static_cast<std::size_t>(index))
+            {
+                throw std::invalid_argument("The destination array is too small");
+            }
+            std::move(items.begin(), items.end(), array.begin() + index);
+        }
+
+    private:
+        template<typename U>
+        void EnqueueItem(U&& item)
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            for (;;)
+            {
+                Segment* current = tail.load(std::memory_order_acquire);
+                if (current->TryEnqueue(std::forward<U>(item)))
+                {
+                    return;
+                }
+
+                std::lock_guard<std::mutex> lock(crossSegmentLock);
+                if (current == tail.load(std::memory_order_relaxed))
+                {
+                    current->EnsureFrozenForEnqueues();
+                    // Preserved segments cannot be reused, so start small again after one
+                    std::int64_t length = current->preservedForObservation.load(std::memory_order_acquire)
+                        ? InitialSegmentLength
+                        : std::min(current->length * 2, MaxSegmentLength);
+                    Segment* next = new Segment(length);
+                    current->nextSegment.store(next, std::memory_order_release);
+                    tail.store(next, std::memory_order_release);
+                }
+            }
+        }
+
+        template<typename Sink>
+        std::size_t TryDequeueRange(std::int64_t count, Sink&& sink)
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            std::int64_t taken = 0;
+            while (taken < count)
+            {
+                Segment* current = head.load(std::memory_order_acquire);
+                taken += current->TryDequeueRange(count - taken, sink);
+                if (taken == count)
+                {
+                    break;
+                }
+
+                // A segment with a successor is frozen: once empty it stays empty
+                if (!current->nextSegment.load(std::memory_order_acquire))
+                {
+                    break;
+                }
+                if (current->GetCount() > 0)
+                {
+                    continue;
+                }
+
+                std::lock_guard<std::mutex> lock(crossSegmentLock);
+                if (current == head.load(std::memory_order_relaxed))
+                {
+                    head.store(current->nextSegment.load(std::memory_order_acquire), std::memory_order_release);
+                    System::Threading::EpochReclaimer::Retire(current, sizeof(Segment) + static_cast<std::size_t>(current->length) * sizeof(Slot));
+                }
+            }
+            return static_cast<std::size_t>(taken);
+        }
     };
 }
@@ -1,37 +1,321 @@
-
 #pragma once
 
 #include "System/Object.h"
-#include <stack>
-#include <mutex>
+#include "System/Threading/EpochReclaimer.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
 #include <vector>
 
 namespace System::Collections::Concurrent
 {
+    // Lock-free LIFO stack (Treiber) with an elimination array.
+    //
+    // Push and pop are a single CAS on the head pointer. A thread whose CAS loses to
+    // contention tries the elimination array before retrying: a pusher parks its node
+    // in a random slot for a short while, and a popper that finds it there takes the
+    // node directly, so the pair completes without touching the head at all.
+    // PushRange links its nodes privately and publishes them with one CAS;
+    // TryPopRange detaches a run of nodes with one CAS.
+    //
+    // Popped nodes are retired through the EpochReclaimer rather than deleted, so a
+    // node's address cannot come back while another thread may still compare against
+    // it (no ABA), and readers can walk the list without locks. Nodes are immutable
+    // once published; items are copied out of them.
     template<typename T>
     class ConcurrentStack : public System::Object
     {
     private:
-        std::stack<T> stack;
-        mutable std::mutex mutex;
+        static constexpr std::size_t CacheLineSize = 64;
+        static constexpr int EliminationSlots = 16;
+        static constexpr int EliminationSpins = 128;
+
+        struct Node
+        {
+            T value;
+            Node* next = nullptr;
+
+            explicit Node(const T& value) : value(value) {}
+        };
+
+        struct alignas(CacheLineSize) EliminationSlot
+        {
+            std::atomic<Node*> offer{nullptr};
+        };
+
+        alignas(CacheLineSize) std::atomic<Node*> head{nullptr};
+        EliminationSlot elimination[EliminationSlots];
 
     public:
         ConcurrentStack() = default;
-        ConcurrentStack(const std::vector<T>& collection);
 
-        void Push(const T& item);
-        void PushRange(const std::vector<T>& items);
-        bool TryPop(T& result);
-        int TryPopRange(std::vector<T>& items);
-        int TryPopRange(std::vector<T>& items, int startIndex, int count);
-        bool TryPeek(T& result);
+        ConcurrentStack(const std::vector<T>& collection)
+        {
+            PushRange(collection);
+        }
+
+        ~ConcurrentStack()
+        {
+            Node* node = head.load(std::memory_order_relaxed);
+            while (node)
+            {
+                Node* next = node->next;
+                delete node;
+                node = next;
+            }
+        }
+
+        ConcurrentStack(const ConcurrentStack&) = delete;
+        ConcurrentStack& operator=(const ConcurrentStack&) = delete;
+
+        void Push(const T& item)
+        {
+            Node* node = new Node(item);
+            System::Threading::EpochReclaimer::Guard guard;
+            for (;;)
+            {
+                Node* top = head.load(std::memory_order_relaxed);
+                node->next = top;
+                if (head.compare_exchange_weak(top, node, std::memory_order_release, std::memory_order_relaxed))
+                {
+                    return;
+                }
+                if (TryEliminatePush(node))
+                {
+                    return;
+                }
+            }
+        }
+
+        // Pushes items so that the last one ends up on top, all in one step
+        void PushRange(const std::vector<T>& items)
+        {
+            PushRange(items, 0, static_cast<int>(items.size()));
+        }
+
+        void PushRange(const std::vector<T>& items, int startIndex, int count)
+        {
+            ValidateRange(items, startIndex, count);
+            if (count == 0)
+            {
+                return;
+            }
+
+            Node* bottom = new Node(items[startIndex]);
+            Node* top = bottom;
+            for (int i = startIndex + 1; i < startIndex + count; ++i)
+            {
+                Node* node = new Node(items[i]);
+                node->next = top;
+                top = node;
+            }
+
+            Node* current = head.load(std::memory_order_relaxed);
+            do
+            {
+                bottom->next = current;
+            } while (!head.compare_exchange_weak(current, top, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        bool TryPop(T& result)
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            for (;;)
+            {
+                Node* top = head.load(std::memory_order_acquire);
+                if (!top)
+                {
+                    return false;
+                }
+                if (head.compare_exchange_weak(top, top->next, std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    result = top->value;
+                    System::Threading::EpochReclaimer::Retire(top);
+                    return true;
+                }
+                if (Node* node = TryEliminatePop())
+                {
+                    result = node->value;
+                    // The pusher may still compare against its address
+                    System::Threading::EpochReclaimer::Retire(node);
+                    return true;
+                }
+            }
+        }
+
+        // Pops up to items.size() items, top first
+        int TryPopRange(std::vector<T>& items)
+        {
+            return TryPopRange(items, 0, static_cast<int>(items.size()));
+        }
+
+        int TryPopRange(std::vector<T>& items, int startIndex, int count)
+        {
+            ValidateRange(items, startIndex, count);
+            if (count == 0)
+            {
+                return 0;
+            }
+
+            System::Threading::EpochReclaimer::Guard guard;
+            for (;;)
+            {
+                Node* top = head.load(std::memory_order_acquire);
+                if (!top)
+                {
+                    return 0;
+                }
+
+                Node* last = top;
+                int taken = 1;
+                while (taken < count && last->next)
+                {
+                    last = last->next;
+                    ++taken;
+                }
+
+                if (head.compare_exchange_weak(top, last->next, std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    Node* node = top;
+                    for (int i = 0; i < taken; ++i)
+                    {
+                        Node* next = node->next;
+                        items[startIndex + i] = node->value;
+                        System::Threading::EpochReclaimer::Retire(node);
+                        node = next;
+                    }
+                    return taken;
+                }
+            }
+        }
+
+        bool TryPeek(T& result)
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            Node* top = head.load(std::memory_order_acquire);
+            if (!top)
+            {
+                return false;
+            }
+            result = top->value;
+            return true;
+        }
+
+        void Clear()
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            Node* node = head.exchange(nullptr, std::memory_order_acquire);
+            while (node)
+            {
+                Node* next = node->next;
+                System::Threading::EpochReclaimer::Retire(node);
+                node = next;
+            }
+        }
 
         // Properties
-        bool GetIsEmpty() const;
-        int GetCount() const;
+        bool GetIsEmpty() const
+        {
+            return head.load(std::memory_order_acquire) == nullptr;
+        }
+
+        // Walks the stack: O(n) and a moment-in-time estimate under concurrent use
+        int GetCount() const
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            int count = 0;
+            for (Node* node = head.load(std::memory_order_acquire); node; node = node->next)
+            {
+                ++count;
+            }
+            return count;
+        }
+
+        // IEnumerable: top first, as of the moment the head was read
+        std::vector<T> ToArray()
+        {
+            System::Threading::EpochReclaimer::Guard guard;
+            std::vector<T> items;
+            for (Node* node = head.load(std::memory_order_acquire); node; node = node->next)
+            {
+                items.push_back(node->value);
+            }
+            return items;
+        }
+
+        void CopyTo(std::vector<T>& array, int index)
+        {
+            if (index < 0 || static_cast<std::size_t>(index) > array.size())
+            {
+                throw std::out_of_range("index");
+            }
+
+            std::vector<T> items = ToArray();
+            if (items.size() > array.size() - static_cast<std::size_t>(index))
+            {
+                throw std::invalid_argument("The destination array is too small");
+            }
+            std::copy(items.begin(), items.end(), array.begin() + index);
+        }
+
+    private:
+        static void ValidateRange(const std::vector<T>& items, int startIndex, int count)
+        {
+            if (startIndex < 0 || count < 0)
+            {
+                throw std::out_of_range("startIndex and count must be non-negative");
+            }
+            if (static_cast<std::size_t>(startIndex) + static_cast<std::size_t>(count) > items.size())
+            {
+                throw std::invalid_argument("startIndex and count exceed the collection");
+            }
+        }
+
+        static int RandomSlot()
+        {
+            thread_local std::uint32_t state = static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(&state)) | 1;
+            // xorshift32
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return static_cast<int>(state % EliminationSlots);
+        }
+
+        // Offers node to a concurrent popper. Returns true if one took it.
+        bool TryEliminatePush(Node* node)
+        {
+            EliminationSlot& slot = elimination[RandomSlot()];
+            Node* empty = nullptr;
+            if (!slot.offer.compare_exchange_strong(empty, node, std::memory_order_release, std::memory_order_relaxed))
+            {
+                return false;
+            }
+
+            for (int spin = 0; spin < EliminationSpins; ++spin)
+            {
+                if (slot.offer.load(std::memory_order_relaxed) != node)
+                {
+                    return true;
+                }
+            }
+
+            // Withdraw the offer; failing means a popper got there first. The caller's
+            // guard keeps node's address from being reused while we compare against it.
+            Node* expected = node;
+            return !slot.offer.compare_exchange_strong(expected, nullptr, std::memory_order_acquire, std::memory_order_relaxed);
+        }
 
-        // IEnumerable
-        std::vector<T> ToArray();
-        void CopyTo(std::vector<T>& array, int index);
+        Node* TryEliminatePop()
+        {
+            EliminationSlot& slot = elimination[RandomSlot()];
+            Node* node = slot.offer.load(std::memory_order_acquire);
+            if (node && slot.offer.compare_exchange_strong(node, nullptr, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                return node;
+            }
+            return nullptr;
+        }
     };
 }
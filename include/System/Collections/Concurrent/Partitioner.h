@@ -0,0 +1,506 @@
+#pragma once
+
+#include "System/Object.h"
+#include "System/Coroutines/Generator.hpp"
+#include "System/Linq/IEnumerable.hpp"
+#include "System/Linq/IEnumerator.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace System::Collections::Concurrent
+{
+    enum class EnumerablePartitionerOptions
+    {
+        None,
+        // Hand out one element at a time instead of growing chunks
+        NoBuffering
+    };
+
+    // Splits a data source into partitions that are enumerated concurrently, one
+    // thread per partition. Together the partitions yield every element once.
+    template<typename TSource>
+    class IPartitioner : public System::Object
+    {
+    public:
+        using Partition = std::unique_ptr<System::Linq::IEnumerator<TSource>>;
+
+        virtual ~IPartitioner() = default;
+
+        virtual std::vector<Partition> GetPartitions(int partitionCount) const = 0;
+
+    protected:
+        static void ValidatePartitionCount(int partitionCount)
+        {
+            if (partitionCount <= 0)
+            {
+                throw std::out_of_range("partitionCount must be positive");
+            }
+        }
+    };
+
+    // Dynamic partitions claim chunks that start at one element and double with
+    // every claim up to this size: short or uneven sources still spread over all
+    // partitions, long ones pay for the shared claim only every MaxChunkSize elements
+    constexpr int PartitionerMaxChunkSize = 512;
+
+    // Splits [fromInclusive, toExclusive) into fixed-size ranges and deals them out
+    // to the partitions round-robin up front; partitions share nothing.
+    template<typename TIndex>
+    class RangePartitioner : public IPartitioner<std::pair<TIndex, TIndex>>
+    {
+    private:
+        using Range = std::pair<TIndex, TIndex>;
+
+        class Partition : public System::Linq::IEnumerator<Range>
+        {
+        private:
+            TIndex fromInclusive;
+            TIndex toExclusive;
+            long long rangeSize;
+            // Index of the next range; advances by stride
+            long long next;
+            long long stride;
+            Range current;
+
+        public:
+            Partition(TIndex fromInclusive, TIndex toExclusive, long long rangeSize, int first, int stride)
+                : fromInclusive(fromInclusive), toExclusive(toExclusive), rangeSize(rangeSize), next(first), stride(stride), current()
+            {
+            }
+
+            const Range& Current() const override { return current; }
+            Range& Current() override { return current; }
+
+            bool MoveNext() override
+            {
+                // Widened: the range may not fit in TIndex
+                long long begin = static_cast<long long>(fromInclusive) + next * rangeSize;
+                if (begin >= static_cast<long long>(toExclusive))
+                {
+                    return false;
+                }
+                long long end = std::min<long long>(begin + rangeSize, toExclusive);
+                current = Range(static_cast<TIndex>(begin), static_cast<TIndex>(end));
+                next += stride;
+                return true;
+            }
+
+            void Reset() override
+            {
+                throw std::logic_error("Partitions cannot be reset");
+            }
+        };
+
+        TIndex fromInclusive;
+        TIndex toExclusive;
+        long long rangeSize;
+
+    public:
+        RangePartitioner(TIndex fromInclusive, TIndex toExclusive, long long rangeSize)
+            : fromInclusive(fromInclusive), toExclusive(toExclusive), rangeSize(rangeSize)
+        {
+        }
+
+        std::vector<typename IPartitioner<Range>::Partition> GetPartitions(int partitionCount) const override
+        {
+            IPartitioner<Range>::ValidatePartitionCount(partitionCount);
+            std::vector<typename IPartitioner<Range>::Partition> partitions;
+            partitions.reserve(static_cast<std::size_t>(partitionCount));
+            for (int p = 0; p < partitionCount; ++p)
+            {
+                partitions.push_back(std::make_unique<Partition>(fromInclusive, toExclusive, rangeSize, p, partitionCount));
+            }
+            return partitions;
+        }
+    };
+
+    // Partitions a vector in place; elements are read from the source, not copied.
+    // Static mode gives each partition one contiguous block. Load-balanced mode has
+    // the partitions claim growing chunks from a shared atomic cursor.
+    template<typename T>
+    class VectorPartitioner : public IPartitioner<T>
+    {
+    private:
+        class Partition : public System::Linq::IEnumerator<T>
+        {
+        private:
+            const std::vector<T>* source;
+            // Null in static mode
+            std::shared_ptr<std::atomic<std::size_t>> cursor;
+            std::size_t chunkSize = 1;
+            std::size_t index;
+            std::size_t end;
+            bool started = false;
+
+        public:
+            Partition(const std::vector<T>* source, std::shared_ptr<std::atomic<std::size_t>> cursor, std::size_t begin, std::size_t end)
+                : source(source), cursor(std::move(cursor)), index(begin), end(end)
+            {
+            }
+
+            const T& Current() const override { return (*source)[index]; }
+            T& Current() override { return const_cast<T&>((*source)[index]); }
+
+            bool MoveNext() override
+            {
+                if (started)
+                {
+                    ++index;
+                }
+                started = true;
+                if (index < end)
+                {
+                    return true;
+                }
+                if (!cursor)
+                {
+                    return false;
+                }
+
+                index = cursor->fetch_add(chunkSize, std::memory_order_relaxed);
+                if (index >= source->size())
+                {
+                    end = index;
+                    return false;
+                }
+                end = std::min(index + chunkSize, source->size());
+                chunkSize = std::min<std::size_t>(chunkSize * 2, PartitionerMaxChunkSize);
+                return true;
+            }
+
+            void Reset() override
+            {
+                throw std::logic_error("Partitions cannot be reset");
+            }
+        };
+
+        const std::vector<T>* source;
+        bool loadBalance;
+
+    public:
+        VectorPartitioner(const std::vector<T>& source, bool loadBalance)
+            : source(&source), loadBalance(loadBalance)
+        {
+        }
+
+        std::vector<typename IPartitioner<T>::Partition> GetPartitions(int partitionCount) const override
+        {
+            IPartitioner<T>::ValidatePartitionCount(partitionCount);
+            std::vector<typename IPartitioner<T>::Partition> partitions;
+            partitions.reserve(static_cast<std::size_t>(partitionCount));
+
+            if (loadBalance)
+            {
+                auto cursor = std::make_shared<std::atomic<std::size_t>>(0);
+                for (int p = 0; p < partitionCount; ++p)
+                {
+                    partitions.push_back(std::make_unique<Partition>(source, cursor, 0, 0));
+                }
+                return partitions;
+            }
+
+            std::size_t count = source->size();
+            std::size_t blockSize = count / static_cast<std::size_t>(partitionCount);
+            std::size_t larger = count % static_cast<std::size_t>(partitionCount);
+            std::size_t next = 0;
+            for (int p = 0; p < partitionCount; ++p)
+            {
+                std::size_t begin = next;
+                next += blockSize + (static_cast<std::size_t>(p) < larger ? 1 : 0);
+                partitions.push_back(std::make_unique<Partition>(source, nullptr, begin, next));
+            }
+            return partitions;
+        }
+    };
+
+    // Load-balanced partitioning of a sequence that can only be walked once, front
+    // to back: an IEnumerable's enumerator or a Generator. The partitions share one
+    // cursor behind a mutex and copy a chunk of elements out of it per acquisition,
+    // so the source is never materialized and the lock is taken once per chunk.
+    template<typename T>
+    class StreamPartitioner : public IPartitioner<T>
+    {
+    protected:
+        // The cursor shared by the partitions of one GetPartitions call
+        class Stream
+        {
+        private:
+            std::mutex mutex;
+            bool exhausted = false;
+
+        protected:
+            // Called under the lock: appends up to count elements, false once the
+            // source has ended
+            virtual bool Read(std::vector<T>& chunk, int count) = 0;
+
+        public:
+            virtual ~Stream() = default;
+
+            void Take(std::vector<T>& chunk, int count)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (exhausted)
+                {
+                    return;
+                }
+                try
+                {
+                    exhausted = !Read(chunk, count);
+                }
+                catch (...)
+                {
+                    // A source that has thrown cannot be resumed
+                    exhausted = true;
+                    throw;
+                }
+            }
+        };
+
+        virtual std::shared_ptr<Stream> Open() const = 0;
+
+    private:
+        class Partition : public System::Linq::IEnumerator<T>
+        {
+        private:
+            std::shared_ptr<Stream> stream;
+            std::vector<T> chunk;
+            std::size_t index = 0;
+            int chunkSize = 1;
+            bool buffered;
+
+        public:
+            Partition(std::shared_ptr<Stream> stream, bool buffered)
+                : stream(std::move(stream)), buffered(buffered)
+            {
+            }
+
+            const T& Current() const override { return chunk[index]; }
+            T& Current() override { return chunk[index]; }
+
+            bool MoveNext() override
+            {
+                if (++index < chunk.size())
+                {
+                    return true;
+                }
+                chunk.clear();
+                index = 0;
+                stream->Take(chunk, chunkSize);
+                if (buffered)
+                {
+                    chunkSize = std::min(chunkSize * 2, PartitionerMaxChunkSize);
+                }
+                return !chunk.empty();
+            }
+
+            void Reset() override
+            {
+                throw std::logic_error("Partitions cannot be reset");
+            }
+        };
+
+        bool buffered;
+
+    public:
+        explicit StreamPartitioner(EnumerablePartitionerOptions options)
+            : buffered(options != EnumerablePartitionerOptions::NoBuffering)
+        {
+        }
+
+        std::vector<typename IPartitioner<T>::Partition> GetPartitions(int partitionCount) const override
+        {
+            IPartitioner<T>::ValidatePartitionCount(partitionCount);
+            std::shared_ptr<Stream> stream = Open();
+            std::vector<typename IPartitioner<T>::Partition> partitions;
+            partitions.reserve(static_cast<std::size_t>(partitionCount));
+            for (int p = 0; p < partitionCount; ++p)
+            {
+                partitions.push_back(std::make_unique<Partition>(stream, buffered));
+            }
+            return partitions;
+        }
+    };
+
+    // Each GetPartitions call enumerates the source afresh; the source must outlive
+    // the partitions
+    template<typename T>
+    class EnumerablePartitioner : public StreamPartitioner<T>
+    {
+    private:
+        using typename StreamPartitioner<T>::Stream;
+
+        class EnumeratorStream : public Stream
+        {
+        private:
+            std::unique_ptr<System::Linq::IEnumerator<T>> enumerator;
+
+        protected:
+            bool Read(std::vector<T>& chunk, int count) override
+            {
+                for (; count > 0; --count)
+                {
+                    if (!enumerator->MoveNext())
+                    {
+                        return false;
+                    }
+                    chunk.push_back(enumerator->Current());
+                }
+                return true;
+            }
+
+        public:
+            explicit EnumeratorStream(std::unique_ptr<System::Linq::IEnumerator<T>> enumerator)
+                : enumerator(std::move(enumerator))
+            {
+            }
+        };
+
+        const System::Linq::IEnumerable<T>* source;
+
+    protected:
+        std::shared_ptr<Stream> Open() const override
+        {
+            return std::make_shared<EnumeratorStream>(source->GetEnumerator());
+        }
+
+    public:
+        EnumerablePartitioner(const System::Linq::IEnumerable<T>& source, EnumerablePartitionerOptions options)
+            : StreamPartitioner<T>(options), source(&source)
+        {
+        }
+    };
+
+    // Owns the generator, which runs only once: it can be partitioned a single time
+    template<typename T>
+    class GeneratorPartitioner : public StreamPartitioner<T>
+    {
+    private:
+        using typename StreamPartitioner<T>::Stream;
+
+        class GeneratorStream : public Stream
+        {
+        private:
+            System::Coroutines::Generator<T> generator;
+            typename System::Coroutines::Generator<T>::iterator position;
+            bool started = false;
+
+        protected:
+            bool Read(std::vector<T>& chunk, int count) override
+            {
+                for (; count > 0; --count)
+                {
+                    // The iterator rests on the last element handed out
+                    if (started)
+                    {
+                        ++position;
+                    }
+                    else
+                    {
+                        position = generator.begin();
+                        started = true;
+                    }
+                    if (position == generator.end())
+                    {
+                        return false;
+                    }
+                    chunk.push_back(*position);
+                }
+                return true;
+            }
+
+        public:
+            std::atomic<bool> opened{false};
+
+            explicit GeneratorStream(System::Coroutines::Generator<T>&& generator)
+                : generator(std::move(generator))
+            {
+            }
+        };
+
+        std::shared_ptr<GeneratorStream> stream;
+
+    protected:
+        std::shared_ptr<Stream> Open() const override
+        {
+            if (stream->opened.exchange(true))
+            {
+                throw std::logic_error("A generator can only be partitioned once");
+            }
+            return stream;
+        }
+
+    public:
+        GeneratorPartitioner(System::Coroutines::Generator<T>&& generator, EnumerablePartitionerOptions options)
+            : StreamPartitioner<T>(options), stream(std::make_shared<GeneratorStream>(std::move(generator)))
+        {
+        }
+
+    };
+
+    // Factory methods, as System.Collections.Concurrent.Partitioner
+    class Partitioner
+    {
+    public:
+        // Static ranges of rangeSize indices, by default about three per core
+        template<typename TIndex>
+        static RangePartitioner<TIndex> Create(TIndex fromInclusive, TIndex toExclusive)
+        {
+            static_assert(std::is_integral_v<TIndex>, "Range partitioning needs an integral index");
+            ValidateRange(fromInclusive, toExclusive);
+            long long count = static_cast<long long>(toExclusive) - static_cast<long long>(fromInclusive);
+            long long cores = std::max(1u, std::thread::hardware_concurrency());
+            return RangePartitioner<TIndex>(fromInclusive, toExclusive, std::max(1LL, count / (cores * 3)));
+        }
+
+        template<typename TIndex>
+        static RangePartitioner<TIndex> Create(TIndex fromInclusive, TIndex toExclusive, TIndex rangeSize)
+        {
+            static_assert(std::is_integral_v<TIndex>, "Range partitioning needs an integral index");
+            ValidateRange(fromInclusive, toExclusive);
+            if (rangeSize <= 0)
+            {
+                throw std::out_of_range("rangeSize must be positive");
+            }
+            return RangePartitioner<TIndex>(fromInclusive, toExclusive, rangeSize);
+        }
+
+        // Static blocks, or growing chunks from a shared cursor when loadBalance is set
+        template<typename T>
+        static VectorPartitioner<T> Create(const std::vector<T>& source, bool loadBalance)
+        {
+            return VectorPartitioner<T>(source, loadBalance);
+        }
+
+        template<typename T>
+        static EnumerablePartitioner<T> Create(const System::Linq::IEnumerable<T>& source,
+                                               EnumerablePartitionerOptions options = EnumerablePartitionerOptions::None)
+        {
+            return EnumerablePartitioner<T>(source, options);
+        }
+
+        template<typename T>
+        static GeneratorPartitioner<T> Create(System::Coroutines::Generator<T>&& source,
+                                              EnumerablePartitionerOptions options = EnumerablePartitionerOptions::None)
+        {
+            return GeneratorPartitioner<T>(std::move(source), options);
+        }
+
+    private:
+        template<typename TIndex>
+        static void ValidateRange(TIndex fromInclusive, TIndex toExclusive)
+        {
+            if (toExclusive <= fromInclusive)
+            {
+                throw std::out_of_range("toExclusive must be greater than fromInclusive");
+            }
+        }
+    };
+}
@@ -1,73 +1,86 @@
-
 #pragma once
 
-#include <memory>
-#include <unordered_map>
-#include <thread>
-#include <mutex>
+#include "ExecutionContext.hpp"
+#include <cstdint>
 #include <functional>
+#include <utility>
 
 namespace System {
 namespace Threading {
 
+// Ambient data that flows with asynchronous control flow rather than staying on a
+// thread.
+//
+// The value lives in the current ExecutionContext, so tasks and continuations see
+// what their creator had set, and whatever a task sets is gone again once it
+// returns. set and clear replace the current context with a copy, leaving every
+// context captured earlier as it was.
+//
+// An await resumes with the context it was suspended in. The body of a coroutine
+// runs in its caller's context until that first suspension, so values it sets
+// before then are still visible to the caller.
 template<typename T>
 class AsyncLocal {
 private:
-    static thread_local std::unordered_map<void*, std::shared_ptr<T>> thread_storage;
-    static std::mutex global_mutex;
-    
-    void* key;
+    using Value = detail::AsyncLocalValueOf<T>;
+
+    std::uint64_t key;
     std::function<T()> value_factory;
-    
-public:
-    AsyncLocal() : key(this) {}
-    
-    explicit AsyncLocal(std::function<T()> factory) 
-        : key(this), value_factory(std::move(factory)) {}
-    
-    ~AsyncLocal() {
-        std::lock_guard<std::mutex> lock(global_mutex);
-        thread_storage.erase(key);
+
+    const Value* find() const {
+        return static_cast<const Value*>(detail::find(detail::current_async_locals, key));
+    }
+
+    template<typename U>
+    void store(U&& value) const {
+        auto* node = new Value(std::forward<U>(value));
+        detail::set_current_async_locals(detail::with(detail::current_async_locals, key, node));
     }
-    
+
+public:
+    AsyncLocal() : key(detail::next_async_local_key()) {}
+
+    explicit AsyncLocal(std::function<T()> factory)
+        : key(detail::next_async_local_key()), value_factory(std::move(factory)) {}
+
+    AsyncLocal(const AsyncLocal&) = delete;
+    AsyncLocal& operator=(const AsyncLocal&) = delete;
+
+    // Values already stored stay in the contexts holding them until those go away
+    ~AsyncLocal() = default;
+
     T get() const {
-        auto it = thread_storage.find(key);
-        if (it != thread_storage.end() && it->second) {
-            return *(it->second);
+        if (const Value* value = find()) {
+            return value->value;
         }
-        
+
         if (value_factory) {
             T value = value_factory();
-            thread_storage[key] = std::make_shared<T>(std::move(value));
-            return *(thread_storage[key]);
+            store(value);
+            return value;
         }
-        
+
         return T{};
     }
-    
+
     void set(const T& value) {
-        thread_storage[key] = std::make_shared<T>(value);
+        store(value);
     }
-    
+
     void set(T&& value) {
-        thread_storage[key] = std::make_shared<T>(std::move(value));
+        store(std::move(value));
     }
-    
+
     bool has_value() const {
-        auto it = thread_storage.find(key);
-        return it != thread_storage.end() && it->second != nullptr;
+        return find() != nullptr;
     }
-    
+
     void clear() {
-        thread_storage.erase(key);
+        if (find()) {
+            detail::set_current_async_locals(detail::without(detail::current_async_locals, key));
+        }
     }
 };
 
-template<typename T>
-thread_local std::unordered_map<void*, std::shared_ptr<T>> AsyncLocal<T>::thread_storage;
-
-template<typename T>
-std::mutex AsyncLocal<T>::global_mutex;
-
 } // namespace Threading
 } // namespace System
@@ -1,51 +1,103 @@
-
 #pragma once
 
+#include "Structures.hpp"
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
 #include <functional>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 namespace System {
 namespace Threading {
 
 class BarrierPostPhaseException : public std::runtime_error {
 public:
-    explicit BarrierPostPhaseException(const std::string& message) 
+    explicit BarrierPostPhaseException(const std::string& message)
         : std::runtime_error(message) {}
 };
 
+// How waiters are released at the end of a phase
+enum class BarrierMode {
+    // Every waiter parks on one word and is woken by a single notify_all
+    Flat,
+    // Waiters park on per-group words, and the groups are woken down a tree so
+    // the wake-ups run in parallel rather than all from the last arriver
+    Tree
+};
+
+namespace detail {
+
+// Stable per-thread number used to spread threads over a barrier's groups
+inline unsigned barrier_thread_index() {
+    static std::atomic<unsigned> next_index{0};
+    thread_local unsigned index = next_index.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+} // namespace detail
+
+// Sense-reversing barrier on atomic wait/notify.
+//
+// Arrival is one fetch_sub on a word that packs the participant count, the
+// participants still to arrive and the phase's sense bit, so the common path
+// takes no lock. The last arriver runs the post-phase action, advances the phase
+// and resets the word with the sense flipped, then releases the waiters: they
+// spin briefly on their group's word and otherwise park on it with
+// std::atomic::wait. Timed waits park on a condition variable instead, since
+// atomic waits cannot time out, and withdraw their arrival if the phase does not
+// complete in time.
 class Barrier {
 private:
-    mutable std::mutex mutex_;
-    std::condition_variable condition_;
-    std::atomic<int> participant_count_;
-    std::atomic<int> current_phase_number_;
-    int remaining_participants_;
+    static constexpr int TREE_GROUP_SIZE = 8;
+    static constexpr int TREE_FAN_OUT = 4;
+    static constexpr std::uint64_t SENSE_BIT = 1ull << 63;
+    static constexpr std::uint64_t COUNT_MASK = 0x7fffffffull;
+    
+    struct alignas(64) ReleaseGroup {
+        // Low 32 bits of the last phase number released to this group
+        std::atomic<int> phase{0};
+        std::atomic<int> sleepers{0};
+        // Last phase whose release this group has passed on to its children
+        std::atomic<int> claimed{0};
+    };
+    
+    // sense (bit 63) | participants (bits 32-62) | remaining (bits 0-30)
+    std::atomic<std::uint64_t> state_;
+    std::atomic<long long> current_phase_number_;
+    std::vector<ReleaseGroup> groups_;
     std::function<void(Barrier&)> post_phase_action_;
-    bool disposed_;
+    std::atomic<bool> disposed_;
+    AdaptiveSpin spinner_;
     
+    // Timed waiters only
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::atomic<int> timed_waiters_;
+
 public:
     explicit Barrier(int participantCount)
-        : participant_count_(participantCount)
-        , current_phase_number_(0)
-        , remaining_participants_(participantCount)
-        , disposed_(false) {
-        if (participantCount <= 0) {
-            throw std::invalid_argument("participantCount must be positive");
-        }
-    }
+        : Barrier(participantCount, nullptr) {}
     
     Barrier(int participantCount, std::function<void(Barrier&)> postPhaseAction)
-        : participant_count_(participantCount)
+        : Barrier(participantCount, std::move(postPhaseAction), BarrierMode::Flat) {}
+    
+    Barrier(int participantCount, std::function<void(Barrier&)> postPhaseAction, BarrierMode mode)
+        : state_(0)
         , current_phase_number_(0)
-        , remaining_participants_(participantCount)
+        , groups_(mode == BarrierMode::Tree ? group_count_for(participantCount) : 1)
         , post_phase_action_(std::move(postPhaseAction))
-        , disposed_(false) {
+        , disposed_(false)
+        , timed_waiters_(0) {
         if (participantCount <= 0) {
             throw std::invalid_argument("participantCount must be positive");
         }
+        std::uint64_t count = static_cast<std::uint64_t>(participantCount);
+        state_.store((count << 32) | count, std::memory_order_relaxed);
     }
     
     ~Barrier() {
@@ -53,150 +105,304 @@ public:
     }
     
     void signal_and_wait() {
-        std::unique_lock<std::mutex> lock(mutex_);
-        
-        if (disposed_) {
-            throw std::runtime_error("Barrier has been disposed");
+        long long phase;
+        if (arrive(phase)) {
+            return;
         }
         
-        int current_phase = current_phase_number_.load();
-        --remaining_participants_;
-        
-        if (remaining_participants_ == 0) {
-            // Last participant - trigger phase completion
-            remaining_participants_ = participant_count_.load();
-            current_phase_number_.fetch_add(1);
-            
-            // Execute post-phase action if provided
-            if (post_phase_action_) {
-                try {
-                    post_phase_action_(*this);
-                } catch (...) {
-                    condition_.notify_all();
-                    throw BarrierPostPhaseException("Post-phase action threw an exception");
+        ReleaseGroup& group = groups_[detail::barrier_thread_index() % groups_.size()];
+        int target = static_cast<int>(phase + 1);
+        if (!spinner_.spin_until([this, &group, target]() { return reached(group.phase.load(), target) || disposed_.load(); })) {
+            group.sleepers.fetch_add(1);
+            for (;;) {
+                int observed = group.phase.load();
+                if (disposed_.load()) {
+                    group.sleepers.fetch_sub(1);
+                    throw std::runtime_error("Barrier has been disposed");
                 }
+                if (reached(observed, target)) {
+                    break;
+                }
+                group.phase.wait(observed);
+                // Whoever wakes first passes the release on, whichever phase it was for
+                propagate(group_index(group), group.phase.load());
             }
-            
-            condition_.notify_all();
-        } else {
-            // Wait for phase completion
-            condition_.wait(lock, [this, current_phase]() {
-                return current_phase_number_.load() > current_phase || disposed_;
-            });
-            
-            if (disposed_) {
-                throw std::runtime_error("Barrier has been disposed");
-            }
+            group.sleepers.fetch_sub(1);
+        }
+        if (disposed_.load()) {
+            throw std::runtime_error("Barrier has been disposed");
         }
+        propagate(group_index(group), target);
     }
     
     bool signal_and_wait(int millisecondsTimeout) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        
-        if (disposed_) {
-            throw std::runtime_error("Barrier has been disposed");
+        if (millisecondsTimeout < -1) {
+            throw std::invalid_argument("millisecondsTimeout must be -1 (Infinite) or greater");
+        }
+        if (millisecondsTimeout == -1) {
+            signal_and_wait();
+            return true;
         }
         
-        int current_phase = current_phase_number_.load();
-        --remaining_participants_;
+        std::uint64_t arrived_state = 0;
+        long long phase;
+        if (arrive(phase, &arrived_state)) {
+            return true;
+        }
         
-        if (remaining_participants_ == 0) {
-            // Last participant - trigger phase completion
-            remaining_participants_ = participant_count_.load();
-            current_phase_number_.fetch_add(1);
-            
-            // Execute post-phase action if provided
-            if (post_phase_action_) {
-                try {
-                    post_phase_action_(*this);
-                } catch (...) {
-                    condition_.notify_all();
-                    throw BarrierPostPhaseException("Post-phase action threw an exception");
-                }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(millisecondsTimeout);
+        // Completion is the sense flip rather than the phase number: finish_phase
+        // advances the number before it re-arms the count, and a waiter leaving on
+        // the number could arrive again on the spent word
+        std::uint64_t sense = arrived_state & SENSE_BIT;
+        auto completed = [this, sense]() { return (state_.load() & SENSE_BIT) != sense; };
+        if (spinner_.spin_until([&completed, this]() { return completed() || disposed_.load(); })) {
+            if (disposed_.load()) {
+                throw std::runtime_error("Barrier has been disposed");
             }
-            
-            condition_.notify_all();
             return true;
-        } else {
-            // Wait for phase completion with timeout
-            auto timeout = std::chrono::milliseconds(millisecondsTimeout);
-            bool result = condition_.wait_for(lock, timeout, [this, current_phase]() {
-                return current_phase_number_.load() > current_phase || disposed_;
-            });
-            
-            if (disposed_) {
-                throw std::runtime_error("Barrier has been disposed");
+        }
+        
+        {
+            timed_waiters_.fetch_add(1);
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait_until(lock, deadline, [&completed, this]() { return completed() || disposed_.load(); });
+            timed_waiters_.fetch_sub(1);
+        }
+        if (disposed_.load()) {
+            throw std::runtime_error("Barrier has been disposed");
+        }
+        if (completed()) {
+            return true;
+        }
+        
+        // Timed out: take the arrival back unless the phase is already completing
+        std::uint64_t state = state_.load();
+        for (;;) {
+            if ((state & SENSE_BIT) != sense) {
+                return true;
+            }
+            if (remaining(state) == 0) {
+                wait_for_rearm();
+                return true;
+            }
+            if (state_.compare_exchange_weak(state, state + 1)) {
+                return false;
             }
-            
-            return result;
         }
     }
     
     long add_participant() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        if (disposed_) {
-            throw std::runtime_error("Barrier has been disposed");
+        throw_if_disposed();
+        for (;;) {
+            std::uint64_t state = state_.load();
+            if (remaining(state) == 0 && participants(state) > 0) {
+                // The last arriver is finishing the phase; join the next one
+                wait_for_rearm();
+                continue;
+            }
+            if (state_.compare_exchange_weak(state, state + (1ull << 32) + 1)) {
+                return static_cast<long>(participants(state) + 1);
+            }
         }
-        
-        participant_count_.fetch_add(1);
-        ++remaining_participants_;
-        
-        return participant_count_.load();
     }
     
     void remove_participant() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        if (disposed_) {
-            throw std::runtime_error("Barrier has been disposed");
-        }
-        
-        if (participant_count_.load() <= 0) {
-            throw std::runtime_error("No participants to remove");
-        }
-        
-        participant_count_.fetch_sub(1);
-        --remaining_participants_;
-        
-        // If this was the last participant needed, complete the phase
-        if (remaining_participants_ == 0 && participant_count_.load() > 0) {
-            remaining_participants_ = participant_count_.load();
-            current_phase_number_.fetch_add(1);
+        throw_if_disposed();
+        for (;;) {
+            std::uint64_t state = state_.load();
+            if (participants(state) == 0) {
+                throw std::runtime_error("No participants to remove");
+            }
+            if (remaining(state) == 0) {
+                wait_for_rearm();
+                continue;
+            }
             
-            if (post_phase_action_) {
-                try {
-                    post_phase_action_(*this);
-                } catch (...) {
-                    condition_.notify_all();
-                    throw BarrierPostPhaseException("Post-phase action threw an exception");
+            std::uint64_t updated = state - (1ull << 32) - 1;
+            if (state_.compare_exchange_weak(state, updated)) {
+                // If everyone else has arrived, the removal completes the phase. Only
+                // read the phase now: finish_phase stores it before re-arming the word
+                // the CAS succeeded on, and nobody else can advance it from here, while
+                // a read before the CAS could be a phase or two stale (the word repeats
+                // every second phase)
+                if (remaining(updated) == 0 && participants(updated) > 0) {
+                    finish_phase(current_phase_number_.load(), updated);
                 }
+                return;
             }
-            
-            condition_.notify_all();
         }
     }
     
     int get_participant_count() const {
-        return participant_count_.load();
+        return static_cast<int>(participants(state_.load()));
     }
     
     int get_participants_remaining() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return remaining_participants_;
+        return static_cast<int>(remaining(state_.load()));
     }
     
     long get_current_phase_number() const {
-        return current_phase_number_.load();
+        return static_cast<long>(current_phase_number_.load());
+    }
+    
+    BarrierMode get_mode() const {
+        return groups_.size() > 1 ? BarrierMode::Tree : BarrierMode::Flat;
     }
     
+    // Wakes every waiter, which then throws
     void dispose() {
+        if (disposed_.exchange(true)) {
+            return;
+        }
+        for (auto& group : groups_) {
+            // Change the word so atomic waits return; waiters check disposed_ first
+            group.phase.fetch_xor(static_cast<int>(0x80000000u));
+            group.phase.notify_all();
+        }
         std::lock_guard<std::mutex> lock(mutex_);
-        if (!disposed_) {
-            disposed_ = true;
+        condition_.notify_all();
+    }
+
+private:
+    static int group_count_for(int participantCount) {
+        int count = (participantCount + TREE_GROUP_SIZE - 1) / TREE_GROUP_SIZE;
+        return count > 1 ? count : 1;
+    }
+    
+    static std::uint64_t participants(std::uint64_t state) {
+        return (state >> 32) & COUNT_MASK;
+    }
+    
+    static std::uint64_t remaining(std::uint64_t state) {
+        return state & COUNT_MASK;
+    }
+    
+    // Phase numbers wrap in the 32-bit words; compare them modulo 2^32
+    static bool reached(int observed, int target) {
+        return static_cast<int>(static_cast<unsigned>(observed) - static_cast<unsigned>(target)) >= 0;
+    }
+    
+    std::size_t group_index(const ReleaseGroup& group) const {
+        return static_cast<std::size_t>(&group - groups_.data());
+    }
+    
+    void throw_if_disposed() const {
+        if (disposed_.load()) {
+            throw std::runtime_error("Barrier has been disposed");
+        }
+    }
+    
+    // Counts this thread in. Returns true if it was the last to arrive (the phase is
+    // then finished); otherwise phase is the phase it is waiting on.
+    bool arrive(long long& phase, std::uint64_t* arrived_state = nullptr) {
+        throw_if_disposed();
+        std::uint64_t state = state_.fetch_sub(1);
+        if (remaining(state) == 0) {
+            state_.fetch_add(1);
+            throw std::runtime_error("The number of threads using the barrier exceeded the total number of registered participants");
+        }
+        if (arrived_state) {
+            *arrived_state = state;
+        }
+        
+        // The phase is advanced before the sense flips, so a number whose parity
+        // differs from our sense means our phase has already completed
+        phase = current_phase_number_.load();
+        bool sense = (state & SENSE_BIT) != 0;
+        if (((phase & 1) != 0) != sense) {
+            phase -= 1;
+            if (remaining(state) != 1) {
+                return true;
+            }
+        }
+        
+        if (remaining(state) == 1) {
+            finish_phase(phase, state - 1);
+            return true;
+        }
+        return false;
+    }
+    
+    // Runs with every participant arrived and state's remaining count at zero
+    void finish_phase(long long phase, std::uint64_t state) {
+        std::exception_ptr action_error;
+        if (post_phase_action_) {
+            try {
+                post_phase_action_(*this);
+            } catch (...) {
+                action_error = std::current_exception();
+            }
+        }
+        
+        current_phase_number_.store(phase + 1);
+        
+        // Flip the sense and re-arm the count; participants may have been added or
+        // removed while the action ran, so take them from the current word
+        std::uint64_t current = state;
+        std::uint64_t next;
+        do {
+            std::uint64_t count = participants(current);
+            next = ((current & SENSE_BIT) ^ SENSE_BIT) | (count << 32) | count;
+        } while (!state_.compare_exchange_weak(current, next));
+        
+        release(static_cast<int>(phase + 1));
+        
+        if (action_error) {
+            throw BarrierPostPhaseException("Post-phase action threw an exception");
+        }
+    }
+    
+    void release(int target) {
+        // Children have higher indices; storing them first means a waiter that sees
+        // its own group released also sees its children's words released
+        for (std::size_t i = groups_.size(); i-- > 0;) {
+            groups_[i].phase.store(target);
+        }
+        propagate(0, target);
+        
+        if (timed_waiters_.load() > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
             condition_.notify_all();
         }
     }
+    
+    // Wakes group index's sleepers for target and passes the release down: children
+    // with sleepers are notified and carry on from there, empty ones are handled here
+    void propagate(std::size_t index, int target) {
+        ReleaseGroup& group = groups_[index];
+        int claimed = group.claimed.load();
+        do {
+            if (reached(claimed, target)) {
+                return;
+            }
+        } while (!group.claimed.compare_exchange_weak(claimed, target));
+        
+        if (group.sleepers.load() > 0) {
+            group.phase.notify_all();
+        }
+        for (std::size_t child = index * TREE_FAN_OUT + 1; child <= index * TREE_FAN_OUT + TREE_FAN_OUT && child < groups_.size(); ++child) {
+            if (groups_[child].sleepers.load() > 0) {
+                groups_[child].phase.notify_all();
+            } else {
+                propagate(child, target);
+            }
+        }
+    }
+    
+    // Waits out a phase that every participant has reached but whose count has not
+    // been reset yet; the window only spans the post-phase action
+    void wait_for_rearm() {
+        SpinWait spinner;
+        for (;;) {
+            std::uint64_t state = state_.load();
+            if (remaining(state) != 0 || participants(state) == 0) {
+                return;
+            }
+            throw_if_disposed();
+            spinner.spin_once();
+        }
+    }
 };
 
 } // namespace Threading
@@ -4,12 +4,17 @@
 #include "Structures.hpp"
 #include "Enums.hpp"
 #include "Delegates.hpp"
+#include "TimerWheel.hpp"
 #include <memory>
-#include <vector>
 #include <mutex>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <exception>
 #include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace System {
 namespace Threading {
@@ -22,53 +27,205 @@ public:
 
 class CancellationTokenSource;
 
-class CancellationToken {
+namespace detail {
+
+class CancellationState;
+
+// One registered callback, or the link to a linked child source. Shared by the
+// state's list and the registration until both let go: the list drops it once it
+// is run or swept, the registration on dispose.
+struct CancellationCallbackNode {
+    static constexpr std::uint32_t Registered = 0;
+    static constexpr std::uint32_t Unregistered = 1;
+    static constexpr std::uint32_t Executing = 2;
+    static constexpr std::uint32_t Executed = 3;
+    
+    std::atomic<std::uint32_t> refs{2};
+    std::atomic<std::uint32_t> state{Registered};
+    CancellationCallbackNode* next = nullptr;
+    CancellationCallback callback;
+    // Canceled along with the list's owner; holds a reference
+    CancellationState* child = nullptr;
+    
+    explicit CancellationCallbackNode(CancellationCallback cb) : callback(std::move(cb)) {}
+    explicit CancellationCallbackNode(CancellationState* linked);
+    ~CancellationCallbackNode();
+    
+    CancellationCallbackNode(const CancellationCallbackNode&) = delete;
+    CancellationCallbackNode& operator=(const CancellationCallbackNode&) = delete;
+    
+    void release() noexcept {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+};
+
+// The state one CancellationTokenSource shares with all of its tokens,
+// intrusively reference counted so that a token is a single pointer.
+//
+// Callbacks form an intrusive Treiber stack: registering is one CAS push, and
+// unregistering is one CAS on the node's own state, which leaves it in the list
+// as a tombstone. Tombstones are swept out in batches once they outnumber the
+// live callbacks, so unregistration stays O(1) amortized and the list stays
+// bounded. Cancelling swaps the whole list for a marker, after which callbacks
+// registered late run inline. The sweep and the cancel are the only walks over
+// the list and exclude each other through a flag; nothing else ever blocks.
+//
+// Linked sources hang off their parents' lists as child links rather than as
+// callbacks. Cancelling walks the whole tree below the state in one iterative
+// pass: each child is marked canceled as soon as its link is reached, and its own
+// list is run later in the same pass, so deep and wide trees cost no recursion.
+class CancellationState {
 private:
-    struct CallbackRegistration {
-        CancellationCallback callback;
-        void* state;
-        bool execute_synchronously;
-        
-        CallbackRegistration(CancellationCallback cb, void* st, bool sync)
-            : callback(std::move(cb)), state(st), execute_synchronously(sync) {}
-    };
+    static constexpr std::int32_t MinimumSweep = 16;
+    
+    std::atomic<std::uint32_t> refs_{1};
+    std::atomic<bool> canceled_;
+    std::atomic<CancellationCallbackNode*> head_{nullptr};
+    std::atomic<bool> walking_{false};
+    // Unregistered nodes still linked; may dip below zero while a sweep races an unregister
+    std::atomic<std::int32_t> tombstones_{0};
+    std::atomic<std::int32_t> sweep_threshold_{MinimumSweep};
+    // Written before the cancelling thread claims any callback
+    std::thread::id cancelling_thread_;
+    // Next state to free while destroying a chain of linked states
+    CancellationState* next_destroyed_ = nullptr;
+    
+    static CancellationCallbackNode* canceled_marker() noexcept {
+        static CancellationCallbackNode marker{CancellationCallback()};
+        return &marker;
+    }
+    
+    void lock_walk() noexcept;
+    void unlock_walk() noexcept {
+        walking_.store(false, std::memory_order_release);
+    }
+    void sweep() noexcept;
+    
+    // Frees the state and any linked states only its list kept alive, iteratively
+    static void destroy(CancellationState* state) noexcept;
+    
+    bool try_mark_canceled() noexcept {
+        bool expected = false;
+        return canceled_.compare_exchange_strong(expected, true, std::memory_order_acq_rel);
+    }
+    
+    // Runs the list of a state just marked canceled; the links to the children it
+    // marks are queued on pending, each still holding the list's reference
+    void notify(std::vector<CancellationCallbackNode*>& pending);
+    
+    CancellationCallbackNode* push(CancellationCallbackNode* node);
+
+public:
+    explicit CancellationState(bool canceled = false) : canceled_(canceled) {}
+    
+    CancellationState(const CancellationState&) = delete;
+    CancellationState& operator=(const CancellationState&) = delete;
+    
+    void add_ref() noexcept {
+        refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    void release() noexcept {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            destroy(this);
+        }
+    }
+    
+    bool is_canceled() const noexcept {
+        return canceled_.load(std::memory_order_acquire);
+    }
     
-    std::shared_ptr<std::atomic<bool>> is_canceled_;
-    std::shared_ptr<std::mutex> callbacks_mutex_;
-    std::shared_ptr<std::vector<std::shared_ptr<CallbackRegistration>>> callbacks_;
+    // Marks the state canceled and runs the registered callbacks, newest first, on
+    // this thread. False if it was already canceled.
+    bool cancel();
+    
+    // Queues callback, or runs it right away and returns null once canceled
+    CancellationCallbackNode* register_callback(CancellationCallback callback);
+    
+    // Links child so that it is canceled with this state, or cancels it right
+    // away and returns null once this state is canceled
+    CancellationCallbackNode* register_child(CancellationState* child);
+    
+    // Drops the registration's reference to node after making sure its callback
+    // will not run, or waiting for it to return if it is running elsewhere
+    void unregister(CancellationCallbackNode* node) noexcept;
+    
+    // The state behind every pre-canceled token; never destroyed
+    static CancellationState* canceled_state() noexcept {
+        static CancellationState* state = new CancellationState(true);
+        return state;
+    }
+};
+
+} // namespace detail
+
+// A handle on the cancellation state of a CancellationTokenSource.
+//
+// A token is one pointer: none() and default-constructed tokens are null, and
+// copying a real token is a single reference count increment, so tokens can be
+// passed by value through every layer.
+class CancellationToken {
+private:
+    detail::CancellationState* state_ = nullptr;
     
     friend class CancellationTokenSource;
     
-    CancellationToken(std::shared_ptr<std::atomic<bool>> canceled,
-                     std::shared_ptr<std::mutex> mutex,
-                     std::shared_ptr<std::vector<std::shared_ptr<CallbackRegistration>>> callbacks)
-        : is_canceled_(std::move(canceled))
-        , callbacks_mutex_(std::move(mutex))
-        , callbacks_(std::move(callbacks)) {}
+    // Adopts the reference
+    explicit CancellationToken(detail::CancellationState* state) noexcept : state_(state) {}
+    
+    // Cancels child along with this token until the registration is disposed
+    CancellationTokenRegistration register_child(detail::CancellationState* child) const {
+        detail::CancellationCallbackNode* node = state_->register_child(child);
+        if (!node) {
+            return CancellationTokenRegistration{};
+        }
+        state_->add_ref();
+        return CancellationTokenRegistration(state_, node);
+    }
     
 public:
     // Default constructor creates a token that will never be canceled
-    CancellationToken() 
-        : is_canceled_(std::make_shared<std::atomic<bool>>(false))
-        , callbacks_mutex_(std::make_shared<std::mutex>())
-        , callbacks_(std::make_shared<std::vector<std::shared_ptr<CallbackRegistration>>>()) {}
+    CancellationToken() noexcept = default;
     
     // Constructor for pre-canceled token
-    explicit CancellationToken(bool canceled)
-        : is_canceled_(std::make_shared<std::atomic<bool>>(canceled))
-        , callbacks_mutex_(std::make_shared<std::mutex>())
-        , callbacks_(std::make_shared<std::vector<std::shared_ptr<CallbackRegistration>>>()) {}
+    explicit CancellationToken(bool canceled) noexcept {
+        if (canceled) {
+            state_ = detail::CancellationState::canceled_state();
+            state_->add_ref();
+        }
+    }
     
-    // Copy constructor and assignment
-    CancellationToken(const CancellationToken&) = default;
-    CancellationToken& operator=(const CancellationToken&) = default;
+    CancellationToken(const CancellationToken& other) noexcept : state_(other.state_) {
+        if (state_) {
+            state_->add_ref();
+        }
+    }
     
-    // Move constructor and assignment
-    CancellationToken(CancellationToken&&) = default;
-    CancellationToken& operator=(CancellationToken&&) = default;
+    CancellationToken(CancellationToken&& other) noexcept : state_(other.state_) {
+        other.state_ = nullptr;
+    }
+    
+    CancellationToken& operator=(const CancellationToken& other) noexcept {
+        CancellationToken copy(other);
+        std::swap(state_, copy.state_);
+        return *this;
+    }
+    
+    CancellationToken& operator=(CancellationToken&& other) noexcept {
+        std::swap(state_, other.state_);
+        return *this;
+    }
+    
+    ~CancellationToken() {
+        if (state_) {
+            state_->release();
+        }
+    }
     
     bool is_cancellation_requested() const {
-        return is_canceled_->load();
+        return state_ && state_->is_canceled();
     }
     
     bool can_be_canceled() const {
@@ -81,107 +238,88 @@ public:
         }
     }
     
-    CancellationTokenRegistration register_callback(CancellationCallback callback) {
+    CancellationTokenRegistration register_callback(CancellationCallback callback) const {
         return register_callback(std::move(callback), nullptr, false);
     }
     
-    CancellationTokenRegistration register_callback(CancellationCallback callback, void* state) {
+    CancellationTokenRegistration register_callback(CancellationCallback callback, void* state) const {
         return register_callback(std::move(callback), state, false);
     }
     
+    // Runs callback inline if the token is already canceled, and never for a token
+    // that cannot be canceled
     CancellationTokenRegistration register_callback(CancellationCallback callback, 
                                                    void* state, 
-                                                   bool use_synchronization_context) {
-        if (!callback) {
+                                                   bool use_synchronization_context) const {
+        (void)state;
+        (void)use_synchronization_context;
+        if (!callback || !state_) {
             return CancellationTokenRegistration{};
         }
         
-        auto registration = std::make_shared<CallbackRegistration>(
-            std::move(callback), state, use_synchronization_context);
-        
-        {
-            std::lock_guard<std::mutex> lock(*callbacks_mutex_);
-            
-            // If already canceled, execute callback immediately
-            if (is_canceled_->load()) {
-                try {
-                    registration->callback();
-                } catch (...) {
-                    // Ignore exceptions in callbacks
-                }
-                return CancellationTokenRegistration{};
-            }
-            
-            callbacks_->push_back(registration);
+        detail::CancellationCallbackNode* node = state_->register_callback(std::move(callback));
+        if (!node) {
+            return CancellationTokenRegistration{};
         }
-        
-        return CancellationTokenRegistration(registration, 
-                                           std::weak_ptr<CancellationToken>(
-                                               std::shared_ptr<CancellationToken>(
-                                                   const_cast<CancellationToken*>(this), 
-                                                   [](CancellationToken*){})));
+        state_->add_ref();
+        return CancellationTokenRegistration(state_, node);
     }
     
     // Static factory methods
-    static CancellationToken none() {
-        static CancellationToken never_canceled(false);
-        return never_canceled;
+    static CancellationToken none() noexcept {
+        return CancellationToken();
     }
     
-    static CancellationToken canceled() {
+    static CancellationToken canceled() noexcept {
         return CancellationToken(true);
     }
     
     // Equality operators
     bool operator==(const CancellationToken& other) const {
-        return is_canceled_ == other.is_canceled_;
+        return state_ == other.state_;
     }
     
     bool operator!=(const CancellationToken& other) const {
         return !(*this == other);
     }
-    
-private:
-    void execute_callbacks() {
-        std::lock_guard<std::mutex> lock(*callbacks_mutex_);
-        
-        for (auto& registration : *callbacks_) {
-            if (registration) {
-                try {
-                    registration->callback();
-                } catch (...) {
-                    // Ignore exceptions in callbacks
-                }
-            }
-        }
-        
-        callbacks_->clear();
-    }
-    
-    void remove_callback(std::shared_ptr<CallbackRegistration> registration) {
-        std::lock_guard<std::mutex> lock(*callbacks_mutex_);
-        
-        auto it = std::find(callbacks_->begin(), callbacks_->end(), registration);
-        if (it != callbacks_->end()) {
-            callbacks_->erase(it);
-        }
-    }
-    
-    friend struct CancellationTokenRegistration;
 };
 
 class CancellationTokenSource {
 private:
     CancellationToken token_;
     std::atomic<bool> disposed_;
+    std::mutex timer_mutex_;
+    TimerWheel::Handle timer_;
+    // A linked source's links in the lists of its parents
+    std::vector<CancellationTokenRegistration> links_;
+    
+    // Tokens that can never be canceled need no link
+    void link(const CancellationToken& parent) {
+        if (!parent.state_) {
+            return;
+        }
+        CancellationTokenRegistration registration = parent.register_child(token_.state_);
+        if (registration.is_valid()) {
+            links_.push_back(std::move(registration));
+        }
+    }
     
 public:
     CancellationTokenSource() 
-        : token_(std::make_shared<std::atomic<bool>>(false),
-                std::make_shared<std::mutex>(),
-                std::make_shared<std::vector<std::shared_ptr<CancellationToken::CallbackRegistration>>>())
+        : token_(new detail::CancellationState())
         , disposed_(false) {}
     
+    explicit CancellationTokenSource(int millisecondsDelay)
+        : CancellationTokenSource() {
+        cancel_after(millisecondsDelay);
+    }
+    
+    template<typename Rep, typename Period>
+    explicit CancellationTokenSource(const std::chrono::duration<Rep, Period>& delay)
+        : CancellationTokenSource() {
+        cancel_after(delay);
+    }
+    
     ~CancellationTokenSource() {
         dispose();
     }
@@ -193,7 +331,10 @@ public:
     // Move constructor and assignment
     CancellationTokenSource(CancellationTokenSource&& other) noexcept
         : token_(std::move(other.token_))
-        , disposed_(other.disposed_.load()) {
+        , disposed_(other.disposed_.load())
+        , links_(std::move(other.links_)) {
+        std::lock_guard<std::mutex> lock(other.timer_mutex_);
+        timer_ = std::move(other.timer_);
         other.disposed_.store(true);
     }
     
@@ -202,6 +343,11 @@ public:
             dispose();
             token_ = std::move(other.token_);
             disposed_.store(other.disposed_.load());
+            links_ = std::move(other.links_);
+            {
+                std::scoped_lock lock(timer_mutex_, other.timer_mutex_);
+                timer_ = std::move(other.timer_);
+            }
             other.disposed_.store(true);
         }
         return *this;
@@ -219,10 +365,7 @@ public:
             throw std::runtime_error("CancellationTokenSource has been disposed");
         }
         
-        bool expected = false;
-        if (token_.is_canceled_->compare_exchange_strong(expected, true)) {
-            token_.execute_callbacks();
-        }
+        token_.state_->cancel();
     }
     
     void cancel(bool throw_on_first_exception) {
@@ -237,6 +380,36 @@ public:
         }
     }
     
+    // Schedules cancellation on the shared timer wheel; a later call replaces the
+    // pending one. -1 stops a pending cancellation.
+    void cancel_after(int millisecondsDelay) {
+        if (disposed_.load()) {
+            throw std::runtime_error("CancellationTokenSource has been disposed");
+        }
+        if (millisecondsDelay < -1) {
+            throw std::out_of_range("millisecondsDelay must be -1 or greater");
+        }
+        if (token_.is_cancellation_requested()) {
+            return;
+        }
+        
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        if (timer_) {
+            TimerWheel::instance().change(timer_, millisecondsDelay);
+            return;
+        }
+        
+        // The entry holds the token, not the source, so a moved or destroyed source is never touched
+        timer_ = TimerWheel::instance().schedule([token = token_]() {
+            token.state_->cancel();
+        }, millisecondsDelay);
+    }
+    
+    template<typename Rep, typename Period>
+    void cancel_after(const std::chrono::duration<Rep, Period>& delay) {
+        cancel_after(static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(delay).count()));
+    }
+    
     bool is_cancellation_requested() const {
         return !disposed_.load() && token_.is_cancellation_requested();
     }
@@ -245,24 +418,24 @@ public:
         if (!disposed_.exchange(true)) {
             // Mark as disposed but don't cancel automatically
             // The token remains valid but the source cannot be used to cancel it
+            {
+                std::lock_guard<std::mutex> lock(timer_mutex_);
+                if (timer_) {
+                    TimerWheel::instance().cancel(timer_);
+                    timer_.reset();
+                }
+            }
+            links_.clear();
         }
     }
     
     // Static factory methods
+    //
+    // A linked source is canceled when any of its parents is, or right away if one
+    // already is. Disposing it unlinks it from every parent.
     static CancellationTokenSource create_linked_token_source(const CancellationToken& token) {
         CancellationTokenSource source;
-        
-        if (token.is_cancellation_requested()) {
-            source.cancel();
-        } else {
-            // Register callback to cancel this source when the linked token is canceled
-            token.register_callback([&source]() {
-                if (!source.disposed_.load()) {
-                    source.cancel();
-                }
-            });
-        }
-        
+        source.link(token);
         return source;
     }
     
@@ -271,37 +444,30 @@ public:
                                                              const CancellationToken& token2,
                                                              const Tokens&... tokens) {
         CancellationTokenSource source;
-        
-        auto register_token = [&source](const CancellationToken& token) {
-            if (token.is_cancellation_requested()) {
-                source.cancel();
-            } else {
-                token.register_callback([&source]() {
-                    if (!source.disposed_.load()) {
-                        source.cancel();
-                    }
-                });
-            }
-        };
-        
-        register_token(token1);
-        register_token(token2);
-        (register_token(tokens), ...);
-        
+        source.link(token1);
+        source.link(token2);
+        (source.link(tokens), ...);
+        return source;
+    }
+    
+    static CancellationTokenSource create_linked_token_source(const std::vector<CancellationToken>& tokens) {
+        CancellationTokenSource source;
+        source.links_.reserve(tokens.size());
+        for (const CancellationToken& token : tokens) {
+            source.link(token);
+        }
         return source;
     }
 };
 
 // Implementation of CancellationTokenRegistration::dispose()
 inline void CancellationTokenRegistration::dispose() {
-    if (registration_handle_ && !token_.expired()) {
-        if (auto token = token_.lock()) {
-            auto registration = std::static_pointer_cast<CancellationToken::CallbackRegistration>(registration_handle_);
-            token->remove_callback(registration);
-        }
+    if (node_) {
+        state_->unregister(node_);
+        state_->release();
+        node_ = nullptr;
+        state_ = nullptr;
     }
-    registration_handle_.reset();
-    token_.reset();
 }
 
 } // namespace Threading
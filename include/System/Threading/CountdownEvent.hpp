@@ -1,28 +1,42 @@
-
 #pragma once
 
+#include "Structures.hpp"
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <stdexcept>
 
 namespace System {
 namespace Threading {
 
+// The count and the waiter bookkeeping share one atomic word, so signal is a
+// single fetch_sub and the signal that reaches zero learns from its own result
+// whether anybody needs waking. Untimed waiters park on the word with
+// std::atomic::wait; timed waiters, which atomic::wait cannot serve, block on a
+// condition variable. A fan-in with nobody blocked never enters the kernel.
 class CountdownEvent {
 private:
-    mutable std::mutex mutex_;
-    std::condition_variable condition_;
-    std::atomic<int> current_count_;
-    int initial_count_;
-    bool disposed_;
+    // Layout of state_: flag bits, then the signed count above them
+    static constexpr std::int64_t HAS_WAITERS = 1;
+    static constexpr std::int64_t HAS_TIMED_WAITERS = 2;
+    static constexpr std::int64_t DISPOSED = 4;
+    static constexpr std::int64_t WAITER_FLAGS = HAS_WAITERS | HAS_TIMED_WAITERS;
+    static constexpr int COUNT_SHIFT = 3;
+    static constexpr std::int64_t COUNT_UNIT = std::int64_t(1) << COUNT_SHIFT;
     
+    std::atomic<std::int64_t> state_;
+    std::atomic<int> initial_count_;
+    // Timed waits only
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    AdaptiveSpin spinner_;
+
 public:
     explicit CountdownEvent(int initialCount)
-        : current_count_(initialCount)
-        , initial_count_(initialCount)
-        , disposed_(false) {
+        : state_(std::int64_t(initialCount) << COUNT_SHIFT)
+        , initial_count_(initialCount) {
         if (initialCount < 0) {
             throw std::invalid_argument("initialCount cannot be negative");
         }
@@ -33,61 +47,81 @@ public:
     }
     
     void wait() {
-        std::unique_lock<std::mutex> lock(mutex_);
-        condition_.wait(lock, [this]() {
-            return current_count_.load() == 0 || disposed_;
-        });
+        if (spin_until_set()) {
+            return;
+        }
+        
+        std::int64_t observed = state_.load();
+        while (!is_released(observed)) {
+            if (!(observed & HAS_WAITERS)) {
+                // Only while the count is positive, so the signal that reaches
+                // zero is sure to see the flag
+                if (!state_.compare_exchange_weak(observed, observed | HAS_WAITERS)) {
+                    continue;
+                }
+                observed |= HAS_WAITERS;
+            }
+            state_.wait(observed);
+            observed = state_.load();
+        }
         
-        if (disposed_) {
+        if (observed & DISPOSED) {
             throw std::runtime_error("CountdownEvent has been disposed");
         }
     }
     
     bool wait(int millisecondsTimeout) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        auto timeout = std::chrono::milliseconds(millisecondsTimeout);
-        
-        bool result = condition_.wait_for(lock, timeout, [this]() {
-            return current_count_.load() == 0 || disposed_;
-        });
-        
-        if (disposed_) {
-            throw std::runtime_error("CountdownEvent has been disposed");
-        }
-        
-        return result && current_count_.load() == 0;
+        return wait(std::chrono::milliseconds(millisecondsTimeout));
     }
     
     template<typename Rep, typename Period>
     bool wait(const std::chrono::duration<Rep, Period>& timeout) {
+        if (spin_until_set()) {
+            return true;
+        }
+        
+        auto deadline = std::chrono::steady_clock::now() + timeout;
         std::unique_lock<std::mutex> lock(mutex_);
         
-        bool result = condition_.wait_for(lock, timeout, [this]() {
-            return current_count_.load() == 0 || disposed_;
+        std::int64_t observed = state_.load();
+        while (!is_released(observed) && !(observed & HAS_TIMED_WAITERS)) {
+            if (state_.compare_exchange_weak(observed, observed | HAS_TIMED_WAITERS)) {
+                break;
+            }
+        }
+        
+        condition_.wait_until(lock, deadline, [this]() {
+            return is_released(state_.load());
         });
         
-        if (disposed_) {
+        // A release that saw the flag still has to pass through the mutex;
+        // wait it out so that returning cannot race the event's destruction
+        condition_.wait(lock, [this, &observed]() {
+            observed = state_.load();
+            return !is_released(observed) || !(observed & HAS_TIMED_WAITERS);
+        });
+        
+        if (observed & DISPOSED) {
             throw std::runtime_error("CountdownEvent has been disposed");
         }
         
-        return result && current_count_.load() == 0;
+        return count_of(observed) <= 0;
     }
     
     bool signal() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        if (disposed_) {
-            throw std::runtime_error("CountdownEvent has been disposed");
-        }
+        throw_if_disposed();
         
-        if (current_count_.load() <= 0) {
+        std::int64_t previous = state_.fetch_sub(COUNT_UNIT);
+        std::int64_t count = count_of(previous);
+        if (count <= 0) {
+            // Already set: undo. The count dips below zero only meanwhile,
+            // which every reader treats as zero.
+            state_.fetch_add(COUNT_UNIT);
             return false;
         }
         
-        int new_count = current_count_.fetch_sub(1) - 1;
-        
-        if (new_count == 0) {
-            condition_.notify_all();
+        if (count == 1) {
+            wake_waiters(previous);
         }
         
         return true;
@@ -98,21 +132,17 @@ public:
             throw std::invalid_argument("signalCount must be positive");
         }
         
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        if (disposed_) {
-            throw std::runtime_error("CountdownEvent has been disposed");
-        }
-        
-        int current = current_count_.load();
-        if (current < signalCount) {
-            return false;
-        }
+        throw_if_disposed();
         
-        int new_count = current_count_.fetch_sub(signalCount) - signalCount;
+        std::int64_t previous = state_.load();
+        do {
+            if (count_of(previous) < signalCount) {
+                return false;
+            }
+        } while (!state_.compare_exchange_weak(previous, previous - signalCount * COUNT_UNIT));
         
-        if (new_count == 0) {
-            condition_.notify_all();
+        if (count_of(previous) == signalCount) {
+            wake_waiters(previous);
         }
         
         return true;
@@ -127,17 +157,15 @@ public:
             throw std::invalid_argument("signalCount must be positive");
         }
         
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        if (disposed_) {
-            throw std::runtime_error("CountdownEvent has been disposed");
-        }
-        
-        if (current_count_.load() == 0) {
-            throw std::runtime_error("Cannot add count when CountdownEvent is set");
-        }
-        
-        current_count_.fetch_add(signalCount);
+        std::int64_t previous = state_.load();
+        do {
+            if (previous & DISPOSED) {
+                throw std::runtime_error("CountdownEvent has been disposed");
+            }
+            if (count_of(previous) <= 0) {
+                throw std::runtime_error("Cannot add count when CountdownEvent is set");
+            }
+        } while (!state_.compare_exchange_weak(previous, previous + signalCount * COUNT_UNIT));
     }
     
     bool try_add_count() {
@@ -149,54 +177,98 @@ public:
             throw std::invalid_argument("signalCount must be positive");
         }
         
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::int64_t previous = state_.load();
+        do {
+            if ((previous & DISPOSED) || count_of(previous) <= 0) {
+                return false;
+            }
+        } while (!state_.compare_exchange_weak(previous, previous + signalCount * COUNT_UNIT));
         
-        if (disposed_ || current_count_.load() == 0) {
-            return false;
-        }
-        
-        current_count_.fetch_add(signalCount);
         return true;
     }
     
     void reset() {
-        reset(initial_count_);
+        reset(initial_count_.load());
     }
     
+    // Not safe to call concurrently with signal or wait
     void reset(int count) {
         if (count < 0) {
             throw std::invalid_argument("count cannot be negative");
         }
         
-        std::lock_guard<std::mutex> lock(mutex_);
+        throw_if_disposed();
         
-        if (disposed_) {
-            throw std::runtime_error("CountdownEvent has been disposed");
+        initial_count_.store(count);
+        
+        // Waiters parked through the reset still need their flags
+        std::int64_t previous = state_.load();
+        while (!state_.compare_exchange_weak(previous, (std::int64_t(count) << COUNT_SHIFT) | (previous & WAITER_FLAGS))) {
         }
         
-        current_count_.store(count);
-        initial_count_ = count;
+        if (count == 0) {
+            wake_waiters(previous);
+        }
     }
     
     int get_current_count() const {
-        return current_count_.load();
+        std::int64_t count = count_of(state_.load());
+        return count > 0 ? static_cast<int>(count) : 0;
     }
     
     int get_initial_count() const {
-        return initial_count_;
+        return initial_count_.load();
     }
     
     bool is_set() const {
-        return current_count_.load() == 0;
+        return count_of(state_.load()) <= 0;
     }
     
     void dispose() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (!disposed_) {
-            disposed_ = true;
+        std::int64_t previous = state_.fetch_or(DISPOSED);
+        if (!(previous & DISPOSED)) {
+            wake_waiters(previous);
+        }
+    }
+
+private:
+    static std::int64_t count_of(std::int64_t state) {
+        return state >> COUNT_SHIFT;
+    }
+    
+    static bool is_released(std::int64_t state) {
+        return count_of(state) <= 0 || (state & DISPOSED);
+    }
+    
+    void throw_if_disposed() const {
+        if (state_.load(std::memory_order_relaxed) & DISPOSED) {
+            throw std::runtime_error("CountdownEvent has been disposed");
+        }
+    }
+    
+    // Called by whoever released the event, with the state it replaced. Waiters
+    // may return (and destroy the event) as soon as the count is zero, so only
+    // flags set before the release are acted on: notify_all needs nothing but
+    // the address, and timed waiters hold off until the mutex hand-off is done.
+    void wake_waiters(std::int64_t previous) {
+        if (previous & HAS_WAITERS) {
+            state_.notify_all();
+        }
+        if (previous & HAS_TIMED_WAITERS) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state_.fetch_and(~HAS_TIMED_WAITERS);
             condition_.notify_all();
         }
     }
+    
+    // Lock-free part of a wait: the event was released while spinning
+    bool spin_until_set() {
+        if (!spinner_.spin_until([this]() { return is_released(state_.load(std::memory_order_acquire)); })) {
+            return false;
+        }
+        throw_if_disposed();
+        return true;
+    }
 };
 
 } // namespace Threading
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace System::Threading
+{
+    // The CPUs and NUMA nodes this process may run on, read from /sys/devices/system.
+    //
+    // Only CPUs in the affinity mask are listed, and nodes left without any (memory-only
+    // nodes, or nodes outside the process's cpuset) are dropped, so node indices run from
+    // 0 to GetNodeCount() - 1 and need not match the kernel's node ids. Without sysfs the
+    // topology is a single node holding every allowed CPU.
+    class CpuTopology
+    {
+    public:
+        struct Node
+        {
+            int id;                 // The kernel's node id
+            std::vector<int> cpus;  // Ascending
+        };
+
+        // This machine's topology, read once with the process's affinity mask
+        static const CpuTopology& GetCurrent();
+
+        // Reads the topology under sysfsRoot (normally "/sys/devices/system"), keeping
+        // only allowedCpus; an empty allowedCpus keeps every CPU.
+        static CpuTopology Read(const std::string& sysfsRoot, const std::vector<int>& allowedCpus);
+
+        // Parses the kernel's list format, e.g. "0-3,8,10-11"; throws std::invalid_argument
+        // when the list is malformed
+        static std::vector<int> ParseCpuList(const std::string& list);
+
+        int GetNodeCount() const;
+        int GetProcessorCount() const;
+        const Node& GetNode(int node) const;
+        // The node index holding cpu, or -1 when cpu is not one of ours
+        int GetNodeOfCpu(int cpu) const;
+        // The node the calling thread is running on right now, or -1 when unknown
+        int GetCurrentNode() const;
+
+        // The CPUs the calling thread may run on; empty when the platform cannot tell
+        static std::vector<int> GetCurrentThreadAffinity();
+        // Restricts the calling thread to cpus; false when the platform cannot
+        static bool SetCurrentThreadAffinity(const std::vector<int>& cpus);
+
+    private:
+        void AddNode(int id, std::vector<int> cpus);
+
+        std::vector<Node> nodes;
+        std::vector<int> nodeOfCpu;  // Indexed by CPU number, -1 where not ours
+        int processorCount = 0;
+    };
+}
@@ -9,7 +9,7 @@ namespace Threading {
 
 // Forward declarations
 class Task;
-template<typename T> class Task;
+template<typename T> class TaskOf;
 class CancellationToken;
 
 // Action delegates (void return)
@@ -17,7 +17,7 @@ using Action = std::function<void()>;
 using ParameterizedThreadStart = std::function<void(void*)>;
 using ThreadStart = std::function<void()>;
 using TimerCallback = std::function<void(void*)>;
-using WaitCallback = std::function<void(void*)>;
+// WaitCallback is ThreadPool.h's, which takes a System::Object*
 using WaitOrTimerCallback = std::function<void(void*, bool)>;
 
 // Function delegates (with return values)
@@ -37,25 +37,25 @@ using Func3 = std::function<TResult(T1, T2, T3)>;
 using TaskAction = std::function<void(Task&)>;
 
 template<typename T>
-using TaskAction1 = std::function<void(Task<T>&)>;
+using TaskAction1 = std::function<void(TaskOf<T>&)>;
 
 template<typename TResult>
 using TaskFunc = std::function<TResult(Task&)>;
 
 template<typename T, typename TResult>
-using TaskFunc1 = std::function<TResult(Task<T>&)>;
+using TaskFunc1 = std::function<TResult(TaskOf<T>&)>;
 
 // Continuation delegates
 using ContinuationAction = std::function<void(Task&)>;
 
 template<typename T>
-using ContinuationAction1 = std::function<void(Task<T>&)>;
+using ContinuationAction1 = std::function<void(TaskOf<T>&)>;
 
 template<typename TResult>
 using ContinuationFunc = std::function<TResult(Task&)>;
 
 template<typename T, typename TResult>
-using ContinuationFunc1 = std::function<TResult(Task<T>&)>;
+using ContinuationFunc1 = std::function<TResult(TaskOf<T>&)>;
 
 // Cancellation delegates
 using CancellationCallback = std::function<void()>;
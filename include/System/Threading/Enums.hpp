@@ -37,9 +37,9 @@ enum class TaskContinuationOptions {
     NotOnRanToCompletion = 65536,
     NotOnFaulted = 131072,
     NotOnCanceled = 262144,
-    OnlyOnRanToCompletion = 393216,
-    OnlyOnFaulted = 524288,
-    OnlyOnCanceled = 1048576,
+    OnlyOnRanToCompletion = 393216,  // NotOnFaulted | NotOnCanceled
+    OnlyOnFaulted = 327680,          // NotOnRanToCompletion | NotOnCanceled
+    OnlyOnCanceled = 196608,         // NotOnRanToCompletion | NotOnFaulted
     ExecuteSynchronously = 524288
 };
 
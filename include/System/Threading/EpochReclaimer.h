@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace System::Threading
+{
+    // Epoch-based memory reclamation for the lock-free collections.
+    //
+    // A thread holds a Guard while it dereferences shared nodes. Nodes that have
+    // been unlinked are handed to Retire() instead of being deleted; they are freed
+    // once the global epoch has advanced twice past their retirement, by which time
+    // no guard that could still see them is alive. Entering and leaving a guard only
+    // writes the calling thread's own, cache-line aligned record.
+    //
+    // A thread collects after CollectThreshold retirements, or as soon as what it
+    // holds adds up to CollectBytesThreshold; while it holds that much it tries again
+    // each time it leaves a guard. What a thread still holds when it exits is adopted
+    // by the next thread that collects, so large nodes are not kept alive by a thread
+    // that has gone quiet or gone away.
+    class EpochReclaimer
+    {
+        struct ThreadRecord;
+
+    public:
+        using Deleter = void (*)(void*);
+
+        class Guard
+        {
+        public:
+            Guard()
+                : record(CurrentRecord())
+            {
+                if (record->depth++ == 0)
+                {
+                    record->epoch.store((globalEpoch.load(std::memory_order_relaxed) << 1) | Active, std::memory_order_relaxed);
+                    // Pairs with the fence in TryAdvance: either the advancer sees this
+                    // announcement or this thread sees every unlink made before it
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                }
+            }
+
+            ~Guard()
+            {
+                if (--record->depth == 0)
+                {
+                    record->epoch.store(0, std::memory_order_release);
+                    if (record->retiredBytes >= CollectBytesThreshold)
+                    {
+                        Collect(record);
+                    }
+                }
+            }
+
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+
+        private:
+            ThreadRecord* record;
+        };
+
+        // Frees pointer with deleter once no guard can still reference it; bytes is
+        // the memory that frees, including anything the object owns
+        static void Retire(void* pointer, Deleter deleter, std::size_t bytes = 0);
+
+        template<typename T>
+        static void Retire(T* pointer, std::size_t bytes = sizeof(T))
+        {
+            Retire(pointer, [](void* retired) { delete static_cast<T*>(retired); }, bytes);
+        }
+
+        // Frees whatever the calling thread has retired that is no longer reachable
+        static void Collect();
+
+        // Diagnostics
+        static std::uint64_t GetEpoch();
+        static std::size_t GetPendingCount();
+
+    private:
+        static constexpr std::uint64_t Active = 1;
+        static constexpr std::size_t CollectThreshold = 64;
+        static constexpr std::size_t CollectBytesThreshold = 256 * 1024;
+
+        struct RetiredNode
+        {
+            void* pointer;
+            Deleter deleter;
+            std::uint64_t epoch;
+            std::size_t bytes;
+        };
+
+        struct alignas(64) ThreadRecord
+        {
+            // (epoch << 1) | Active while inside a guard, 0 otherwise
+            std::atomic<std::uint64_t> epoch{0};
+            std::atomic<bool> inUse{false};
+            int depth = 0;
+            std::vector<RetiredNode> retired;
+            std::size_t retiredBytes = 0;
+            ThreadRecord* next = nullptr;
+        };
+
+        // Hands the thread's record back for reuse when the thread exits
+        struct RecordOwner
+        {
+            ThreadRecord* record = nullptr;
+            ~RecordOwner();
+        };
+
+        static std::atomic<std::uint64_t> globalEpoch;
+        static std::atomic<ThreadRecord*> records;
+        // Released records that still hold retired nodes
+        static std::atomic<int> orphanedRecords;
+        static thread_local ThreadRecord* currentRecord;
+        static thread_local RecordOwner recordOwner;
+
+        static ThreadRecord* CurrentRecord()
+        {
+            ThreadRecord* record = currentRecord;
+            return record ? record : AcquireRecord();
+        }
+
+        static ThreadRecord* AcquireRecord();
+        static void ReleaseRecord(ThreadRecord* record);
+        static bool TryAdvance();
+        static void Collect(ThreadRecord* record);
+        static void FreeExpired(ThreadRecord* record, std::uint64_t epoch);
+        static void CollectOrphans(std::uint64_t epoch);
+    };
+}
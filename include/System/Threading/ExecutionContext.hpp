@@ -0,0 +1,187 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace System {
+namespace Threading {
+
+class ExecutionContext;
+
+namespace detail {
+
+// The value one AsyncLocal holds in one context. Immutable once published and
+// shared by every context that still contains it.
+class AsyncLocalValue {
+private:
+    std::atomic<std::uint32_t> refs_{1};
+
+public:
+    virtual ~AsyncLocalValue() = default;
+
+    void add_ref() noexcept {
+        refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release() noexcept {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+};
+
+template<typename T>
+class AsyncLocalValueOf : public AsyncLocalValue {
+public:
+    const T value;
+
+    template<typename U>
+    explicit AsyncLocalValueOf(U&& initial) : value(std::forward<U>(initial)) {}
+};
+
+// Root of an immutable AsyncLocal map; the layout beyond the count is private to
+// ExecutionContext.cpp. Null is the empty map.
+struct AsyncLocalNode {
+    std::atomic<std::uint32_t> refs{1};
+};
+
+inline void add_ref(AsyncLocalNode* node) noexcept {
+    if (node) {
+        node->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void destroy(AsyncLocalNode* node) noexcept;
+
+inline void release(AsyncLocalNode* node) noexcept {
+    if (node && node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        destroy(node);
+    }
+}
+
+// The map of the code running on this thread; owns one reference
+extern thread_local constinit AsyncLocalNode* current_async_locals;
+
+// Persistent map operations: the input is left alone and the result is a new
+// reference. with() takes over the caller's reference to value.
+const AsyncLocalValue* find(const AsyncLocalNode* root, std::uint64_t key) noexcept;
+AsyncLocalNode* with(const AsyncLocalNode* root, std::uint64_t key, AsyncLocalValue* value);
+AsyncLocalNode* without(const AsyncLocalNode* root, std::uint64_t key);
+
+// Replaces this thread's map for good, adopting the reference to root
+void set_current_async_locals(AsyncLocalNode* root) noexcept;
+
+// Identifies an AsyncLocal; never reused
+std::uint64_t next_async_local_key() noexcept;
+
+// Installs a context for the lifetime of the scope (or keeps the current one) and
+// puts the previous context back on exit, whatever the code inside has set.
+class ExecutionContextScope {
+private:
+    AsyncLocalNode* saved_;
+
+public:
+    ExecutionContextScope() noexcept : saved_(current_async_locals) {
+        add_ref(saved_);
+    }
+
+    inline explicit ExecutionContextScope(const ExecutionContext& context) noexcept;
+    inline explicit ExecutionContextScope(ExecutionContext&& context) noexcept;
+
+    ~ExecutionContextScope() {
+        release(current_async_locals);
+        current_async_locals = saved_;
+    }
+
+    ExecutionContextScope(const ExecutionContextScope&) = delete;
+    ExecutionContextScope& operator=(const ExecutionContextScope&) = delete;
+};
+
+} // namespace detail
+
+// The ambient state that flows with asynchronous work: the values of every
+// AsyncLocal, as seen by the code that captured it.
+//
+// A context is an immutable persistent map, so capturing one is a pointer copy
+// and one reference count increment (none at all while no AsyncLocal has been
+// set), and AsyncLocal::set builds a new map that shares all but the changed path
+// with the old one. Up to three values sit in a flat array; from four on the map
+// is a hash array mapped trie with 32-way nodes, where set copies O(log32 n)
+// nodes.
+//
+// Task::run and continue_with capture the context when the task is created and
+// install it while the body runs; co_await captures it at the suspension and
+// restores it on resumption. Whatever the body sets is dropped when it returns.
+class ExecutionContext {
+private:
+    detail::AsyncLocalNode* root_ = nullptr;
+
+    explicit ExecutionContext(detail::AsyncLocalNode* root) noexcept : root_(root) {}
+
+    friend class detail::ExecutionContextScope;
+
+public:
+    // The default context, in which no AsyncLocal has a value
+    ExecutionContext() noexcept = default;
+
+    ExecutionContext(const ExecutionContext& other) noexcept : root_(other.root_) {
+        detail::add_ref(root_);
+    }
+
+    ExecutionContext(ExecutionContext&& other) noexcept : root_(std::exchange(other.root_, nullptr)) {}
+
+    ExecutionContext& operator=(ExecutionContext other) noexcept {
+        std::swap(root_, other.root_);
+        return *this;
+    }
+
+    ~ExecutionContext() {
+        detail::release(root_);
+    }
+
+    static ExecutionContext capture() noexcept {
+        detail::AsyncLocalNode* root = detail::current_async_locals;
+        detail::add_ref(root);
+        return ExecutionContext(root);
+    }
+
+    // Makes context current on this thread until something else replaces it
+    static void restore(const ExecutionContext& context) noexcept {
+        detail::add_ref(context.root_);
+        detail::set_current_async_locals(context.root_);
+    }
+
+    static void restore(ExecutionContext&& context) noexcept {
+        detail::set_current_async_locals(std::exchange(context.root_, nullptr));
+    }
+
+    // Runs callback in context and then returns to the caller's context
+    template<typename TCallback>
+    static void run(const ExecutionContext& context, TCallback&& callback) {
+        detail::ExecutionContextScope scope(context);
+        std::forward<TCallback>(callback)();
+    }
+
+    bool is_default() const noexcept {
+        return root_ == nullptr;
+    }
+};
+
+namespace detail {
+
+inline ExecutionContextScope::ExecutionContextScope(const ExecutionContext& context) noexcept
+    : saved_(current_async_locals) {
+    add_ref(context.root_);
+    current_async_locals = context.root_;
+}
+
+inline ExecutionContextScope::ExecutionContextScope(ExecutionContext&& context) noexcept
+    : saved_(current_async_locals) {
+    current_async_locals = std::exchange(context.root_, nullptr);
+}
+
+} // namespace detail
+
+} // namespace Threading
+} // namespace System
@@ -3,21 +3,37 @@
 
 #include "System/Object.h"
 #include "System/TimeSpan.h"
-#include "CancellationToken.h"
+#include "CancellationToken.hpp"
 #include "WaitHandle.h"
 #include <atomic>
+#include <cstdint>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
 
 namespace System::Threading
 {
+    // Event whose Set, Reset and GetIsSet are single atomic operations on one
+    // word holding the set flag and the waiter bookkeeping. Wait spins through the
+    // shared AdaptiveSpin policy, never more than spinCount times, then parks on
+    // the word with std::atomic::wait, so Set only makes a system call when a
+    // thread is actually blocked. Timed and cancelable waits, which atomic::wait
+    // cannot serve, block on a condition variable instead.
     class ManualResetEventSlim : public System::Object
     {
     private:
-        std::atomic<bool> isSet;
+        // Layout of state: flag bits, then the count of parked threads
+        static constexpr std::uint32_t SetFlag = 1;
+        static constexpr std::uint32_t ConditionWaitersFlag = 2;
+        static constexpr std::uint32_t WaitHandleFlag = 4;
+        static constexpr std::uint32_t WaiterUnit = 8;
+
+        std::atomic<std::uint32_t> state;
         std::mutex mutex;
         std::condition_variable condition;
         int spinCount;
+        AdaptiveSpin spinner;
+        // Created on demand and kept in step with state under mutex
         std::unique_ptr<WaitHandle> waitHandle;
 
     public:
@@ -38,5 +54,12 @@ namespace System::Threading
         bool GetIsSet() const;
         int GetSpinCount() const;
         WaitHandle* GetWaitHandle();
+
+    private:
+        bool SpinUntilSet(const CancellationToken* cancellationToken);
+        bool WaitOnCondition(int millisecondsTimeout, const CancellationToken* cancellationToken);
+        void ReleaseConditionWaiters();
+        void SyncWaitHandle();
+        void SyncWaitHandleLocked();
     };
 }
@@ -23,6 +23,30 @@ public:
         : std::runtime_error(message) {}
 };
 
+namespace detail {
+
+// Process-wide table of visible readers for biased read locks (BRAVO). Each
+// thread owns one slot, which holds the lock the thread has read-acquired on the
+// fast path, or null.
+struct alignas(64) VisibleReaderSlot {
+    std::atomic<const void*> lock{nullptr};
+};
+
+constexpr int visible_reader_slot_count = 256;
+extern VisibleReaderSlot visible_readers[visible_reader_slot_count];
+
+// This thread's slot, or -1 while every slot is owned by a live thread
+int visible_reader_index();
+
+} // namespace detail
+
+// Read-biased reader-writer lock. While the bias is set, enter_read_lock only
+// publishes the lock in the calling thread's visible-reader slot and fences, so
+// readers on different cores never write a shared cache line. A writer revokes
+// the bias and waits for the slots naming this lock to drain before entering;
+// readers then take the slow path through state_mutex_ until the bias is
+// re-armed, which a slow reader does once no writer is waiting and a back-off
+// proportional to the last revocation's cost has passed.
 class ReaderWriterLockSlim {
 private:
     mutable std::shared_mutex shared_mutex_;
@@ -39,11 +63,18 @@ private:
     std::atomic<int> waiting_upgraders_;
     bool disposed_;
     
+    std::atomic<bool> read_bias_;
+    // steady_clock ticks before which the bias stays revoked
+    std::atomic<std::chrono::steady_clock::rep> inhibit_until_;
+    
+    // Revocation backs off for this many times its own duration
+    static constexpr int bias_inhibit_multiplier = 9;
+    
     // Recursion tracking (only used when recursion is supported)
     thread_local static int reader_recursion_count_;
     thread_local static int writer_recursion_count_;
     thread_local static int upgradeable_recursion_count_;
-    
+
 public:
     explicit ReaderWriterLockSlim(LockRecursionPolicy recursionPolicy = LockRecursionPolicy::NoRecursion)
         : recursion_policy_(recursionPolicy)
@@ -54,7 +85,9 @@ public:
         , upgradeable_thread_id_(std::thread::id{})
         , waiting_writers_(0)
         , waiting_upgraders_(0)
-        , disposed_(false) {}
+        , disposed_(false)
+        , read_bias_(true)
+        , inhibit_until_(0) {}
     
     ~ReaderWriterLockSlim() {
         dispose();
@@ -88,12 +121,16 @@ public:
             }
         }
         
-        std::unique_lock<std::mutex> lock(state_mutex_);
-        condition_.wait(lock, [this]() {
-            return !writer_held_.load() && waiting_upgraders_.load() == 0;
-        });
+        if (!try_enter_biased_read()) {
+            std::unique_lock<std::mutex> lock(state_mutex_);
+            condition_.wait(lock, [this]() {
+                return !writer_held_.load() && waiting_upgraders_.load() == 0;
+            });
+            
+            reader_count_.fetch_add(1);
+            rearm_read_bias();
+        }
         
-        reader_count_.fetch_add(1);
         if (recursion_policy_ == LockRecursionPolicy::SupportsRecursion) {
             ++reader_recursion_count_;
         }
@@ -122,16 +159,19 @@ public:
             }
         }
         
-        std::unique_lock<std::mutex> lock(state_mutex_, std::try_to_lock);
-        if (!lock.owns_lock()) {
-            return false;
-        }
-        
-        if (writer_held_.load() || waiting_upgraders_.load() > 0) {
-            return false;
+        if (!try_enter_biased_read()) {
+            std::unique_lock<std::mutex> lock(state_mutex_, std::try_to_lock);
+            if (!lock.owns_lock()) {
+                return false;
+            }
+            
+            if (writer_held_.load() || waiting_upgraders_.load() > 0) {
+                return false;
+            }
+            
+            reader_count_.fetch_add(1);
         }
         
-        reader_count_.fetch_add(1);
         if (recursion_policy_ == LockRecursionPolicy::SupportsRecursion) {
             ++reader_recursion_count_;
         }
@@ -162,6 +202,10 @@ public:
             }
         }
         
+        if (exit_biased_read()) {
+            return;
+        }
+        
         std::lock_guard<std::mutex> lock(state_mutex_);
         
         if (reader_count_.load() <= 0) {
@@ -182,11 +226,11 @@ public:
         
         std::thread::id current_thread = std::this_thread::get_id();
         
-        // Check for recursion
+        // Check for recursion; the upgradeable holder may always upgrade
+        bool upgrading = upgradeable_thread_id_.load() == current_thread;
         if (recursion_policy_ == LockRecursionPolicy::NoRecursion) {
             if (writer_thread_id_.load() == current_thread || 
-                upgradeable_thread_id_.load() == current_thread ||
-                reader_recursion_count_ > 0) {
+                (!upgrading && (reader_recursion_count_ > 0 || holds_biased_read()))) {
                 throw LockRecursionException("Write lock cannot be acquired when any lock is held by the same thread");
             }
         } else {
@@ -199,13 +243,17 @@ public:
         waiting_writers_.fetch_add(1);
         
         std::unique_lock<std::mutex> lock(state_mutex_);
-        condition_.wait(lock, [this]() {
-            return !writer_held_.load() && reader_count_.load() == 0 && !upgradeable_held_.load();
+        condition_.wait(lock, [this, upgrading]() {
+            return !writer_held_.load() && can_enter_write(upgrading);
         });
         
         waiting_writers_.fetch_sub(1);
         writer_held_.store(true);
         writer_thread_id_.store(current_thread);
+        lock.unlock();
+        
+        // Slow readers are out and held off by writer_held_; drain the fast ones
+        revoke_read_bias(true);
         
         if (recursion_policy_ == LockRecursionPolicy::SupportsRecursion) {
             ++writer_recursion_count_;
@@ -227,17 +275,28 @@ public:
             }
         }
         
+        bool upgrading = upgradeable_thread_id_.load() == current_thread;
         std::unique_lock<std::mutex> lock(state_mutex_, std::try_to_lock);
         if (!lock.owns_lock()) {
             return false;
         }
         
-        if (writer_held_.load() || reader_count_.load() > 0 || upgradeable_held_.load()) {
+        if (writer_held_.load() || !can_enter_write(upgrading)) {
             return false;
         }
         
         writer_held_.store(true);
         writer_thread_id_.store(current_thread);
+        lock.unlock();
+        
+        if (!revoke_read_bias(false)) {
+            // A fast reader is inside; back out without waiting for it
+            lock.lock();
+            writer_held_.store(false);
+            writer_thread_id_.store(std::thread::id{});
+            condition_.notify_all();
+            return false;
+        }
         
         if (recursion_policy_ == LockRecursionPolicy::SupportsRecursion) {
             ++writer_recursion_count_;
@@ -389,7 +448,7 @@ public:
                    writer_thread_id_.load() == std::this_thread::get_id() ||
                    upgradeable_thread_id_.load() == std::this_thread::get_id();
         }
-        return reader_count_.load() > 0;
+        return reader_count_.load() > 0 || holds_biased_read();
     }
     
     bool is_write_lock_held() const {
@@ -405,7 +464,13 @@ public:
     }
     
     int get_current_read_count() const {
-        return reader_count_.load();
+        int count = reader_count_.load();
+        for (const auto& slot : detail::visible_readers) {
+            if (slot.lock.load(std::memory_order_relaxed) == this) {
+                ++count;
+            }
+        }
+        return count;
     }
     
     int get_waiting_read_count() const {
@@ -432,12 +497,92 @@ public:
             condition_.notify_all();
         }
     }
-};
 
-// Thread-local storage for recursion tracking
-thread_local int ReaderWriterLockSlim::reader_recursion_count_ = 0;
-thread_local int ReaderWriterLockSlim::writer_recursion_count_ = 0;
-thread_local int ReaderWriterLockSlim::upgradeable_recursion_count_ = 0;
+private:
+    // Readers other than an upgrader are out; an upgrader only waits for them
+    bool can_enter_write(bool upgrading) const {
+        if (upgrading) {
+            return reader_count_.load() == 1;
+        }
+        return reader_count_.load() == 0 && !upgradeable_held_.load();
+    }
+    
+    bool try_enter_biased_read() {
+        if (!read_bias_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        int index = detail::visible_reader_index();
+        if (index < 0) {
+            return false;
+        }
+        
+        // Only this thread writes its slot; it is busy if we hold another biased read
+        std::atomic<const void*>& slot = detail::visible_readers[index].lock;
+        if (slot.load(std::memory_order_relaxed) != nullptr) {
+            return false;
+        }
+        slot.store(this, std::memory_order_relaxed);
+        // Pairs with the fence in revoke_read_bias: either we see the bias
+        // cleared or the writer sees our slot
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (read_bias_.load(std::memory_order_acquire)) {
+            return true;
+        }
+        slot.store(nullptr, std::memory_order_release);
+        return false;
+    }
+    
+    bool exit_biased_read() {
+        if (!holds_biased_read()) {
+            return false;
+        }
+        detail::visible_readers[detail::visible_reader_index()].lock.store(nullptr, std::memory_order_release);
+        return true;
+    }
+    
+    bool holds_biased_read() const {
+        int index = detail::visible_reader_index();
+        return index >= 0 && detail::visible_readers[index].lock.load(std::memory_order_relaxed) == this;
+    }
+    
+    // Clears the bias and waits for fast readers to leave. Without wait, returns
+    // false instead if one is still inside.
+    bool revoke_read_bias(bool wait) {
+        if (!read_bias_.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        read_bias_.store(false, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        
+        bool drained = true;
+        for (const auto& slot : detail::visible_readers) {
+            while (slot.lock.load(std::memory_order_acquire) == this) {
+                if (!wait) {
+                    drained = false;
+                    break;
+                }
+                std::this_thread::yield();
+            }
+        }
+        
+        auto now = std::chrono::steady_clock::now();
+        inhibit_until_.store((now + (now - start) * bias_inhibit_multiplier).time_since_epoch().count(),
+                             std::memory_order_relaxed);
+        return drained;
+    }
+    
+    // Called by a slow reader under state_mutex_, so no writer holds the lock
+    void rearm_read_bias() {
+        if (read_bias_.load(std::memory_order_relaxed) || waiting_writers_.load() > 0) {
+            return;
+        }
+        if (std::chrono::steady_clock::now().time_since_epoch().count() >= inhibit_until_.load(std::memory_order_relaxed)) {
+            read_bias_.store(true, std::memory_order_release);
+        }
+    }
+};
 
 } // namespace Threading
 } // namespace System
@@ -0,0 +1,338 @@
+#pragma once
+
+#include "Task.hpp"
+#include "TaskCompletionSource.hpp"
+#include "TimerWheel.hpp"
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace System {
+namespace Threading {
+
+class SemaphoreFullException : public std::runtime_error {
+public:
+    SemaphoreFullException()
+        : std::runtime_error("Adding the specified count to the semaphore would cause it to exceed its maximum count") {}
+};
+
+// Counting semaphore whose waits do not need a thread of their own.
+//
+// Taking an available permit is one CAS on the count. Otherwise the caller joins
+// a FIFO queue as a TaskCompletionSource<bool>, and release hands its permits to
+// the front of the queue by completing those tasks directly; permits only go
+// back into the count once nobody is queued. wait_async returns the queued task.
+// The blocking waits first spin through the shared AdaptiveSpin policy, retrying
+// the CAS, and only then queue the same way and block on the task.
+//
+// A timeout is one entry in the shared timer wheel and a cancelable wait
+// registers with its token. Release, the timer and the token race to take the
+// waiter out of the queue under the lock, and whichever removes it completes it.
+class SemaphoreSlim {
+private:
+    struct Waiter;
+    using WaiterList = std::list<std::shared_ptr<Waiter>>;
+    
+    struct Waiter {
+        TaskCompletionSource<bool> completion;
+        WaiterList::iterator position;
+        bool queued = false;
+        // Stored once queued; whoever dequeues the waiter releases them
+        TimerWheel::Handle timer;
+        CancellationTokenRegistration registration;
+    };
+    
+    // Shared with timer and token callbacks, which can outlive the semaphore
+    struct State {
+        std::mutex mutex;
+        WaiterList waiters;
+        std::atomic<int> current_count;
+        const int maximum_count;
+        AdaptiveSpin spinner;
+        
+        State(int initialCount, int maxCount)
+            : current_count(initialCount), maximum_count(maxCount) {}
+    };
+    
+    std::shared_ptr<State> state_;
+
+public:
+    explicit SemaphoreSlim(int initialCount)
+        : SemaphoreSlim(initialCount, INT_MAX) {}
+    
+    SemaphoreSlim(int initialCount, int maxCount) {
+        if (maxCount <= 0) {
+            throw std::invalid_argument("maxCount must be positive");
+        }
+        if (initialCount < 0 || initialCount > maxCount) {
+            throw std::invalid_argument("initialCount must be between 0 and maxCount");
+        }
+        state_ = std::make_shared<State>(initialCount, maxCount);
+    }
+    
+    // Waits still queued can no longer be granted and end up canceled
+    ~SemaphoreSlim() {
+        WaiterList abandoned;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            abandoned.swap(state_->waiters);
+            for (auto& waiter : abandoned) {
+                waiter->queued = false;
+            }
+        }
+        for (auto& waiter : abandoned) {
+            release_timer(*waiter);
+            waiter->registration.dispose();
+            waiter->completion.try_set_canceled();
+        }
+    }
+    
+    SemaphoreSlim(const SemaphoreSlim&) = delete;
+    SemaphoreSlim& operator=(const SemaphoreSlim&) = delete;
+    
+    void wait() {
+        wait(-1, CancellationToken::none());
+    }
+    
+    bool wait(int millisecondsTimeout) {
+        return wait(millisecondsTimeout, CancellationToken::none());
+    }
+    
+    template<typename Rep, typename Period>
+    bool wait(const std::chrono::duration<Rep, Period>& timeout) {
+        return wait(to_milliseconds(timeout), CancellationToken::none());
+    }
+    
+    void wait(CancellationToken cancellationToken) {
+        wait(-1, std::move(cancellationToken));
+    }
+    
+    // Throws OperationCanceledException if the token is canceled first
+    bool wait(int millisecondsTimeout, CancellationToken cancellationToken) {
+        validate_timeout(millisecondsTimeout);
+        cancellationToken.throw_if_cancellation_requested();
+        
+        if (try_acquire()) {
+            return true;
+        }
+        if (millisecondsTimeout == 0) {
+            return false;
+        }
+        
+        // A permit released within the spin is taken without queueing; waits that
+        // keep missing shrink the budget until they go almost straight to the queue
+        bool acquired = false;
+        state_->spinner.spin_until([this, &acquired, &cancellationToken]() {
+            acquired = try_acquire();
+            return acquired || cancellationToken.is_cancellation_requested();
+        });
+        if (acquired) {
+            return true;
+        }
+        cancellationToken.throw_if_cancellation_requested();
+        return enqueue(millisecondsTimeout, std::move(cancellationToken)).get_result();
+    }
+    
+    Task wait_async() {
+        return wait_async(-1, CancellationToken::none());
+    }
+    
+    TaskOf<bool> wait_async(int millisecondsTimeout) {
+        return wait_async(millisecondsTimeout, CancellationToken::none());
+    }
+    
+    template<typename Rep, typename Period>
+    TaskOf<bool> wait_async(const std::chrono::duration<Rep, Period>& timeout) {
+        return wait_async(to_milliseconds(timeout), CancellationToken::none());
+    }
+    
+    Task wait_async(CancellationToken cancellationToken) {
+        return wait_async(-1, std::move(cancellationToken));
+    }
+    
+    // The task is true once a permit is taken, false on timeout, and canceled
+    // if the token is canceled first
+    TaskOf<bool> wait_async(int millisecondsTimeout, CancellationToken cancellationToken) {
+        validate_timeout(millisecondsTimeout);
+        
+        if (cancellationToken.is_cancellation_requested()) {
+            TaskCompletionSource<bool> canceled;
+            canceled.set_canceled(cancellationToken);
+            return canceled.get_task();
+        }
+        if (try_acquire()) {
+            return completed(true);
+        }
+        if (millisecondsTimeout == 0) {
+            return completed(false);
+        }
+        return enqueue(millisecondsTimeout, std::move(cancellationToken));
+    }
+    
+    // Returns the count before the release
+    int release() {
+        return release(1);
+    }
+    
+    int release(int releaseCount) {
+        if (releaseCount < 1) {
+            throw std::invalid_argument("releaseCount must be positive");
+        }
+        
+        std::vector<std::shared_ptr<Waiter>> granted;
+        int previous;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            // The count only grows under the lock; lock-free acquires can
+            // only make it smaller in the meantime
+            previous = state_->current_count.load();
+            if (releaseCount > state_->maximum_count - previous) {
+                throw SemaphoreFullException();
+            }
+            
+            int remaining = releaseCount;
+            while (remaining > 0 && !state_->waiters.empty()) {
+                auto waiter = std::move(state_->waiters.front());
+                state_->waiters.pop_front();
+                waiter->queued = false;
+                granted.push_back(std::move(waiter));
+                --remaining;
+            }
+            if (remaining > 0) {
+                state_->current_count.fetch_add(remaining);
+            }
+        }
+        
+        // Continuations may run inline here, so complete outside the lock
+        for (auto& waiter : granted) {
+            release_timer(*waiter);
+            waiter->registration.dispose();
+            waiter->completion.set_result(true);
+        }
+        return previous;
+    }
+    
+    int get_current_count() const {
+        return state_->current_count.load();
+    }
+
+private:
+    bool try_acquire() {
+        int count = state_->current_count.load(std::memory_order_relaxed);
+        while (count > 0) {
+            if (state_->current_count.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    TaskOf<bool> enqueue(int millisecondsTimeout, CancellationToken cancellationToken) {
+        auto waiter = std::make_shared<Waiter>();
+        TaskOf<bool> task = waiter->completion.get_task();
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            // A release since the fast path failed has raised the count
+            if (try_acquire()) {
+                return completed(true);
+            }
+            waiter->position = state_->waiters.insert(state_->waiters.end(), waiter);
+            waiter->queued = true;
+        }
+        
+        // Both callbacks may fire at once, even before the handles are stored
+        std::weak_ptr<State> weak_state = state_;
+        std::weak_ptr<Waiter> weak_waiter = waiter;
+        
+        TimerWheel::Handle timer;
+        if (millisecondsTimeout > 0) {
+            timer = TimerWheel::instance().schedule([weak_state, weak_waiter]() {
+                if (auto waiter = take(weak_state, weak_waiter)) {
+                    waiter->registration.dispose();
+                    waiter->completion.set_result(false);
+                }
+            }, millisecondsTimeout);
+        }
+        
+        CancellationTokenRegistration registration;
+        if (cancellationToken != CancellationToken::none()) {
+            registration = cancellationToken.register_callback([weak_state, weak_waiter]() {
+                // The registration goes with the waiter, or enqueue disposes it if not stored yet
+                if (auto waiter = take(weak_state, weak_waiter)) {
+                    release_timer(*waiter);
+                    waiter->completion.set_canceled();
+                }
+            });
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (waiter->queued) {
+                waiter->timer = std::move(timer);
+                waiter->registration = std::move(registration);
+                return task;
+            }
+        }
+        
+        // Already granted, timed out or canceled
+        if (timer) {
+            TimerWheel::instance().cancel(timer);
+        }
+        registration.dispose();
+        return task;
+    }
+    
+    // Takes a waiter out of the queue unless something else already has
+    static std::shared_ptr<Waiter> take(const std::weak_ptr<State>& weak_state, const std::weak_ptr<Waiter>& weak_waiter) {
+        auto state = weak_state.lock();
+        auto waiter = weak_waiter.lock();
+        if (!state || !waiter) {
+            return nullptr;
+        }
+        
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (!waiter->queued) {
+            return nullptr;
+        }
+        state->waiters.erase(waiter->position);
+        waiter->queued = false;
+        return waiter;
+    }
+    
+    static void release_timer(Waiter& waiter) {
+        if (waiter.timer) {
+            TimerWheel::instance().cancel(waiter.timer);
+            waiter.timer.reset();
+        }
+    }
+    
+    static TaskOf<bool> completed(bool result) {
+        // Completed tasks are immutable, so every caller can share these
+        static const TaskOf<bool> acquired = Task::from_result(true);
+        static const TaskOf<bool> timed_out = Task::from_result(false);
+        return result ? acquired : timed_out;
+    }
+    
+    static void validate_timeout(int millisecondsTimeout) {
+        if (millisecondsTimeout < -1) {
+            throw std::invalid_argument("millisecondsTimeout must be -1 (Infinite) or greater");
+        }
+    }
+    
+    template<typename Rep, typename Period>
+    static int to_milliseconds(const std::chrono::duration<Rep, Period>& timeout) {
+        auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+        if (milliseconds < -1 || milliseconds > INT_MAX) {
+            throw std::invalid_argument("timeout must be -1 milliseconds (Infinite) or a non-negative value up to INT_MAX milliseconds");
+        }
+        return static_cast<int>(milliseconds);
+    }
+};
+
+} // namespace Threading
+} // namespace System
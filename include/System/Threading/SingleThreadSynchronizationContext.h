@@ -0,0 +1,87 @@
+#pragma once
+
+#include "System/Threading/SynchronizationContext.h"
+
+namespace System {
+namespace Threading {
+
+class Task;
+
+// A SynchronizationContext that runs everything posted to it on one thread: the one
+// inside Run or RunUntil. Post pushes onto an intrusive multi-producer, single-consumer
+// queue with one atomic exchange and wakes the loop only if it is asleep, so posting
+// takes no lock; posts from the loop's own thread go to a plain list. The loop drains
+// everything queued before it checks whether to stop or sleep.
+//
+// The context must be owned by a shared_ptr. Make it current before starting
+// coroutines that should come back to it:
+//
+//     auto context = std::make_shared<SingleThreadSynchronizationContext>();
+//     SynchronizationContext::SetSynchronizationContext(context);
+//     TaskOf<int> task = RunActorAsync();
+//     context->RunUntil(task);
+class SingleThreadSynchronizationContext : public SynchronizationContext,
+                                           public std::enable_shared_from_this<SingleThreadSynchronizationContext> {
+public:
+    SingleThreadSynchronizationContext();
+    ~SingleThreadSynchronizationContext() override;
+
+    SingleThreadSynchronizationContext(const SingleThreadSynchronizationContext&) = delete;
+    SingleThreadSynchronizationContext& operator=(const SingleThreadSynchronizationContext&) = delete;
+
+    // Override core methods
+    void Post(std::function<void(void*)> callback, void* state) override;
+    // Runs inline on the loop's thread; from any other thread, waits for the loop to
+    // run it and rethrows what it threw
+    void Send(std::function<void(void*)> callback, void* state) override;
+    // Returns this context: a copy has to post to the same thread
+    std::shared_ptr<SynchronizationContext> CreateCopy() override;
+
+    // Runs posted callbacks on the calling thread, with this context current, until
+    // Complete has been called and the queue is empty
+    void Run();
+    // Runs posted callbacks on the calling thread, with this context current, until
+    // task has completed. Callbacks still queued then stay queued.
+    void RunUntil(const Task& task);
+    // Lets Run return once the queue has drained
+    void Complete();
+
+    // True on the thread running the loop
+    bool IsOwnerThread() const;
+
+private:
+    struct WorkItem {
+        std::atomic<WorkItem*> next{nullptr};
+        std::function<void(void*)> callback;
+        void* state{nullptr};
+    };
+
+    void Push(WorkItem* item);
+    WorkItem* Dequeue();
+    WorkItem* DequeueLocal();
+    WorkItem* AllocateLocal();
+    void Recycle(WorkItem* item);
+    bool IsEmpty() const;
+    void WakeIfSleeping();
+    template<typename TDone>
+    void RunLoop(TDone done);
+
+    // Producers exchange m_head; only the loop touches m_tail. m_stub keeps the
+    // queue from ever being empty of nodes.
+    alignas(64) std::atomic<WorkItem*> m_head;
+    alignas(64) WorkItem* m_tail;
+    WorkItem m_stub;
+    // Posts made by the loop's own thread skip the atomics, and reuse the items
+    // the loop has finished with
+    WorkItem* m_localHead{nullptr};
+    WorkItem* m_localTail{nullptr};
+    WorkItem* m_freeItems{nullptr};
+    int m_freeCount{0};
+    static constexpr int MaxFreeItems = 64;
+    std::atomic<bool> m_sleeping{false};
+    std::atomic<bool> m_completed{false};
+    std::atomic<std::thread::id> m_ownerThread{};
+};
+
+} // namespace Threading
+} // namespace System
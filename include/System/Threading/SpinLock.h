@@ -1,20 +1,52 @@
-
 #pragma once
 
 #include "System/TimeSpan.h"
 #include <atomic>
+#include <thread>
 
 namespace System::Threading
 {
+    // Counters kept by a SpinLock constructed with statistics enabled
+    struct SpinLockStatistics
+    {
+        long long Acquisitions = 0;
+        long long ContendedAcquisitions = 0;
+        long long SpinIterations = 0;
+    };
+
+    // Queue-based (MCS) spin lock.
+    //
+    // A thread entering the lock appends a node of its own to the queue with one
+    // exchange on the tail, then spins on a flag inside that node, on its own cache
+    // line. Exit hands the lock straight to the next node, so waiters get the lock in
+    // FIFO order and a release touches only its successor's line. Nodes come from a
+    // per-thread free list.
+    //
+    // Timed TryEnter calls do not join the queue, since a queued waiter cannot leave
+    // it. Instead they poll for an empty queue until the timeout expires.
     struct SpinLock
     {
     private:
-        std::atomic_flag flag = ATOMIC_FLAG_INIT;
+        struct Node;
+        struct NodeCache;
+
+        std::atomic<Node*> tail{nullptr};
+        // Owner-only: set after acquiring, consumed by Exit
+        Node* ownerNode = nullptr;
+        std::atomic<std::thread::id> ownerThread{};
         bool isThreadOwnerTrackingEnabled;
-        thread_local static bool isHeldByCurrentThread;
+        bool isStatisticsEnabled;
+
+        // Written only by the owner; atomic so GetStatistics can read them at any time
+        std::atomic<long long> acquisitions{0};
+        std::atomic<long long> contendedAcquisitions{0};
+        std::atomic<long long> spinIterations{0};
 
     public:
-        SpinLock(bool enableThreadOwnerTracking);
+        SpinLock(bool enableThreadOwnerTracking, bool enableStatistics = false);
+
+        SpinLock(const SpinLock&) = delete;
+        SpinLock& operator=(const SpinLock&) = delete;
 
         void Enter(bool& lockTaken);
         bool TryEnter(bool& lockTaken);
@@ -27,5 +59,15 @@ namespace System::Threading
         bool GetIsHeld() const;
         bool GetIsHeldByCurrentThread() const;
         bool GetIsThreadOwnerTrackingEnabled() const;
+        bool GetIsStatisticsEnabled() const;
+
+        // Statistics; all zero unless enabled at construction
+        SpinLockStatistics GetStatistics() const;
+        void ResetStatistics();
+
+    private:
+        void ValidateEnter(bool lockTaken) const;
+        void OnAcquired(Node* node, bool contended, long long spins);
+        static NodeCache& CurrentNodeCache();
     };
 }
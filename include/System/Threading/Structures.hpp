@@ -1,22 +1,60 @@
-
 #pragma once
 
+#include "../../CompilerCompat.hpp"
 #include <chrono>
 #include <thread>
 #include <atomic>
 #include <functional>
+#include <memory>
+#include <climits>
+#include <utility>
 
 namespace System {
 namespace Threading {
 
+namespace detail {
+
+// Nanoseconds one CPU pause hint takes on this machine. Measured once: the hint
+// costs a handful of cycles on some CPUs and over a hundred on others, so spin
+// budgets are expressed in time rather than in pauses.
+inline double pause_cost_ns() {
+    static const double cost = []() {
+        constexpr int samples = 20000;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < samples; ++i) {
+            CORELIB_CPU_PAUSE();
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        double per_pause = elapsed.count() / samples;
+        return per_pause < 1.0 ? 1.0 : per_pause;
+    }();
+    return cost;
+}
+
+// Runs the calibration during static initialization, so the first thread to spin
+// does not pay for it in the middle of a wait; spins that happen earlier still
+// measure on first use
+inline const double pause_cost_at_startup_ns = pause_cost_ns();
+
+inline bool is_single_processor() {
+    static const bool single = std::thread::hardware_concurrency() <= 1;
+    return single;
+}
+
+} // namespace detail
+
 struct SpinWait {
 private:
     int spin_count_;
-    static constexpr int YIELD_THRESHOLD = 10;
     static constexpr int SLEEP_0_EVERY_HOW_MANY_TIMES = 5;
     static constexpr int SLEEP_1_EVERY_HOW_MANY_TIMES = 20;
-    
+    // First busy spin lasts this long; each later one doubles it
+    static constexpr double FIRST_SPIN_NS = 40.0;
+
 public:
+    // Spins before spin_once starts yielding: about 40us of busy waiting in all
+    static constexpr int YIELD_THRESHOLD = 10;
+    
     SpinWait() : spin_count_(0) {}
     
     void spin_once() {
@@ -31,18 +69,20 @@ public:
                 std::this_thread::yield();
             }
         } else {
-            // Busy wait with exponential backoff
-            int iterations = 4 << spin_count_;
-            for (int i = 0; i < iterations; ++i) {
-                std::atomic_thread_fence(std::memory_order_acquire);
+            // Exponential backoff in pause hints, which free the core for a
+            // hyperthread sibling and slow the polling loads
+            int pauses = static_cast<int>((FIRST_SPIN_NS * (1 << spin_count_)) / detail::pause_cost_ns());
+            for (int i = 0; i < (pauses > 0 ? pauses : 1); ++i) {
+                CORELIB_CPU_PAUSE();
             }
         }
         
         spin_count_ = (spin_count_ == INT_MAX) ? YIELD_THRESHOLD : spin_count_ + 1;
     }
     
+    // Spinning cannot help on one processor: the thread being waited for needs it
     bool next_spin_will_yield() const {
-        return spin_count_ >= YIELD_THRESHOLD;
+        return spin_count_ >= YIELD_THRESHOLD || detail::is_single_processor();
     }
     
     int get_count() const {
@@ -77,32 +117,98 @@ public:
     }
 };
 
-// Forward declaration for CancellationTokenRegistration
+// Spin-then-block policy shared by the blocking primitives: Barrier,
+// CountdownEvent, ManualResetEventSlim and SemaphoreSlim all spin through it before
+// they park. An instance is the memory of one wait site: a wait whose condition
+// came true while spinning grows the spin budget, one that still had to block
+// shrinks it. Sites whose waits are always long end up spinning only once before
+// parking, and sites whose waits are short stay out of the kernel.
+class AdaptiveSpin {
+private:
+    // Budget in SpinWait::spin_once calls, kept within the busy-wait phase
+    std::atomic<int> budget_;
+    static constexpr int MIN_BUDGET = 1;
+    static constexpr int MAX_BUDGET = SpinWait::YIELD_THRESHOLD;
+
+public:
+    AdaptiveSpin() : budget_(MAX_BUDGET / 2) {}
+    
+    // Spins until condition holds or the budget runs out; false means block now
+    template<typename Condition>
+    bool spin_until(Condition&& condition) {
+        return spin_until(std::forward<Condition>(condition), MAX_BUDGET);
+    }
+    
+    // Spins no more than limit times whatever the budget, for primitives that let
+    // the caller set a spin count
+    template<typename Condition>
+    bool spin_until(Condition&& condition, int limit) {
+        int budget = budget_.load(std::memory_order_relaxed);
+        if (!detail::is_single_processor()) {
+            SpinWait spinner;
+            int spins = budget < limit ? budget : limit;
+            for (int i = 0; i < spins; ++i) {
+                if (condition()) {
+                    // Racy read-modify-write: a lost update only delays adaptation
+                    budget_.store(budget < MAX_BUDGET ? budget + 1 : MAX_BUDGET, std::memory_order_relaxed);
+                    return true;
+                }
+                spinner.spin_once();
+            }
+        }
+        if (condition()) {
+            return true;
+        }
+        budget_.store(budget > MIN_BUDGET ? budget - 1 : MIN_BUDGET, std::memory_order_relaxed);
+        return false;
+    }
+    
+    int get_budget() const {
+        return budget_.load(std::memory_order_relaxed);
+    }
+};
+
+// Forward declarations for CancellationTokenRegistration
 class CancellationToken;
 
+namespace detail {
+class CancellationState;
+struct CancellationCallbackNode;
+}
+
+// Owns one callback registered with a CancellationToken. Disposing it (or
+// destroying it) unregisters the callback; if the callback is already running on
+// another thread, dispose waits for it to return.
 struct CancellationTokenRegistration {
 private:
-    std::shared_ptr<void> registration_handle_;
-    std::weak_ptr<CancellationToken> token_;
-    
+    detail::CancellationState* state_ = nullptr;
+    detail::CancellationCallbackNode* node_ = nullptr;
+
+    friend class CancellationToken;
+
+    // Adopts one reference to each
+    CancellationTokenRegistration(detail::CancellationState* state, detail::CancellationCallbackNode* node)
+        : state_(state)
+        , node_(node) {}
+
 public:
     CancellationTokenRegistration() = default;
     
-    CancellationTokenRegistration(std::shared_ptr<void> handle, 
-                                 std::weak_ptr<CancellationToken> token)
-        : registration_handle_(std::move(handle))
-        , token_(std::move(token)) {}
-    
     // Move constructor and assignment
     CancellationTokenRegistration(CancellationTokenRegistration&& other) noexcept
-        : registration_handle_(std::move(other.registration_handle_))
-        , token_(std::move(other.token_)) {}
+        : state_(other.state_)
+        , node_(other.node_) {
+        other.state_ = nullptr;
+        other.node_ = nullptr;
+    }
     
     CancellationTokenRegistration& operator=(CancellationTokenRegistration&& other) noexcept {
         if (this != &other) {
             dispose();
-            registration_handle_ = std::move(other.registration_handle_);
-            token_ = std::move(other.token_);
+            state_ = other.state_;
+            node_ = other.node_;
+            other.state_ = nullptr;
+            other.node_ = nullptr;
         }
         return *this;
     }
@@ -118,7 +224,7 @@ public:
     void dispose();
     
     bool operator==(const CancellationTokenRegistration& other) const {
-        return registration_handle_ == other.registration_handle_;
+        return node_ == other.node_;
     }
     
     bool operator!=(const CancellationTokenRegistration& other) const {
@@ -127,7 +233,7 @@ public:
     
     // Check if the registration is valid
     bool is_valid() const {
-        return registration_handle_ != nullptr && !token_.expired();
+        return node_ != nullptr;
     }
 };
 
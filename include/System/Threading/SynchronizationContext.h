@@ -14,9 +14,6 @@
 namespace System {
 namespace Threading {
 
-// Forward declarations
-class SendOrPostCallback;
-
 class SynchronizationContext : public System::Object {
 public:
     // Constructor and destructor
@@ -1,13 +1,18 @@
-
 #pragma once
 
 #include "Enums.hpp"
 #include "Delegates.hpp"
 #include "CancellationToken.hpp"
-#include <future>
+#include "TaskScheduler.hpp"
+#include "TaskCore.hpp"
+#include "TimerWheel.hpp"
+#include <atomic>
+#include <mutex>
 #include <memory>
 #include <functional>
 #include <exception>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 #include <thread>
 #include <chrono>
@@ -16,29 +21,35 @@ namespace System {
 namespace Threading {
 
 // Forward declarations
-template<typename T> class Task;
+template<typename T> class TaskOf;
 template<typename T> class TaskCompletionSource;
+template<typename T> class TaskAwaiter;
+template<typename T> class ConfiguredTaskAwaitable;
+
+namespace detail {
+template<typename T> class TaskPromise;
+}
 
 // Base Task class (non-generic)
+//
+// A Task is a reference to a detail::TaskCore; copies share the same state and
+// cost one atomic increment. Status queries are lock-free reads of the core's
+// state word.
 class Task {
 protected:
-    std::shared_future<void> future_;
-    TaskStatus status_;
-    std::exception_ptr exception_;
-    CancellationToken cancellation_token_;
-    TaskCreationOptions creation_options_;
-    mutable std::mutex status_mutex_;
-    
-    Task(std::shared_future<void> future, 
-         CancellationToken token = CancellationToken::none(),
-         TaskCreationOptions options = TaskCreationOptions::None)
-        : future_(std::move(future))
-        , status_(TaskStatus::Created)
-        , cancellation_token_(token)
-        , creation_options_(options) {}
+    detail::TaskCoreRef<detail::TaskCore> core_;
     
+    template<typename> friend class TaskCompletionSource;
+
 public:
-    Task() : status_(TaskStatus::Created) {}
+    // A function returning Task may be a coroutine (see TaskAwaiter.hpp)
+    using promise_type = detail::TaskPromise<void>;
+    
+    Task() = default;
+    
+    // core must be completed by whoever created it
+    explicit Task(detail::TaskCoreRef<detail::TaskCore> core)
+        : core_(std::move(core)) {}
     
     virtual ~Task() = default;
     
@@ -48,17 +59,19 @@ public:
     Task(Task&&) = default;
     Task& operator=(Task&&) = default;
     
+    // co_await resumes on the current SynchronizationContext, if any;
+    // configure_await(false) always resumes on the completing thread
+    TaskAwaiter<void> get_awaiter() const;
+    TaskAwaiter<void> operator co_await() const;
+    ConfiguredTaskAwaitable<void> configure_await(bool continue_on_captured_context) const;
+    
     // Properties
     TaskStatus get_status() const {
-        std::lock_guard<std::mutex> lock(status_mutex_);
-        return status_;
+        return core_ ? core_->get_status() : TaskStatus::Created;
     }
     
     bool is_completed() const {
-        auto status = get_status();
-        return status == TaskStatus::RanToCompletion || 
-               status == TaskStatus::Faulted || 
-               status == TaskStatus::Canceled;
+        return core_ && core_->is_completed();
     }
     
     bool is_completed_successfully() const {
@@ -74,305 +87,397 @@ public:
     }
     
     std::exception_ptr get_exception() const {
-        std::lock_guard<std::mutex> lock(status_mutex_);
-        return exception_;
+        return core_ ? core_->get_exception() : nullptr;
     }
     
     CancellationToken get_cancellation_token() const {
-        return cancellation_token_;
+        return core_ ? core_->get_token() : CancellationToken::none();
     }
     
     TaskCreationOptions get_creation_options() const {
-        return creation_options_;
+        return core_ ? core_->get_options() : TaskCreationOptions::None;
     }
     
-    // Wait methods
+    // Wait methods. A faulted or canceled task rethrows its exception.
     void wait() const {
-        if (future_.valid()) {
-            try {
-                future_.wait();
-                update_status_from_future();
-            } catch (...) {
-                std::lock_guard<std::mutex> lock(status_mutex_);
-                status_ = TaskStatus::Faulted;
-                exception_ = std::current_exception();
-                throw;
-            }
+        if (!core_) {
+            return;
         }
+        core_->wait();
+        throw_if_failed();
     }
     
+    // -1 waits indefinitely
     bool wait(int millisecondsTimeout) const {
-        if (!future_.valid()) {
+        if (millisecondsTimeout == -1) {
+            wait();
             return true;
         }
-        
-        auto timeout = std::chrono::milliseconds(millisecondsTimeout);
-        auto status = future_.wait_for(timeout);
-        
-        if (status == std::future_status::ready) {
-            update_status_from_future();
-            return true;
-        }
-        
-        return false;
+        return wait(std::chrono::milliseconds(millisecondsTimeout));
     }
     
     template<typename Rep, typename Period>
     bool wait(const std::chrono::duration<Rep, Period>& timeout) const {
-        if (!future_.valid()) {
+        if (!core_) {
             return true;
         }
         
-        auto status = future_.wait_for(timeout);
-        
-        if (status == std::future_status::ready) {
-            update_status_from_future();
-            return true;
+        if (!core_->is_completed()) {
+            if (timeout <= std::chrono::duration<Rep, Period>::zero()) {
+                return false;
+            }
+            auto waiter = std::make_shared<detail::CompletionWaiter>(1);
+            core_->add_continuation([waiter]() {
+                waiter->signal(0);
+            });
+            auto deadline = std::chrono::steady_clock::now() +
+                            std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+            if (!waiter->wait_until(deadline)) {
+                return false;
+            }
         }
         
-        return false;
+        throw_if_failed();
+        return true;
     }
     
     // Continuation methods
     Task continue_with(std::function<void(Task&)> continuation,
                       TaskContinuationOptions options = TaskContinuationOptions::None) {
-        return continue_with_impl(std::move(continuation), options);
+        return continue_with(std::move(continuation), options, continuation_scheduler(options));
+    }
+    
+    Task continue_with(std::function<void(Task&)> continuation,
+                      TaskContinuationOptions options,
+                      TaskScheduler& scheduler) {
+        return Task(continue_with_core<void, Task>(std::move(continuation), options, scheduler));
     }
     
     template<typename TResult>
-    Task<TResult> continue_with(std::function<TResult(Task&)> continuation,
+    TaskOf<TResult> continue_with(std::function<TResult(Task&)> continuation,
                                TaskContinuationOptions options = TaskContinuationOptions::None) {
-        return continue_with_impl(std::move(continuation), options);
+        return continue_with<TResult>(std::move(continuation), options, continuation_scheduler(options));
+    }
+    
+    template<typename TResult>
+    TaskOf<TResult> continue_with(std::function<TResult(Task&)> continuation,
+                               TaskContinuationOptions options,
+                               TaskScheduler& scheduler) {
+        return TaskOf<TResult>(continue_with_core<TResult, Task>(std::move(continuation), options, scheduler));
     }
     
     // Static factory methods
-    static Task run(std::function<void()> action, 
+    static Task run(std::function<void()> action,
                    CancellationToken cancellationToken = CancellationToken::none(),
                    TaskCreationOptions options = TaskCreationOptions::None) {
-        auto promise = std::make_shared<std::promise<void>>();
-        auto future = promise->get_future().share();
-        
-        std::thread([promise, action = std::move(action), cancellationToken]() {
-            try {
-                cancellationToken.throw_if_cancellation_requested();
-                action();
-                promise->set_value();
-            } catch (...) {
-                promise->set_exception(std::current_exception());
-            }
-        }).detach();
-        
-        return Task(std::move(future), cancellationToken, options);
+        return run(std::move(action), std::move(cancellationToken), options, TaskScheduler::get_default());
+    }
+    
+    static Task run(std::function<void()> action,
+                   CancellationToken cancellationToken,
+                   TaskCreationOptions options,
+                   TaskScheduler& scheduler) {
+        auto* core = new detail::TaskCoreOf<void>(TaskStatus::WaitingToRun, std::move(cancellationToken),
+                                                  options, std::move(action));
+        Task task{detail::TaskCoreRef<detail::TaskCore>(core)};
+        schedule(core, scheduler, options);
+        return task;
     }
     
     template<typename TResult>
-    static Task<TResult> run(std::function<TResult()> function,
+    static TaskOf<TResult> run(std::function<TResult()> function,
                             CancellationToken cancellationToken = CancellationToken::none(),
                             TaskCreationOptions options = TaskCreationOptions::None) {
-        auto promise = std::make_shared<std::promise<TResult>>();
-        auto future = promise->get_future().share();
-        
-        std::thread([promise, function = std::move(function), cancellationToken]() {
-            try {
-                cancellationToken.throw_if_cancellation_requested();
-                if constexpr (std::is_void_v<TResult>) {
-                    function();
-                    promise->set_value();
-                } else {
-                    auto result = function();
-                    promise->set_value(std::move(result));
-                }
-            } catch (...) {
-                promise->set_exception(std::current_exception());
-            }
-        }).detach();
-        
-        return Task<TResult>(std::move(future), cancellationToken, options);
+        return run<TResult>(std::move(function), std::move(cancellationToken), options, TaskScheduler::get_default());
     }
     
+    template<typename TResult>
+    static TaskOf<TResult> run(std::function<TResult()> function,
+                            CancellationToken cancellationToken,
+                            TaskCreationOptions options,
+                            TaskScheduler& scheduler) {
+        auto* core = new detail::TaskCoreOf<TResult>(TaskStatus::WaitingToRun, std::move(cancellationToken),
+                                                     options, std::move(function));
+        TaskOf<TResult> task{detail::TaskCoreRef<detail::TaskCore>(core)};
+        schedule(core, scheduler, options);
+        return task;
+    }
+    
+    // Deduces TResult from a callable, so Task::run([] { return 42; }) yields a TaskOf<int>
+    template<typename TFunction,
+             typename TResult = std::invoke_result_t<TFunction&>,
+             std::enable_if_t<!std::is_void_v<TResult>, int> = 0>
+    static TaskOf<TResult> run(TFunction function,
+                            CancellationToken cancellationToken = CancellationToken::none(),
+                            TaskCreationOptions options = TaskCreationOptions::None) {
+        return run<TResult>(std::function<TResult()>(std::move(function)), std::move(cancellationToken),
+                            options, TaskScheduler::get_default());
+    }
+    
+    // Shared, already completed task; never allocates
     static Task completed_task() {
-        auto promise = std::promise<void>();
-        promise.set_value();
-        return Task(promise.get_future().share());
+        return Task(detail::completed_core());
     }
     
     static Task from_exception(std::exception_ptr exception) {
-        auto promise = std::promise<void>();
-        promise.set_exception(exception);
-        return Task(promise.get_future().share());
+        return Task(detail::TaskCoreRef<detail::TaskCore>(
+            new detail::TaskCore(std::move(exception), TaskStatus::Faulted)));
     }
     
+    // bool results and small integers come from cached completed tasks
     template<typename TResult>
-    static Task<TResult> from_result(TResult result) {
-        auto promise = std::promise<TResult>();
-        promise.set_value(std::move(result));
-        return Task<TResult>(promise.get_future().share());
+    static TaskOf<TResult> from_result(TResult result) {
+        if (auto cached = detail::cached_result_core(result)) {
+            return TaskOf<TResult>(std::move(cached));
+        }
+        return TaskOf<TResult>(detail::TaskCoreRef<detail::TaskCore>(
+            new detail::TaskCoreOf<TResult>(std::in_place, std::move(result))));
     }
     
     static Task from_canceled(CancellationToken cancellationToken) {
-        auto promise = std::promise<void>();
-        promise.set_exception(std::make_exception_ptr(OperationCanceledException()));
-        return Task(promise.get_future().share(), cancellationToken);
+        return Task(detail::TaskCoreRef<detail::TaskCore>(
+            new detail::TaskCore(std::make_exception_ptr(OperationCanceledException()),
+                                 TaskStatus::Canceled, std::move(cancellationToken))));
     }
     
-    // Wait for all tasks
+    // Wait for all tasks. Blocks on a single countdown signalled by the tasks'
+    // completions; a timeout of -1 waits indefinitely. Once every task has completed,
+    // the first faulted or canceled one in list order rethrows its exception; a
+    // timed-out wait returns false without throwing.
     static void wait_all(const std::vector<Task>& tasks) {
-        for (const auto& task : tasks) {
-            task.wait();
-        }
+        wait_for_tasks(tasks, tasks.size(), -1, nullptr);
+        throw_first_failure(tasks);
     }
     
     static bool wait_all(const std::vector<Task>& tasks, int millisecondsTimeout) {
-        auto start_time = std::chrono::steady_clock::now();
-        
-        for (const auto& task : tasks) {
-            auto elapsed = std::chrono::steady_clock::now() - start_time;
-            auto remaining = std::chrono::milliseconds(millisecondsTimeout) - elapsed;
-            
-            if (remaining <= std::chrono::milliseconds(0) || !task.wait(remaining)) {
-                return false;
-            }
+        if (wait_for_tasks(tasks, tasks.size(), millisecondsTimeout, nullptr) < 0) {
+            return false;
         }
-        
+        throw_first_failure(tasks);
         return true;
     }
     
-    // Wait for any task
-    static int wait_any(const std::vector<Task>& tasks) {
-        // Simple implementation - in practice, this would be more sophisticated
-        while (true) {
-            for (size_t i = 0; i < tasks.size(); ++i) {
-                if (tasks[i].is_completed()) {
-                    return static_cast<int>(i);
-                }
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    static void wait_all(const std::vector<Task>& tasks, CancellationToken cancellationToken) {
+        wait_for_tasks(tasks, tasks.size(), -1, &cancellationToken);
+        throw_first_failure(tasks);
+    }
+    
+    static bool wait_all(const std::vector<Task>& tasks, int millisecondsTimeout,
+                         CancellationToken cancellationToken) {
+        if (wait_for_tasks(tasks, tasks.size(), millisecondsTimeout, &cancellationToken) < 0) {
+            return false;
         }
+        throw_first_failure(tasks);
+        return true;
+    }
+    
+    // Wait for any task. Returns the index of the first task to complete, or -1 on timeout.
+    static int wait_any(const std::vector<Task>& tasks) {
+        return wait_for_tasks(tasks, 1, -1, nullptr);
     }
     
     static int wait_any(const std::vector<Task>& tasks, int millisecondsTimeout) {
-        auto start_time = std::chrono::steady_clock::now();
+        return wait_for_tasks(tasks, 1, millisecondsTimeout, nullptr);
+    }
+    
+    static int wait_any(const std::vector<Task>& tasks, CancellationToken cancellationToken) {
+        return wait_for_tasks(tasks, 1, -1, &cancellationToken);
+    }
+    
+    static int wait_any(const std::vector<Task>& tasks, int millisecondsTimeout,
+                        CancellationToken cancellationToken) {
+        return wait_for_tasks(tasks, 1, millisecondsTimeout, &cancellationToken);
+    }
+    
+    // Task that completes when every task has. It faults with the first fault among
+    // them, is canceled if any was canceled, and otherwise runs to completion.
+    // Canceling cancellationToken cancels the returned task, not the inputs.
+    static Task when_all(const std::vector<Task>& tasks,
+                         CancellationToken cancellationToken = CancellationToken::none()) {
+        if (tasks.empty()) {
+            return completed_task();
+        }
+        
+        auto state = std::make_shared<CombinatorState>(
+            new detail::TaskCoreOf<void>(TaskStatus::WaitingForActivation, cancellationToken));
+        state->remaining.store(tasks.size(), std::memory_order_relaxed);
+        state->tasks = tasks;
         
-        while (std::chrono::steady_clock::now() - start_time < std::chrono::milliseconds(millisecondsTimeout)) {
-            for (size_t i = 0; i < tasks.size(); ++i) {
-                if (tasks[i].is_completed()) {
-                    return static_cast<int>(i);
+        for (const auto& task : tasks) {
+            on_completed(task, [state]() {
+                if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                    return;
                 }
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                
+                std::exception_ptr fault;
+                bool canceled = false;
+                for (const auto& input : state->tasks) {
+                    TaskStatus status = input.get_status();
+                    if (status == TaskStatus::Faulted && !fault) {
+                        fault = input.get_exception();
+                    } else if (status == TaskStatus::Canceled) {
+                        canceled = true;
+                    }
+                }
+                state->tasks.clear();
+                
+                if (fault) {
+                    state->core->try_set_exception(fault);
+                } else if (canceled) {
+                    state->core->try_set_canceled();
+                } else {
+                    state->core->try_set_result();
+                }
+            });
         }
         
-        return -1; // Timeout
+        register_cancellation(state, cancellationToken);
+        return Task(state->core);
     }
     
+    // Task whose result is the index of the first task to complete, whatever its outcome.
+    // Canceling cancellationToken cancels the returned task, not the inputs.
+    static TaskOf<int> when_any(const std::vector<Task>& tasks,
+                              CancellationToken cancellationToken = CancellationToken::none());
+    
     // Delay
     static Task delay(int millisecondsDelay, CancellationToken cancellationToken = CancellationToken::none()) {
         return delay(std::chrono::milliseconds(millisecondsDelay), cancellationToken);
     }
     
     template<typename Rep, typename Period>
-    static Task delay(const std::chrono::duration<Rep, Period>& delay, 
+    static Task delay(const std::chrono::duration<Rep, Period>& delay,
                      CancellationToken cancellationToken = CancellationToken::none()) {
-        auto promise = std::make_shared<std::promise<void>>();
-        auto future = promise->get_future().share();
+        if (cancellationToken.is_cancellation_requested()) {
+            return from_canceled(cancellationToken);
+        }
+        
+        auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(delay).count();
+        if (milliseconds <= 0) {
+            return completed_task();
+        }
         
-        std::thread([promise, delay, cancellationToken]() {
-            try {
-                std::this_thread::sleep_for(delay);
-                cancellationToken.throw_if_cancellation_requested();
-                promise->set_value();
-            } catch (...) {
-                promise->set_exception(std::current_exception());
+        auto state = std::make_shared<DelayState>();
+        state->core = detail::TaskCoreRef<detail::TaskCore>(
+            new detail::TaskCoreOf<void>(TaskStatus::WaitingForActivation, cancellationToken));
+        
+        // One entry in the shared timer wheel rather than a sleeping thread per delay
+        state->timer = TimerWheel::instance().schedule([state]() {
+            if (state->core->try_set_result()) {
+                state->dispose_registration();
             }
-        }).detach();
+        }, static_cast<std::int64_t>(milliseconds));
+        
+        if (cancellationToken != CancellationToken::none()) {
+            std::weak_ptr<DelayState> weak_state = state;
+            auto registration = cancellationToken.register_callback([weak_state]() {
+                if (auto alive = weak_state.lock()) {
+                    TimerWheel::instance().cancel(alive->timer.lock());
+                    alive->core->try_set_canceled();
+                }
+            });
+            state->set_registration(std::move(registration));
+        }
         
-        return Task(std::move(future), cancellationToken);
+        return Task(state->core);
     }
-    
+
 protected:
-    void update_status_from_future() const {
-        if (!future_.valid()) {
-            return;
+    // Scheduling hints shared by TaskCreationOptions and TaskContinuationOptions
+    static TaskCreationOptions to_creation_options(TaskContinuationOptions options) {
+        constexpr int shared_flags = static_cast<int>(TaskCreationOptions::PreferFairness) |
+                                     static_cast<int>(TaskCreationOptions::LongRunning);
+        return static_cast<TaskCreationOptions>(static_cast<int>(options) & shared_flags);
+    }
+    
+    static TaskScheduler& continuation_scheduler(TaskContinuationOptions options) {
+        if ((options & TaskContinuationOptions::HideScheduler) != TaskContinuationOptions::None) {
+            return TaskScheduler::get_default();
         }
-        
-        std::lock_guard<std::mutex> lock(status_mutex_);
-        
+        return TaskScheduler::get_current();
+    }
+    
+    void throw_if_failed() const {
+        TaskStatus status = core_->get_status();
+        if (status == TaskStatus::Faulted || status == TaskStatus::Canceled) {
+            std::rethrow_exception(core_->get_exception());
+        }
+    }
+    
+    // Hands a core's body to the scheduler. The queued work item holds its own
+    // reference and captures nothing else, so it fits std::function's inline buffer.
+    static void schedule(detail::TaskCore* core, TaskScheduler& scheduler, TaskCreationOptions options) {
+        core->add_ref();
         try {
-            // This will throw if the future contains an exception
-            future_.get();
-            status_ = TaskStatus::RanToCompletion;
-        } catch (const OperationCanceledException&) {
-            status_ = TaskStatus::Canceled;
-            exception_ = std::current_exception();
+            scheduler.queue_task([core]() {
+                detail::TaskCoreRef<detail::TaskCore> owned(core);
+                owned->run_body();
+            }, options);
         } catch (...) {
-            status_ = TaskStatus::Faulted;
-            exception_ = std::current_exception();
+            core->release();
+            throw;
         }
     }
     
-private:
-    Task continue_with_impl(std::function<void(Task&)> continuation,
-                           TaskContinuationOptions options) {
-        auto promise = std::make_shared<std::promise<void>>();
-        auto future = promise->get_future().share();
-        
-        std::thread([this, promise, continuation = std::move(continuation), options]() {
-            try {
-                // Wait for this task to complete
-                this->wait();
-                
-                // Check continuation options
-                if (should_run_continuation(options)) {
-                    continuation(*this);
-                }
-                
-                promise->set_value();
-            } catch (...) {
-                promise->set_exception(std::current_exception());
-            }
-        }).detach();
-        
-        return Task(std::move(future), cancellation_token_);
+    // Runs action once task has completed; a default-constructed task counts as completed
+    static void on_completed(const Task& task, std::function<void()> action) {
+        if (task.core_) {
+            task.core_->add_continuation(std::move(action));
+        } else {
+            action();
+        }
     }
     
-    template<typename TResult>
-    Task<TResult> continue_with_impl(std::function<TResult(Task&)> continuation,
-                                    TaskContinuationOptions options) {
-        auto promise = std::make_shared<std::promise<TResult>>();
-        auto future = promise->get_future().share();
+    // Registers body to run once this task has completed. ExecuteSynchronously runs it
+    // inline on the completing thread (unless this task asked for asynchronous
+    // continuations); anything else is posted to the scheduler at that point.
+    void add_continuation(std::function<void()> body,
+                          TaskContinuationOptions options,
+                          TaskScheduler& scheduler) const {
+        bool execute_synchronously =
+            (options & TaskContinuationOptions::ExecuteSynchronously) != TaskContinuationOptions::None &&
+            (get_creation_options() & TaskCreationOptions::RunContinuationsAsynchronously) == TaskCreationOptions::None;
         
-        std::thread([this, promise, continuation = std::move(continuation), options]() {
-            try {
-                // Wait for this task to complete
-                this->wait();
-                
-                // Check continuation options
-                if (should_run_continuation(options)) {
-                    if constexpr (std::is_void_v<TResult>) {
-                        continuation(*this);
-                        promise->set_value();
-                    } else {
-                        auto result = continuation(*this);
-                        promise->set_value(std::move(result));
-                    }
-                } else {
-                    if constexpr (std::is_void_v<TResult>) {
-                        promise->set_value();
-                    } else {
-                        promise->set_value(TResult{});
-                    }
-                }
-            } catch (...) {
-                promise->set_exception(std::current_exception());
+        if (execute_synchronously) {
+            on_completed(*this, std::move(body));
+            return;
+        }
+        
+        TaskScheduler* target = &scheduler;
+        TaskCreationOptions creation = to_creation_options(options);
+        on_completed(*this, [target, creation, body = std::move(body)]() mutable {
+            target->queue_task(std::move(body), creation);
+        });
+    }
+    
+    // Creates the core of a continuation of this task. The antecedent is handed to the
+    // continuation as a TAntecedent sharing this task's core. A continuation excluded
+    // by its options ends up Canceled, as in .NET.
+    template<typename TResult, typename TAntecedent>
+    detail::TaskCoreRef<detail::TaskCore> continue_with_core(std::function<TResult(TAntecedent&)> continuation,
+                                                             TaskContinuationOptions options,
+                                                             TaskScheduler& scheduler) const {
+        auto* continuation_core = new detail::TaskCoreOf<TResult>(
+            TaskStatus::WaitingForActivation, CancellationToken::none(), to_creation_options(options),
+            [antecedent = TAntecedent(core_), continuation = std::move(continuation)]() mutable -> TResult {
+                return continuation(antecedent);
+            });
+        detail::TaskCoreRef<detail::TaskCore> result(continuation_core);
+        
+        add_continuation([antecedent_core = core_, pending = result, options]() {
+            TaskStatus status = antecedent_core ? antecedent_core->get_status() : TaskStatus::RanToCompletion;
+            if (should_run_continuation(status, options)) {
+                pending->run_body();
+            } else {
+                pending->try_set_canceled();
             }
-        }).detach();
+        }, options, scheduler);
         
-        return Task<TResult>(std::move(future), cancellation_token_);
+        return result;
     }
     
-    bool should_run_continuation(TaskContinuationOptions options) const {
-        auto status = get_status();
-        
+    static bool should_run_continuation(TaskStatus status, TaskContinuationOptions options) {
+        // The OnlyOn* values are combinations of the NotOn* bits
         if ((options & TaskContinuationOptions::NotOnRanToCompletion) != TaskContinuationOptions::None &&
             status == TaskStatus::RanToCompletion) {
             return false;
@@ -388,130 +493,208 @@ private:
             return false;
         }
         
-        if ((options & TaskContinuationOptions::OnlyOnRanToCompletion) != TaskContinuationOptions::None &&
-            status != TaskStatus::RanToCompletion) {
-            return false;
+        return true;
+    }
+
+private:
+    // Shared by the when_* combinators: the core of the returned task plus what the
+    // input completions need to decide its outcome.
+    struct CombinatorState {
+        detail::TaskCoreRef<detail::TaskCore> core;
+        std::atomic<size_t> remaining{0};
+        std::vector<Task> tasks;
+        CancellationTokenRegistration cancellation_registration;
+        
+        explicit CombinatorState(detail::TaskCore* combinator_core) : core(combinator_core) {}
+    };
+    
+    // The registration is owned by the state, so the callback holds it weakly
+    static void register_cancellation(const std::shared_ptr<CombinatorState>& state,
+                                      CancellationToken token) {
+        if (token == CancellationToken::none() || state->core->is_completed()) {
+            return;
+        }
+        std::weak_ptr<CombinatorState> weak_state = state;
+        state->cancellation_registration = token.register_callback([weak_state]() {
+            if (auto alive = weak_state.lock()) {
+                alive->core->try_set_canceled();
+            }
+        });
+    }
+    
+    // A pending delay: completed by its timer wheel entry or by its token, whichever
+    // comes first. The timer entry owns the state until it fires or is canceled.
+    struct DelayState {
+        detail::TaskCoreRef<detail::TaskCore> core;
+        // Weak: the entry's callback already owns this state
+        std::weak_ptr<TimerWheel::Entry> timer;
+        std::mutex registration_mutex;
+        CancellationTokenRegistration registration;
+        
+        // Only from the timer path: the token's callback must not unregister itself
+        void dispose_registration() {
+            std::lock_guard<std::mutex> lock(registration_mutex);
+            registration.dispose();
         }
         
-        if ((options & TaskContinuationOptions::OnlyOnFaulted) != TaskContinuationOptions::None &&
-            status != TaskStatus::Faulted) {
-            return false;
+        void set_registration(CancellationTokenRegistration value) {
+            std::lock_guard<std::mutex> lock(registration_mutex);
+            if (core->is_completed()) {
+                value.dispose();
+            } else {
+                registration = std::move(value);
+            }
+        }
+    };
+    
+    // Every task has completed
+    static void throw_first_failure(const std::vector<Task>& tasks) {
+        for (const auto& task : tasks) {
+            if (task.core_) {
+                task.throw_if_failed();
+            }
+        }
+    }
+    
+    // Blocks until required tasks have completed, the timeout elapses or the token is
+    // canceled. Returns the index of the first completed task (0 for an empty list),
+    // -1 on timeout, and throws OperationCanceledException on cancellation.
+    static int wait_for_tasks(const std::vector<Task>& tasks,
+                              size_t required,
+                              int millisecondsTimeout,
+                              CancellationToken* cancellationToken) {
+        if (cancellationToken) {
+            cancellationToken->throw_if_cancellation_requested();
         }
         
-        if ((options & TaskContinuationOptions::OnlyOnCanceled) != TaskContinuationOptions::None &&
-            status != TaskStatus::Canceled) {
-            return false;
+        if (tasks.empty()) {
+            return 0;
         }
         
-        return true;
+        // Fast path: enough tasks have already finished
+        size_t completed = 0;
+        int first_completed = -1;
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            if (!tasks[i].core_ || tasks[i].core_->is_completed()) {
+                ++completed;
+                if (first_completed < 0) {
+                    first_completed = static_cast<int>(i);
+                }
+            }
+        }
+        if (completed >= required) {
+            return first_completed;
+        }
+        
+        if (millisecondsTimeout == 0) {
+            return -1;
+        }
+        
+        auto waiter = std::make_shared<detail::CompletionWaiter>(static_cast<long long>(required));
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            int index = static_cast<int>(i);
+            on_completed(tasks[i], [waiter, index]() {
+                waiter->signal(index);
+            });
+        }
+        
+        CancellationTokenRegistration registration;
+        if (cancellationToken && *cancellationToken != CancellationToken::none()) {
+            registration = cancellationToken->register_callback([waiter]() {
+                waiter->release();
+            });
+        }
+        
+        if (millisecondsTimeout < 0) {
+            waiter->wait();
+        } else {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(millisecondsTimeout);
+            waiter->wait_until(deadline);
+        }
+        
+        if (waiter->is_satisfied()) {
+            return waiter->first_completed();
+        }
+        if (cancellationToken) {
+            cancellationToken->throw_if_cancellation_requested();
+        }
+        return -1;
     }
 };
 
-// Generic Task<T> class
+// Generic task with a T result, .NET's Task<T>. C++ cannot declare a class and
+// a class template both named Task in one namespace, hence the name.
 template<typename T>
-class Task : public Task {
-private:
-    std::shared_future<T> typed_future_;
-    
+class TaskOf : public Task {
 public:
-    Task() = default;
+    using promise_type = detail::TaskPromise<T>;
+    
+    TaskOf() = default;
     
-    Task(std::shared_future<T> future, 
-         CancellationToken token = CancellationToken::none(),
-         TaskCreationOptions options = TaskCreationOptions::None)
-        : Task(std::shared_future<void>(future), token, options)
-        , typed_future_(std::move(future)) {}
+    explicit TaskOf(detail::TaskCoreRef<detail::TaskCore> core)
+        : Task(std::move(core)) {}
+    
+    TaskAwaiter<T> get_awaiter() const;
+    TaskAwaiter<T> operator co_await() const;
+    ConfiguredTaskAwaitable<T> configure_await(bool continue_on_captured_context) const;
     
     // Get the result
     T get_result() const {
-        if (!typed_future_.valid()) {
+        if (!this->core_) {
             throw std::runtime_error("Task has no result");
         }
         
-        try {
-            auto result = typed_future_.get();
-            update_status_from_future();
-            return result;
-        } catch (...) {
-            std::lock_guard<std::mutex> lock(status_mutex_);
-            status_ = TaskStatus::Faulted;
-            exception_ = std::current_exception();
-            throw;
-        }
+        this->wait();
+        return static_cast<const detail::TaskCoreOf<T>*>(this->core_.get())->get_value();
     }
     
-    // Continuation methods for Task<T>
-    Task continue_with(std::function<void(Task<T>&)> continuation,
+    // Continuation methods for generic tasks
+    Task continue_with(std::function<void(TaskOf<T>&)> continuation,
                       TaskContinuationOptions options = TaskContinuationOptions::None) {
-        return continue_with_impl(std::move(continuation), options);
+        return continue_with(std::move(continuation), options, this->continuation_scheduler(options));
     }
     
-    template<typename TResult>
-    Task<TResult> continue_with(std::function<TResult(Task<T>&)> continuation,
-                               TaskContinuationOptions options = TaskContinuationOptions::None) {
-        return continue_with_impl(std::move(continuation), options);
+    Task continue_with(std::function<void(TaskOf<T>&)> continuation,
+                      TaskContinuationOptions options,
+                      TaskScheduler& scheduler) {
+        return Task(this->template continue_with_core<void, TaskOf<T>>(std::move(continuation), options, scheduler));
     }
     
-private:
-    Task continue_with_impl(std::function<void(Task<T>&)> continuation,
-                           TaskContinuationOptions options) {
-        auto promise = std::make_shared<std::promise<void>>();
-        auto future = promise->get_future().share();
-        
-        std::thread([this, promise, continuation = std::move(continuation), options]() {
-            try {
-                // Wait for this task to complete
-                this->wait();
-                
-                // Check continuation options
-                if (this->should_run_continuation(options)) {
-                    continuation(*this);
-                }
-                
-                promise->set_value();
-            } catch (...) {
-                promise->set_exception(std::current_exception());
-            }
-        }).detach();
-        
-        return Task(std::move(future), cancellation_token_);
+    template<typename TResult>
+    TaskOf<TResult> continue_with(std::function<TResult(TaskOf<T>&)> continuation,
+                               TaskContinuationOptions options = TaskContinuationOptions::None) {
+        return continue_with<TResult>(std::move(continuation), options, this->continuation_scheduler(options));
     }
     
     template<typename TResult>
-    Task<TResult> continue_with_impl(std::function<TResult(Task<T>&)> continuation,
-                                    TaskContinuationOptions options) {
-        auto promise = std::make_shared<std::promise<TResult>>();
-        auto future = promise->get_future().share();
-        
-        std::thread([this, promise, continuation = std::move(continuation), options]() {
-            try {
-                // Wait for this task to complete
-                this->wait();
-                
-                // Check continuation options
-                if (this->should_run_continuation(options)) {
-                    if constexpr (std::is_void_v<TResult>) {
-                        continuation(*this);
-                        promise->set_value();
-                    } else {
-                        auto result = continuation(*this);
-                        promise->set_value(std::move(result));
-                    }
-                } else {
-                    if constexpr (std::is_void_v<TResult>) {
-                        promise->set_value();
-                    } else {
-                        promise->set_value(TResult{});
-                    }
-                }
-            } catch (...) {
-                promise->set_exception(std::current_exception());
-            }
-        }).detach();
-        
-        return Task<TResult>(std::move(future), cancellation_token_);
+    TaskOf<TResult> continue_with(std::function<TResult(TaskOf<T>&)> continuation,
+                               TaskContinuationOptions options,
+                               TaskScheduler& scheduler) {
+        return TaskOf<TResult>(this->template continue_with_core<TResult, TaskOf<T>>(std::move(continuation), options, scheduler));
     }
 };
 
+// Defined after TaskOf<T>, which it returns
+inline TaskOf<int> Task::when_any(const std::vector<Task>& tasks, CancellationToken cancellationToken) {
+    if (tasks.empty()) {
+        throw std::invalid_argument("when_any requires at least one task");
+    }
+    
+    auto* core = new detail::TaskCoreOf<int>(TaskStatus::WaitingForActivation, cancellationToken);
+    auto state = std::make_shared<CombinatorState>(core);
+    
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        int index = static_cast<int>(i);
+        on_completed(tasks[i], [state, core, index]() {
+            core->try_set_result(index);
+        });
+    }
+    
+    register_cancellation(state, cancellationToken);
+    return TaskOf<int>(state->core);
+}
+
 } // namespace Threading
 } // namespace System
+
+#include "TaskAwaiter.hpp"
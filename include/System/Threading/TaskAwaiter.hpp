@@ -0,0 +1,369 @@
+#pragma once
+
+#include "Task.hpp"
+#include "SynchronizationContext.h"
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace System {
+namespace Threading {
+namespace detail {
+
+// Per-thread free lists of coroutine frames, one per 64-byte size class.
+//
+// A coroutine returning Task allocates its frame here; the promise inside the
+// frame is the task core, so the frame is the task's only allocation. Frames
+// released on another thread simply join that thread's lists. Frames larger than
+// the biggest class go straight to the global allocator.
+class CoroutineFramePool {
+private:
+    static constexpr std::size_t Granularity = 64;
+    static constexpr std::size_t ClassCount = 16;
+    static constexpr std::size_t MaxCachedPerClass = 64;
+
+    struct FreeFrame {
+        FreeFrame* next;
+    };
+
+    struct Cache {
+        FreeFrame* heads[ClassCount] = {};
+        std::size_t counts[ClassCount] = {};
+
+        ~Cache() {
+            for (FreeFrame* head : heads) {
+                while (head) {
+                    FreeFrame* next = head->next;
+                    ::operator delete(head);
+                    head = next;
+                }
+            }
+            destroyed() = true;
+        }
+    };
+
+    // Frames freed during thread teardown must not touch a destroyed cache
+    static bool& destroyed() {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+    static Cache& cache() {
+        thread_local Cache local;
+        return local;
+    }
+
+    static std::size_t size_class(std::size_t size) {
+        return (size + Granularity - 1) / Granularity - 1;
+    }
+
+public:
+    static void* allocate(std::size_t size) {
+        std::size_t index = size_class(size);
+        if (index >= ClassCount) {
+            return ::operator new(size);
+        }
+        if (!destroyed()) {
+            Cache& local = cache();
+            if (FreeFrame* frame = local.heads[index]) {
+                local.heads[index] = frame->next;
+                --local.counts[index];
+                return frame;
+            }
+        }
+        return ::operator new((index + 1) * Granularity);
+    }
+
+    static void deallocate(void* frame, std::size_t size) noexcept {
+        std::size_t index = size_class(size);
+        if (index < ClassCount && !destroyed()) {
+            Cache& local = cache();
+            if (local.counts[index] < MaxCachedPerClass) {
+                auto* free_frame = static_cast<FreeFrame*>(frame);
+                free_frame->next = local.heads[index];
+                local.heads[index] = free_frame;
+                ++local.counts[index];
+                return;
+            }
+        }
+        ::operator delete(frame);
+    }
+};
+
+// Promise of a coroutine returning Task or TaskOf<T>.
+//
+// The promise derives from the task core, so the Task handed to the caller points
+// straight into the coroutine frame. The running coroutine holds one reference
+// and drops it at its final suspend point; the frame is destroyed when the last
+// Task copy lets go. Completion is published from final_suspend, where the first
+// awaiting coroutine is resumed by symmetric transfer rather than a nested call.
+//
+// The promise also keeps the caller's ExecutionContext until the body first gives
+// the thread back, at its first suspension or at the end, and puts it back then:
+// what the body set before that point stays with the body, as in an async method.
+template<typename T, typename TPromise>
+class TaskPromiseBase : public TaskCoreOf<T> {
+private:
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<TPromise> coroutine) noexcept {
+            return coroutine.promise().finish();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::coroutine_handle<> finish() noexcept {
+        if (on_caller_) {
+            ExecutionContext::restore(take_caller_context());
+        }
+        std::coroutine_handle<> next = this->publish_and_transfer(outcome_);
+        // May destroy this frame; nothing below touches it
+        this->release();
+        return next;
+    }
+
+    ExecutionContext caller_context_;
+    bool on_caller_ = true;
+
+protected:
+    TaskStatus outcome_ = TaskStatus::Faulted;
+
+public:
+    // Constructed on the caller's thread before the body starts
+    TaskPromiseBase()
+        : TaskCoreOf<T>(TaskStatus::WaitingForActivation)
+        , caller_context_(ExecutionContext::capture()) {}
+
+    static void* operator new(std::size_t size) {
+        return CoroutineFramePool::allocate(size);
+    }
+
+    static void operator delete(void* frame, std::size_t size) noexcept {
+        CoroutineFramePool::deallocate(frame, size);
+    }
+
+    // Like an async method, the body runs synchronously until its first await
+    std::suspend_never initial_suspend() noexcept { return {}; }
+
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    bool is_on_caller() const noexcept {
+        return on_caller_;
+    }
+
+    // Taken before the body suspends, since it may be resumed elsewhere at once
+    ExecutionContext take_caller_context() noexcept {
+        on_caller_ = false;
+        return std::move(caller_context_);
+    }
+
+    // The suspension did not happen after all and the body goes on in the caller
+    void return_caller_context(ExecutionContext&& context) noexcept {
+        caller_context_ = std::move(context);
+        on_caller_ = true;
+    }
+
+    void unhandled_exception() {
+        if (this->try_reserve_completion()) {
+            outcome_ = this->store_exception(std::current_exception());
+        }
+    }
+
+protected:
+    detail::TaskCoreRef<detail::TaskCore> get_core() {
+        return detail::TaskCoreRef<detail::TaskCore>(this, true);
+    }
+
+    void destroy() noexcept override {
+        std::coroutine_handle<TPromise>::from_promise(static_cast<TPromise&>(*this)).destroy();
+    }
+};
+
+template<typename T>
+class TaskPromise : public TaskPromiseBase<T, TaskPromise<T>> {
+public:
+    TaskOf<T> get_return_object() {
+        return TaskOf<T>(this->get_core());
+    }
+
+    template<typename U = T>
+    void return_value(U&& value) {
+        if (!this->try_reserve_completion()) {
+            return;
+        }
+        try {
+            this->construct_value(std::forward<U>(value));
+            this->outcome_ = TaskStatus::RanToCompletion;
+        } catch (...) {
+            this->outcome_ = this->store_exception(std::current_exception());
+        }
+    }
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase<void, TaskPromise<void>> {
+public:
+    Task get_return_object() {
+        return Task(get_core());
+    }
+
+    void return_void() {
+        if (try_reserve_completion()) {
+            outcome_ = TaskStatus::RanToCompletion;
+        }
+    }
+};
+
+} // namespace detail
+
+// Awaiter behind co_await on a Task or TaskOf<T>.
+//
+// If the task is already complete the coroutine never suspends. Otherwise it
+// parks on the task's continuation list through a node embedded in the awaiter
+// and is resumed by whichever thread completes the task. Only when
+// continue_on_captured_context is set and a SynchronizationContext is current
+// is resumption posted back to that context instead.
+//
+// A coroutine that suspends captures the ExecutionContext and gets it back on
+// resumption, whichever thread resumes it. If this is the first suspension of a
+// Task coroutine, the thread goes back to its caller in the caller's context.
+template<typename T>
+class TaskAwaiter {
+private:
+    detail::TaskCoreRef<detail::TaskCore> core_;
+    bool continue_on_captured_context_;
+    bool suspended_ = false;
+    detail::TaskContinuation node_;
+    ExecutionContext execution_context_;
+
+public:
+    TaskAwaiter(detail::TaskCoreRef<detail::TaskCore> core, bool continue_on_captured_context)
+        : core_(std::move(core))
+        , continue_on_captured_context_(continue_on_captured_context) {}
+
+    bool await_ready() const noexcept {
+        return !core_ || core_->is_completed();
+    }
+
+    template<typename TPromise>
+    bool await_suspend(std::coroutine_handle<TPromise> coroutine) {
+        if constexpr (requires { coroutine.promise().take_caller_context(); }) {
+            auto& promise = coroutine.promise();
+            if (promise.is_on_caller()) {
+                ExecutionContext caller = promise.take_caller_context();
+                if (suspend(coroutine)) {
+                    // The frame may already be running elsewhere; only this thread is ours
+                    ExecutionContext::restore(std::move(caller));
+                    return true;
+                }
+                promise.return_caller_context(std::move(caller));
+                return false;
+            }
+        }
+        return suspend(coroutine);
+    }
+
+    T await_resume() {
+        if (suspended_) {
+            ExecutionContext::restore(std::move(execution_context_));
+        }
+        if (!core_) {
+            if constexpr (std::is_void_v<T>) {
+                return;
+            } else {
+                throw std::runtime_error("Task has no result");
+            }
+        }
+
+        TaskStatus status = core_->get_status();
+        if (status == TaskStatus::Faulted || status == TaskStatus::Canceled) {
+            std::rethrow_exception(core_->get_exception());
+        }
+        if constexpr (!std::is_void_v<T>) {
+            return static_cast<const detail::TaskCoreOf<T>*>(core_.get())->get_value();
+        }
+    }
+
+private:
+    bool suspend(std::coroutine_handle<> coroutine) {
+        // Set before anything can resume the coroutine on another thread
+        execution_context_ = ExecutionContext::capture();
+        suspended_ = true;
+        if (continue_on_captured_context_) {
+            if (auto context = SynchronizationContext::Current()) {
+                core_->add_continuation([context, coroutine]() {
+                    context->Post([coroutine](void*) {
+                        detail::ExecutionContextScope scope;
+                        coroutine.resume();
+                    }, nullptr);
+                });
+                return true;
+            }
+        }
+        node_.coroutine = coroutine;
+        if (!core_->try_add_coroutine(node_)) {
+            // Already complete: carry on in the current context
+            suspended_ = false;
+            return false;
+        }
+        return true;
+    }
+};
+
+// Result of configure_await(): an awaitable with an explicit context choice
+template<typename T>
+class ConfiguredTaskAwaitable {
+private:
+    detail::TaskCoreRef<detail::TaskCore> core_;
+    bool continue_on_captured_context_;
+
+public:
+    ConfiguredTaskAwaitable(detail::TaskCoreRef<detail::TaskCore> core, bool continue_on_captured_context)
+        : core_(std::move(core))
+        , continue_on_captured_context_(continue_on_captured_context) {}
+
+    TaskAwaiter<T> get_awaiter() const {
+        return TaskAwaiter<T>(core_, continue_on_captured_context_);
+    }
+
+    TaskAwaiter<T> operator co_await() const {
+        return get_awaiter();
+    }
+};
+
+inline TaskAwaiter<void> Task::get_awaiter() const {
+    return TaskAwaiter<void>(core_, true);
+}
+
+inline TaskAwaiter<void> Task::operator co_await() const {
+    return get_awaiter();
+}
+
+inline ConfiguredTaskAwaitable<void> Task::configure_await(bool continue_on_captured_context) const {
+    return ConfiguredTaskAwaitable<void>(core_, continue_on_captured_context);
+}
+
+template<typename T>
+TaskAwaiter<T> TaskOf<T>::get_awaiter() const {
+    return TaskAwaiter<T>(this->core_, true);
+}
+
+template<typename T>
+TaskAwaiter<T> TaskOf<T>::operator co_await() const {
+    return get_awaiter();
+}
+
+template<typename T>
+ConfiguredTaskAwaitable<T> TaskOf<T>::configure_await(bool continue_on_captured_context) const {
+    return ConfiguredTaskAwaitable<T>(this->core_, continue_on_captured_context);
+}
+
+} // namespace Threading
+} // namespace System
@@ -1,187 +1,126 @@
-
 #pragma once
 
 #include "Task.hpp"
-#include <promise>
-#include <future>
 #include <memory>
 
 namespace System {
 namespace Threading {
 
+// The source owns nothing but its task: completion is a CAS on the task core's
+// state word, so concurrent set/try_set calls race safely without a lock.
 template<typename T>
 class TaskCompletionSource {
 private:
-    std::shared_ptr<std::promise<T>> promise_;
-    Task<T> task_;
-    std::atomic<bool> completed_;
-    
+    TaskOf<T> task_;
+
+    detail::TaskCoreOf<T>* core() const {
+        return static_cast<detail::TaskCoreOf<T>*>(task_.core_.get());
+    }
+
+    static void throw_already_completed() {
+        throw std::runtime_error("TaskCompletionSource has already been completed");
+    }
+
 public:
-    TaskCompletionSource() 
-        : promise_(std::make_shared<std::promise<T>>())
-        , task_(promise_->get_future().share())
-        , completed_(false) {}
-    
+    TaskCompletionSource()
+        : TaskCompletionSource(TaskCreationOptions::None) {}
+
     explicit TaskCompletionSource(TaskCreationOptions options)
-        : promise_(std::make_shared<std::promise<T>>())
-        , task_(promise_->get_future().share(), CancellationToken::none(), options)
-        , completed_(false) {}
-    
+        : task_(detail::TaskCoreRef<detail::TaskCore>(
+              new detail::TaskCoreOf<T>(TaskStatus::WaitingForActivation, CancellationToken::none(), options))) {}
+
     TaskCompletionSource(void* state, TaskCreationOptions options)
-        : promise_(std::make_shared<std::promise<T>>())
-        , task_(promise_->get_future().share(), CancellationToken::none(), options)
-        , completed_(false) {
+        : TaskCompletionSource(options) {
         // Note: state parameter is for compatibility but not used in this implementation
         (void)state;
     }
-    
+
     // Disable copy constructor and assignment
     TaskCompletionSource(const TaskCompletionSource&) = delete;
     TaskCompletionSource& operator=(const TaskCompletionSource&) = delete;
-    
+
     // Move constructor and assignment
-    TaskCompletionSource(TaskCompletionSource&& other) noexcept
-        : promise_(std::move(other.promise_))
-        , task_(std::move(other.task_))
-        , completed_(other.completed_.load()) {}
-    
-    TaskCompletionSource& operator=(TaskCompletionSource&& other) noexcept {
-        if (this != &other) {
-            promise_ = std::move(other.promise_);
-            task_ = std::move(other.task_);
-            completed_.store(other.completed_.load());
-        }
-        return *this;
-    }
-    
+    TaskCompletionSource(TaskCompletionSource&& other) noexcept = default;
+    TaskCompletionSource& operator=(TaskCompletionSource&& other) noexcept = default;
+
     // Get the associated task
-    Task<T> get_task() const {
+    TaskOf<T> get_task() const {
         return task_;
     }
-    
+
     // Set the result
     void set_result(const T& result) {
-        if (completed_.exchange(true)) {
-            throw std::runtime_error("TaskCompletionSource has already been completed");
-        }
-        
-        try {
-            promise_->set_value(result);
-        } catch (...) {
-            completed_.store(false);
-            throw;
+        if (!try_set_result(result)) {
+            throw_already_completed();
         }
     }
-    
+
     void set_result(T&& result) {
-        if (completed_.exchange(true)) {
-            throw std::runtime_error("TaskCompletionSource has already been completed");
-        }
-        
-        try {
-            promise_->set_value(std::move(result));
-        } catch (...) {
-            completed_.store(false);
-            throw;
+        if (!try_set_result(std::move(result))) {
+            throw_already_completed();
         }
     }
-    
+
     // Try to set the result (returns false if already completed)
     bool try_set_result(const T& result) {
-        if (completed_.exchange(true)) {
-            return false;
-        }
-        
-        try {
-            promise_->set_value(result);
-            return true;
-        } catch (...) {
-            completed_.store(false);
-            return false;
-        }
+        return core()->try_set_result(result);
     }
-    
+
     bool try_set_result(T&& result) {
-        if (completed_.exchange(true)) {
-            return false;
-        }
-        
-        try {
-            promise_->set_value(std::move(result));
-            return true;
-        } catch (...) {
-            completed_.store(false);
-            return false;
-        }
+        return core()->try_set_result(std::move(result));
     }
-    
+
     // Set exception
     void set_exception(std::exception_ptr exception) {
-        if (completed_.exchange(true)) {
-            throw std::runtime_error("TaskCompletionSource has already been completed");
-        }
-        
-        try {
-            promise_->set_exception(exception);
-        } catch (...) {
-            completed_.store(false);
-            throw;
+        if (!try_set_exception(std::move(exception))) {
+            throw_already_completed();
         }
     }
-    
+
     template<typename Exception>
     void set_exception(const Exception& exception) {
         set_exception(std::make_exception_ptr(exception));
     }
-    
+
     // Try to set exception (returns false if already completed)
     bool try_set_exception(std::exception_ptr exception) {
-        if (completed_.exchange(true)) {
-            return false;
-        }
-        
-        try {
-            promise_->set_exception(exception);
-            return true;
-        } catch (...) {
-            completed_.store(false);
-            return false;
-        }
+        return core()->try_set_exception(std::move(exception));
     }
-    
+
     template<typename Exception>
     bool try_set_exception(const Exception& exception) {
         return try_set_exception(std::make_exception_ptr(exception));
     }
-    
+
     // Set canceled
     void set_canceled() {
-        set_exception(std::make_exception_ptr(OperationCanceledException()));
+        if (!try_set_canceled()) {
+            throw_already_completed();
+        }
     }
-    
+
     void set_canceled(CancellationToken cancellationToken) {
-        if (cancellationToken.is_cancellation_requested()) {
-            set_exception(std::make_exception_ptr(OperationCanceledException()));
-        } else {
+        if (!cancellationToken.is_cancellation_requested()) {
             throw std::invalid_argument("CancellationToken is not in canceled state");
         }
+        set_canceled();
     }
-    
+
     // Try to set canceled (returns false if already completed)
     bool try_set_canceled() {
-        return try_set_exception(std::make_exception_ptr(OperationCanceledException()));
+        return core()->try_set_canceled();
     }
-    
+
     bool try_set_canceled(CancellationToken cancellationToken) {
         if (cancellationToken.is_cancellation_requested()) {
-            return try_set_exception(std::make_exception_ptr(OperationCanceledException()));
+            return try_set_canceled();
         }
         return false;
     }
-    
+
     // Check if the task has been completed
     bool is_completed() const {
-        return completed_.load();
+        return core()->is_completed();
     }
 };
 
@@ -189,148 +128,105 @@ public:
 template<>
 class TaskCompletionSource<void> {
 private:
-    std::shared_ptr<std::promise<void>> promise_;
     Task task_;
-    std::atomic<bool> completed_;
-    
+
+    detail::TaskCore* core() const {
+        return task_.core_.get();
+    }
+
+    static void throw_already_completed() {
+        throw std::runtime_error("TaskCompletionSource has already been completed");
+    }
+
 public:
-    TaskCompletionSource() 
-        : promise_(std::make_shared<std::promise<void>>())
-        , task_(promise_->get_future().share())
-        , completed_(false) {}
-    
+    TaskCompletionSource()
+        : TaskCompletionSource(TaskCreationOptions::None) {}
+
     explicit TaskCompletionSource(TaskCreationOptions options)
-        : promise_(std::make_shared<std::promise<void>>())
-        , task_(promise_->get_future().share(), CancellationToken::none(), options)
-        , completed_(false) {}
-    
+        : task_(detail::TaskCoreRef<detail::TaskCore>(
+              new detail::TaskCoreOf<void>(TaskStatus::WaitingForActivation, CancellationToken::none(), options))) {}
+
     TaskCompletionSource(void* state, TaskCreationOptions options)
-        : promise_(std::make_shared<std::promise<void>>())
-        , task_(promise_->get_future().share(), CancellationToken::none(), options)
-        , completed_(false) {
+        : TaskCompletionSource(options) {
         (void)state;
     }
-    
+
     // Disable copy constructor and assignment
     TaskCompletionSource(const TaskCompletionSource&) = delete;
     TaskCompletionSource& operator=(const TaskCompletionSource&) = delete;
-    
+
     // Move constructor and assignment
-    TaskCompletionSource(TaskCompletionSource&& other) noexcept
-        : promise_(std::move(other.promise_))
-        , task_(std::move(other.task_))
-        , completed_(other.completed_.load()) {}
-    
-    TaskCompletionSource& operator=(TaskCompletionSource&& other) noexcept {
-        if (this != &other) {
-            promise_ = std::move(other.promise_);
-            task_ = std::move(other.task_);
-            completed_.store(other.completed_.load());
-        }
-        return *this;
-    }
-    
+    TaskCompletionSource(TaskCompletionSource&& other) noexcept = default;
+    TaskCompletionSource& operator=(TaskCompletionSource&& other) noexcept = default;
+
     // Get the associated task
     Task get_task() const {
         return task_;
     }
-    
+
     // Set the result (void)
     void set_result() {
-        if (completed_.exchange(true)) {
-            throw std::runtime_error("TaskCompletionSource has already been completed");
-        }
-        
-        try {
-            promise_->set_value();
-        } catch (...) {
-            completed_.store(false);
-            throw;
+        if (!try_set_result()) {
+            throw_already_completed();
         }
     }
-    
+
     // Try to set the result (returns false if already completed)
     bool try_set_result() {
-        if (completed_.exchange(true)) {
-            return false;
-        }
-        
-        try {
-            promise_->set_value();
-            return true;
-        } catch (...) {
-            completed_.store(false);
-            return false;
-        }
+        return core()->try_set_result();
     }
-    
+
     // Set exception
     void set_exception(std::exception_ptr exception) {
-        if (completed_.exchange(true)) {
-            throw std::runtime_error("TaskCompletionSource has already been completed");
-        }
-        
-        try {
-            promise_->set_exception(exception);
-        } catch (...) {
-            completed_.store(false);
-            throw;
+        if (!try_set_exception(std::move(exception))) {
+            throw_already_completed();
         }
     }
-    
+
     template<typename Exception>
     void set_exception(const Exception& exception) {
         set_exception(std::make_exception_ptr(exception));
     }
-    
+
     // Try to set exception (returns false if already completed)
     bool try_set_exception(std::exception_ptr exception) {
-        if (completed_.exchange(true)) {
-            return false;
-        }
-        
-        try {
-            promise_->set_exception(exception);
-            return true;
-        } catch (...) {
-            completed_.store(false);
-            return false;
-        }
+        return core()->try_set_exception(std::move(exception));
     }
-    
+
     template<typename Exception>
     bool try_set_exception(const Exception& exception) {
         return try_set_exception(std::make_exception_ptr(exception));
     }
-    
+
     // Set canceled
     void set_canceled() {
-        set_exception(std::make_exception_ptr(OperationCanceledException()));
+        if (!try_set_canceled()) {
+            throw_already_completed();
+        }
     }
-    
+
     void set_canceled(CancellationToken cancellationToken) {
-        if (cancellationToken.is_cancellation_requested()) {
-            set_exception(std::make_exception_ptr(OperationCanceledException()));
-        } else {
+        if (!cancellationToken.is_cancellation_requested()) {
             throw std::invalid_argument("CancellationToken is not in canceled state");
         }
+        set_canceled();
     }
-    
+
     // Try to set canceled (returns false if already completed)
     bool try_set_canceled() {
-        return try_set_exception(std::make_exception_ptr(OperationCanceledException()));
+        return core()->try_set_canceled();
     }
-    
+
     bool try_set_canceled(CancellationToken cancellationToken) {
         if (cancellationToken.is_cancellation_requested()) {
-            return try_set_exception(std::make_exception_ptr(OperationCanceledException()));
+            return try_set_canceled();
         }
         return false;
     }
-    
+
     // Check if the task has been completed
     bool is_completed() const {
-        return completed_.load();
+        return core()->is_completed();
     }
 };
 
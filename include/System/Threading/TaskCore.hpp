@@ -0,0 +1,582 @@
+#pragma once
+
+#include "Enums.hpp"
+#include "CancellationToken.hpp"
+#include "ExecutionContext.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace System {
+namespace Threading {
+namespace detail {
+
+// A continuation waiting for its antecedent. Nodes form an intrusive Treiber
+// stack; the completing thread detaches the whole stack with one exchange.
+//
+// A node carrying a coroutine belongs to the awaiter inside that coroutine's
+// suspended frame, so awaiting costs no allocation and the core never deletes it.
+struct TaskContinuation {
+    TaskContinuation* next = nullptr;
+    std::function<void()> action;
+    std::coroutine_handle<> coroutine;
+    
+    TaskContinuation() = default;
+    explicit TaskContinuation(std::function<void()> a) : action(std::move(a)) {}
+};
+
+// The one heap block behind a Task and all of its copies.
+//
+// Status lives in a single atomic word: the low bits hold the TaskStatus, plus a
+// bit reserved by whichever completer wins the CAS race while it stores the
+// outcome, and a bit telling the completer that a thread is blocked in wait().
+// Reading the status never takes a lock. The block is intrusively reference
+// counted by TaskCoreRef, so a Task is a single pointer and copying it is one
+// atomic increment.
+class TaskCore {
+private:
+    static constexpr std::uint32_t StatusMask = 0x7;
+    static constexpr std::uint32_t CompletionReserved = 0x8;
+    static constexpr std::uint32_t WaitersPresent = 0x10;
+    
+    std::atomic<std::uint32_t> refs_{1};
+    std::atomic<std::uint32_t> state_;
+    std::atomic<TaskContinuation*> continuations_;
+    TaskCreationOptions options_;
+    CancellationToken token_;
+    std::exception_ptr exception_;
+    // Captured when a body is attached; moved out when the body runs
+    ExecutionContext context_;
+    
+    static TaskContinuation* completed_marker() {
+        static TaskContinuation marker{nullptr};
+        return &marker;
+    }
+    
+    static bool is_final(std::uint32_t state) {
+        return static_cast<TaskStatus>(state & StatusMask) >= TaskStatus::RanToCompletion;
+    }
+
+public:
+    explicit TaskCore(TaskStatus status,
+                      CancellationToken token = CancellationToken::none(),
+                      TaskCreationOptions options = TaskCreationOptions::None)
+        : state_(static_cast<std::uint32_t>(status))
+        , continuations_(is_final(static_cast<std::uint32_t>(status)) ? completed_marker() : nullptr)
+        , options_(options)
+        , token_(std::move(token)) {}
+    
+    // A task that is already Faulted or Canceled
+    TaskCore(std::exception_ptr exception, TaskStatus status,
+             CancellationToken token = CancellationToken::none())
+        : state_(static_cast<std::uint32_t>(status))
+        , continuations_(completed_marker())
+        , options_(TaskCreationOptions::None)
+        , token_(std::move(token))
+        , exception_(std::move(exception)) {}
+    
+    virtual ~TaskCore() {
+        TaskContinuation* head = continuations_.load(std::memory_order_acquire);
+        if (head == completed_marker()) {
+            return;
+        }
+        // Never completed: drop pending continuations without running them
+        while (head) {
+            TaskContinuation* next = head->next;
+            if (!head->coroutine) {
+                delete head;
+            }
+            head = next;
+        }
+    }
+    
+    TaskCore(const TaskCore&) = delete;
+    TaskCore& operator=(const TaskCore&) = delete;
+    
+    void add_ref() noexcept {
+        refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    void release() noexcept {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            destroy();
+        }
+    }
+    
+    TaskStatus get_status() const {
+        return static_cast<TaskStatus>(state_.load(std::memory_order_acquire) & StatusMask);
+    }
+    
+    bool is_completed() const {
+        return is_final(state_.load(std::memory_order_acquire));
+    }
+    
+    TaskCreationOptions get_options() const { return options_; }
+    const CancellationToken& get_token() const { return token_; }
+    
+    // Valid once the task is Faulted or Canceled
+    std::exception_ptr get_exception() const {
+        return is_completed() ? exception_ : nullptr;
+    }
+    
+    // Runs the task body on the calling (scheduler) thread. A token canceled before
+    // the body starts cancels the task instead.
+    void run_body() {
+        if (token_.is_cancellation_requested()) {
+            try_set_canceled();
+            return;
+        }
+        if (try_start()) {
+            ExecutionContextScope scope(std::move(context_));
+            execute();
+        }
+    }
+    
+    bool try_set_result() {
+        if (!try_reserve_completion()) {
+            return false;
+        }
+        publish(TaskStatus::RanToCompletion);
+        return true;
+    }
+    
+    // OperationCanceledException cancels the task; anything else faults it
+    bool try_set_exception(std::exception_ptr exception) {
+        if (!try_reserve_completion()) {
+            return false;
+        }
+        publish_exception(std::move(exception));
+        return true;
+    }
+    
+    bool try_set_canceled() {
+        if (!try_reserve_completion()) {
+            return false;
+        }
+        exception_ = std::make_exception_ptr(OperationCanceledException());
+        publish(TaskStatus::Canceled);
+        return true;
+    }
+    
+    // Blocks until the task completes, sleeping on the state word itself
+    void wait() const {
+        std::uint32_t state = state_.load(std::memory_order_acquire);
+        while (!is_final(state)) {
+            if ((state & WaitersPresent) == 0) {
+                auto& word = const_cast<std::atomic<std::uint32_t>&>(state_);
+                if (!word.compare_exchange_weak(state, state | WaitersPresent, std::memory_order_acq_rel)) {
+                    continue;
+                }
+                state |= WaitersPresent;
+            }
+            state_.wait(state, std::memory_order_acquire);
+            state = state_.load(std::memory_order_acquire);
+        }
+    }
+    
+    // Runs action when the task completes, or right away if it already has.
+    void add_continuation(std::function<void()> action) {
+        if (continuations_.load(std::memory_order_acquire) != completed_marker()) {
+            auto* node = new TaskContinuation(std::move(action));
+            if (try_push(node)) {
+                return;
+            }
+            action = std::move(node->action);
+            delete node;
+        }
+        invoke(action);
+    }
+    
+    // Queues the caller-owned node of a suspended coroutine for resumption.
+    // Returns false if the task has already completed; the caller then simply
+    // keeps running instead of suspending.
+    bool try_add_coroutine(TaskContinuation& node) {
+        return try_push(&node);
+    }
+
+protected:
+    // The task body; typed cores store its result
+    virtual void execute() {}
+    
+    // Makes the body run in the context of the code creating the task
+    void capture_context() {
+        context_ = ExecutionContext::capture();
+    }
+    
+    // Frees the block once the last reference is gone
+    virtual void destroy() noexcept {
+        delete this;
+    }
+    
+    bool try_start() {
+        std::uint32_t state = state_.load(std::memory_order_acquire);
+        for (;;) {
+            auto status = static_cast<TaskStatus>(state & StatusMask);
+            if ((state & CompletionReserved) != 0 ||
+                (status != TaskStatus::WaitingToRun && status != TaskStatus::WaitingForActivation &&
+                 status != TaskStatus::Created)) {
+                return false;
+            }
+            std::uint32_t running = (state & ~StatusMask) | static_cast<std::uint32_t>(TaskStatus::Running);
+            if (state_.compare_exchange_weak(state, running, std::memory_order_acq_rel)) {
+                return true;
+            }
+        }
+    }
+    
+    // Wins the right to complete the task; losers must leave it alone
+    bool try_reserve_completion() {
+        std::uint32_t state = state_.load(std::memory_order_acquire);
+        for (;;) {
+            if (is_final(state) || (state & CompletionReserved) != 0) {
+                return false;
+            }
+            if (state_.compare_exchange_weak(state, state | CompletionReserved, std::memory_order_acq_rel)) {
+                return true;
+            }
+        }
+    }
+    
+    // Caller has reserved completion. Returns the status to publish.
+    TaskStatus store_exception(std::exception_ptr exception) {
+        TaskStatus status = TaskStatus::Faulted;
+        try {
+            std::rethrow_exception(exception);
+        } catch (const OperationCanceledException&) {
+            status = TaskStatus::Canceled;
+        } catch (...) {
+        }
+        exception_ = std::move(exception);
+        return status;
+    }
+    
+    // Caller has reserved completion
+    void publish_exception(std::exception_ptr exception) {
+        publish(store_exception(std::move(exception)));
+    }
+    
+    // Makes the outcome visible, wakes blocked waiters and drains the continuations
+    void publish(TaskStatus status) {
+        publish_status(status);
+        run_continuations(false);
+    }
+    
+    // Like publish, but hands back one awaiting coroutine instead of resuming it,
+    // so a completing coroutine can transfer to it without growing the stack
+    std::coroutine_handle<> publish_and_transfer(TaskStatus status) {
+        publish_status(status);
+        std::coroutine_handle<> next = run_continuations(true);
+        return next ? next : std::noop_coroutine();
+    }
+
+private:
+    bool try_push(TaskContinuation* node) {
+        TaskContinuation* head = continuations_.load(std::memory_order_acquire);
+        do {
+            if (head == completed_marker()) {
+                return false;
+            }
+            node->next = head;
+        } while (!continuations_.compare_exchange_weak(head, node,
+                                                        std::memory_order_release,
+                                                        std::memory_order_acquire));
+        return true;
+    }
+    
+    void publish_status(TaskStatus status) {
+        std::uint32_t previous = state_.exchange(static_cast<std::uint32_t>(status), std::memory_order_acq_rel);
+        if ((previous & WaitersPresent) != 0) {
+            state_.notify_all();
+        }
+    }
+    
+    std::coroutine_handle<> run_continuations(bool transfer) {
+        TaskContinuation* head = continuations_.exchange(completed_marker(), std::memory_order_acq_rel);
+        if (head == completed_marker()) {
+            return nullptr;
+        }
+        
+        // The stack holds the newest registration first
+        TaskContinuation* ordered = nullptr;
+        while (head) {
+            TaskContinuation* next = head->next;
+            head->next = ordered;
+            ordered = head;
+            head = next;
+        }
+        
+        std::coroutine_handle<> transferred;
+        while (ordered) {
+            TaskContinuation* next = ordered->next;
+            if (ordered->coroutine) {
+                // The node lives in the frame; it is gone once the coroutine resumes
+                std::coroutine_handle<> coroutine = ordered->coroutine;
+                if (transfer && !transferred) {
+                    transferred = coroutine;
+                } else {
+                    ExecutionContextScope scope;
+                    coroutine.resume();
+                }
+            } else {
+                ExecutionContextScope scope;
+                invoke(ordered->action);
+                delete ordered;
+            }
+            ordered = next;
+        }
+        return transferred;
+    }
+    
+    static void invoke(std::function<void()>& action) {
+        try {
+            action();
+        } catch (...) {
+            // Continuation bodies report failures through their own task
+        }
+    }
+};
+
+// Core of a task producing a T. The result is constructed in place on success,
+// so a TaskOf<T> needs no allocation besides this block.
+template<typename T>
+class TaskCoreOf : public TaskCore {
+private:
+    union {
+        T value_;
+    };
+    std::function<T()> function_;
+
+public:
+    explicit TaskCoreOf(TaskStatus status,
+                        CancellationToken token = CancellationToken::none(),
+                        TaskCreationOptions options = TaskCreationOptions::None,
+                        std::function<T()> function = nullptr)
+        : TaskCore(status, std::move(token), options)
+        , function_(std::move(function)) {
+        if (function_) {
+            capture_context();
+        }
+    }
+    
+    // An already completed core holding value
+    template<typename U>
+    TaskCoreOf(std::in_place_t, U&& value)
+        : TaskCore(TaskStatus::Created) {
+        ::new (static_cast<void*>(&value_)) T(std::forward<U>(value));
+        TaskCore::try_set_result();
+    }
+    
+    ~TaskCoreOf() override {
+        if (get_status() == TaskStatus::RanToCompletion) {
+            value_.~T();
+        }
+    }
+    
+    template<typename U>
+    bool try_set_result(U&& value) {
+        if (!try_reserve_completion()) {
+            return false;
+        }
+        try {
+            construct_value(std::forward<U>(value));
+        } catch (...) {
+            publish_exception(std::current_exception());
+            return true;
+        }
+        publish(TaskStatus::RanToCompletion);
+        return true;
+    }
+    
+    // Only valid once the task has run to completion
+    const T& get_value() const {
+        return value_;
+    }
+
+protected:
+    // Caller has reserved completion
+    template<typename U>
+    void construct_value(U&& value) {
+        ::new (static_cast<void*>(&value_)) T(std::forward<U>(value));
+    }
+    
+    void execute() override {
+        auto function = std::move(function_);
+        try {
+            try_set_result(function());
+        } catch (...) {
+            try_set_exception(std::current_exception());
+        }
+    }
+};
+
+template<>
+class TaskCoreOf<void> : public TaskCore {
+private:
+    std::function<void()> function_;
+
+public:
+    explicit TaskCoreOf(TaskStatus status,
+                        CancellationToken token = CancellationToken::none(),
+                        TaskCreationOptions options = TaskCreationOptions::None,
+                        std::function<void()> function = nullptr)
+        : TaskCore(status, std::move(token), options)
+        , function_(std::move(function)) {
+        if (function_) {
+            capture_context();
+        }
+    }
+
+protected:
+    void execute() override {
+        auto function = std::move(function_);
+        try {
+            function();
+            try_set_result();
+        } catch (...) {
+            try_set_exception(std::current_exception());
+        }
+    }
+};
+
+// Intrusive owning pointer to a TaskCore
+template<typename TCore>
+class TaskCoreRef {
+private:
+    TCore* core_ = nullptr;
+
+public:
+    TaskCoreRef() = default;
+    
+    // Adopts the reference a freshly allocated core starts with unless add_ref is set
+    explicit TaskCoreRef(TCore* core, bool add_ref = false) : core_(core) {
+        if (core_ && add_ref) {
+            core_->add_ref();
+        }
+    }
+    
+    TaskCoreRef(const TaskCoreRef& other) : core_(other.core_) {
+        if (core_) {
+            core_->add_ref();
+        }
+    }
+    
+    TaskCoreRef(TaskCoreRef&& other) noexcept : core_(std::exchange(other.core_, nullptr)) {}
+    
+    TaskCoreRef& operator=(TaskCoreRef other) noexcept {
+        std::swap(core_, other.core_);
+        return *this;
+    }
+    
+    ~TaskCoreRef() {
+        if (core_) {
+            core_->release();
+        }
+    }
+    
+    TCore* get() const { return core_; }
+    TCore* operator->() const { return core_; }
+    explicit operator bool() const { return core_ != nullptr; }
+};
+
+// Immortal cores shared by completed_task() and from_result(). They start with
+// one reference that is never released.
+inline TaskCoreRef<TaskCore> completed_core() {
+    static TaskCore* core = new TaskCore(TaskStatus::RanToCompletion);
+    return TaskCoreRef<TaskCore>(core, true);
+}
+
+// Returns an empty ref for results that are not cached
+template<typename T>
+TaskCoreRef<TaskCore> cached_result_core(const T& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        static TaskCore* cores[2] = {
+            new TaskCoreOf<bool>(std::in_place, false),
+            new TaskCoreOf<bool>(std::in_place, true)
+        };
+        return TaskCoreRef<TaskCore>(cores[value ? 1 : 0], true);
+    } else if constexpr (std::is_same_v<T, int>) {
+        constexpr int min_cached = -1;
+        constexpr int max_cached = 8;
+        static TaskCore** cores = []() {
+            auto** table = new TaskCore*[max_cached - min_cached + 1];
+            for (int i = min_cached; i <= max_cached; ++i) {
+                table[i - min_cached] = new TaskCoreOf<int>(std::in_place, i);
+            }
+            return table;
+        }();
+        if (value >= min_cached && value <= max_cached) {
+            return TaskCoreRef<TaskCore>(cores[value - min_cached], true);
+        }
+        return TaskCoreRef<TaskCore>();
+    } else {
+        (void)value;
+        return TaskCoreRef<TaskCore>();
+    }
+}
+
+// Parks one waiting thread until a number of tasks have completed.
+//
+// Each watched task gets a continuation that calls signal(); the thread doing
+// wait_all/wait_any sleeps on a condition variable instead of polling, and the
+// completion that brings the count to zero wakes it. The first signaller is
+// recorded so wait_any can report which task finished.
+class CompletionWaiter {
+private:
+    std::atomic<long long> remaining_;
+    std::atomic<int> first_completed_{-1};
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool released_ = false;
+
+public:
+    explicit CompletionWaiter(long long required) : remaining_(required) {}
+    
+    CompletionWaiter(const CompletionWaiter&) = delete;
+    CompletionWaiter& operator=(const CompletionWaiter&) = delete;
+    
+    void signal(int index) {
+        int expected = -1;
+        first_completed_.compare_exchange_strong(expected, index, std::memory_order_acq_rel);
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            release();
+        }
+    }
+    
+    // Wakes the waiter without the tasks having completed (cancellation)
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        released_ = true;
+        condition_.notify_all();
+    }
+    
+    bool is_satisfied() const {
+        return remaining_.load(std::memory_order_acquire) <= 0;
+    }
+    
+    int first_completed() const {
+        return first_completed_.load(std::memory_order_acquire);
+    }
+    
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() { return released_; });
+    }
+    
+    // Returns false if the deadline passed before the waiter was released
+    bool wait_until(std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return condition_.wait_until(lock, deadline, [this]() { return released_; });
+    }
+};
+
+} // namespace detail
+} // namespace Threading
+} // namespace System
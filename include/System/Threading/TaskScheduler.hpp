@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Enums.hpp"
+#include <functional>
+#include <memory>
+
+namespace System {
+namespace Threading {
+
+// Decides where the body of a Task (or a continuation) runs.
+//
+// Task::run and continue_with never create threads themselves; they hand the work
+// to a scheduler. The default scheduler posts to the process-wide ThreadPool and
+// gives LongRunning work its own thread so it cannot starve pool workers.
+class TaskScheduler {
+public:
+    virtual ~TaskScheduler() = default;
+
+    // Queue work for execution. Must not run it inline on the calling thread.
+    virtual void queue_task(std::function<void()> work, TaskCreationOptions options) = 0;
+
+    virtual int get_maximum_concurrency_level() const;
+
+    // The scheduler used by Task::run (the ThreadPool-backed scheduler unless replaced)
+    static TaskScheduler& get_default();
+
+    // The scheduler of the task running on this thread, or the default one.
+    // Continuations inherit it unless HideScheduler is specified.
+    static TaskScheduler& get_current();
+
+    // Replace the default scheduler; pass nullptr to restore the ThreadPool scheduler.
+    static void set_default(std::shared_ptr<TaskScheduler> scheduler);
+
+protected:
+    // Runs work with this scheduler installed as the current one
+    void execute_task(const std::function<void()>& work);
+};
+
+class ThreadPoolTaskScheduler : public TaskScheduler {
+public:
+    void queue_task(std::function<void()> work, TaskCreationOptions options) override;
+    int get_maximum_concurrency_level() const override;
+};
+
+} // namespace Threading
+} // namespace System
@@ -1,17 +1,32 @@
-
 #pragma once
 
 #include "System/Object.h"
-#include "../CancellationToken.h"
-#include "TaskScheduler.h"
+#include "System/Collections/Concurrent/Partitioner.h"
+#include "../CancellationToken.hpp"
+#include "../ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <exception>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 namespace System::Threading::Tasks
 {
+    // Held by pointer only
+    class TaskScheduler;
+
     struct ParallelLoopResult
     {
         bool IsCompleted;
+        // LONG_MAX unless some iteration called Break
         long LowestBreakIteration;
 
         ParallelLoopResult(bool isCompleted, long lowestBreakIteration);
@@ -20,9 +35,20 @@ namespace System::Threading::Tasks
     class ParallelLoopState
     {
     private:
-        std::atomic<bool> isStopped{false};
-        std::atomic<bool> isExceptional{false};
-        std::atomic<long> lowestBreakIteration{LONG_MAX};
+        // Shared by the states of every worker in one loop
+        struct alignas(64) Control
+        {
+            std::atomic<bool> isStopped{false};
+            std::atomic<bool> isExceptional{false};
+            std::atomic<long> lowestBreakIteration{LONG_MAX};
+        };
+
+        Control* control;
+        long currentIteration = 0;
+
+        explicit ParallelLoopState(Control& loopControl);
+
+        friend class Parallel;
 
     public:
         void Stop();
@@ -41,6 +67,7 @@ namespace System::Threading::Tasks
         CancellationToken cancellationToken;
         int maxDegreeOfParallelism;
         TaskScheduler* taskScheduler;
+        int preferredNode;
 
     public:
         ParallelOptions();
@@ -54,35 +81,655 @@ namespace System::Threading::Tasks
 
         TaskScheduler* GetTaskScheduler() const;
         void SetTaskScheduler(TaskScheduler* value);
+
+        // NUMA node (see ThreadPool::GetNodeCount) whose workers should run the loop,
+        // or -1 for any. The default degree of parallelism becomes that node's CPU
+        // count. The calling thread still runs a share wherever it is; a node this
+        // machine does not have is ignored.
+        int GetPreferredNode() const;
+        void SetPreferredNode(int value);
     };
 
+    // Data-parallel loops on the ThreadPool.
+    //
+    // Bodies are template parameters, so an iteration is a direct (usually inlined)
+    // call. A body takes the index, or the index and a ParallelLoopState&.
+    //
+    // The range is cut into one contiguous slice per worker; the calling thread is
+    // worker 0 and the rest are pool work items. A worker eats its slice from the
+    // front in chunks, and a worker whose slice is empty steals the back half of
+    // the largest remaining slice, so ranges split recursively wherever the work
+    // turns out to be. Each worker sizes its chunks from the measured time of its
+    // previous chunk, aiming for chunks that are long enough to hide the per-chunk
+    // bookkeeping but short enough to leave work to steal.
+    //
+    // Stop, Break, exceptions and cancellation are seen at chunk boundaries; bodies
+    // taking a ParallelLoopState also stop mid-chunk.
+    //
+    // The localInit/localFinally overloads give each worker a private TLocal kept in
+    // its own cache-line padded slot: localInit seeds it when the worker runs its
+    // first chunk, the body threads it through every iteration the worker runs, and
+    // once the loop has finished localFinally is called with each worker's value in
+    // turn on the calling thread, so it needs no locking. A loop that throws or is
+    // canceled drops the values without calling localFinally. Reduce and
+    // TransformReduce are built on these.
     class Parallel
     {
     public:
         // Parallel.For
-        static ParallelLoopResult For(int fromInclusive, int toExclusive, std::function<void(int)> body);
-        static ParallelLoopResult For(int fromInclusive, int toExclusive, const ParallelOptions& parallelOptions, std::function<void(int)> body);
-        static ParallelLoopResult For(int fromInclusive, int toExclusive, std::function<void(int, ParallelLoopState&)> body);
-        static ParallelLoopResult For(int fromInclusive, int toExclusive, const ParallelOptions& parallelOptions, std::function<void(int, ParallelLoopState&)> body);
+        template<typename TBody>
+        static ParallelLoopResult For(int fromInclusive, int toExclusive, TBody&& body)
+        {
+            return ForRange<int>(fromInclusive, toExclusive, ParallelOptions(), body);
+        }
+
+        template<typename TBody>
+        static ParallelLoopResult For(int fromInclusive, int toExclusive, const ParallelOptions& parallelOptions, TBody&& body)
+        {
+            return ForRange<int>(fromInclusive, toExclusive, parallelOptions, body);
+        }
+
+        template<typename TBody>
+        static ParallelLoopResult For(long fromInclusive, long toExclusive, TBody&& body)
+        {
+            return ForRange<long>(fromInclusive, toExclusive, ParallelOptions(), body);
+        }
+
+        template<typename TBody>
+        static ParallelLoopResult For(long fromInclusive, long toExclusive, const ParallelOptions& parallelOptions, TBody&& body)
+        {
+            return ForRange<long>(fromInclusive, toExclusive, parallelOptions, body);
+        }
+
+        // Parallel.For with thread-local state. The body is (index, ParallelLoopState&,
+        // TLocal) -> TLocal or, without Stop/Break support, (index, TLocal) -> TLocal.
+        // TLocal defaults to whatever localInit returns.
+        template<typename TLocal = void, typename TLocalInit, typename TBody, typename TLocalFinally>
+        static ParallelLoopResult For(int fromInclusive, int toExclusive, TLocalInit&& localInit, TBody&& body, TLocalFinally&& localFinally)
+        {
+            return For<TLocal>(fromInclusive, toExclusive, ParallelOptions(), localInit, body, localFinally);
+        }
+
+        template<typename TLocal = void, typename TLocalInit, typename TBody, typename TLocalFinally>
+        static ParallelLoopResult For(int fromInclusive, int toExclusive, const ParallelOptions& parallelOptions,
+                                      TLocalInit&& localInit, TBody&& body, TLocalFinally&& localFinally)
+        {
+            LocalBody<LocalType<TLocal, TLocalInit>, TLocalInit, TBody, TLocalFinally> local{localInit, body, localFinally};
+            return ForRange<int>(fromInclusive, toExclusive, parallelOptions, local);
+        }
+
+        template<typename TLocal = void, typename TLocalInit, typename TBody, typename TLocalFinally>
+        static ParallelLoopResult For(long fromInclusive, long toExclusive, TLocalInit&& localInit, TBody&& body, TLocalFinally&& localFinally)
+        {
+            return For<TLocal>(fromInclusive, toExclusive, ParallelOptions(), localInit, body, localFinally);
+        }
+
+        template<typename TLocal = void, typename TLocalInit, typename TBody, typename TLocalFinally>
+        static ParallelLoopResult For(long fromInclusive, long toExclusive, const ParallelOptions& parallelOptions,
+                                      TLocalInit&& localInit, TBody&& body, TLocalFinally&& localFinally)
+        {
+            LocalBody<LocalType<TLocal, TLocalInit>, TLocalInit, TBody, TLocalFinally> local{localInit, body, localFinally};
+            return ForRange<long>(fromInclusive, toExclusive, parallelOptions, local);
+        }
+
+        // Parallel.Reduce: combines every element with reduce, starting each worker
+        // from identity. reduce must be associative and commutative, since workers
+        // cover scattered parts of the range and their results are combined in
+        // worker order.
+        template<typename T, typename TReduce>
+        static T Reduce(const std::vector<T>& source, T identity, TReduce&& reduce)
+        {
+            return Reduce(source, ParallelOptions(), std::move(identity), reduce);
+        }
+
+        template<typename T, typename TReduce>
+        static T Reduce(const std::vector<T>& source, const ParallelOptions& parallelOptions, T identity, TReduce&& reduce)
+        {
+            return TransformReduce(source, parallelOptions, std::move(identity), reduce, [](const T& element) -> const T& {
+                return element;
+            });
+        }
 
-        static ParallelLoopResult For(long fromInclusive, long toExclusive, std::function<void(long)> body);
-        static ParallelLoopResult For(long fromInclusive, long toExclusive, const ParallelOptions& parallelOptions, std::function<void(long)> body);
+        // Parallel.TransformReduce: reduces transform(index) over [fromInclusive,
+        // toExclusive), or transform(element) over a vector, with the same
+        // requirements on reduce as Reduce
+        template<typename TResult, typename TReduce, typename TTransform>
+        static TResult TransformReduce(long fromInclusive, long toExclusive, TResult identity, TReduce&& reduce, TTransform&& transform)
+        {
+            return TransformReduce(fromInclusive, toExclusive, ParallelOptions(), std::move(identity), reduce, transform);
+        }
+
+        template<typename TResult, typename TReduce, typename TTransform>
+        static TResult TransformReduce(long fromInclusive, long toExclusive, const ParallelOptions& parallelOptions,
+                                       TResult identity, TReduce&& reduce, TTransform&& transform)
+        {
+            TResult result = identity;
+            For<TResult>(fromInclusive, toExclusive, parallelOptions,
+                [&identity]() { return identity; },
+                [&reduce, &transform](long i, TResult partial) {
+                    return reduce(std::move(partial), transform(i));
+                },
+                [&result, &reduce](TResult partial) {
+                    result = reduce(std::move(result), std::move(partial));
+                });
+            return result;
+        }
+
+        template<typename T, typename TResult, typename TReduce, typename TTransform>
+        static TResult TransformReduce(const std::vector<T>& source, TResult identity, TReduce&& reduce, TTransform&& transform)
+        {
+            return TransformReduce(source, ParallelOptions(), std::move(identity), reduce, transform);
+        }
+
+        template<typename T, typename TResult, typename TReduce, typename TTransform>
+        static TResult TransformReduce(const std::vector<T>& source, const ParallelOptions& parallelOptions,
+                                       TResult identity, TReduce&& reduce, TTransform&& transform)
+        {
+            return TransformReduce(0L, static_cast<long>(source.size()), parallelOptions, std::move(identity), reduce,
+                [&source, &transform](long i) -> decltype(auto) {
+                    return transform(source[static_cast<std::size_t>(i)]);
+                });
+        }
 
         // Parallel.ForEach
-        template<typename T>
-        static ParallelLoopResult ForEach(const std::vector<T>& source, std::function<void(T)> body);
+        template<typename T, typename TBody>
+        static ParallelLoopResult ForEach(const std::vector<T>& source, TBody&& body)
+        {
+            return ForEach(source, ParallelOptions(), std::forward<TBody>(body));
+        }
+
+        template<typename T, typename TBody>
+        static ParallelLoopResult ForEach(const std::vector<T>& source, const ParallelOptions& parallelOptions, TBody&& body)
+        {
+            long count = static_cast<long>(source.size());
+            if constexpr (std::is_invocable_v<TBody&, const T&, ParallelLoopState&>)
+            {
+                auto element = [&source, &body](long i, ParallelLoopState& state) {
+                    body(source[static_cast<std::size_t>(i)], state);
+                };
+                return ForRange<long>(0, count, parallelOptions, element);
+            }
+            else
+            {
+                auto element = [&source, &body](long i) {
+                    body(source[static_cast<std::size_t>(i)]);
+                };
+                return ForRange<long>(0, count, parallelOptions, element);
+            }
+        }
+
+        // Parallel.ForEach over a partitioner: one partition per worker, each drained
+        // by whichever worker takes it. Partitions are unordered, so Break ends the
+        // loop like Stop and the result carries no LowestBreakIteration; Stop, Break,
+        // exceptions and cancellation are seen between elements.
+        template<typename TSource, typename TBody>
+        static ParallelLoopResult ForEach(const Collections::Concurrent::IPartitioner<TSource>& source, TBody&& body)
+        {
+            return ForEach(source, ParallelOptions(), std::forward<TBody>(body));
+        }
+
+        template<typename TSource, typename TBody>
+        static ParallelLoopResult ForEach(const Collections::Concurrent::IPartitioner<TSource>& source, const ParallelOptions& parallelOptions, TBody&& body)
+        {
+            static_assert(std::is_invocable_v<TBody&, const TSource&> || std::is_invocable_v<TBody&, const TSource&, ParallelLoopState&>,
+                          "The loop body must be callable with (element) or (element, ParallelLoopState&)");
+
+            int degree = parallelOptions.GetMaxDegreeOfParallelism();
+            auto partitions = source.GetPartitions(degree == -1 ? DefaultDegreeOfParallelism(parallelOptions.GetPreferredNode()) : degree);
 
-        template<typename T>
-        static ParallelLoopResult ForEach(const std::vector<T>& source, const ParallelOptions& parallelOptions, std::function<void(T)> body);
+            CancellationToken cancellationToken = parallelOptions.GetCancellationToken();
+            std::atomic<bool> isCanceled{false};
+            auto drain = [&](long p, ParallelLoopState& state) {
+                System::Linq::IEnumerator<TSource>& partition = *partitions[static_cast<std::size_t>(p)];
+                ParallelLoopState::Control& control = *state.control;
+                for (;;)
+                {
+                    if (control.isStopped.load(std::memory_order_relaxed) || control.isExceptional.load(std::memory_order_relaxed) ||
+                        control.lowestBreakIteration.load(std::memory_order_relaxed) != LONG_MAX)
+                    {
+                        return;
+                    }
+                    if (cancellationToken.is_cancellation_requested())
+                    {
+                        isCanceled.store(true, std::memory_order_relaxed);
+                        return;
+                    }
+                    if (!partition.MoveNext())
+                    {
+                        return;
+                    }
+                    if constexpr (std::is_invocable_v<TBody&, const TSource&, ParallelLoopState&>)
+                    {
+                        body(static_cast<const TSource&>(partition.Current()), state);
+                    }
+                    else
+                    {
+                        body(static_cast<const TSource&>(partition.Current()));
+                    }
+                }
+            };
 
-        template<typename T>
-        static ParallelLoopResult ForEach(const std::vector<T>& source, std::function<void(T, ParallelLoopState&)> body);
+            ParallelLoopResult result = ForRange<long>(0, static_cast<long>(partitions.size()), parallelOptions, drain);
+            // A partition abandoned to cancellation may have been the last one running
+            if (isCanceled.load(std::memory_order_relaxed))
+            {
+                cancellationToken.throw_if_cancellation_requested();
+            }
+            return ParallelLoopResult(result.IsCompleted, LONG_MAX);
+        }
 
-        template<typename T>
-        static ParallelLoopResult ForEach(const std::vector<T>& source, const ParallelOptions& parallelOptions, std::function<void(T, ParallelLoopState&)> body);
+        // Parallel.ForEach over streams that cannot be indexed, through the
+        // load-balanced partitioner
+        template<typename T, typename TBody>
+        static ParallelLoopResult ForEach(const System::Linq::IEnumerable<T>& source, TBody&& body)
+        {
+            return ForEach(Collections::Concurrent::Partitioner::Create(source), ParallelOptions(), std::forward<TBody>(body));
+        }
+
+        template<typename T, typename TBody>
+        static ParallelLoopResult ForEach(const System::Linq::IEnumerable<T>& source, const ParallelOptions& parallelOptions, TBody&& body)
+        {
+            return ForEach(Collections::Concurrent::Partitioner::Create(source), parallelOptions, std::forward<TBody>(body));
+        }
+
+        template<typename T, typename TBody>
+        static ParallelLoopResult ForEach(System::Coroutines::Generator<T>&& source, TBody&& body)
+        {
+            return ForEach(Collections::Concurrent::Partitioner::Create(std::move(source)), ParallelOptions(), std::forward<TBody>(body));
+        }
+
+        template<typename T, typename TBody>
+        static ParallelLoopResult ForEach(System::Coroutines::Generator<T>&& source, const ParallelOptions& parallelOptions, TBody&& body)
+        {
+            return ForEach(Collections::Concurrent::Partitioner::Create(std::move(source)), parallelOptions, std::forward<TBody>(body));
+        }
 
         // Parallel.Invoke
         static void Invoke(const std::vector<std::function<void()>>& actions);
         static void Invoke(const ParallelOptions& parallelOptions, const std::vector<std::function<void()>>& actions);
+
+    private:
+        // Chunks aim to run this long
+        static constexpr long long TargetChunkNanoseconds = 20000;
+
+        template<typename TIndex>
+        struct alignas(64) Slice
+        {
+            std::mutex mutex;
+            // Written under mutex; read without it only to pick a victim
+            std::atomic<TIndex> begin{0};
+            std::atomic<TIndex> end{0};
+        };
+
+        template<typename TLocal, typename TLocalInit>
+        using LocalType = std::conditional_t<std::is_void_v<TLocal>, std::decay_t<std::invoke_result_t<TLocalInit&>>, TLocal>;
+
+        // The three delegates of a For with thread-local state, run as one body
+        template<typename TLocal, typename TLocalInit, typename TBody, typename TLocalFinally>
+        struct LocalBody
+        {
+            TLocalInit& localInit;
+            TBody& body;
+            TLocalFinally& localFinally;
+        };
+
+        // TLocal of a LocalBody; NoLocal for plain bodies
+        struct NoLocal
+        {
+        };
+
+        template<typename TBody>
+        struct LocalOf
+        {
+            using Type = NoLocal;
+        };
+
+        template<typename TLocal, typename TLocalInit, typename TBody, typename TLocalFinally>
+        struct LocalOf<LocalBody<TLocal, TLocalInit, TBody, TLocalFinally>>
+        {
+            using Type = TLocal;
+        };
+
+        // One per worker, padded so that workers never write to a shared line
+        template<typename TLocal>
+        struct alignas(64) LocalSlot
+        {
+            std::optional<TLocal> value;
+        };
+
+        // Heap state shared with the helper work items. A helper that starts after
+        // the loop has finished holds it alive but never touches the body.
+        template<typename TIndex, typename TBody>
+        struct Loop
+        {
+            static constexpr int Closed = 1 << 30;
+
+            ParallelLoopState::Control control;
+            std::unique_ptr<Slice<TIndex>[]> slices;
+            int workerCount;
+            TBody* body;
+            // Only allocated for LocalBody loops; each slot belongs to one worker
+            std::unique_ptr<LocalSlot<typename LocalOf<TBody>::Type>[]> locals;
+            CancellationToken cancellationToken;
+            std::atomic<bool> isCanceled{false};
+            // Helpers inside the loop, plus Closed once the caller has finished
+            std::atomic<int> active{0};
+            std::mutex exceptionMutex;
+            std::exception_ptr exception;
+        };
+
+        // node is a preferred node or -1
+        static int DefaultDegreeOfParallelism(int node);
+
+        template<typename TIndex, typename TBody>
+        static ParallelLoopResult ForRange(TIndex fromInclusive, TIndex toExclusive, const ParallelOptions& parallelOptions, TBody& body)
+        {
+            using TLocal = typename LocalOf<TBody>::Type;
+            constexpr bool hasLocal = !std::is_same_v<TLocal, NoLocal>;
+            static_assert(hasLocal || std::is_invocable_v<TBody&, TIndex> || std::is_invocable_v<TBody&, TIndex, ParallelLoopState&>,
+                          "The loop body must be callable with (index) or (index, ParallelLoopState&)");
+
+            if (fromInclusive >= toExclusive)
+            {
+                return ParallelLoopResult(true, LONG_MAX);
+            }
+
+            auto loop = std::make_shared<Loop<TIndex, TBody>>();
+            loop->body = &body;
+            loop->cancellationToken = parallelOptions.GetCancellationToken();
+            loop->cancellationToken.throw_if_cancellation_requested();
+
+            int node = parallelOptions.GetPreferredNode();
+            if (node >= ThreadPool::GetNodeCount())
+            {
+                node = -1;
+            }
+            int degree = parallelOptions.GetMaxDegreeOfParallelism();
+            if (degree == -1)
+            {
+                degree = DefaultDegreeOfParallelism(node);
+            }
+            // Widened: the range may not fit in TIndex
+            long long count = static_cast<long long>(toExclusive) - static_cast<long long>(fromInclusive);
+            loop->workerCount = static_cast<int>(std::min<long long>(degree, count));
+
+            loop->slices.reset(new Slice<TIndex>[static_cast<std::size_t>(loop->workerCount)]);
+            if constexpr (hasLocal)
+            {
+                loop->locals.reset(new LocalSlot<TLocal>[static_cast<std::size_t>(loop->workerCount)]);
+            }
+            long long sliceSize = count / loop->workerCount;
+            long long larger = count % loop->workerCount;
+            long long next = fromInclusive;
+            for (int w = 0; w < loop->workerCount; ++w)
+            {
+                loop->slices[w].begin.store(static_cast<TIndex>(next), std::memory_order_relaxed);
+                next += sliceSize + (w < larger ? 1 : 0);
+                loop->slices[w].end.store(static_cast<TIndex>(next), std::memory_order_relaxed);
+            }
+
+            for (int w = 1; w < loop->workerCount; ++w)
+            {
+                auto helper = [loop, w](System::Object*) {
+                    if (!TryJoin(*loop))
+                    {
+                        return;
+                    }
+                    RunWorker(*loop, w);
+                    if (loop->active.fetch_sub(1) - 1 == Loop<TIndex, TBody>::Closed)
+                    {
+                        loop->active.notify_all();
+                    }
+                };
+                if (node >= 0)
+                {
+                    ThreadPool::QueueUserWorkItemOnNode(helper, nullptr, node);
+                }
+                else
+                {
+                    ThreadPool::QueueUserWorkItem(helper);
+                }
+            }
+
+            RunWorker(*loop, 0);
+
+            // Helpers that have not started by now find the loop closed
+            int observed = loop->active.fetch_or(Loop<TIndex, TBody>::Closed) | Loop<TIndex, TBody>::Closed;
+            while (observed != Loop<TIndex, TBody>::Closed)
+            {
+                loop->active.wait(observed);
+                observed = loop->active.load();
+            }
+            // Late helpers keep the loop alive; the values must not outlive the call
+            auto locals = std::move(loop->locals);
+
+            if (loop->exception)
+            {
+                std::rethrow_exception(loop->exception);
+            }
+            if (loop->isCanceled.load(std::memory_order_relaxed))
+            {
+                loop->cancellationToken.throw_if_cancellation_requested();
+            }
+
+            if constexpr (hasLocal)
+            {
+                for (int w = 0; w < loop->workerCount; ++w)
+                {
+                    if (locals[w].value)
+                    {
+                        body.localFinally(std::move(*locals[w].value));
+                    }
+                }
+            }
+
+            long lowestBreak = loop->control.lowestBreakIteration.load();
+            return ParallelLoopResult(!loop->control.isStopped.load() && lowestBreak == LONG_MAX, lowestBreak);
+        }
+
+        template<typename TIndex, typename TBody>
+        static bool TryJoin(Loop<TIndex, TBody>& loop)
+        {
+            int observed = loop.active.load();
+            do
+            {
+                if (observed & Loop<TIndex, TBody>::Closed)
+                {
+                    return false;
+                }
+            } while (!loop.active.compare_exchange_weak(observed, observed + 1));
+            return true;
+        }
+
+        template<typename TIndex, typename TBody>
+        static void RunWorker(Loop<TIndex, TBody>& loop, int self)
+        {
+            ParallelLoopState state(loop.control);
+            TIndex grain = 1;
+            TIndex begin;
+            TIndex end;
+
+            while (TakeChunk(loop, self, grain, begin, end))
+            {
+                ParallelLoopState::Control& control = loop.control;
+                if (control.isStopped.load(std::memory_order_relaxed) || control.isExceptional.load(std::memory_order_relaxed) ||
+                    loop.isCanceled.load(std::memory_order_relaxed))
+                {
+                    return;
+                }
+                if (loop.cancellationToken.is_cancellation_requested())
+                {
+                    loop.isCanceled.store(true, std::memory_order_relaxed);
+                    return;
+                }
+                // Past a Break: skip the chunk but keep going, lower ones must run
+                if (static_cast<long>(begin) > control.lowestBreakIteration.load(std::memory_order_relaxed))
+                {
+                    continue;
+                }
+
+                auto started = std::chrono::steady_clock::now();
+                try
+                {
+                    RunChunk(loop, self, state, begin, end);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(loop.exceptionMutex);
+                    if (!loop.exception)
+                    {
+                        loop.exception = std::current_exception();
+                    }
+                    control.isExceptional.store(true);
+                    return;
+                }
+                long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+
+                if (elapsed < TargetChunkNanoseconds / 2 && grain <= std::numeric_limits<TIndex>::max() / 2)
+                {
+                    grain *= 2;
+                }
+                else if (elapsed > TargetChunkNanoseconds * 2 && grain > 1)
+                {
+                    grain /= 2;
+                }
+            }
+        }
+
+        template<typename TIndex, typename TBody>
+        static void RunChunk(Loop<TIndex, TBody>& loop, int self, ParallelLoopState& state, TIndex begin, TIndex end)
+        {
+            using TLocal = typename LocalOf<TBody>::Type;
+            TBody& body = *loop.body;
+            if constexpr (!std::is_same_v<TLocal, NoLocal>)
+            {
+                // Iterations work on a copy on the stack; the slot is only touched per chunk
+                LocalSlot<TLocal>& slot = loop.locals[self];
+                if (!slot.value)
+                {
+                    slot.value.emplace(body.localInit());
+                }
+                TLocal local = std::move(*slot.value);
+                if constexpr (std::is_invocable_v<decltype(body.body), TIndex, ParallelLoopState&, TLocal>)
+                {
+                    ParallelLoopState::Control& control = loop.control;
+                    for (TIndex i = begin; i < end; ++i)
+                    {
+                        if (control.isStopped.load(std::memory_order_relaxed) ||
+                            static_cast<long>(i) > control.lowestBreakIteration.load(std::memory_order_relaxed))
+                        {
+                            break;
+                        }
+                        state.currentIteration = static_cast<long>(i);
+                        local = body.body(i, state, std::move(local));
+                    }
+                }
+                else
+                {
+                    static_assert(std::is_invocable_r_v<TLocal, decltype(body.body), TIndex, TLocal>,
+                                  "The loop body must be callable with (index, ParallelLoopState&, TLocal) or (index, TLocal) and return TLocal");
+                    for (TIndex i = begin; i < end; ++i)
+                    {
+                        local = body.body(i, std::move(local));
+                    }
+                }
+                *slot.value = std::move(local);
+            }
+            else if constexpr (std::is_invocable_v<TBody&, TIndex, ParallelLoopState&>)
+            {
+                ParallelLoopState::Control& control = loop.control;
+                for (TIndex i = begin; i < end; ++i)
+                {
+                    if (control.isStopped.load(std::memory_order_relaxed) ||
+                        static_cast<long>(i) > control.lowestBreakIteration.load(std::memory_order_relaxed))
+                    {
+                        return;
+                    }
+                    state.currentIteration = static_cast<long>(i);
+                    body(i, state);
+                }
+            }
+            else
+            {
+                for (TIndex i = begin; i < end; ++i)
+                {
+                    body(i);
+                }
+            }
+        }
+
+        // Next chunk from the worker's own slice, refilled by stealing when empty
+        template<typename TIndex, typename TBody>
+        static bool TakeChunk(Loop<TIndex, TBody>& loop, int self, TIndex grain, TIndex& begin, TIndex& end)
+        {
+            Slice<TIndex>& own = loop.slices[self];
+            for (;;)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(own.mutex);
+                    TIndex ownBegin = own.begin.load(std::memory_order_relaxed);
+                    TIndex ownEnd = own.end.load(std::memory_order_relaxed);
+                    if (ownBegin < ownEnd)
+                    {
+                        begin = ownBegin;
+                        end = static_cast<long long>(ownEnd) - ownBegin > grain ? static_cast<TIndex>(ownBegin + grain) : ownEnd;
+                        own.begin.store(end, std::memory_order_relaxed);
+                        return true;
+                    }
+                }
+                if (!Steal(loop, self))
+                {
+                    return false;
+                }
+            }
+        }
+
+        // Moves the back half of the largest other slice into the worker's own
+        template<typename TIndex, typename TBody>
+        static bool Steal(Loop<TIndex, TBody>& loop, int self)
+        {
+            for (;;)
+            {
+                int victim = -1;
+                long long largest = 0;
+                for (int w = 0; w < loop.workerCount; ++w)
+                {
+                    long long remaining = static_cast<long long>(loop.slices[w].end.load(std::memory_order_relaxed)) -
+                                          static_cast<long long>(loop.slices[w].begin.load(std::memory_order_relaxed));
+                    if (w != self && remaining > largest)
+                    {
+                        victim = w;
+                        largest = remaining;
+                    }
+                }
+                if (victim < 0)
+                {
+                    return false;
+                }
+
+                TIndex stolenBegin;
+                TIndex stolenEnd;
+                {
+                    Slice<TIndex>& slice = loop.slices[victim];
+                    std::lock_guard<std::mutex> lock(slice.mutex);
+                    TIndex victimBegin = slice.begin.load(std::memory_order_relaxed);
+                    TIndex victimEnd = slice.end.load(std::memory_order_relaxed);
+                    if (victimBegin >= victimEnd)
+                    {
+                        // Drained since the scan; look again
+                        continue;
+                    }
+                    stolenBegin = static_cast<TIndex>(victimBegin + (static_cast<long long>(victimEnd) - victimBegin) / 2);
+                    stolenEnd = victimEnd;
+                    slice.end.store(stolenBegin, std::memory_order_relaxed);
+                }
+
+                Slice<TIndex>& own = loop.slices[self];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                own.begin.store(stolenBegin, std::memory_order_relaxed);
+                own.end.store(stolenEnd, std::memory_order_relaxed);
+                return true;
+            }
+        }
     };
 }
@@ -1,90 +1,204 @@
-
 #pragma once
 
-#include <memory>
-#include <unordered_map>
-#include <thread>
-#include <mutex>
+#include <cstddef>
 #include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace System {
 namespace Threading {
 
+namespace detail {
+
+class ThreadLocalSlot;
+
+// The value of one ThreadLocal on one thread, linked into its instance's list so
+// the instance can reach the values of every thread
+struct ThreadLocalNode {
+    virtual ~ThreadLocalNode() = default;
+
+    ThreadLocalSlot* owner = nullptr;
+    // &thread_local_nodes of the owning thread; null once that thread has exited
+    ThreadLocalNode*** thread_nodes = nullptr;
+    ThreadLocalNode* prev = nullptr;
+    ThreadLocalNode* next = nullptr;
+};
+
+// This thread's values, indexed by slot. Constant-initialized, so reading them
+// needs no TLS initialization guard.
+extern thread_local constinit ThreadLocalNode** thread_local_nodes;
+extern thread_local constinit std::size_t thread_local_capacity;
+
+// The type-erased half of a ThreadLocal<T>: a slot index, recycled once the
+// instance is gone, and the list of the instance's values across threads.
+// Everything here runs under one registry lock, which only the first access on
+// each thread, thread exit and destruction take.
+class ThreadLocalSlot {
+private:
+    std::size_t index_;
+    bool track_all_values_;
+    ThreadLocalNode* head_ = nullptr;
+
+    friend class ThreadLocalTable;
+
+public:
+    explicit ThreadLocalSlot(bool trackAllValues);
+    // Destroys the values of every thread and releases the index
+    ~ThreadLocalSlot();
+
+    ThreadLocalSlot(const ThreadLocalSlot&) = delete;
+    ThreadLocalSlot& operator=(const ThreadLocalSlot&) = delete;
+
+    std::size_t index() const { return index_; }
+    bool track_all_values() const { return track_all_values_; }
+
+    // Makes node this thread's value; owned by the slot once this returns
+    void install(ThreadLocalNode* node);
+
+    // Visits the values of every thread under the registry lock
+    void for_each(const std::function<void(ThreadLocalNode&)>& visit) const;
+};
+
+} // namespace detail
+
+// Per-thread storage.
+//
+// Each instance owns a slot index into a flat per-thread array, so reading the
+// value is a bounds check and two loads; the first access on a thread creates the
+// value and registers it with the instance.
+//
+// A thread's values are destroyed when the thread exits, except for instances
+// created with trackAllValues: those keep the values of exited threads, so that
+// values() can still sum per-thread counters after the workers are joined.
+// Destroying the instance destroys whatever values remain on every thread.
 template<typename T>
 class ThreadLocal {
 private:
-    static thread_local std::unordered_map<void*, std::shared_ptr<T>> thread_storage;
-    static std::mutex global_mutex;
-    
-    void* key;
+    struct FromFactory {};
+
+    struct Node : detail::ThreadLocalNode {
+        T value;
+
+        Node() : value() {}
+        explicit Node(const T& initial) : value(initial) {}
+        explicit Node(T&& initial) : value(std::move(initial)) {}
+
+        // Constructs the value in place, so T need not be movable
+        Node(FromFactory, const std::function<T()>& factory) : value(factory()) {}
+    };
+
     std::function<T()> value_factory;
-    bool track_all_values;
-    
+    detail::ThreadLocalSlot slot;
+
+    T* find() const {
+        std::size_t index = slot.index();
+        if (index < detail::thread_local_capacity) {
+            if (detail::ThreadLocalNode* node = detail::thread_local_nodes[index]) {
+                return &static_cast<Node*>(node)->value;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename... Args>
+    T& install(Args&&... args) {
+        auto node = std::make_unique<Node>(std::forward<Args>(args)...);
+        slot.install(node.get());
+        return node.release()->value;
+    }
+
+    T& create() {
+        if (!value_factory) {
+            return install();
+        }
+        auto node = std::make_unique<Node>(FromFactory{}, value_factory);
+        if (find()) {
+            throw std::runtime_error("value_factory attempted to access the value of this ThreadLocal");
+        }
+        slot.install(node.get());
+        return node.release()->value;
+    }
+
 public:
-    ThreadLocal() : key(this), track_all_values(false) {}
-    
-    explicit ThreadLocal(std::function<T()> factory) 
-        : key(this), value_factory(std::move(factory)), track_all_values(false) {}
-    
+    ThreadLocal() : slot(false) {}
+
+    explicit ThreadLocal(std::function<T()> factory)
+        : value_factory(std::move(factory)), slot(false) {}
+
+    // A null factory value-initializes, as the default constructor does
     ThreadLocal(std::function<T()> factory, bool trackAllValues)
-        : key(this), value_factory(std::move(factory)), track_all_values(trackAllValues) {}
-    
-    ~ThreadLocal() {
-        std::lock_guard<std::mutex> lock(global_mutex);
-        thread_storage.erase(key);
-    }
-    
+        : value_factory(std::move(factory)), slot(trackAllValues) {}
+
+    ThreadLocal(const ThreadLocal&) = delete;
+    ThreadLocal& operator=(const ThreadLocal&) = delete;
+
     T& get() {
-        auto it = thread_storage.find(key);
-        if (it != thread_storage.end() && it->second) {
-            return *(it->second);
+        if (T* value = find()) {
+            return *value;
         }
-        
-        if (value_factory) {
-            T value = value_factory();
-            thread_storage[key] = std::make_shared<T>(std::move(value));
-        } else {
-            thread_storage[key] = std::make_shared<T>();
-        }
-        
-        return *(thread_storage[key]);
+        return create();
     }
-    
+
     const T& get() const {
-        auto it = thread_storage.find(key);
-        if (it != thread_storage.end() && it->second) {
-            return *(it->second);
+        if (T* value = find()) {
+            return *value;
         }
-        
+
         static const T default_value{};
         return default_value;
     }
-    
+
     void set(const T& value) {
-        thread_storage[key] = std::make_shared<T>(value);
+        if (T* current = find()) {
+            *current = value;
+        } else {
+            install(value);
+        }
     }
-    
+
     void set(T&& value) {
-        thread_storage[key] = std::make_shared<T>(std::move(value));
+        if (T* current = find()) {
+            *current = std::move(value);
+        } else {
+            install(std::move(value));
+        }
     }
-    
+
     bool is_value_created() const {
-        auto it = thread_storage.find(key);
-        return it != thread_storage.end() && it->second != nullptr;
+        return find() != nullptr;
     }
-    
+
+    // A copy of the value of every thread that has created one, including threads
+    // that have exited. Requires trackAllValues; the caller synchronizes with
+    // threads still writing their values.
+    std::vector<T> values() const {
+        std::vector<T> result;
+        for_each_value([&result](const T& value) {
+            result.push_back(value);
+        });
+        return result;
+    }
+
+    // Visits the same values in place, under the registry lock: for values that
+    // cannot be copied, such as atomic counters
+    template<typename TVisitor>
+    void for_each_value(TVisitor&& visitor) const {
+        if (!slot.track_all_values()) {
+            throw std::runtime_error("The ThreadLocal was not created with trackAllValues");
+        }
+        slot.for_each([&visitor](detail::ThreadLocalNode& node) {
+            visitor(static_cast<const T&>(static_cast<Node&>(node).value));
+        });
+    }
+
     T& operator*() { return get(); }
     const T& operator*() const { return get(); }
-    
+
     T* operator->() { return &get(); }
     const T* operator->() const { return &get(); }
 };
 
-template<typename T>
-thread_local std::unordered_map<void*, std::shared_ptr<T>> ThreadLocal<T>::thread_storage;
-
-template<typename T>
-std::mutex ThreadLocal<T>::global_mutex;
-
 } // namespace Threading
 } // namespace System
@@ -1,30 +1,80 @@
-
 #pragma once
 
 #include "System/Object.h"
+#include "WorkStealingQueue.h"
+#include "CpuTopology.h"
 #include <functional>
 #include <vector>
-#include <queue>
+#include <deque>
+#include <memory>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 
 namespace System::Threading
 {
     using WaitCallback = std::function<void(System::Object*)>;
 
+    // Work-stealing thread pool.
+    //
+    // Every worker owns a Chase-Lev deque. Items queued from a pool thread go to that
+    // thread's deque and are popped LIFO by their owner; items queued from any other
+    // thread go to the global injection queue. An idle worker drains its own deque,
+    // then the injection queue, then steals FIFO from randomly chosen victims before
+    // it parks. Producers only touch the park lock when a worker is actually asleep.
+    //
+    // Workers are split into one group per NUMA node of CpuTopology::GetCurrent(), in
+    // proportion to the node's CPUs, and by default each worker may only run on its
+    // node's CPUs. A group has its own injection queue for items queued to that node
+    // and its own park lock. An idle worker looks at its node's queue before the
+    // global one and steals from workers on its node before it looks at other nodes,
+    // so work and the memory it touches stay on one node until a node runs dry.
     class ThreadPool
     {
     public:
+        // Where workers may run: anywhere in the process's affinity mask, on the CPUs
+        // of their node (the default), or each on one CPU of its node
+        enum class WorkerAffinity
+        {
+            None,
+            Node,
+            Core
+        };
+
         static bool QueueUserWorkItem(WaitCallback callback);
         static bool QueueUserWorkItem(WaitCallback callback, System::Object* state);
+        // preferLocal = false always uses the global queue, even from a pool thread.
+        static bool QueueUserWorkItem(WaitCallback callback, System::Object* state, bool preferLocal);
         static void GetMaxThreads(int& workerThreads, int& completionPortThreads);
         static void GetMinThreads(int& workerThreads, int& completionPortThreads);
         static bool SetMaxThreads(int workerThreads, int completionPortThreads);
         static bool SetMinThreads(int workerThreads, int completionPortThreads);
         static void GetAvailableThreads(int& workerThreads, int& completionPortThreads);
 
+        // Queues to the workers of a node (an index into CpuTopology::GetCurrent());
+        // workers on other nodes only take the item once they run out of their own work.
+        // Returns false for a node that does not exist.
+        static bool QueueUserWorkItemOnNode(WaitCallback callback, System::Object* state, int node);
+        static int GetNodeCount();
+        // The node of the calling pool thread's group; on any other thread, the node it
+        // is running on right now, or -1 when unknown
+        static int GetCurrentNode();
+        // Takes effect on each worker before the next item it runs
+        static void SetWorkerAffinity(WorkerAffinity affinity);
+        static WorkerAffinity GetWorkerAffinity();
+
+        // Diagnostics
+        static int GetThreadCount();
+        static long long GetPendingWorkItemCount();
+        static bool GetIsThreadPoolThread();
+
+        // Upper bound for SetMaxThreads; worker slots are preallocated so stealers can
+        // index them without synchronization.
+        static constexpr int MaxWorkerSlots = 1024;
+
     private:
         struct WorkItem
         {
@@ -32,18 +82,90 @@ namespace System::Threading
             System::Object* state;
         };
 
-        static std::vector<std::jthread> workerThreads;
-        static std::queue<WorkItem> workQueue;
-        static std::mutex queueMutex;
-        static std::condition_variable condition;
-        static std::atomic<bool> shutdown;
+        struct alignas(64) WorkerSlot
+        {
+            WorkStealingQueue<WorkItem*> localQueue;
+            std::uint32_t randomState;
+            int index;
+            int node;
+            int nodeRank;  // Position among its node's workers, picks its CPU under Core
+            std::uint32_t affinityGeneration;
+        };
+
+        struct InjectionQueue
+        {
+            std::deque<WorkItem*> items;
+            std::mutex mutex;
+            std::atomic<long long> count{0};
+        };
+
+        struct alignas(64) NodeGroup
+        {
+            std::vector<int> cpus;
+            InjectionQueue injection;
+            // Indices of the node's workers, preallocated like workerSlots; written
+            // under growMutex before memberCount publishes them
+            std::unique_ptr<int[]> members;
+            std::atomic<int> memberCount{0};
+            std::mutex parkMutex;
+            std::condition_variable_any parkCondition;
+            std::atomic<int> sleepingThreads{0};
+        };
+
+        static std::unique_ptr<WorkerSlot> workerSlots[MaxWorkerSlots];
+        static std::atomic<int> workerCount;
+        static std::mutex growMutex;
+
+        static InjectionQueue globalInjection;
+
+        static std::unique_ptr<NodeGroup[]> nodeGroups;
+        static int nodeCount;
+        static std::vector<int> allCpus;
+        static std::atomic<int> workerAffinity;
+        static std::atomic<std::uint32_t> affinityGeneration;
+        static std::atomic<std::uint32_t> nextWakeNode;
+
+        static std::atomic<int> sleepingThreads;
+        static std::atomic<std::uint64_t> workEpoch;
+
         static std::atomic<int> maxWorkerThreads;
         static std::atomic<int> minWorkerThreads;
         static std::atomic<int> maxCompletionPortThreads;
         static std::atomic<int> minCompletionPortThreads;
         static std::atomic<int> activeThreads;
+        static std::atomic<std::int64_t> lastThreadInjectionTicks;
+
+        static thread_local WorkerSlot* currentWorker;
+
+        // Owns the workers. Destroyed first at exit, it closes the pool to new workers
+        // under growMutex, stops and joins the ones it has, and frees the items they
+        // left queued.
+        struct WorkerThreads
+        {
+            std::vector<std::jthread> threads;
+            std::jthread starvationMonitor;
+            bool closed = false;
+
+            ~WorkerThreads();
+        };
+
+        static WorkerThreads workerThreads;
 
-        static void WorkerThreadProc(std::stop_token stopToken);
+        static void WorkerThreadProc(std::stop_token stopToken, WorkerSlot* slot);
+        static WorkItem* FindWork(WorkerSlot* slot, bool remote);
+        static WorkItem* TryDequeueInjected(InjectionQueue& queue);
+        static WorkItem* TryStealFromNode(WorkerSlot* slot, int node);
+        static WorkItem* TryStealRemote(WorkerSlot* slot);
+        static void Inject(InjectionQueue& queue, WorkItem* item);
+        static void ApplyAffinity(WorkerSlot* slot);
+        static void Execute(WorkItem* item);
+        // node is where the work was queued, or -1 for anywhere
+        static void SignalWork(int node);
+        static void Park(WorkerSlot* slot, std::stop_token& stopToken, std::uint64_t observedEpoch);
+        static int PickNodeForNewWorker();
+        static bool TryAddWorker();
+        static void InjectThreadIfStarved();
+        static void MonitorStarvation(std::stop_token stopToken);
         static void EnsureMinimumThreads();
         static void Initialize();
         static std::once_flag initFlag;
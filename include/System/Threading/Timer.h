@@ -4,27 +4,29 @@
 #include "System/Object.h"
 #include "System/TimeSpan.h"
 #include "WaitHandle.h"
+#include "TimerWheel.hpp"
 #include <functional>
-#include <thread>
 #include <atomic>
 #include <mutex>
-#include <condition_variable>
 
 namespace System::Threading
 {
     using TimerCallback = std::function<void(System::Object*)>;
 
+    // Timers are entries in the process-wide TimerWheel rather than threads of their
+    // own; callbacks run on the ThreadPool. A due time or period of -1 (Infinite)
+    // disables the timer or its repetition.
     class Timer : public System::Object
     {
+    public:
+        static constexpr int Infinite = -1;
+
     private:
         TimerCallback callback;
         System::Object* state;
-        std::unique_ptr<std::jthread> timerThread;
+        TimerWheel::Handle entry;
         std::atomic<bool> disposed{false};
         std::mutex mutex;
-        std::condition_variable condition;
-        std::atomic<int> dueTime;
-        std::atomic<int> period;
 
     public:
         Timer(TimerCallback callback, System::Object* state, int dueTime, int period);
@@ -40,6 +42,6 @@ namespace System::Threading
         bool Dispose(WaitHandle* notifyObject);
 
     private:
-        void TimerThreadProc(std::stop_token stopToken);
+        static long ToMilliseconds(const TimeSpan& value);
     };
 }
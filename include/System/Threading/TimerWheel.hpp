@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace System {
+namespace Threading {
+
+// Process-wide hierarchical timing wheel serviced by a single timer thread.
+//
+// Task::delay, CancellationTokenSource::cancel_after and Timer all schedule entries
+// here instead of owning a sleeping thread each. The wheel has four levels of 64
+// slots at 1 ms resolution (about 4.6 hours before an entry sits in the overflow
+// list); scheduling, changing and canceling an entry unlink/link it in O(1) under
+// one short lock. Expired callbacks are posted to the ThreadPool, never run on the
+// timer thread itself.
+class TimerWheel {
+public:
+    struct Entry;
+    using Handle = std::shared_ptr<Entry>;
+
+    static constexpr std::int64_t Infinite = -1;
+
+    static TimerWheel& instance();
+
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Runs callback once after dueMilliseconds and then every periodMilliseconds if
+    // the period is positive. A due time of Infinite creates the entry disabled.
+    Handle schedule(std::function<void()> callback,
+                    std::int64_t dueMilliseconds,
+                    std::int64_t periodMilliseconds = 0);
+
+    // Reschedules an entry; returns false if it has been canceled
+    bool change(const Handle& handle, std::int64_t dueMilliseconds, std::int64_t periodMilliseconds = 0);
+
+    // Stops an entry from firing again. A callback already handed to the ThreadPool
+    // still runs. Returns true if the entry was pending.
+    bool cancel(const Handle& handle);
+
+    std::size_t get_pending_count() const;
+
+private:
+    static constexpr int LevelBits = 6;
+    static constexpr int SlotsPerLevel = 1 << LevelBits;
+    static constexpr int Levels = 4;
+    static constexpr std::uint64_t SlotMask = SlotsPerLevel - 1;
+
+    struct Slot {
+        Entry* head = nullptr;
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable_any wake_;
+    bool wake_requested_ = false;
+    std::array<std::array<Slot, SlotsPerLevel>, Levels> wheel_;
+    Slot overflow_;
+    std::size_t count_ = 0;
+
+    // Next tick to process and the tick the timer thread is sleeping until
+    std::uint64_t current_tick_ = 0;
+    std::uint64_t wake_tick_ = UINT64_MAX;
+    const std::chrono::steady_clock::time_point epoch_;
+
+    std::jthread thread_;
+
+    TimerWheel();
+
+    std::uint64_t now_tick() const;
+    void arm(const Handle& handle, std::int64_t dueMilliseconds, std::int64_t periodMilliseconds);
+    void link(Entry* entry);
+    void unlink(Entry* entry);
+    void cascade(Slot& slot);
+    void advance(std::uint64_t tick, std::vector<Handle>& expired);
+    std::uint64_t next_event_tick() const;
+    void run(std::stop_token stop_token);
+    static void dispatch(Handle entry);
+};
+
+} // namespace Threading
+} // namespace System
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace System::Threading
+{
+    // Chase-Lev work-stealing deque (Le et al., "Correct and Efficient Work-Stealing
+    // for Weak Memory Models", PPoPP 2013).
+    //
+    // The owning thread pushes and pops at the bottom (LIFO); any other thread may
+    // steal from the top (FIFO). T must be trivially copyable - the thread pool stores
+    // raw work item pointers. Buffers replaced by Grow() are retired rather than freed
+    // because a concurrent stealer may still be reading from them; they are released
+    // together with the queue.
+    template<typename T>
+    class WorkStealingQueue
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "WorkStealingQueue requires a trivially copyable element type");
+
+    private:
+        struct Buffer
+        {
+            std::int64_t capacity;
+            std::int64_t mask;
+            std::unique_ptr<std::atomic<T>[]> slots;
+
+            explicit Buffer(std::int64_t cap)
+                : capacity(cap), mask(cap - 1), slots(new std::atomic<T>[static_cast<std::size_t>(cap)]) {}
+
+            T Get(std::int64_t index) const { return slots[index & mask].load(std::memory_order_relaxed); }
+            void Put(std::int64_t index, T value) { slots[index & mask].store(value, std::memory_order_relaxed); }
+        };
+
+        static constexpr std::size_t CacheLineSize = 64;
+
+        alignas(CacheLineSize) std::atomic<std::int64_t> top{0};
+        alignas(CacheLineSize) std::atomic<std::int64_t> bottom{0};
+        alignas(CacheLineSize) std::atomic<Buffer*> buffer;
+        std::vector<std::unique_ptr<Buffer>> retiredBuffers;
+
+    public:
+        explicit WorkStealingQueue(std::int64_t initialCapacity = 256)
+        {
+            std::int64_t capacity = 1;
+            while (capacity < initialCapacity)
+            {
+                capacity <<= 1;
+            }
+            retiredBuffers.push_back(std::make_unique<Buffer>(capacity));
+            buffer.store(retiredBuffers.back().get(), std::memory_order_relaxed);
+        }
+
+        WorkStealingQueue(const WorkStealingQueue&) = delete;
+        WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+
+        // Owner only.
+        void Push(T item)
+        {
+            std::int64_t b = bottom.load(std::memory_order_relaxed);
+            std::int64_t t = top.load(std::memory_order_acquire);
+            Buffer* a = buffer.load(std::memory_order_relaxed);
+            if (b - t > a->capacity - 1)
+            {
+                a = Grow(a, b, t);
+            }
+            a->Put(b, item);
+            bottom.store(b + 1, std::memory_order_release);
+        }
+
+        // Owner only. Takes the most recently pushed item.
+        bool TryPop(T& result)
+        {
+            std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            Buffer* a = buffer.load(std::memory_order_relaxed);
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t t = top.load(std::memory_order_relaxed);
+
+            if (t > b)
+            {
+                // Empty
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            result = a->Get(b);
+            if (t == b)
+            {
+                // Last element - race against stealers for it
+                bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        // Any thread. Takes the oldest item.
+        bool TrySteal(T& result)
+        {
+            std::int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t b = bottom.load(std::memory_order_acquire);
+
+            if (t >= b)
+            {
+                return false;
+            }
+
+            Buffer* a = buffer.load(std::memory_order_acquire);
+            T item = a->Get(t);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                return false;
+            }
+            result = item;
+            return true;
+        }
+
+        // Approximate; exact only when called by the owner with no concurrent stealers.
+        std::int64_t GetCount() const
+        {
+            std::int64_t b = bottom.load(std::memory_order_relaxed);
+            std::int64_t t = top.load(std::memory_order_relaxed);
+            return b > t ? b - t : 0;
+        }
+
+        bool GetIsEmpty() const
+        {
+            return GetCount() == 0;
+        }
+
+    private:
+        Buffer* Grow(Buffer* old, std::int64_t b, std::int64_t t)
+        {
+            auto grown = std::make_unique<Buffer>(old->capacity * 2);
+            for (std::int64_t i = t; i < b; ++i)
+            {
+                grown->Put(i, old->Get(i));
+            }
+            Buffer* result = grown.get();
+            retiredBuffers.push_back(std::move(grown));
+            buffer.store(result, std::memory_order_release);
+            return result;
+        }
+    };
+}
@@ -2,7 +2,7 @@
 // AsyncLocal.cpp - Implementation file for AsyncLocal<T>
 // Most functionality is implemented in the header due to template nature
 
-#include "../../include/System/Threading/AsyncLocal.hpp"
+#include "System/Threading/AsyncLocal.hpp"
 
 namespace System {
 namespace Threading {
@@ -1,7 +1,7 @@
 
 // Barrier.cpp - Implementation file for Barrier class
 
-#include "../../include/System/Threading/Barrier.hpp"
+#include "System/Threading/Barrier.hpp"
 
 namespace System {
 namespace Threading {
@@ -1,13 +1,223 @@
+// CancellationToken.cpp - The callback list behind CancellationTokenSource
 
-// CancellationToken.cpp - Implementation file for CancellationToken and related classes
-
-#include "../../include/System/Threading/CancellationToken.hpp"
+#include "System/Threading/CancellationToken.hpp"
+#include <algorithm>
+#include <vector>
 
 namespace System {
 namespace Threading {
+namespace detail {
+
+namespace {
+
+void invoke(CancellationCallbackNode& node) noexcept {
+    try {
+        node.callback();
+    } catch (...) {
+        // Ignore exceptions in callbacks
+    }
+}
+
+} // namespace
+
+CancellationCallbackNode::CancellationCallbackNode(CancellationState* linked) : child(linked) {
+    child->add_ref();
+}
+
+CancellationCallbackNode::~CancellationCallbackNode() {
+    if (child) {
+        child->release();
+    }
+}
+
+void CancellationState::destroy(CancellationState* state) noexcept {
+    // Releasing a link can free a child whose list links further children, so a
+    // long chain of linked sources is freed in a loop rather than by recursion
+    while (state) {
+        CancellationCallbackNode* node = state->head_.load(std::memory_order_acquire);
+        if (node == canceled_marker()) {
+            node = nullptr;
+        }
+        // Registrations hold the state alive, so only the list's references remain
+        while (node) {
+            CancellationCallbackNode* next = node->next;
+            if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                CancellationState* child = std::exchange(node->child, nullptr);
+                if (child && child->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    child->next_destroyed_ = state->next_destroyed_;
+                    state->next_destroyed_ = child;
+                }
+                delete node;
+            }
+            node = next;
+        }
+
+        CancellationState* next_state = state->next_destroyed_;
+        delete state;
+        state = next_state;
+    }
+}
+
+void CancellationState::lock_walk() noexcept {
+    while (walking_.exchange(true, std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+bool CancellationState::cancel() {
+    if (!try_mark_canceled()) {
+        return false;
+    }
+
+    // Depth-first through the linked sources, without recursion
+    std::vector<CancellationCallbackNode*> pending;
+    notify(pending);
+    while (!pending.empty()) {
+        CancellationCallbackNode* link = pending.back();
+        pending.pop_back();
+        link->child->notify(pending);
+        link->release();
+    }
+    return true;
+}
+
+void CancellationState::notify(std::vector<CancellationCallbackNode*>& pending) {
+    cancelling_thread_ = std::this_thread::get_id();
+
+    // Registrations from here on run inline. Only a sweep can be walking a
+    // non-empty list, so only then is there anything to wait out.
+    CancellationCallbackNode* node = nullptr;
+    if (!head_.compare_exchange_strong(node, canceled_marker(), std::memory_order_acq_rel)) {
+        lock_walk();
+        node = head_.exchange(canceled_marker(), std::memory_order_acq_rel);
+        unlock_walk();
+    }
+
+    while (node) {
+        CancellationCallbackNode* next = node->next;
+        std::uint32_t registered = CancellationCallbackNode::Registered;
+        if (node->state.compare_exchange_strong(registered, CancellationCallbackNode::Executing,
+                                                std::memory_order_acq_rel)) {
+            bool queued = false;
+            if (node->child) {
+                // The child is canceled now; its list runs later in the same pass,
+                // with the list's reference to the link keeping it alive
+                queued = node->child->try_mark_canceled();
+            } else {
+                invoke(*node);
+            }
+            node->state.store(CancellationCallbackNode::Executed, std::memory_order_release);
+            node->state.notify_all();
+            if (queued) {
+                pending.push_back(node);
+                node = next;
+                continue;
+            }
+        }
+        node->release();
+        node = next;
+    }
+}
+
+CancellationCallbackNode* CancellationState::register_callback(CancellationCallback callback) {
+    if (is_canceled()) {
+        try {
+            callback();
+        } catch (...) {
+            // Ignore exceptions in callbacks
+        }
+        return nullptr;
+    }
+    return push(new CancellationCallbackNode(std::move(callback)));
+}
+
+CancellationCallbackNode* CancellationState::register_child(CancellationState* child) {
+    if (is_canceled()) {
+        child->cancel();
+        return nullptr;
+    }
+    return push(new CancellationCallbackNode(child));
+}
+
+CancellationCallbackNode* CancellationState::push(CancellationCallbackNode* node) {
+    CancellationCallbackNode* head = head_.load(std::memory_order_relaxed);
+    do {
+        if (head == canceled_marker()) {
+            // Lost the race with cancel
+            if (node->child) {
+                node->child->cancel();
+            } else {
+                invoke(*node);
+            }
+            delete node;
+            return nullptr;
+        }
+        node->next = head;
+    } while (!head_.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+
+    if (tombstones_.load(std::memory_order_relaxed) >= sweep_threshold_.load(std::memory_order_relaxed)) {
+        sweep();
+    }
+    return node;
+}
+
+void CancellationState::unregister(CancellationCallbackNode* node) noexcept {
+    std::uint32_t state = CancellationCallbackNode::Registered;
+    if (node->state.compare_exchange_strong(state, CancellationCallbackNode::Unregistered,
+                                            std::memory_order_acq_rel)) {
+        tombstones_.fetch_add(1, std::memory_order_relaxed);
+    } else if (state == CancellationCallbackNode::Executing &&
+               cancelling_thread_ != std::this_thread::get_id()) {
+        // Running on the cancelling thread; a callback disposing itself must not wait
+        node->state.wait(CancellationCallbackNode::Executing, std::memory_order_acquire);
+    }
+    node->release();
+}
+
+void CancellationState::sweep() noexcept {
+    if (walking_.exchange(true, std::memory_order_acquire)) {
+        return;
+    }
+
+    CancellationCallbackNode* head = head_.load(std::memory_order_acquire);
+    if (head == canceled_marker()) {
+        unlock_walk();
+        return;
+    }
+
+    // Pushes only ever replace head_, so everything behind the loaded head is
+    // ours to relink; the head itself is only unlinked if no push has raced in
+    std::int32_t removed = 0;
+    std::int32_t live = 0;
+    CancellationCallbackNode* previous = nullptr;
+    CancellationCallbackNode* node = head;
+    while (node) {
+        CancellationCallbackNode* next = node->next;
+        bool unlinked = false;
+        if (node->state.load(std::memory_order_acquire) == CancellationCallbackNode::Unregistered) {
+            if (previous) {
+                previous->next = next;
+                unlinked = true;
+            } else {
+                CancellationCallbackNode* expected = node;
+                unlinked = head_.compare_exchange_strong(expected, next, std::memory_order_acq_rel);
+            }
+        }
+        if (unlinked) {
+            node->release();
+            ++removed;
+        } else {
+            previous = node;
+            ++live;
+        }
+        node = next;
+    }
 
-// Most functionality is implemented in the header
-// Any additional non-inline implementations would go here
+    tombstones_.fetch_sub(removed, std::memory_order_relaxed);
+    sweep_threshold_.store(std::max(MinimumSweep, live), std::memory_order_relaxed);
+    unlock_walk();
+}
 
+} // namespace detail
 } // namespace Threading
 } // namespace System
@@ -1,7 +1,7 @@
 
 // CountdownEvent.cpp - Implementation file for CountdownEvent class
 
-#include "../../include/System/Threading/CountdownEvent.hpp"
+#include "System/Threading/CountdownEvent.hpp"
 
 namespace System {
 namespace Threading {
@@ -0,0 +1,255 @@
+// CpuTopology.cpp - CPU and NUMA node discovery from sysfs
+
+#include "System/Threading/CpuTopology.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace System::Threading
+{
+    namespace
+    {
+        bool ReadFirstLine(const std::filesystem::path& path, std::string& line)
+        {
+            std::ifstream file(path);
+            return static_cast<bool>(std::getline(file, line));
+        }
+
+        bool IsNumber(const std::string& text)
+        {
+            return !text.empty() && std::all_of(text.begin(), text.end(), [](unsigned char c) {
+                return std::isdigit(c) != 0;
+            });
+        }
+
+        std::vector<int> Intersect(const std::vector<int>& cpus, const std::vector<int>& allowedCpus)
+        {
+            if (allowedCpus.empty())
+            {
+                return cpus;
+            }
+            std::vector<int> kept;
+            std::set_intersection(cpus.begin(), cpus.end(), allowedCpus.begin(), allowedCpus.end(),
+                                  std::back_inserter(kept));
+            return kept;
+        }
+    }
+
+    const CpuTopology& CpuTopology::GetCurrent()
+    {
+        static const CpuTopology topology = Read("/sys/devices/system", GetCurrentThreadAffinity());
+        return topology;
+    }
+
+    CpuTopology CpuTopology::Read(const std::string& sysfsRoot, const std::vector<int>& allowedCpus)
+    {
+        std::vector<int> allowed = allowedCpus;
+        std::sort(allowed.begin(), allowed.end());
+        allowed.erase(std::unique(allowed.begin(), allowed.end()), allowed.end());
+
+        std::vector<std::pair<int, std::vector<int>>> found;
+        std::error_code error;
+        std::filesystem::directory_iterator entries(std::filesystem::path(sysfsRoot) / "node", error);
+        for (; !error && entries != std::filesystem::directory_iterator(); entries.increment(error))
+        {
+            std::string name = entries->path().filename().string();
+            std::string list;
+            if (name.compare(0, 4, "node") != 0 || !IsNumber(name.substr(4)) ||
+                !ReadFirstLine(entries->path() / "cpulist", list))
+            {
+                continue;
+            }
+            try
+            {
+                found.emplace_back(std::stoi(name.substr(4)), Intersect(ParseCpuList(list), allowed));
+            }
+            catch (const std::exception&)
+            {
+                // An unreadable node is left out like a memory-only one
+            }
+        }
+        std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        CpuTopology topology;
+        for (auto& [id, cpus] : found)
+        {
+            if (!cpus.empty())
+            {
+                topology.AddNode(id, std::move(cpus));
+            }
+        }
+        if (topology.nodes.empty())
+        {
+            // No NUMA information: one node with every CPU we may use
+            std::vector<int> cpus;
+            std::string online;
+            if (ReadFirstLine(std::filesystem::path(sysfsRoot) / "cpu" / "online", online))
+            {
+                try
+                {
+                    cpus = Intersect(ParseCpuList(online), allowed);
+                }
+                catch (const std::invalid_argument&)
+                {
+                    // Fall back to the affinity mask
+                }
+            }
+            if (cpus.empty())
+            {
+                cpus = allowed;
+            }
+            if (cpus.empty())
+            {
+                int count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+                for (int cpu = 0; cpu < count; ++cpu)
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+            topology.AddNode(0, std::move(cpus));
+        }
+        return topology;
+    }
+
+    std::vector<int> CpuTopology::ParseCpuList(const std::string& list)
+    {
+        std::vector<int> cpus;
+        std::string trimmed;
+        std::copy_if(list.begin(), list.end(), std::back_inserter(trimmed), [](unsigned char c) {
+            return std::isspace(c) == 0;
+        });
+
+        std::size_t position = 0;
+        while (position < trimmed.size())
+        {
+            std::size_t comma = trimmed.find(',', position);
+            std::string range = trimmed.substr(position, comma == std::string::npos ? std::string::npos : comma - position);
+            position = comma == std::string::npos ? trimmed.size() : comma + 1;
+
+            std::size_t dash = range.find('-');
+            std::string first = range.substr(0, dash);
+            std::string last = dash == std::string::npos ? first : range.substr(dash + 1);
+            if (!IsNumber(first) || !IsNumber(last) || first.size() > 9 || last.size() > 9)
+            {
+                throw std::invalid_argument("Malformed CPU list: " + list);
+            }
+            int from = std::stoi(first);
+            int to = std::stoi(last);
+            if (from > to)
+            {
+                throw std::invalid_argument("Malformed CPU list: " + list);
+            }
+            for (int cpu = from; cpu <= to; ++cpu)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        return cpus;
+    }
+
+    int CpuTopology::GetNodeCount() const
+    {
+        return static_cast<int>(nodes.size());
+    }
+
+    int CpuTopology::GetProcessorCount() const
+    {
+        return processorCount;
+    }
+
+    const CpuTopology::Node& CpuTopology::GetNode(int node) const
+    {
+        if (node < 0 || node >= GetNodeCount())
+        {
+            throw std::out_of_range("Node index is out of range");
+        }
+        return nodes[static_cast<std::size_t>(node)];
+    }
+
+    int CpuTopology::GetNodeOfCpu(int cpu) const
+    {
+        if (cpu < 0 || cpu >= static_cast<int>(nodeOfCpu.size()))
+        {
+            return -1;
+        }
+        return nodeOfCpu[static_cast<std::size_t>(cpu)];
+    }
+
+    int CpuTopology::GetCurrentNode() const
+    {
+#if defined(__linux__)
+        return GetNodeOfCpu(sched_getcpu());
+#else
+        return -1;
+#endif
+    }
+
+    std::vector<int> CpuTopology::GetCurrentThreadAffinity()
+    {
+        std::vector<int> cpus;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &set))
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+#endif
+        return cpus;
+    }
+
+    bool CpuTopology::SetCurrentThreadAffinity(const std::vector<int>& cpus)
+    {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        bool any = false;
+        for (int cpu : cpus)
+        {
+            if (cpu >= 0 && cpu < CPU_SETSIZE)
+            {
+                CPU_SET(cpu, &set);
+                any = true;
+            }
+        }
+        return any && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpus;
+        return false;
+#endif
+    }
+
+    void CpuTopology::AddNode(int id, std::vector<int> cpus)
+    {
+        int index = GetNodeCount();
+        if (cpus.back() >= static_cast<int>(nodeOfCpu.size()))
+        {
+            nodeOfCpu.resize(static_cast<std::size_t>(cpus.back()) + 1, -1);
+        }
+        for (int cpu : cpus)
+        {
+            nodeOfCpu[static_cast<std::size_t>(cpu)] = index;
+        }
+        processorCount += static_cast<int>(cpus.size());
+        nodes.push_back(Node{id, std::move(cpus)});
+    }
+}
@@ -0,0 +1,167 @@
+// EpochReclaimer.cpp - Epoch-based reclamation shared by the lock-free collections
+
+#include "System/Threading/EpochReclaimer.h"
+#include <algorithm>
+
+namespace System::Threading
+{
+    // Epochs start at 1 so a live announcement is never 0
+    std::atomic<std::uint64_t> EpochReclaimer::globalEpoch{1};
+    std::atomic<EpochReclaimer::ThreadRecord*> EpochReclaimer::records{nullptr};
+    std::atomic<int> EpochReclaimer::orphanedRecords{0};
+    thread_local EpochReclaimer::ThreadRecord* EpochReclaimer::currentRecord = nullptr;
+    thread_local EpochReclaimer::RecordOwner EpochReclaimer::recordOwner;
+
+    EpochReclaimer::RecordOwner::~RecordOwner()
+    {
+        if (record)
+        {
+            ReleaseRecord(record);
+        }
+    }
+
+    EpochReclaimer::ThreadRecord* EpochReclaimer::AcquireRecord()
+    {
+        // Records are never freed; a record left behind by an exited thread is
+        // reused, together with anything it retired and could not free yet
+        ThreadRecord* record = records.load(std::memory_order_acquire);
+        for (; record; record = record->next)
+        {
+            bool expected = false;
+            if (!record->inUse.load(std::memory_order_relaxed) &&
+                record->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+                if (!record->retired.empty())
+                {
+                    orphanedRecords.fetch_sub(1, std::memory_order_relaxed);
+                }
+                break;
+            }
+        }
+
+        if (!record)
+        {
+            record = new ThreadRecord();
+            record->inUse.store(true, std::memory_order_relaxed);
+            ThreadRecord* head = records.load(std::memory_order_relaxed);
+            do
+            {
+                record->next = head;
+            } while (!records.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        currentRecord = record;
+        recordOwner.record = record;
+        return record;
+    }
+
+    void EpochReclaimer::ReleaseRecord(ThreadRecord* record)
+    {
+        record->epoch.store(0, std::memory_order_release);
+        record->depth = 0;
+        Collect(record);
+        currentRecord = nullptr;
+        if (!record->retired.empty())
+        {
+            orphanedRecords.fetch_add(1, std::memory_order_relaxed);
+        }
+        record->inUse.store(false, std::memory_order_release);
+    }
+
+    void EpochReclaimer::Retire(void* pointer, Deleter deleter, std::size_t bytes)
+    {
+        ThreadRecord* record = CurrentRecord();
+        record->retired.push_back({pointer, deleter, globalEpoch.load(std::memory_order_acquire), bytes});
+        record->retiredBytes += bytes;
+        if (record->retired.size() >= CollectThreshold || record->retiredBytes >= CollectBytesThreshold)
+        {
+            Collect(record);
+        }
+    }
+
+    void EpochReclaimer::Collect()
+    {
+        Collect(CurrentRecord());
+    }
+
+    void EpochReclaimer::Collect(ThreadRecord* record)
+    {
+        TryAdvance();
+        std::uint64_t epoch = globalEpoch.load(std::memory_order_acquire);
+        FreeExpired(record, epoch);
+        if (orphanedRecords.load(std::memory_order_relaxed) > 0)
+        {
+            CollectOrphans(epoch);
+        }
+    }
+
+    void EpochReclaimer::FreeExpired(ThreadRecord* record, std::uint64_t epoch)
+    {
+        auto& retired = record->retired;
+        auto reclaimable = std::partition(retired.begin(), retired.end(), [epoch](const RetiredNode& node) {
+            return node.epoch + 2 > epoch;
+        });
+        // Detach first: a deleter may itself retire nodes
+        std::vector<RetiredNode> expired(reclaimable, retired.end());
+        retired.erase(reclaimable, retired.end());
+        for (const RetiredNode& node : expired)
+        {
+            record->retiredBytes -= node.bytes;
+        }
+        for (const RetiredNode& node : expired)
+        {
+            node.deleter(node.pointer);
+        }
+    }
+
+    // Frees what exited threads left behind, claiming each record the way a new
+    // thread would so no other thread touches its list meanwhile
+    void EpochReclaimer::CollectOrphans(std::uint64_t epoch)
+    {
+        for (ThreadRecord* record = records.load(std::memory_order_acquire); record; record = record->next)
+        {
+            bool expected = false;
+            if (record->inUse.load(std::memory_order_relaxed) ||
+                !record->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+                continue;
+            }
+            if (!record->retired.empty())
+            {
+                FreeExpired(record, epoch);
+                if (record->retired.empty())
+                {
+                    orphanedRecords.fetch_sub(1, std::memory_order_relaxed);
+                }
+            }
+            record->inUse.store(false, std::memory_order_release);
+        }
+    }
+
+    // Moves the global epoch forward if every thread inside a guard has seen it
+    bool EpochReclaimer::TryAdvance()
+    {
+        std::uint64_t epoch = globalEpoch.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        for (ThreadRecord* record = records.load(std::memory_order_acquire); record; record = record->next)
+        {
+            std::uint64_t announced = record->epoch.load(std::memory_order_acquire);
+            if ((announced & Active) != 0 && (announced >> 1) != epoch)
+            {
+                return false;
+            }
+        }
+        return globalEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel);
+    }
+
+    std::uint64_t EpochReclaimer::GetEpoch()
+    {
+        return globalEpoch.load(std::memory_order_acquire);
+    }
+
+    std::size_t EpochReclaimer::GetPendingCount()
+    {
+        return CurrentRecord()->retired.size();
+    }
+}
@@ -0,0 +1,407 @@
+// ExecutionContext.cpp - The persistent AsyncLocal map behind ExecutionContext
+
+#include "System/Threading/ExecutionContext.hpp"
+#include <bit>
+#include <memory>
+#include <new>
+
+namespace System {
+namespace Threading {
+namespace detail {
+
+thread_local constinit AsyncLocalNode* current_async_locals = nullptr;
+
+namespace {
+
+// Maps with fewer entries than this are a flat array
+constexpr std::uint32_t TrieThreshold = 4;
+constexpr unsigned BitsPerLevel = 5;
+constexpr std::uint64_t LevelMask = (1u << BitsPerLevel) - 1;
+
+struct Entry {
+    std::uint64_t key = 0;
+    AsyncLocalValue* value = nullptr;
+};
+
+struct MapNode : AsyncLocalNode {
+    bool trie;
+    // Entries in this node and below it
+    std::uint32_t size = 0;
+
+    explicit MapNode(bool isTrie) : trie(isTrie) {}
+};
+
+struct ArrayMap : MapNode {
+    Entry entries[TrieThreshold - 1];
+
+    ArrayMap() : MapNode(false) {}
+};
+
+// A child is either a subtrie or a single entry
+struct Slot {
+    MapNode* child = nullptr;
+    Entry leaf;
+};
+
+// One level of a hash array mapped trie. The bitmap marks which of the 32 hash
+// digits at this level are present; the slots for just those follow the node in
+// the same allocation, in digit order.
+struct TrieNode : MapNode {
+    std::uint32_t bitmap;
+
+    explicit TrieNode(std::uint32_t presentDigits) : MapNode(true), bitmap(presentDigits) {}
+
+    unsigned count() const {
+        return static_cast<unsigned>(std::popcount(bitmap));
+    }
+
+    Slot* slots() {
+        return reinterpret_cast<Slot*>(this + 1);
+    }
+
+    const Slot* slots() const {
+        return reinterpret_cast<const Slot*>(this + 1);
+    }
+};
+
+static_assert(sizeof(TrieNode) % alignof(Slot) == 0, "slots must follow the node aligned");
+
+TrieNode* allocate_trie(std::uint32_t bitmap) {
+    unsigned count = static_cast<unsigned>(std::popcount(bitmap));
+    void* memory = ::operator new(sizeof(TrieNode) + count * sizeof(Slot));
+    auto* node = ::new (memory) TrieNode(bitmap);
+    std::uninitialized_value_construct_n(node->slots(), count);
+    return node;
+}
+
+void free_trie(TrieNode* node) {
+    node->~TrieNode();
+    ::operator delete(node);
+}
+
+// A bijection, so distinct keys never share a hash and every pair of keys
+// diverges within the 64 bits the trie consumes
+std::uint64_t hash(std::uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+unsigned digit(std::uint64_t keyHash, unsigned shift) {
+    return static_cast<unsigned>((keyHash >> shift) & LevelMask);
+}
+
+unsigned position(std::uint32_t bitmap, unsigned bit) {
+    return static_cast<unsigned>(std::popcount(bitmap & ((1u << bit) - 1)));
+}
+
+// Shallow copy with the digits of bitmap, sharing the children and values of the
+// digits both have; digits new in bitmap get empty slots
+TrieNode* clone(const TrieNode& node, std::uint32_t bitmap) {
+    TrieNode* copy = allocate_trie(bitmap);
+    copy->size = node.size;
+    Slot* target = copy->slots();
+    for (std::uint32_t digits = bitmap; digits; digits &= digits - 1, ++target) {
+        unsigned bit = static_cast<unsigned>(std::countr_zero(digits));
+        if (!(node.bitmap & (1u << bit))) {
+            continue;
+        }
+        *target = node.slots()[position(node.bitmap, bit)];
+        if (target->child) {
+            add_ref(target->child);
+        } else {
+            target->leaf.value->add_ref();
+        }
+    }
+    return copy;
+}
+
+ArrayMap* clone(const ArrayMap& node) {
+    auto* copy = new ArrayMap();
+    copy->size = node.size;
+    for (std::uint32_t i = 0; i < node.size; ++i) {
+        copy->entries[i] = node.entries[i];
+        copy->entries[i].value->add_ref();
+    }
+    return copy;
+}
+
+// A trie holding just two entries whose hashes agree below shift
+TrieNode* pair(const Entry& first, const Entry& second, unsigned shift) {
+    std::uint64_t first_hash = hash(first.key);
+    std::uint64_t second_hash = hash(second.key);
+    unsigned first_digit = digit(first_hash, shift);
+    unsigned second_digit = digit(second_hash, shift);
+
+    if (first_digit == second_digit) {
+        TrieNode* node = allocate_trie(1u << first_digit);
+        node->size = 2;
+        node->slots()[0].child = pair(first, second, shift + BitsPerLevel);
+        return node;
+    }
+
+    TrieNode* node = allocate_trie((1u << first_digit) | (1u << second_digit));
+    node->size = 2;
+    bool first_low = first_digit < second_digit;
+    node->slots()[0].leaf = first_low ? first : second;
+    node->slots()[1].leaf = first_low ? second : first;
+    return node;
+}
+
+// Copies the path to key and stores entry there, taking over its value reference
+TrieNode* insert(const TrieNode& node, std::uint64_t keyHash, const Entry& entry, unsigned shift) {
+    unsigned bit = digit(keyHash, shift);
+    TrieNode* copy = clone(node, node.bitmap | (1u << bit));
+    unsigned index = position(copy->bitmap, bit);
+
+    if (!(node.bitmap & (1u << bit))) {
+        copy->slots()[index].leaf = entry;
+        ++copy->size;
+        return copy;
+    }
+
+    Slot& slot = copy->slots()[index];
+    if (slot.child) {
+        std::uint32_t before = slot.child->size;
+        TrieNode* child = insert(static_cast<const TrieNode&>(*slot.child), keyHash, entry, shift + BitsPerLevel);
+        release(slot.child);
+        slot.child = child;
+        copy->size += child->size - before;
+    } else if (slot.leaf.key == entry.key) {
+        slot.leaf.value->release();
+        slot.leaf.value = entry.value;
+    } else {
+        // The copy's reference to the old leaf moves into the new subtrie
+        slot.child = pair(slot.leaf, entry, shift + BitsPerLevel);
+        slot.leaf = Entry{};
+        ++copy->size;
+    }
+    return copy;
+}
+
+// Copies the path to key without it. Null if the subtrie ends up empty; the node
+// itself, with a new reference, if key is not there.
+MapNode* remove(TrieNode& node, std::uint64_t keyHash, std::uint64_t key, unsigned shift) {
+    unsigned bit = digit(keyHash, shift);
+    if (!(node.bitmap & (1u << bit))) {
+        add_ref(&node);
+        return &node;
+    }
+
+    unsigned index = position(node.bitmap, bit);
+    const Slot& slot = node.slots()[index];
+    MapNode* child = nullptr;
+    if (slot.child) {
+        child = remove(static_cast<TrieNode&>(*slot.child), keyHash, key, shift + BitsPerLevel);
+        if (child == slot.child) {
+            release(child);
+            add_ref(&node);
+            return &node;
+        }
+    } else if (slot.leaf.key != key) {
+        add_ref(&node);
+        return &node;
+    }
+
+    if (node.size == 1) {
+        return nullptr;
+    }
+
+    auto* subtrie = static_cast<TrieNode*>(child);
+    if (!subtrie) {
+        TrieNode* copy = clone(node, node.bitmap & ~(1u << bit));
+        --copy->size;
+        return copy;
+    }
+
+    TrieNode* copy = clone(node, node.bitmap);
+    Slot& copied = copy->slots()[index];
+    --copy->size;
+    release(copied.child);
+    if (subtrie->size == 1 && !subtrie->slots()[0].child) {
+        // A lone entry moves up into its parent
+        copied.child = nullptr;
+        copied.leaf = subtrie->slots()[0].leaf;
+        copied.leaf.value->add_ref();
+        release(subtrie);
+    } else {
+        copied.child = subtrie;
+    }
+    return copy;
+}
+
+void collect(const MapNode& node, ArrayMap& into) {
+    auto& trie = static_cast<const TrieNode&>(node);
+    for (const Slot* slot = trie.slots(); slot != trie.slots() + trie.count(); ++slot) {
+        if (slot->child) {
+            collect(*slot->child, into);
+        } else {
+            into.entries[into.size] = slot->leaf;
+            into.entries[into.size].value->add_ref();
+            ++into.size;
+        }
+    }
+}
+
+// Releases this thread's map when the thread exits
+struct CurrentAsyncLocalsGuard {
+    ~CurrentAsyncLocalsGuard() {
+        release(std::exchange(current_async_locals, nullptr));
+    }
+};
+
+} // namespace
+
+void destroy(AsyncLocalNode* node) noexcept {
+    auto* map = static_cast<MapNode*>(node);
+    if (map->trie) {
+        auto* trie = static_cast<TrieNode*>(map);
+        for (Slot* slot = trie->slots(); slot != trie->slots() + trie->count(); ++slot) {
+            if (slot->child) {
+                release(slot->child);
+            } else {
+                slot->leaf.value->release();
+            }
+        }
+        free_trie(trie);
+    } else {
+        auto* array = static_cast<ArrayMap*>(map);
+        for (std::uint32_t i = 0; i < array->size; ++i) {
+            array->entries[i].value->release();
+        }
+        delete array;
+    }
+}
+
+const AsyncLocalValue* find(const AsyncLocalNode* root, std::uint64_t key) noexcept {
+    if (!root) {
+        return nullptr;
+    }
+
+    auto* map = static_cast<const MapNode*>(root);
+    if (!map->trie) {
+        auto* array = static_cast<const ArrayMap*>(map);
+        for (std::uint32_t i = 0; i < array->size; ++i) {
+            if (array->entries[i].key == key) {
+                return array->entries[i].value;
+            }
+        }
+        return nullptr;
+    }
+
+    std::uint64_t key_hash = hash(key);
+    auto* node = static_cast<const TrieNode*>(map);
+    for (unsigned shift = 0;; shift += BitsPerLevel) {
+        unsigned bit = digit(key_hash, shift);
+        if (!(node->bitmap & (1u << bit))) {
+            return nullptr;
+        }
+        const Slot& slot = node->slots()[position(node->bitmap, bit)];
+        if (!slot.child) {
+            return slot.leaf.key == key ? slot.leaf.value : nullptr;
+        }
+        node = static_cast<const TrieNode*>(slot.child);
+    }
+}
+
+AsyncLocalNode* with(const AsyncLocalNode* root, std::uint64_t key, AsyncLocalValue* value) {
+    Entry entry{key, value};
+    if (!root) {
+        auto* array = new ArrayMap();
+        array->entries[0] = entry;
+        array->size = 1;
+        return array;
+    }
+
+    auto* map = static_cast<const MapNode*>(root);
+    if (map->trie) {
+        return insert(static_cast<const TrieNode&>(*map), hash(key), entry, 0);
+    }
+
+    auto* array = static_cast<const ArrayMap*>(map);
+    for (std::uint32_t i = 0; i < array->size; ++i) {
+        if (array->entries[i].key == key) {
+            ArrayMap* copy = clone(*array);
+            copy->entries[i].value->release();
+            copy->entries[i].value = value;
+            return copy;
+        }
+    }
+
+    if (array->size + 1 < TrieThreshold) {
+        ArrayMap* copy = clone(*array);
+        copy->entries[copy->size++] = entry;
+        return copy;
+    }
+
+    // Outgrown the array: rebuild as a trie
+    TrieNode* trie = allocate_trie(0);
+    for (std::uint32_t i = 0; i <= array->size; ++i) {
+        Entry next = i < array->size ? array->entries[i] : entry;
+        if (i < array->size) {
+            next.value->add_ref();
+        }
+        TrieNode* grown = insert(*trie, hash(next.key), next, 0);
+        release(trie);
+        trie = grown;
+    }
+    return trie;
+}
+
+AsyncLocalNode* without(const AsyncLocalNode* root, std::uint64_t key) {
+    if (!root) {
+        return nullptr;
+    }
+
+    auto* map = const_cast<MapNode*>(static_cast<const MapNode*>(root));
+    if (map->trie) {
+        MapNode* result = remove(static_cast<TrieNode&>(*map), hash(key), key, 0);
+        if (result && result != map && result->size < TrieThreshold) {
+            auto* array = new ArrayMap();
+            collect(*result, *array);
+            release(result);
+            return array;
+        }
+        return result;
+    }
+
+    auto* array = static_cast<ArrayMap*>(map);
+    for (std::uint32_t i = 0; i < array->size; ++i) {
+        if (array->entries[i].key == key) {
+            if (array->size == 1) {
+                return nullptr;
+            }
+            auto* copy = new ArrayMap();
+            for (std::uint32_t j = 0; j < array->size; ++j) {
+                if (j != i) {
+                    copy->entries[copy->size] = array->entries[j];
+                    copy->entries[copy->size].value->add_ref();
+                    ++copy->size;
+                }
+            }
+            return copy;
+        }
+    }
+
+    add_ref(map);
+    return map;
+}
+
+void set_current_async_locals(AsyncLocalNode* root) noexcept {
+    static thread_local CurrentAsyncLocalsGuard guard;
+    (void)guard;
+
+    release(std::exchange(current_async_locals, root));
+}
+
+std::uint64_t next_async_local_key() noexcept {
+    static std::atomic<std::uint64_t> next_key{1};
+    return next_key.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace detail
+} // namespace Threading
+} // namespace System
@@ -0,0 +1,272 @@
+// ManualResetEventSlim.cpp - lock-free set/wait fast paths for ManualResetEventSlim
+
+#include "System/Threading/ManualResetEventSlim.h"
+#include "System/Threading/ManualResetEvent.h"
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace System::Threading
+{
+    namespace
+    {
+        // Same limits and defaults as the .NET type
+        constexpr int MaxSpinCount = 2047;
+        constexpr int DefaultSpinCount = 35;
+
+        int DefaultSpinCountForMachine()
+        {
+            // Spinning cannot help on one processor: the setter needs it
+            return std::thread::hardware_concurrency() > 1 ? DefaultSpinCount : 1;
+        }
+    }
+
+    ManualResetEventSlim::ManualResetEventSlim()
+        : ManualResetEventSlim(false)
+    {
+    }
+
+    ManualResetEventSlim::ManualResetEventSlim(bool initialState)
+        : state(initialState ? SetFlag : 0), spinCount(DefaultSpinCountForMachine())
+    {
+    }
+
+    ManualResetEventSlim::ManualResetEventSlim(bool initialState, int spinCount)
+        : state(initialState ? SetFlag : 0), spinCount(spinCount)
+    {
+        if (spinCount < 0 || spinCount > MaxSpinCount)
+        {
+            throw std::out_of_range("spinCount must be between 0 and 2047");
+        }
+    }
+
+    void ManualResetEventSlim::Set()
+    {
+        // Everything that needs waking is recorded in the word this replaces;
+        // a waiter may return and destroy the event as soon as the flag is set
+        std::uint32_t previous = state.fetch_or(SetFlag);
+        if (previous & SetFlag)
+        {
+            return;
+        }
+
+        if (previous >= WaiterUnit)
+        {
+            state.notify_all();
+        }
+        if (previous & ConditionWaitersFlag)
+        {
+            ReleaseConditionWaiters();
+        }
+        if (previous & WaitHandleFlag)
+        {
+            SyncWaitHandle();
+        }
+    }
+
+    void ManualResetEventSlim::Reset()
+    {
+        std::uint32_t previous = state.fetch_and(~SetFlag);
+        if ((previous & SetFlag) && (previous & WaitHandleFlag))
+        {
+            SyncWaitHandle();
+        }
+    }
+
+    void ManualResetEventSlim::Wait()
+    {
+        if (SpinUntilSet(nullptr))
+        {
+            return;
+        }
+
+        // Registering is an RMW on the same word as Set, so either it sees the
+        // flag or Set sees the waiter
+        std::uint32_t observed = state.fetch_add(WaiterUnit) + WaiterUnit;
+        while (!(observed & SetFlag))
+        {
+            state.wait(observed);
+            observed = state.load();
+        }
+        state.fetch_sub(WaiterUnit);
+    }
+
+    bool ManualResetEventSlim::Wait(int millisecondsTimeout)
+    {
+        if (millisecondsTimeout < -1)
+        {
+            throw std::out_of_range("millisecondsTimeout must be -1 (Infinite) or greater");
+        }
+        if (millisecondsTimeout == -1)
+        {
+            Wait();
+            return true;
+        }
+        return WaitOnCondition(millisecondsTimeout, nullptr);
+    }
+
+    bool ManualResetEventSlim::Wait(const TimeSpan& timeout)
+    {
+        double milliseconds = timeout.TotalMilliseconds();
+        if (milliseconds < -1 || milliseconds > 2147483647.0)
+        {
+            throw std::out_of_range("timeout must be -1 milliseconds (Infinite) or a non-negative value up to Int32.MaxValue milliseconds");
+        }
+        return Wait(static_cast<int>(milliseconds));
+    }
+
+    bool ManualResetEventSlim::Wait(const CancellationToken& cancellationToken)
+    {
+        return Wait(-1, cancellationToken);
+    }
+
+    bool ManualResetEventSlim::Wait(int millisecondsTimeout, const CancellationToken& cancellationToken)
+    {
+        if (millisecondsTimeout < -1)
+        {
+            throw std::out_of_range("millisecondsTimeout must be -1 (Infinite) or greater");
+        }
+        cancellationToken.throw_if_cancellation_requested();
+        if (!cancellationToken.can_be_canceled())
+        {
+            return Wait(millisecondsTimeout);
+        }
+        return WaitOnCondition(millisecondsTimeout, &cancellationToken);
+    }
+
+    bool ManualResetEventSlim::GetIsSet() const
+    {
+        return (state.load() & SetFlag) != 0;
+    }
+
+    int ManualResetEventSlim::GetSpinCount() const
+    {
+        return spinCount;
+    }
+
+    WaitHandle* ManualResetEventSlim::GetWaitHandle()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!waitHandle)
+        {
+            waitHandle = std::make_unique<ManualResetEvent>(false);
+            // A Set or Reset racing with this either happened before the flag
+            // and shows up in the sync below, or syncs again once we unlock
+            state.fetch_or(WaitHandleFlag);
+            SyncWaitHandleLocked();
+        }
+        return waitHandle.get();
+    }
+
+    bool ManualResetEventSlim::SpinUntilSet(const CancellationToken* cancellationToken)
+    {
+        spinner.spin_until([this, cancellationToken]()
+        {
+            return GetIsSet() || (cancellationToken && cancellationToken->is_cancellation_requested());
+        }, spinCount);
+        return GetIsSet();
+    }
+
+    bool ManualResetEventSlim::WaitOnCondition(int millisecondsTimeout, const CancellationToken* cancellationToken)
+    {
+        if (GetIsSet())
+        {
+            return true;
+        }
+        if (millisecondsTimeout == 0)
+        {
+            return false;
+        }
+        if (SpinUntilSet(cancellationToken))
+        {
+            return true;
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(millisecondsTimeout);
+        auto done = [this, cancellationToken]()
+        {
+            return GetIsSet() || (cancellationToken && cancellationToken->is_cancellation_requested());
+        };
+
+        CancellationTokenRegistration registration;
+        if (cancellationToken)
+        {
+            registration = cancellationToken->register_callback([this]()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                condition.notify_all();
+            });
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            // Only while unset, so the Set that ends the wait is sure to see it
+            std::uint32_t observed = state.load();
+            while (!(observed & (SetFlag | ConditionWaitersFlag)))
+            {
+                if (state.compare_exchange_weak(observed, observed | ConditionWaitersFlag))
+                {
+                    break;
+                }
+            }
+
+            if (millisecondsTimeout == -1)
+            {
+                condition.wait(lock, done);
+            }
+            else
+            {
+                condition.wait_until(lock, deadline, done);
+            }
+
+            // A Set that saw the flag still has to pass through the mutex; wait
+            // it out so that returning cannot race the event's destruction
+            condition.wait(lock, [this]()
+            {
+                std::uint32_t current = state.load();
+                return !(current & SetFlag) || !(current & ConditionWaitersFlag);
+            });
+        }
+
+        // Outside the mutex: the callback takes it, and Dispose waits for a
+        // callback that is running
+        registration.dispose();
+
+        if (GetIsSet())
+        {
+            return true;
+        }
+        if (cancellationToken)
+        {
+            cancellationToken->throw_if_cancellation_requested();
+        }
+        return false;
+    }
+
+    void ManualResetEventSlim::ReleaseConditionWaiters()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        state.fetch_and(~ConditionWaitersFlag);
+        condition.notify_all();
+    }
+
+    void ManualResetEventSlim::SyncWaitHandle()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        SyncWaitHandleLocked();
+    }
+
+    void ManualResetEventSlim::SyncWaitHandleLocked()
+    {
+        auto* handle = static_cast<ManualResetEvent*>(waitHandle.get());
+        if (GetIsSet())
+        {
+            handle->Set();
+        }
+        else
+        {
+            handle->Reset();
+        }
+    }
+}
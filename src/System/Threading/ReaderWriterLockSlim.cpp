@@ -1,13 +1,56 @@
-
 // ReaderWriterLockSlim.cpp - Implementation file for ReaderWriterLockSlim class
 
-#include "../../include/System/Threading/ReaderWriterLockSlim.hpp"
+#include "System/Threading/ReaderWriterLockSlim.hpp"
+#include <vector>
 
 namespace System {
 namespace Threading {
 
-// Thread-local storage definitions are in the header
-// Any additional non-inline implementations would go here
+// Thread-local storage for recursion tracking
+thread_local int ReaderWriterLockSlim::reader_recursion_count_ = 0;
+thread_local int ReaderWriterLockSlim::writer_recursion_count_ = 0;
+thread_local int ReaderWriterLockSlim::upgradeable_recursion_count_ = 0;
+
+namespace detail {
+
+VisibleReaderSlot visible_readers[visible_reader_slot_count];
+
+namespace {
+
+std::mutex slot_mutex;
+std::vector<int> free_slots;
+int next_slot = 0;
+
+// Claims a slot for the thread's lifetime and hands it back on thread exit
+struct SlotOwner {
+    int index = -1;
+
+    SlotOwner() {
+        std::lock_guard<std::mutex> lock(slot_mutex);
+        if (!free_slots.empty()) {
+            index = free_slots.back();
+            free_slots.pop_back();
+        } else if (next_slot < visible_reader_slot_count) {
+            index = next_slot++;
+        }
+    }
+
+    ~SlotOwner() {
+        if (index >= 0) {
+            std::lock_guard<std::mutex> lock(slot_mutex);
+            free_slots.push_back(index);
+        }
+    }
+};
+
+} // namespace
+
+int visible_reader_index() {
+    thread_local SlotOwner owner;
+    return owner.index;
+}
+
+} // namespace detail
 
 } // namespace Threading
 } // namespace System
@@ -0,0 +1,258 @@
+// SingleThreadSynchronizationContext.cpp - Run loop over a lock-free posting queue
+
+#include "System/Threading/SingleThreadSynchronizationContext.h"
+#include "System/Threading/Task.hpp"
+#include <stdexcept>
+#include <utility>
+
+namespace System {
+namespace Threading {
+
+SingleThreadSynchronizationContext::SingleThreadSynchronizationContext()
+    : m_head(&m_stub), m_tail(&m_stub) {}
+
+SingleThreadSynchronizationContext::~SingleThreadSynchronizationContext() {
+    // Whatever was never run is dropped
+    while (WorkItem* item = DequeueLocal()) {
+        delete item;
+    }
+    while (WorkItem* item = Dequeue()) {
+        delete item;
+    }
+    while (m_freeItems) {
+        delete std::exchange(m_freeItems, m_freeItems->next.load(std::memory_order_relaxed));
+    }
+}
+
+void SingleThreadSynchronizationContext::Post(std::function<void(void*)> callback, void* state) {
+    if (IsOwnerThread()) {
+        // The loop is running us, so it is awake and will see this before it stops
+        WorkItem* item = AllocateLocal();
+        item->callback = std::move(callback);
+        item->state = state;
+        if (m_localTail) {
+            m_localTail->next.store(item, std::memory_order_relaxed);
+        } else {
+            m_localHead = item;
+        }
+        m_localTail = item;
+        return;
+    }
+
+    WorkItem* item = new WorkItem();
+    item->callback = std::move(callback);
+    item->state = state;
+    Push(item);
+    WakeIfSleeping();
+}
+
+void SingleThreadSynchronizationContext::Send(std::function<void(void*)> callback, void* state) {
+    if (IsOwnerThread()) {
+        callback(state);
+        return;
+    }
+
+    std::atomic<bool> done{false};
+    std::exception_ptr error;
+    Post([&callback, &done, &error](void* sent) {
+        try {
+            callback(sent);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        done.store(true, std::memory_order_release);
+        done.notify_one();
+    }, state);
+    done.wait(false, std::memory_order_acquire);
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+std::shared_ptr<SynchronizationContext> SingleThreadSynchronizationContext::CreateCopy() {
+    return shared_from_this();
+}
+
+void SingleThreadSynchronizationContext::Run() {
+    RunLoop([this]() {
+        return m_completed.load(std::memory_order_acquire) && IsEmpty();
+    });
+}
+
+void SingleThreadSynchronizationContext::RunUntil(const Task& task) {
+    Task watched = task;
+    if (!watched.is_completed()) {
+        // Completion on another thread has to wake the loop; an empty item does that
+        auto self = shared_from_this();
+        watched.continue_with([self](Task&) {
+            self->Push(new WorkItem());
+            self->WakeIfSleeping();
+        }, TaskContinuationOptions::ExecuteSynchronously);
+    }
+    RunLoop([&watched]() {
+        return watched.is_completed();
+    });
+}
+
+void SingleThreadSynchronizationContext::Complete() {
+    m_completed.store(true, std::memory_order_release);
+    Push(new WorkItem());
+    WakeIfSleeping();
+}
+
+bool SingleThreadSynchronizationContext::IsOwnerThread() const {
+    return m_ownerThread.load(std::memory_order_relaxed) == std::this_thread::get_id();
+}
+
+template<typename TDone>
+void SingleThreadSynchronizationContext::RunLoop(TDone done) {
+    std::thread::id idle;
+    if (!m_ownerThread.compare_exchange_strong(idle, std::this_thread::get_id())) {
+        throw std::logic_error("SingleThreadSynchronizationContext is already running");
+    }
+
+    struct Installed {
+        SingleThreadSynchronizationContext* context;
+        std::shared_ptr<SynchronizationContext> previous;
+
+        ~Installed() {
+            SynchronizationContext::SetSynchronizationContext(std::move(previous));
+            // Hands the owner-thread list to whichever thread runs the loop next
+            context->m_ownerThread.store(std::thread::id(), std::memory_order_release);
+        }
+    } installed{this, SynchronizationContext::Current()};
+    SynchronizationContext::SetSynchronizationContext(shared_from_this());
+
+    auto invoke = [this](WorkItem* item) {
+        struct Recycled {
+            SingleThreadSynchronizationContext* context;
+            WorkItem* item;
+
+            ~Recycled() {
+                context->Recycle(item);
+            }
+        } recycled{this, item};
+        if (item->callback) {
+            item->callback(item->state);
+        }
+    };
+
+    for (;;) {
+        // A batch is everything queued when it starts, run before done is looked at
+        // again; what the batch posts waits for the next one, so neither a callback
+        // reposting itself nor a busy producer can keep the loop from stopping
+        WorkItem* localLast = m_localTail;
+        WorkItem* remoteLast = m_head.load(std::memory_order_acquire);
+        while (localLast) {
+            WorkItem* item = DequeueLocal();
+            bool last = item == localLast;
+            invoke(item);
+            if (last) {
+                break;
+            }
+        }
+        while (WorkItem* item = Dequeue()) {
+            bool last = item == remoteLast;
+            invoke(item);
+            if (last) {
+                break;
+            }
+        }
+        if (done()) {
+            return;
+        }
+
+        // Pairs with WakeIfSleeping: either a producer's push is visible to
+        // IsEmpty here, or the producer sees m_sleeping and wakes us
+        m_sleeping.store(true, std::memory_order_seq_cst);
+        if (!IsEmpty() || done()) {
+            m_sleeping.store(false, std::memory_order_relaxed);
+            continue;
+        }
+        m_sleeping.wait(true, std::memory_order_seq_cst);
+    }
+}
+
+void SingleThreadSynchronizationContext::Push(WorkItem* item) {
+    item->next.store(nullptr, std::memory_order_relaxed);
+    WorkItem* previous = m_head.exchange(item, std::memory_order_seq_cst);
+    previous->next.store(item, std::memory_order_release);
+}
+
+// Only the loop's thread dequeues. A producer that has exchanged m_head but not
+// yet linked its item leaves a gap; Dequeue returns nothing until the link lands.
+SingleThreadSynchronizationContext::WorkItem* SingleThreadSynchronizationContext::Dequeue() {
+    WorkItem* tail = m_tail;
+    WorkItem* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &m_stub) {
+        if (!next) {
+            return nullptr;
+        }
+        m_tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+        m_tail = next;
+        return tail;
+    }
+    if (tail != m_head.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    // tail is the last item; put the stub behind it so it can be handed out
+    Push(&m_stub);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        m_tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+SingleThreadSynchronizationContext::WorkItem* SingleThreadSynchronizationContext::DequeueLocal() {
+    WorkItem* item = m_localHead;
+    if (item) {
+        m_localHead = item->next.load(std::memory_order_relaxed);
+        if (!m_localHead) {
+            m_localTail = nullptr;
+        }
+    }
+    return item;
+}
+
+SingleThreadSynchronizationContext::WorkItem* SingleThreadSynchronizationContext::AllocateLocal() {
+    WorkItem* item = m_freeItems;
+    if (!item) {
+        return new WorkItem();
+    }
+    m_freeItems = item->next.load(std::memory_order_relaxed);
+    --m_freeCount;
+    item->next.store(nullptr, std::memory_order_relaxed);
+    return item;
+}
+
+void SingleThreadSynchronizationContext::Recycle(WorkItem* item) {
+    if (m_freeCount == MaxFreeItems) {
+        delete item;
+        return;
+    }
+    item->callback = nullptr;
+    item->next.store(m_freeItems, std::memory_order_relaxed);
+    m_freeItems = item;
+    ++m_freeCount;
+}
+
+bool SingleThreadSynchronizationContext::IsEmpty() const {
+    return !m_localHead && m_tail == &m_stub && m_head.load(std::memory_order_seq_cst) == &m_stub;
+}
+
+void SingleThreadSynchronizationContext::WakeIfSleeping() {
+    if (m_sleeping.load(std::memory_order_seq_cst) &&
+        m_sleeping.exchange(false, std::memory_order_seq_cst)) {
+        m_sleeping.notify_one();
+    }
+}
+
+} // namespace Threading
+} // namespace System
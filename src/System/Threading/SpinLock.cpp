@@ -0,0 +1,271 @@
+// SpinLock.cpp - MCS queue lock behind the System::Threading::SpinLock API
+
+#include "System/Threading/SpinLock.h"
+#include "CompilerCompat.hpp"
+#include <chrono>
+#include <stdexcept>
+
+namespace System::Threading
+{
+    namespace
+    {
+        // Waiters pause this many times before also yielding the processor
+        constexpr long long SpinsBeforeYield = 64;
+
+        void Backoff(long long spins)
+        {
+            if (spins < SpinsBeforeYield)
+            {
+                CORELIB_CPU_PAUSE();
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    struct alignas(64) SpinLock::Node
+    {
+        std::atomic<Node*> next{nullptr};
+        std::atomic<bool> locked{false};
+        Node* nextFree = nullptr;
+    };
+
+    // A thread holds at most one node per lock it holds, so the list stays short
+    struct SpinLock::NodeCache
+    {
+        Node* free = nullptr;
+
+        ~NodeCache()
+        {
+            while (free)
+            {
+                Node* next = free->nextFree;
+                delete free;
+                free = next;
+            }
+        }
+
+        Node* Acquire()
+        {
+            Node* node = free;
+            if (node)
+            {
+                free = node->nextFree;
+            }
+            else
+            {
+                node = new Node();
+            }
+            node->next.store(nullptr, std::memory_order_relaxed);
+            node->locked.store(true, std::memory_order_relaxed);
+            return node;
+        }
+
+        void Release(Node* node)
+        {
+            node->nextFree = free;
+            free = node;
+        }
+    };
+
+    SpinLock::NodeCache& SpinLock::CurrentNodeCache()
+    {
+        thread_local NodeCache cache;
+        return cache;
+    }
+
+    SpinLock::SpinLock(bool enableThreadOwnerTracking, bool enableStatistics)
+        : isThreadOwnerTrackingEnabled(enableThreadOwnerTracking), isStatisticsEnabled(enableStatistics)
+    {
+    }
+
+    void SpinLock::Enter(bool& lockTaken)
+    {
+        ValidateEnter(lockTaken);
+
+        Node* node = CurrentNodeCache().Acquire();
+        Node* predecessor = tail.exchange(node, std::memory_order_acq_rel);
+        long long spins = 0;
+        if (predecessor)
+        {
+            predecessor->next.store(node, std::memory_order_release);
+            while (node->locked.load(std::memory_order_acquire))
+            {
+                Backoff(spins++);
+            }
+        }
+
+        OnAcquired(node, predecessor != nullptr, spins);
+        lockTaken = true;
+    }
+
+    bool SpinLock::TryEnter(bool& lockTaken)
+    {
+        return TryEnter(0, lockTaken);
+    }
+
+    bool SpinLock::TryEnter(int millisecondsTimeout, bool& lockTaken)
+    {
+        if (millisecondsTimeout < -1)
+        {
+            throw std::out_of_range("millisecondsTimeout must be -1 (Infinite) or greater");
+        }
+        if (millisecondsTimeout == -1)
+        {
+            Enter(lockTaken);
+            return true;
+        }
+        ValidateEnter(lockTaken);
+
+        NodeCache& cache = CurrentNodeCache();
+        Node* node = cache.Acquire();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(millisecondsTimeout);
+        long long spins = 0;
+        for (;;)
+        {
+            Node* expected = nullptr;
+            if (tail.load(std::memory_order_relaxed) == nullptr &&
+                tail.compare_exchange_strong(expected, node, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                OnAcquired(node, spins > 0, spins);
+                lockTaken = true;
+                return true;
+            }
+            if (millisecondsTimeout == 0 || std::chrono::steady_clock::now() >= deadline)
+            {
+                cache.Release(node);
+                return false;
+            }
+            Backoff(spins++);
+        }
+    }
+
+    bool SpinLock::TryEnter(const TimeSpan& timeout, bool& lockTaken)
+    {
+        double milliseconds = timeout.TotalMilliseconds();
+        if (milliseconds < -1 || milliseconds > 2147483647.0)
+        {
+            throw std::out_of_range("timeout must be -1 milliseconds (Infinite) or a non-negative value up to Int32.MaxValue milliseconds");
+        }
+        return TryEnter(static_cast<int>(milliseconds), lockTaken);
+    }
+
+    void SpinLock::Exit()
+    {
+        if (isThreadOwnerTrackingEnabled && !GetIsHeldByCurrentThread())
+        {
+            throw std::logic_error("The calling thread does not hold the lock");
+        }
+
+        Node* node = ownerNode;
+        if (!node)
+        {
+            throw std::logic_error("The calling thread does not hold the lock");
+        }
+        ownerNode = nullptr;
+        if (isThreadOwnerTrackingEnabled)
+        {
+            ownerThread.store(std::thread::id{}, std::memory_order_relaxed);
+        }
+
+        Node* successor = node->next.load(std::memory_order_acquire);
+        if (!successor)
+        {
+            Node* expected = node;
+            if (tail.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed))
+            {
+                CurrentNodeCache().Release(node);
+                return;
+            }
+            // A waiter has swapped the tail but not yet linked itself behind us
+            long long spins = 0;
+            while (!(successor = node->next.load(std::memory_order_acquire)))
+            {
+                Backoff(spins++);
+            }
+        }
+
+        successor->locked.store(false, std::memory_order_release);
+        CurrentNodeCache().Release(node);
+    }
+
+    void SpinLock::Exit(bool useMemoryBarrier)
+    {
+        // The hand-off is a release store either way, so there is no cheaper variant
+        (void)useMemoryBarrier;
+        Exit();
+    }
+
+    bool SpinLock::GetIsHeld() const
+    {
+        return tail.load(std::memory_order_relaxed) != nullptr;
+    }
+
+    bool SpinLock::GetIsHeldByCurrentThread() const
+    {
+        if (!isThreadOwnerTrackingEnabled)
+        {
+            throw std::logic_error("Thread ownership tracking is disabled");
+        }
+        return ownerThread.load(std::memory_order_relaxed) == std::this_thread::get_id();
+    }
+
+    bool SpinLock::GetIsThreadOwnerTrackingEnabled() const
+    {
+        return isThreadOwnerTrackingEnabled;
+    }
+
+    bool SpinLock::GetIsStatisticsEnabled() const
+    {
+        return isStatisticsEnabled;
+    }
+
+    SpinLockStatistics SpinLock::GetStatistics() const
+    {
+        SpinLockStatistics statistics;
+        statistics.Acquisitions = acquisitions.load(std::memory_order_relaxed);
+        statistics.ContendedAcquisitions = contendedAcquisitions.load(std::memory_order_relaxed);
+        statistics.SpinIterations = spinIterations.load(std::memory_order_relaxed);
+        return statistics;
+    }
+
+    void SpinLock::ResetStatistics()
+    {
+        acquisitions.store(0, std::memory_order_relaxed);
+        contendedAcquisitions.store(0, std::memory_order_relaxed);
+        spinIterations.store(0, std::memory_order_relaxed);
+    }
+
+    void SpinLock::ValidateEnter(bool lockTaken) const
+    {
+        if (lockTaken)
+        {
+            throw std::invalid_argument("lockTaken must be false on entry");
+        }
+        if (isThreadOwnerTrackingEnabled && GetIsHeldByCurrentThread())
+        {
+            throw std::logic_error("The calling thread already holds the lock");
+        }
+    }
+
+    void SpinLock::OnAcquired(Node* node, bool contended, long long spins)
+    {
+        ownerNode = node;
+        if (isThreadOwnerTrackingEnabled)
+        {
+            ownerThread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        }
+        if (isStatisticsEnabled)
+        {
+            // Only the owner writes, so load-then-store cannot lose an update
+            acquisitions.store(acquisitions.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (contended)
+            {
+                contendedAcquisitions.store(contendedAcquisitions.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+            spinIterations.store(spinIterations.load(std::memory_order_relaxed) + spins, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,66 @@
+// SynchronizationContext.cpp - Default (free-threaded) synchronization context
+
+#include "System/Threading/SynchronizationContext.h"
+#include "System/Threading/ThreadPool.h"
+#include <stdexcept>
+
+namespace System {
+namespace Threading {
+
+thread_local std::shared_ptr<SynchronizationContext> SynchronizationContext::s_current;
+
+SynchronizationContext::SynchronizationContext() = default;
+
+SynchronizationContext::~SynchronizationContext() = default;
+
+// The default context has no thread affinity: posted work goes to the ThreadPool
+void SynchronizationContext::Post(std::function<void(void*)> callback, void* state) {
+    ThreadPool::QueueUserWorkItem([callback = std::move(callback), state](System::Object*) {
+        callback(state);
+    });
+}
+
+void SynchronizationContext::Send(std::function<void(void*)> callback, void* state) {
+    callback(state);
+}
+
+std::shared_ptr<SynchronizationContext> SynchronizationContext::CreateCopy() {
+    return std::make_shared<SynchronizationContext>();
+}
+
+void SynchronizationContext::OperationStarted() {
+    m_operationCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SynchronizationContext::OperationCompleted() {
+    m_operationCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+std::shared_ptr<SynchronizationContext> SynchronizationContext::Current() {
+    return s_current;
+}
+
+void SynchronizationContext::SetSynchronizationContext(std::shared_ptr<SynchronizationContext> context) {
+    s_current = std::move(context);
+}
+
+bool SynchronizationContext::IsWaitNotificationRequired() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_waitNotificationRequired;
+}
+
+void SynchronizationContext::Wait(const std::vector<std::shared_ptr<void>>& waitHandles, bool waitAll, int millisecondsTimeout) {
+    // The handles are type-erased; only derived contexts that know them can wait
+    (void)waitHandles;
+    (void)waitAll;
+    (void)millisecondsTimeout;
+    throw std::logic_error("SynchronizationContext::Wait is not supported by the default context");
+}
+
+void SynchronizationContext::SetWaitNotificationRequired() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_waitNotificationRequired = true;
+}
+
+} // namespace Threading
+} // namespace System
@@ -1,7 +1,7 @@
 
 // Task.cpp - Implementation file for Task classes
 
-#include "../../include/System/Threading/Task.hpp"
+#include "System/Threading/Task.hpp"
 
 namespace System {
 namespace Threading {
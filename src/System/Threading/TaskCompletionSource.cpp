@@ -1,7 +1,7 @@
 
 // TaskCompletionSource.cpp - Implementation file for TaskCompletionSource<T>
 
-#include "../../include/System/Threading/TaskCompletionSource.hpp"
+#include "System/Threading/TaskCompletionSource.hpp"
 
 namespace System {
 namespace Threading {
@@ -0,0 +1,89 @@
+// TaskScheduler.cpp - Default ThreadPool-backed scheduler for Task
+
+#include "System/Threading/TaskScheduler.hpp"
+#include "System/Threading/ThreadPool.h"
+#include <atomic>
+#include <climits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace System {
+namespace Threading {
+
+namespace {
+
+ThreadPoolTaskScheduler& thread_pool_scheduler() {
+    static ThreadPoolTaskScheduler instance;
+    return instance;
+}
+
+std::atomic<TaskScheduler*> g_default_scheduler{nullptr};
+std::mutex g_default_scheduler_mutex;
+// Replaced schedulers stay alive: tasks already queued may still reference them
+std::vector<std::shared_ptr<TaskScheduler>> g_installed_schedulers;
+
+thread_local TaskScheduler* t_current_scheduler = nullptr;
+
+} // namespace
+
+int TaskScheduler::get_maximum_concurrency_level() const {
+    return INT_MAX;
+}
+
+TaskScheduler& TaskScheduler::get_default() {
+    TaskScheduler* scheduler = g_default_scheduler.load(std::memory_order_acquire);
+    return scheduler ? *scheduler : thread_pool_scheduler();
+}
+
+TaskScheduler& TaskScheduler::get_current() {
+    return t_current_scheduler ? *t_current_scheduler : get_default();
+}
+
+void TaskScheduler::set_default(std::shared_ptr<TaskScheduler> scheduler) {
+    std::lock_guard<std::mutex> lock(g_default_scheduler_mutex);
+    g_default_scheduler.store(scheduler.get(), std::memory_order_release);
+    if (scheduler) {
+        g_installed_schedulers.push_back(std::move(scheduler));
+    }
+}
+
+void TaskScheduler::execute_task(const std::function<void()>& work) {
+    TaskScheduler* previous = t_current_scheduler;
+    t_current_scheduler = this;
+    try {
+        work();
+    } catch (...) {
+        t_current_scheduler = previous;
+        throw;
+    }
+    t_current_scheduler = previous;
+}
+
+void ThreadPoolTaskScheduler::queue_task(std::function<void()> work, TaskCreationOptions options) {
+    if ((options & TaskCreationOptions::LongRunning) != TaskCreationOptions::None) {
+        // Long-running work gets a dedicated thread instead of pinning a pool worker
+        std::thread([this, work = std::move(work)]() {
+            execute_task(work);
+        }).detach();
+        return;
+    }
+
+    // PreferFairness skips the worker-local LIFO deque so the item is served in
+    // submission order with everything else on the global queue.
+    bool prefer_local = (options & TaskCreationOptions::PreferFairness) == TaskCreationOptions::None;
+
+    ThreadPool::QueueUserWorkItem([this, work = std::move(work)](System::Object*) {
+        execute_task(work);
+    }, nullptr, prefer_local);
+}
+
+int ThreadPoolTaskScheduler::get_maximum_concurrency_level() const {
+    int worker_threads = 0;
+    int completion_port_threads = 0;
+    ThreadPool::GetMaxThreads(worker_threads, completion_port_threads);
+    return worker_threads;
+}
+
+} // namespace Threading
+} // namespace System
@@ -0,0 +1,135 @@
+// Parallel.cpp - Non-template parts of System::Threading::Tasks::Parallel
+
+#include "System/Threading/Tasks/Parallel.h"
+#include <stdexcept>
+
+namespace System::Threading::Tasks
+{
+    ParallelLoopResult::ParallelLoopResult(bool isCompleted, long lowestBreakIteration)
+        : IsCompleted(isCompleted), LowestBreakIteration(lowestBreakIteration)
+    {
+    }
+
+    ParallelLoopState::ParallelLoopState(Control& loopControl)
+        : control(&loopControl)
+    {
+    }
+
+    void ParallelLoopState::Stop()
+    {
+        if (control->lowestBreakIteration.load() != LONG_MAX)
+        {
+            throw std::logic_error("Stop cannot be called after Break");
+        }
+        control->isStopped.store(true);
+    }
+
+    void ParallelLoopState::Break()
+    {
+        if (control->isStopped.load())
+        {
+            throw std::logic_error("Break cannot be called after Stop");
+        }
+        long lowest = control->lowestBreakIteration.load();
+        while (currentIteration < lowest &&
+               !control->lowestBreakIteration.compare_exchange_weak(lowest, currentIteration))
+        {
+        }
+    }
+
+    bool ParallelLoopState::GetIsStopped() const
+    {
+        return control->isStopped.load();
+    }
+
+    bool ParallelLoopState::GetIsExceptional() const
+    {
+        return control->isExceptional.load();
+    }
+
+    long ParallelLoopState::GetLowestBreakIteration() const
+    {
+        return control->lowestBreakIteration.load();
+    }
+
+    bool ParallelLoopState::GetShouldExitCurrentIteration() const
+    {
+        return control->isStopped.load() || control->isExceptional.load() ||
+               control->lowestBreakIteration.load() < currentIteration;
+    }
+
+    ParallelOptions::ParallelOptions()
+        : maxDegreeOfParallelism(-1), taskScheduler(nullptr), preferredNode(-1)
+    {
+    }
+
+    CancellationToken ParallelOptions::GetCancellationToken() const
+    {
+        return cancellationToken;
+    }
+
+    void ParallelOptions::SetCancellationToken(const CancellationToken& value)
+    {
+        cancellationToken = value;
+    }
+
+    int ParallelOptions::GetMaxDegreeOfParallelism() const
+    {
+        return maxDegreeOfParallelism;
+    }
+
+    void ParallelOptions::SetMaxDegreeOfParallelism(int value)
+    {
+        if (value == 0 || value < -1)
+        {
+            throw std::out_of_range("MaxDegreeOfParallelism must be -1 (unlimited) or positive");
+        }
+        maxDegreeOfParallelism = value;
+    }
+
+    TaskScheduler* ParallelOptions::GetTaskScheduler() const
+    {
+        return taskScheduler;
+    }
+
+    void ParallelOptions::SetTaskScheduler(TaskScheduler* value)
+    {
+        taskScheduler = value;
+    }
+
+    int ParallelOptions::GetPreferredNode() const
+    {
+        return preferredNode;
+    }
+
+    void ParallelOptions::SetPreferredNode(int value)
+    {
+        if (value < -1)
+        {
+            throw std::out_of_range("PreferredNode must be -1 (any) or a node index");
+        }
+        preferredNode = value;
+    }
+
+    void Parallel::Invoke(const std::vector<std::function<void()>>& actions)
+    {
+        Invoke(ParallelOptions(), actions);
+    }
+
+    void Parallel::Invoke(const ParallelOptions& parallelOptions, const std::vector<std::function<void()>>& actions)
+    {
+        For(0, static_cast<int>(actions.size()), parallelOptions, [&actions](int i) {
+            actions[static_cast<std::size_t>(i)]();
+        });
+    }
+
+    int Parallel::DefaultDegreeOfParallelism(int node)
+    {
+        const CpuTopology& topology = CpuTopology::GetCurrent();
+        if (node >= 0 && node < topology.GetNodeCount())
+        {
+            return static_cast<int>(topology.GetNode(node).cpus.size());
+        }
+        return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+}
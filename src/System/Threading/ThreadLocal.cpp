@@ -1,14 +1,149 @@
+// ThreadLocal.cpp - Slot registry and per-thread tables behind ThreadLocal<T>
 
-// ThreadLocal.cpp - Implementation file for ThreadLocal<T>
-// Most functionality is implemented in the header due to template nature
-
-#include "../../include/System/Threading/ThreadLocal.hpp"
+#include "System/Threading/ThreadLocal.hpp"
+#include <algorithm>
+#include <mutex>
+#include <vector>
 
 namespace System {
 namespace Threading {
+namespace detail {
+
+thread_local constinit ThreadLocalNode** thread_local_nodes = nullptr;
+thread_local constinit std::size_t thread_local_capacity = 0;
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::size_t next_index = 0;
+    std::vector<std::size_t> free_indices;
+};
+
+// Never destroyed: ThreadLocals with static storage may outlive any other static
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+void unlink(ThreadLocalNode*& head, ThreadLocalNode* node) {
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        head = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    }
+    node->prev = nullptr;
+    node->next = nullptr;
+}
+
+} // namespace
+
+// Hands this thread's values back when the thread exits. The data lives in the
+// constant-initialized thread_local_nodes; this object only hooks thread exit.
+class ThreadLocalTable {
+public:
+    void attach() {}
+
+    ~ThreadLocalTable() {
+        std::vector<ThreadLocalNode*> released;
+        {
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            for (std::size_t i = 0; i < thread_local_capacity; ++i) {
+                ThreadLocalNode* node = thread_local_nodes[i];
+                if (!node) {
+                    continue;
+                }
+                if (node->owner->track_all_values_) {
+                    // Kept for values(); the instance destroys it
+                    node->thread_nodes = nullptr;
+                } else {
+                    unlink(node->owner->head_, node);
+                    released.push_back(node);
+                }
+            }
+            delete[] thread_local_nodes;
+            thread_local_nodes = nullptr;
+            thread_local_capacity = 0;
+        }
+        // Destructors may touch other ThreadLocals, so run them unlocked
+        for (ThreadLocalNode* node : released) {
+            delete node;
+        }
+    }
+};
+
+namespace {
+
+thread_local ThreadLocalTable thread_table;
+
+} // namespace
+
+ThreadLocalSlot::ThreadLocalSlot(bool trackAllValues)
+    : track_all_values_(trackAllValues) {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    if (shared.free_indices.empty()) {
+        index_ = shared.next_index++;
+    } else {
+        index_ = shared.free_indices.back();
+        shared.free_indices.pop_back();
+    }
+}
+
+ThreadLocalSlot::~ThreadLocalSlot() {
+    std::vector<ThreadLocalNode*> released;
+    {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (ThreadLocalNode* node = head_; node; node = node->next) {
+            // Clear the entry before the index can be handed out again
+            if (node->thread_nodes) {
+                (*node->thread_nodes)[index_] = nullptr;
+            }
+            released.push_back(node);
+        }
+        head_ = nullptr;
+        shared.free_indices.push_back(index_);
+    }
+    for (ThreadLocalNode* node : released) {
+        delete node;
+    }
+}
+
+void ThreadLocalSlot::install(ThreadLocalNode* node) {
+    thread_table.attach();
+
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    // Grown under the lock: other threads clear entries of this table through it
+    if (index_ >= thread_local_capacity) {
+        std::size_t capacity = std::max<std::size_t>({index_ + 1, thread_local_capacity * 2, 8});
+        ThreadLocalNode** nodes = new ThreadLocalNode*[capacity]();
+        std::copy(thread_local_nodes, thread_local_nodes + thread_local_capacity, nodes);
+        delete[] thread_local_nodes;
+        thread_local_nodes = nodes;
+        thread_local_capacity = capacity;
+    }
+
+    node->owner = this;
+    node->thread_nodes = &thread_local_nodes;
+    node->next = head_;
+    if (head_) {
+        head_->prev = node;
+    }
+    head_ = node;
+    thread_local_nodes[index_] = node;
+}
 
-// Any non-template specific implementations would go here
-// Currently, ThreadLocal<T> is fully implemented in the header
+void ThreadLocalSlot::for_each(const std::function<void(ThreadLocalNode&)>& visit) const {
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    for (ThreadLocalNode* node = head_; node; node = node->next) {
+        visit(*node);
+    }
+}
 
+} // namespace detail
 } // namespace Threading
 } // namespace System
@@ -0,0 +1,627 @@
+// ThreadPool.cpp - Work-stealing implementation of System::Threading::ThreadPool
+
+#include "System/Threading/ThreadPool.h"
+#include <algorithm>
+
+namespace System::Threading
+{
+    namespace
+    {
+        // How many extra FindWork passes an idle worker makes before parking.
+        constexpr int SpinAttemptsBeforePark = 16;
+
+        // Minimum interval between starvation-driven thread injections.
+        constexpr std::int64_t ThreadInjectionIntervalMs = 500;
+
+        std::int64_t NowMilliseconds()
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        int ProcessorCount()
+        {
+            return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        }
+
+        std::uint32_t NextRandom(std::uint32_t& state)
+        {
+            // xorshift32
+            std::uint32_t x = state;
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            state = x;
+            return x;
+        }
+    }
+
+    // Definition order matters: workerThreads is declared last so it is destroyed
+    // first, stopping and joining every worker before the queues they use go away.
+    std::unique_ptr<ThreadPool::WorkerSlot> ThreadPool::workerSlots[ThreadPool::MaxWorkerSlots];
+    std::atomic<int> ThreadPool::workerCount{0};
+    std::mutex ThreadPool::growMutex;
+
+    ThreadPool::InjectionQueue ThreadPool::globalInjection;
+
+    std::unique_ptr<ThreadPool::NodeGroup[]> ThreadPool::nodeGroups;
+    int ThreadPool::nodeCount = 0;
+    std::vector<int> ThreadPool::allCpus;
+    std::atomic<int> ThreadPool::workerAffinity{static_cast<int>(ThreadPool::WorkerAffinity::Node)};
+    std::atomic<std::uint32_t> ThreadPool::affinityGeneration{0};
+    std::atomic<std::uint32_t> ThreadPool::nextWakeNode{0};
+
+    std::atomic<int> ThreadPool::sleepingThreads{0};
+    std::atomic<std::uint64_t> ThreadPool::workEpoch{0};
+
+    std::atomic<int> ThreadPool::maxWorkerThreads{0};
+    std::atomic<int> ThreadPool::minWorkerThreads{0};
+    std::atomic<int> ThreadPool::maxCompletionPortThreads{0};
+    std::atomic<int> ThreadPool::minCompletionPortThreads{0};
+    std::atomic<int> ThreadPool::activeThreads{0};
+    std::atomic<std::int64_t> ThreadPool::lastThreadInjectionTicks{0};
+
+    thread_local ThreadPool::WorkerSlot* ThreadPool::currentWorker = nullptr;
+    std::once_flag ThreadPool::initFlag;
+
+    ThreadPool::WorkerThreads ThreadPool::workerThreads;
+
+    ThreadPool::WorkerThreads::~WorkerThreads()
+    {
+        if (starvationMonitor.joinable())
+        {
+            starvationMonitor.request_stop();
+            starvationMonitor.join();
+        }
+
+        // A worker still running an item may try to add another; once closed it cannot
+        std::vector<std::jthread> stopping;
+        {
+            std::lock_guard<std::mutex> lock(growMutex);
+            closed = true;
+            stopping.swap(threads);
+        }
+        for (auto& thread : stopping)
+        {
+            thread.request_stop();
+        }
+        stopping.clear();
+
+        // Every worker is joined, so nothing will run what is still queued; free it.
+        // Deleting a callback may release state that queues more, so take it out first
+        std::vector<std::unique_ptr<WorkItem>> abandoned;
+        auto drain = [&abandoned](InjectionQueue& queue)
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            for (WorkItem* item : queue.items)
+            {
+                abandoned.emplace_back(item);
+            }
+            queue.items.clear();
+            queue.count.store(0, std::memory_order_relaxed);
+        };
+        drain(globalInjection);
+        for (int node = 0; node < nodeCount; ++node)
+        {
+            drain(nodeGroups[node].injection);
+        }
+        for (int i = 0; i < workerCount.load(); ++i)
+        {
+            WorkItem* item;
+            while (workerSlots[i] && workerSlots[i]->localQueue.TryPop(item))
+            {
+                abandoned.emplace_back(item);
+            }
+        }
+    }
+
+    bool ThreadPool::QueueUserWorkItem(WaitCallback callback)
+    {
+        return QueueUserWorkItem(std::move(callback), nullptr);
+    }
+
+    bool ThreadPool::QueueUserWorkItem(WaitCallback callback, System::Object* state)
+    {
+        return QueueUserWorkItem(std::move(callback), state, true);
+    }
+
+    bool ThreadPool::QueueUserWorkItem(WaitCallback callback, System::Object* state, bool preferLocal)
+    {
+        if (!callback)
+        {
+            return false;
+        }
+
+        std::call_once(initFlag, Initialize);
+
+        auto* item = new WorkItem{std::move(callback), state};
+
+        if (WorkerSlot* local = preferLocal ? currentWorker : nullptr)
+        {
+            local->localQueue.Push(item);
+            SignalWork(local->node);
+        }
+        else
+        {
+            Inject(globalInjection, item);
+            SignalWork(-1);
+        }
+
+        InjectThreadIfStarved();
+        return true;
+    }
+
+    bool ThreadPool::QueueUserWorkItemOnNode(WaitCallback callback, System::Object* state, int node)
+    {
+        if (!callback)
+        {
+            return false;
+        }
+
+        std::call_once(initFlag, Initialize);
+
+        if (node < 0 || node >= nodeCount)
+        {
+            return false;
+        }
+
+        auto* item = new WorkItem{std::move(callback), state};
+
+        // Already on the node: keep it on this worker's deque, where it is warmest
+        WorkerSlot* local = currentWorker;
+        if (local != nullptr && local->node == node)
+        {
+            local->localQueue.Push(item);
+        }
+        else
+        {
+            Inject(nodeGroups[node].injection, item);
+        }
+
+        SignalWork(node);
+        InjectThreadIfStarved();
+        return true;
+    }
+
+    int ThreadPool::GetNodeCount()
+    {
+        std::call_once(initFlag, Initialize);
+        return nodeCount;
+    }
+
+    int ThreadPool::GetCurrentNode()
+    {
+        if (currentWorker != nullptr)
+        {
+            return currentWorker->node;
+        }
+        return CpuTopology::GetCurrent().GetCurrentNode();
+    }
+
+    void ThreadPool::SetWorkerAffinity(WorkerAffinity affinity)
+    {
+        workerAffinity.store(static_cast<int>(affinity), std::memory_order_relaxed);
+        affinityGeneration.fetch_add(1, std::memory_order_release);
+    }
+
+    ThreadPool::WorkerAffinity ThreadPool::GetWorkerAffinity()
+    {
+        return static_cast<WorkerAffinity>(workerAffinity.load(std::memory_order_relaxed));
+    }
+
+    void ThreadPool::GetMaxThreads(int& workerThreads, int& completionPortThreads)
+    {
+        std::call_once(initFlag, Initialize);
+        workerThreads = maxWorkerThreads.load();
+        completionPortThreads = maxCompletionPortThreads.load();
+    }
+
+    void ThreadPool::GetMinThreads(int& workerThreads, int& completionPortThreads)
+    {
+        std::call_once(initFlag, Initialize);
+        workerThreads = minWorkerThreads.load();
+        completionPortThreads = minCompletionPortThreads.load();
+    }
+
+    bool ThreadPool::SetMaxThreads(int workerThreads, int completionPortThreads)
+    {
+        std::call_once(initFlag, Initialize);
+
+        if (workerThreads < ProcessorCount() || workerThreads > MaxWorkerSlots ||
+            workerThreads < minWorkerThreads.load() ||
+            completionPortThreads < minCompletionPortThreads.load())
+        {
+            return false;
+        }
+
+        maxWorkerThreads.store(workerThreads);
+        maxCompletionPortThreads.store(completionPortThreads);
+        return true;
+    }
+
+    bool ThreadPool::SetMinThreads(int workerThreads, int completionPortThreads)
+    {
+        std::call_once(initFlag, Initialize);
+
+        if (workerThreads < 0 || completionPortThreads < 0 ||
+            workerThreads > maxWorkerThreads.load() ||
+            completionPortThreads > maxCompletionPortThreads.load())
+        {
+            return false;
+        }
+
+        minWorkerThreads.store(workerThreads);
+        minCompletionPortThreads.store(completionPortThreads);
+        EnsureMinimumThreads();
+        return true;
+    }
+
+    void ThreadPool::GetAvailableThreads(int& workerThreads, int& completionPortThreads)
+    {
+        std::call_once(initFlag, Initialize);
+        workerThreads = maxWorkerThreads.load() - activeThreads.load();
+        completionPortThreads = maxCompletionPortThreads.load();
+    }
+
+    int ThreadPool::GetThreadCount()
+    {
+        return workerCount.load(std::memory_order_acquire);
+    }
+
+    long long ThreadPool::GetPendingWorkItemCount()
+    {
+        long long pending = globalInjection.count.load(std::memory_order_relaxed);
+        for (int node = 0; node < nodeCount; ++node)
+        {
+            pending += nodeGroups[node].injection.count.load(std::memory_order_relaxed);
+        }
+        int count = workerCount.load(std::memory_order_acquire);
+        for (int i = 0; i < count; ++i)
+        {
+            pending += workerSlots[i]->localQueue.GetCount();
+        }
+        return pending;
+    }
+
+    bool ThreadPool::GetIsThreadPoolThread()
+    {
+        return currentWorker != nullptr;
+    }
+
+    void ThreadPool::WorkerThreadProc(std::stop_token stopToken, WorkerSlot* slot)
+    {
+        currentWorker = slot;
+
+        while (!stopToken.stop_requested())
+        {
+            if (slot->affinityGeneration != affinityGeneration.load(std::memory_order_acquire))
+            {
+                ApplyAffinity(slot);
+            }
+
+            if (WorkItem* item = FindWork(slot, false))
+            {
+                Execute(item);
+                continue;
+            }
+
+            // Read the epoch before the last look around so that any item published
+            // after this point is guaranteed to change it and keep us from parking.
+            std::uint64_t observedEpoch = workEpoch.load(std::memory_order_seq_cst);
+
+            // Other nodes are left alone for the first half of the spin, which gives
+            // the workers woken for their work time to take it themselves
+            WorkItem* item = nullptr;
+            for (int spin = 0; spin < SpinAttemptsBeforePark && item == nullptr; ++spin)
+            {
+                std::this_thread::yield();
+                item = FindWork(slot, spin >= SpinAttemptsBeforePark / 2);
+            }
+
+            if (item != nullptr)
+            {
+                Execute(item);
+                continue;
+            }
+
+            Park(slot, stopToken, observedEpoch);
+        }
+
+        currentWorker = nullptr;
+    }
+
+    void ThreadPool::Park(WorkerSlot* slot, std::stop_token& stopToken, std::uint64_t observedEpoch)
+    {
+        NodeGroup& group = nodeGroups[slot->node];
+        std::unique_lock<std::mutex> lock(group.parkMutex);
+        group.sleepingThreads.fetch_add(1, std::memory_order_seq_cst);
+        sleepingThreads.fetch_add(1, std::memory_order_seq_cst);
+        group.parkCondition.wait(lock, stopToken, [observedEpoch]() {
+            return workEpoch.load(std::memory_order_seq_cst) != observedEpoch;
+        });
+        sleepingThreads.fetch_sub(1, std::memory_order_seq_cst);
+        group.sleepingThreads.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    // Nearest work first: this worker's deque, its node's queue, the global queue and
+    // its node's other workers, and only then, if remote, other nodes' queues and workers.
+    ThreadPool::WorkItem* ThreadPool::FindWork(WorkerSlot* slot, bool remote)
+    {
+        WorkItem* item = nullptr;
+        if (slot->localQueue.TryPop(item))
+        {
+            return item;
+        }
+
+        if ((item = TryDequeueInjected(nodeGroups[slot->node].injection)) != nullptr ||
+            (item = TryDequeueInjected(globalInjection)) != nullptr ||
+            (item = TryStealFromNode(slot, slot->node)) != nullptr)
+        {
+            return item;
+        }
+
+        if (!remote || nodeCount == 1)
+        {
+            return nullptr;
+        }
+
+        for (int i = 1; i < nodeCount; ++i)
+        {
+            int node = (slot->node + i) % nodeCount;
+            if ((item = TryDequeueInjected(nodeGroups[node].injection)) != nullptr)
+            {
+                return item;
+            }
+        }
+
+        return TryStealRemote(slot);
+    }
+
+    ThreadPool::WorkItem* ThreadPool::TryDequeueInjected(InjectionQueue& queue)
+    {
+        if (queue.count.load(std::memory_order_relaxed) == 0)
+        {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.items.empty())
+        {
+            return nullptr;
+        }
+
+        WorkItem* item = queue.items.front();
+        queue.items.pop_front();
+        queue.count.fetch_sub(1, std::memory_order_relaxed);
+        return item;
+    }
+
+    ThreadPool::WorkItem* ThreadPool::TryStealFromNode(WorkerSlot* slot, int node)
+    {
+        NodeGroup& group = nodeGroups[node];
+        int count = group.memberCount.load(std::memory_order_acquire);
+        if (count == 0 || (count == 1 && node == slot->node))
+        {
+            return nullptr;
+        }
+
+        int start = static_cast<int>(NextRandom(slot->randomState) % static_cast<std::uint32_t>(count));
+        for (int i = 0; i < count; ++i)
+        {
+            int victim = group.members[(start + i) % count];
+            if (victim == slot->index)
+            {
+                continue;
+            }
+
+            WorkItem* item = nullptr;
+            if (workerSlots[victim]->localQueue.TrySteal(item))
+            {
+                return item;
+            }
+        }
+
+        return nullptr;
+    }
+
+    ThreadPool::WorkItem* ThreadPool::TryStealRemote(WorkerSlot* slot)
+    {
+        for (int i = 1; i < nodeCount; ++i)
+        {
+            if (WorkItem* item = TryStealFromNode(slot, (slot->node + i) % nodeCount))
+            {
+                return item;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void ThreadPool::Inject(InjectionQueue& queue, WorkItem* item)
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.items.push_back(item);
+        queue.count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void ThreadPool::ApplyAffinity(WorkerSlot* slot)
+    {
+        // Read the generation first: a change racing with this one is applied next time
+        slot->affinityGeneration = affinityGeneration.load(std::memory_order_acquire);
+        const std::vector<int>& nodeCpus = nodeGroups[slot->node].cpus;
+        switch (GetWorkerAffinity())
+        {
+        case WorkerAffinity::None:
+            CpuTopology::SetCurrentThreadAffinity(allCpus);
+            break;
+        case WorkerAffinity::Node:
+            CpuTopology::SetCurrentThreadAffinity(nodeCpus);
+            break;
+        case WorkerAffinity::Core:
+            CpuTopology::SetCurrentThreadAffinity({nodeCpus[static_cast<std::size_t>(slot->nodeRank) % nodeCpus.size()]});
+            break;
+        }
+    }
+
+    void ThreadPool::Execute(WorkItem* item)
+    {
+        std::unique_ptr<WorkItem> owned(item);
+        activeThreads.fetch_add(1, std::memory_order_relaxed);
+        try
+        {
+            owned->callback(owned->state);
+        }
+        catch (...)
+        {
+            // Work item exceptions must not take down the worker
+        }
+        activeThreads.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void ThreadPool::SignalWork(int node)
+    {
+        workEpoch.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepingThreads.load(std::memory_order_seq_cst) == 0)
+        {
+            return;
+        }
+
+        // Wake a worker on the node the work is for; work for anywhere rotates over nodes
+        int first = node >= 0 ? node : static_cast<int>(nextWakeNode.fetch_add(1, std::memory_order_relaxed) % static_cast<std::uint32_t>(nodeCount));
+        for (int i = 0; i < nodeCount; ++i)
+        {
+            NodeGroup& group = nodeGroups[(first + i) % nodeCount];
+            if (group.sleepingThreads.load(std::memory_order_seq_cst) > 0)
+            {
+                std::lock_guard<std::mutex> lock(group.parkMutex);
+                group.parkCondition.notify_one();
+                return;
+            }
+        }
+    }
+
+    bool ThreadPool::TryAddWorker()
+    {
+        std::lock_guard<std::mutex> lock(growMutex);
+
+        int count = workerCount.load(std::memory_order_relaxed);
+        if (workerThreads.closed || count >= maxWorkerThreads.load() || count >= MaxWorkerSlots)
+        {
+            return false;
+        }
+
+        workerSlots[count] = std::make_unique<WorkerSlot>();
+        WorkerSlot* slot = workerSlots[count].get();
+        slot->index = count;
+        slot->randomState = 0x9E3779B9u ^ static_cast<std::uint32_t>(count * 0x85EBCA6Bu + 1);
+        slot->node = PickNodeForNewWorker();
+        // Never equal to the current generation, so the worker applies its affinity first
+        slot->affinityGeneration = affinityGeneration.load(std::memory_order_relaxed) - 1;
+
+        NodeGroup& group = nodeGroups[slot->node];
+        slot->nodeRank = group.memberCount.load(std::memory_order_relaxed);
+        group.members[slot->nodeRank] = count;
+
+        workerThreads.threads.emplace_back(WorkerThreadProc, slot);
+        group.memberCount.store(slot->nodeRank + 1, std::memory_order_release);
+        workerCount.store(count + 1, std::memory_order_release);
+        return true;
+    }
+
+    // The node with the fewest workers for its CPUs, so groups grow in proportion
+    int ThreadPool::PickNodeForNewWorker()
+    {
+        int best = 0;
+        for (int node = 1; node < nodeCount; ++node)
+        {
+            long long members = nodeGroups[node].memberCount.load(std::memory_order_relaxed);
+            long long bestMembers = nodeGroups[best].memberCount.load(std::memory_order_relaxed);
+            if (members * static_cast<long long>(nodeGroups[best].cpus.size()) <
+                bestMembers * static_cast<long long>(nodeGroups[node].cpus.size()))
+            {
+                best = node;
+            }
+        }
+        return best;
+    }
+
+    void ThreadPool::InjectThreadIfStarved()
+    {
+        // Only grow past the minimum when every worker is busy running an item; a
+        // blocked pool would otherwise never drain. Injection is rate limited so a
+        // burst of long-running items cannot spawn threads without bound.
+        if (sleepingThreads.load(std::memory_order_relaxed) > 0)
+        {
+            return;
+        }
+
+        int count = workerCount.load(std::memory_order_relaxed);
+        if (count >= maxWorkerThreads.load(std::memory_order_relaxed) ||
+            activeThreads.load(std::memory_order_relaxed) < count)
+        {
+            return;
+        }
+
+        std::int64_t now = NowMilliseconds();
+        std::int64_t last = lastThreadInjectionTicks.load(std::memory_order_relaxed);
+        if (now - last < ThreadInjectionIntervalMs ||
+            !lastThreadInjectionTicks.compare_exchange_strong(last, now))
+        {
+            return;
+        }
+
+        TryAddWorker();
+    }
+
+    // Enqueue-time checks alone miss a pool whose workers all block on items they
+    // queued themselves: nothing is queued after that, so nothing would look again.
+    void ThreadPool::MonitorStarvation(std::stop_token stopToken)
+    {
+        std::mutex mutex;
+        std::condition_variable_any tick;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopToken.stop_requested())
+        {
+            tick.wait_for(lock, stopToken, std::chrono::milliseconds(ThreadInjectionIntervalMs), []() { return false; });
+            if (!stopToken.stop_requested() && GetPendingWorkItemCount() > 0)
+            {
+                InjectThreadIfStarved();
+            }
+        }
+    }
+
+    void ThreadPool::EnsureMinimumThreads()
+    {
+        while (workerCount.load(std::memory_order_acquire) < minWorkerThreads.load())
+        {
+            if (!TryAddWorker())
+            {
+                break;
+            }
+        }
+    }
+
+    void ThreadPool::Initialize()
+    {
+        const CpuTopology& topology = CpuTopology::GetCurrent();
+        nodeCount = topology.GetNodeCount();
+        nodeGroups = std::make_unique<NodeGroup[]>(static_cast<std::size_t>(nodeCount));
+        for (int node = 0; node < nodeCount; ++node)
+        {
+            nodeGroups[node].cpus = topology.GetNode(node).cpus;
+            nodeGroups[node].members = std::make_unique<int[]>(MaxWorkerSlots);
+            allCpus.insert(allCpus.end(), nodeGroups[node].cpus.begin(), nodeGroups[node].cpus.end());
+        }
+
+        int processors = ProcessorCount();
+        minWorkerThreads.store(processors);
+        maxWorkerThreads.store(MaxWorkerSlots);
+        minCompletionPortThreads.store(processors);
+        maxCompletionPortThreads.store(1000);
+        lastThreadInjectionTicks.store(NowMilliseconds());
+
+        workerThreads.threads.reserve(static_cast<std::size_t>(processors));
+        EnsureMinimumThreads();
+        workerThreads.starvationMonitor = std::jthread(MonitorStarvation);
+    }
+}
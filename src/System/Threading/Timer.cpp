@@ -0,0 +1,99 @@
+// Timer.cpp - System::Threading::Timer on top of the shared TimerWheel
+
+#include "System/Threading/Timer.h"
+#include <stdexcept>
+
+namespace System::Threading
+{
+    namespace
+    {
+        void ValidateTimes(long dueTime, long period)
+        {
+            if (dueTime < Timer::Infinite)
+            {
+                throw std::out_of_range("dueTime must be -1 (Infinite) or greater");
+            }
+            if (period < Timer::Infinite)
+            {
+                throw std::out_of_range("period must be -1 (Infinite) or greater");
+            }
+        }
+    }
+
+    Timer::Timer(TimerCallback callback, System::Object* state, int dueTime, int period)
+        : Timer(std::move(callback), state, static_cast<long>(dueTime), static_cast<long>(period))
+    {
+    }
+
+    Timer::Timer(TimerCallback callback, System::Object* state, const TimeSpan& dueTime, const TimeSpan& period)
+        : Timer(std::move(callback), state, ToMilliseconds(dueTime), ToMilliseconds(period))
+    {
+    }
+
+    Timer::Timer(TimerCallback callback, System::Object* state, long dueTime, long period)
+        : callback(std::move(callback)), state(state)
+    {
+        if (!this->callback)
+        {
+            throw std::invalid_argument("callback");
+        }
+        ValidateTimes(dueTime, period);
+
+        // The entry captures copies, never this: a callback already queued on the
+        // ThreadPool may run after the Timer itself is gone.
+        entry = TimerWheel::instance().schedule([cb = this->callback, state]() {
+            cb(state);
+        }, dueTime, period == Infinite ? 0 : period);
+    }
+
+    Timer::~Timer()
+    {
+        Dispose();
+    }
+
+    bool Timer::Change(int dueTime, int period)
+    {
+        return Change(static_cast<long>(dueTime), static_cast<long>(period));
+    }
+
+    bool Timer::Change(const TimeSpan& dueTime, const TimeSpan& period)
+    {
+        return Change(ToMilliseconds(dueTime), ToMilliseconds(period));
+    }
+
+    bool Timer::Change(long dueTime, long period)
+    {
+        ValidateTimes(dueTime, period);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (disposed.load())
+        {
+            return false;
+        }
+        return TimerWheel::instance().change(entry, dueTime, period == Infinite ? 0 : period);
+    }
+
+    void Timer::Dispose()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!disposed.exchange(true))
+        {
+            TimerWheel::instance().cancel(entry);
+        }
+    }
+
+    bool Timer::Dispose(WaitHandle* notifyObject)
+    {
+        // Callbacks already handed to the ThreadPool are not tracked, so there is
+        // nothing to signal notifyObject with; it is left untouched.
+        (void)notifyObject;
+        bool wasDisposed = disposed.load();
+        Dispose();
+        return !wasDisposed;
+    }
+
+    long Timer::ToMilliseconds(const TimeSpan& value)
+    {
+        return static_cast<long>(value.TotalMilliseconds());
+    }
+}
@@ -0,0 +1,267 @@
+// TimerWheel.cpp - Shared hierarchical timing wheel behind Task::delay, cancel_after and Timer
+
+#include "System/Threading/TimerWheel.hpp"
+#include "System/Threading/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+
+namespace System {
+namespace Threading {
+
+struct TimerWheel::Entry {
+    std::function<void()> callback;
+    std::uint64_t deadline = 0;
+    std::int64_t period = 0;
+    Entry* prev = nullptr;
+    Entry* next = nullptr;
+    Slot* slot = nullptr;
+    std::atomic<bool> canceled{false};
+    // Keeps the entry alive while it is linked into the wheel
+    Handle self;
+};
+
+TimerWheel& TimerWheel::instance() {
+    static TimerWheel wheel;
+    return wheel;
+}
+
+TimerWheel::TimerWheel()
+    : epoch_(std::chrono::steady_clock::now())
+    , thread_([this](std::stop_token stop_token) { run(stop_token); }) {}
+
+TimerWheel::~TimerWheel() {
+    thread_.request_stop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    // Break the self references of entries that never fired
+    auto release = [](Slot& slot) {
+        Entry* entry = slot.head;
+        slot.head = nullptr;
+        while (entry) {
+            Entry* next = entry->next;
+            entry->slot = nullptr;
+            entry->self.reset();
+            entry = next;
+        }
+    };
+    for (auto& level : wheel_) {
+        for (auto& slot : level) {
+            release(slot);
+        }
+    }
+    release(overflow_);
+}
+
+TimerWheel::Handle TimerWheel::schedule(std::function<void()> callback,
+                                        std::int64_t dueMilliseconds,
+                                        std::int64_t periodMilliseconds) {
+    auto handle = std::make_shared<Entry>();
+    handle->callback = std::move(callback);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    arm(handle, dueMilliseconds, periodMilliseconds);
+    return handle;
+}
+
+bool TimerWheel::change(const Handle& handle, std::int64_t dueMilliseconds, std::int64_t periodMilliseconds) {
+    if (!handle) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (handle->canceled.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    if (handle->slot) {
+        unlink(handle.get());
+    }
+    arm(handle, dueMilliseconds, periodMilliseconds);
+    return true;
+}
+
+bool TimerWheel::cancel(const Handle& handle) {
+    if (!handle) {
+        return false;
+    }
+
+    Handle self;
+    std::lock_guard<std::mutex> lock(mutex_);
+    handle->canceled.store(true, std::memory_order_relaxed);
+    if (!handle->slot) {
+        return false;
+    }
+    unlink(handle.get());
+    self = std::move(handle->self);
+    return true;
+}
+
+std::size_t TimerWheel::get_pending_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+std::uint64_t TimerWheel::now_tick() const {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - epoch_).count());
+}
+
+// Caller holds mutex_ and has unlinked the entry
+void TimerWheel::arm(const Handle& handle, std::int64_t dueMilliseconds, std::int64_t periodMilliseconds) {
+    handle->period = periodMilliseconds > 0 ? periodMilliseconds : 0;
+    if (dueMilliseconds < 0) {
+        // Disabled until the next change()
+        handle->self.reset();
+        return;
+    }
+
+    std::uint64_t now = now_tick();
+    if (count_ == 0) {
+        // Nothing to cascade: skip the ticks the idle timer thread did not process
+        current_tick_ = std::max(current_tick_, now);
+    }
+
+    // +1 because now is rounded down; the entry must never fire early
+    handle->deadline = now + static_cast<std::uint64_t>(dueMilliseconds) + 1;
+    handle->self = handle;
+    link(handle.get());
+
+    if (handle->deadline < wake_tick_) {
+        wake_requested_ = true;
+        wake_.notify_one();
+    }
+}
+
+void TimerWheel::link(Entry* entry) {
+    entry->deadline = std::max(entry->deadline, current_tick_);
+
+    // The level is the highest 6-bit digit in which deadline and current tick differ
+    std::uint64_t diff = entry->deadline ^ current_tick_;
+    int level = 0;
+    while (level < Levels && (diff >> (LevelBits * (level + 1))) != 0) {
+        ++level;
+    }
+
+    Slot* slot = level == Levels
+        ? &overflow_
+        : &wheel_[level][(entry->deadline >> (LevelBits * level)) & SlotMask];
+
+    entry->slot = slot;
+    entry->prev = nullptr;
+    entry->next = slot->head;
+    if (slot->head) {
+        slot->head->prev = entry;
+    }
+    slot->head = entry;
+    ++count_;
+}
+
+void TimerWheel::unlink(Entry* entry) {
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        entry->slot->head = entry->next;
+    }
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    }
+    entry->prev = nullptr;
+    entry->next = nullptr;
+    entry->slot = nullptr;
+    --count_;
+}
+
+// Re-files every entry of a higher-level slot relative to the current tick
+void TimerWheel::cascade(Slot& slot) {
+    Entry* entry = slot.head;
+    slot.head = nullptr;
+    while (entry) {
+        Entry* next = entry->next;
+        entry->slot = nullptr;
+        --count_;
+        link(entry);
+        entry = next;
+    }
+}
+
+void TimerWheel::advance(std::uint64_t tick, std::vector<Handle>& expired) {
+    for (int level = 1; level < Levels; ++level) {
+        if ((tick & ((std::uint64_t{1} << (LevelBits * level)) - 1)) != 0) {
+            break;
+        }
+        cascade(wheel_[level][(tick >> (LevelBits * level)) & SlotMask]);
+    }
+    if ((tick & ((std::uint64_t{1} << (LevelBits * Levels)) - 1)) == 0) {
+        cascade(overflow_);
+    }
+
+    // Everything left in this level 0 slot is due exactly now
+    Slot& slot = wheel_[0][tick & SlotMask];
+    while (Entry* entry = slot.head) {
+        unlink(entry);
+        if (entry->period > 0) {
+            entry->deadline = tick + static_cast<std::uint64_t>(entry->period);
+            link(entry);
+            expired.push_back(entry->self);
+        } else {
+            expired.push_back(std::move(entry->self));
+        }
+    }
+}
+
+std::uint64_t TimerWheel::next_event_tick() const {
+    // Either the next occupied level 0 slot or the end of this rotation, where the
+    // next cascade may bring entries down
+    std::uint64_t rotation_end = (current_tick_ | SlotMask) + 1;
+    for (std::uint64_t tick = current_tick_; tick < rotation_end; ++tick) {
+        if (wheel_[0][tick & SlotMask].head) {
+            return tick;
+        }
+    }
+    return rotation_end;
+}
+
+void TimerWheel::run(std::stop_token stop_token) {
+    std::vector<Handle> expired;
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stop_token.stop_requested()) {
+        std::uint64_t now = now_tick();
+        while (count_ > 0 && current_tick_ <= now) {
+            advance(current_tick_, expired);
+            ++current_tick_;
+        }
+
+        if (!expired.empty()) {
+            lock.unlock();
+            for (auto& entry : expired) {
+                dispatch(std::move(entry));
+            }
+            expired.clear();
+            lock.lock();
+            continue;
+        }
+
+        wake_requested_ = false;
+        if (count_ == 0) {
+            wake_tick_ = UINT64_MAX;
+            wake_.wait(lock, stop_token, [this]() { return wake_requested_; });
+        } else {
+            wake_tick_ = next_event_tick();
+            wake_.wait_until(lock, stop_token, epoch_ + std::chrono::milliseconds(wake_tick_),
+                             [this]() { return wake_requested_; });
+        }
+    }
+}
+
+void TimerWheel::dispatch(Handle entry) {
+    ThreadPool::QueueUserWorkItem([entry = std::move(entry)](System::Object*) {
+        if (!entry->canceled.load(std::memory_order_relaxed)) {
+            entry->callback();
+        }
+    }, nullptr, false);
+}
+
+} // namespace Threading
+} // namespace System
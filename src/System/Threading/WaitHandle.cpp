@@ -0,0 +1,267 @@
+// WaitHandle.cpp - In-process WaitHandle, EventWaitHandle and the two event types
+
+#include "System/Threading/WaitHandle.h"
+#include "System/Threading/EventWaitHandle.h"
+#include "System/Threading/ManualResetEvent.h"
+#include "System/Threading/AutoResetEvent.h"
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace System::Threading
+{
+    namespace
+    {
+        void ValidateTimeout(int millisecondsTimeout)
+        {
+            if (millisecondsTimeout < -1)
+            {
+                throw std::out_of_range("millisecondsTimeout must be -1 (Infinite) or greater");
+            }
+        }
+
+        int ToMilliseconds(const TimeSpan& timeout)
+        {
+            double milliseconds = timeout.TotalMilliseconds();
+            if (milliseconds < -1 || milliseconds > 2147483647.0)
+            {
+                throw std::out_of_range("timeout must be -1 milliseconds (Infinite) or a non-negative value up to Int32.MaxValue milliseconds");
+            }
+            return static_cast<int>(milliseconds);
+        }
+
+        void ValidateHandles(const std::vector<WaitHandle*>& waitHandles)
+        {
+            if (waitHandles.empty())
+            {
+                throw std::invalid_argument("waitHandles must not be empty");
+            }
+            for (WaitHandle* handle : waitHandles)
+            {
+                if (!handle)
+                {
+                    throw std::invalid_argument("waitHandles must not contain null");
+                }
+            }
+        }
+
+        // Handles share no wait queue, so a wait on several of them polls: it
+        // yields at first and then sleeps a millisecond between rounds
+        template<typename Ready>
+        bool PollUntil(int millisecondsTimeout, Ready ready)
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(millisecondsTimeout);
+            for (int round = 0;; ++round)
+            {
+                if (ready())
+                {
+                    return true;
+                }
+                if (millisecondsTimeout != -1 && std::chrono::steady_clock::now() >= deadline)
+                {
+                    return false;
+                }
+                if (round < 16)
+                {
+                    std::this_thread::yield();
+                }
+                else
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+        }
+    }
+
+    WaitHandle::WaitHandle()
+        : signaled(false)
+    {
+    }
+
+    WaitHandle::~WaitHandle() = default;
+
+    bool WaitHandle::WaitOne()
+    {
+        return WaitOne(-1);
+    }
+
+    bool WaitHandle::WaitOne(int millisecondsTimeout)
+    {
+        ValidateTimeout(millisecondsTimeout);
+        std::unique_lock<std::mutex> lock(mutex);
+        auto isSignaled = [this]() { return signaled.load(); };
+        if (millisecondsTimeout == -1)
+        {
+            condition.wait(lock, isSignaled);
+            return true;
+        }
+        return condition.wait_for(lock, std::chrono::milliseconds(millisecondsTimeout), isSignaled);
+    }
+
+    bool WaitHandle::WaitOne(const TimeSpan& timeout)
+    {
+        return WaitOne(ToMilliseconds(timeout));
+    }
+
+    // There is no operating system handle behind it, so nothing to release
+    void WaitHandle::Close()
+    {
+    }
+
+    void WaitHandle::SetSignaled(bool value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        signaled.store(value);
+        if (value)
+        {
+            condition.notify_all();
+        }
+    }
+
+    bool WaitHandle::WaitAll(const std::vector<WaitHandle*>& waitHandles)
+    {
+        return WaitAll(waitHandles, -1);
+    }
+
+    // Unlike the Win32 wait, handles are acquired one at a time rather than
+    // atomically: an auto-reset event stays consumed while the others are awaited
+    bool WaitHandle::WaitAll(const std::vector<WaitHandle*>& waitHandles, int millisecondsTimeout)
+    {
+        ValidateHandles(waitHandles);
+        ValidateTimeout(millisecondsTimeout);
+        std::vector<bool> acquired(waitHandles.size(), false);
+        return PollUntil(millisecondsTimeout, [&]()
+        {
+            bool all = true;
+            for (std::size_t i = 0; i < waitHandles.size(); ++i)
+            {
+                if (!acquired[i])
+                {
+                    acquired[i] = waitHandles[i]->WaitOne(0);
+                    all = all && acquired[i];
+                }
+            }
+            return all;
+        });
+    }
+
+    int WaitHandle::WaitAny(const std::vector<WaitHandle*>& waitHandles)
+    {
+        return WaitAny(waitHandles, -1);
+    }
+
+    // Returns the index of the handle that was signaled, or -1 on timeout
+    int WaitHandle::WaitAny(const std::vector<WaitHandle*>& waitHandles, int millisecondsTimeout)
+    {
+        ValidateHandles(waitHandles);
+        ValidateTimeout(millisecondsTimeout);
+        int index = -1;
+        PollUntil(millisecondsTimeout, [&]()
+        {
+            for (std::size_t i = 0; i < waitHandles.size(); ++i)
+            {
+                if (waitHandles[i]->WaitOne(0))
+                {
+                    index = static_cast<int>(i);
+                    return true;
+                }
+            }
+            return false;
+        });
+        return index;
+    }
+
+    EventWaitHandle::EventWaitHandle(bool initialState, EventResetMode mode)
+        : resetMode(mode), isSet(initialState)
+    {
+        signaled.store(initialState);
+    }
+
+    bool EventWaitHandle::Set()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isSet.store(true);
+        signaled.store(true);
+        // An auto-reset event lets one waiter through; that waiter resets it
+        if (resetMode == EventResetMode::AutoReset)
+        {
+            condition.notify_one();
+        }
+        else
+        {
+            condition.notify_all();
+        }
+        return true;
+    }
+
+    bool EventWaitHandle::Reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isSet.store(false);
+        signaled.store(false);
+        return true;
+    }
+
+    bool EventWaitHandle::WaitOne()
+    {
+        return WaitOne(-1);
+    }
+
+    bool EventWaitHandle::WaitOne(int millisecondsTimeout)
+    {
+        ValidateTimeout(millisecondsTimeout);
+        std::unique_lock<std::mutex> lock(mutex);
+        auto isSignaled = [this]() { return isSet.load(); };
+        if (millisecondsTimeout == -1)
+        {
+            condition.wait(lock, isSignaled);
+        }
+        else if (!condition.wait_for(lock, std::chrono::milliseconds(millisecondsTimeout), isSignaled))
+        {
+            return false;
+        }
+
+        if (resetMode == EventResetMode::AutoReset)
+        {
+            isSet.store(false);
+            signaled.store(false);
+        }
+        return true;
+    }
+
+    bool EventWaitHandle::WaitOne(const TimeSpan& timeout)
+    {
+        return WaitOne(ToMilliseconds(timeout));
+    }
+
+    ManualResetEvent::ManualResetEvent(bool initialState)
+        : EventWaitHandle(initialState, EventResetMode::ManualReset)
+    {
+    }
+
+    bool ManualResetEvent::Set()
+    {
+        return EventWaitHandle::Set();
+    }
+
+    bool ManualResetEvent::Reset()
+    {
+        return EventWaitHandle::Reset();
+    }
+
+    AutoResetEvent::AutoResetEvent(bool initialState)
+        : EventWaitHandle(initialState, EventResetMode::AutoReset)
+    {
+    }
+
+    bool AutoResetEvent::Set()
+    {
+        return EventWaitHandle::Set();
+    }
+
+    bool AutoResetEvent::Reset()
+    {
+        return EventWaitHandle::Reset();
+    }
+}
@@ -3,7 +3,12 @@
 #include <thread>
 #include <vector>
 #include <cassert>
+#include <memory>
+#include <string>
 #include "../include/System/Threading/AsyncLocal.hpp"
+#include "../include/System/Threading/ExecutionContext.hpp"
+#include "../include/System/Threading/Task.hpp"
+#include "../include/System/Threading/TaskCompletionSource.hpp"
 
 using namespace System::Threading;
 
@@ -28,7 +33,8 @@ void test_basic_functionality() {
 void test_thread_isolation() {
     AsyncLocal<int> async_local;
     std::vector<std::thread> threads;
-    std::vector<bool> results(5, false);
+    // Not vector<bool>: its elements share words, so writes from different threads race
+    std::vector<int> results(5, 0);
     
     for (int i = 0; i < 5; ++i) {
         threads.emplace_back([&async_local, &results, i]() {
@@ -37,7 +43,7 @@ void test_thread_isolation() {
             
             // Verify the value is correct for this thread
             if (async_local.get() == i * 10) {
-                results[i] = true;
+                results[i] = 1;
             }
         });
     }
@@ -47,8 +53,8 @@ void test_thread_isolation() {
     }
     
     // Verify all threads had their own values
-    for (bool result : results) {
-        assert(result);
+    for (int result : results) {
+        assert(result == 1);
     }
     
     std::cout << "Thread isolation test passed" << std::endl;
@@ -69,12 +75,201 @@ void test_value_factory() {
     std::cout << "Value factory test passed" << std::endl;
 }
 
+void test_flows_into_tasks() {
+    AsyncLocal<int> async_local;
+    async_local.set(7);
+    
+    auto task = Task::run([&async_local]() {
+        return async_local.get();
+    });
+    assert(task.get_result() == 7);
+    
+    auto continuation = task.continue_with<int>([&async_local](TaskOf<int>& antecedent) {
+        return antecedent.get_result() + async_local.get();
+    });
+    assert(continuation.get_result() == 14);
+    
+    // Captured when the task is created, not when it runs
+    TaskCompletionSource<int> gate;
+    auto delayed = gate.get_task().continue_with<int>([&async_local](TaskOf<int>&) {
+        return async_local.get();
+    });
+    async_local.set(8);
+    gate.set_result(0);
+    assert(delayed.get_result() == 7);
+    
+    async_local.clear();
+    std::cout << "Flows into tasks test passed" << std::endl;
+}
+
+void test_task_changes_stay_local() {
+    AsyncLocal<std::string> async_local;
+    async_local.set("parent");
+    
+    auto child = Task::run([&async_local]() {
+        async_local.set("child");
+        return async_local.get();
+    });
+    assert(child.get_result() == "child");
+    assert(async_local.get() == "parent");
+    
+    // The worker that ran the child is back in the default context
+    auto fresh = std::make_shared<bool>(false);
+    std::thread([&async_local, fresh]() {
+        *fresh = !async_local.has_value();
+    }).join();
+    assert(*fresh);
+    
+    async_local.clear();
+    std::cout << "Task changes stay local test passed" << std::endl;
+}
+
+TaskOf<int> read_after(TaskOf<int> antecedent, AsyncLocal<int>& async_local) {
+    co_await antecedent;
+    co_return async_local.get();
+}
+
+void test_flows_across_await() {
+    AsyncLocal<int> async_local;
+    async_local.set(1);
+    
+    TaskCompletionSource<int> gate;
+    auto reader = read_after(gate.get_task(), async_local);
+    async_local.set(2);
+    
+    // Completed on another thread in another context
+    std::thread([&gate, &async_local]() {
+        async_local.set(3);
+        gate.set_result(0);
+    }).join();
+    
+    assert(reader.get_result() == 1);
+    assert(async_local.get() == 2);
+    
+    async_local.clear();
+    std::cout << "Flows across await test passed" << std::endl;
+}
+
+TaskOf<int> set_between_awaits(AsyncLocal<int>& async_local, int rounds) {
+    // Set before the first suspension: the caller must not see it once we suspend
+    async_local.set(async_local.get() + 1);
+    for (int i = 0; i < rounds; ++i) {
+        int before = async_local.get();
+        co_await Task::run([&async_local]() {
+            // The pool task inherits the coroutine's value, and its own change stays there
+            int seen = async_local.get();
+            async_local.set(-1);
+            return seen;
+        });
+        assert(async_local.get() == before);
+        async_local.set(before + 1);
+    }
+    co_return async_local.get();
+}
+
+void test_coroutine_keeps_its_own_context() {
+    AsyncLocal<int> async_local;
+    async_local.set(100);
+    
+    // Each coroutine resumes on pool threads that last ran other coroutines' work
+    std::vector<TaskOf<int>> coroutines;
+    for (int i = 0; i < 16; ++i) {
+        coroutines.push_back(set_between_awaits(async_local, 20));
+        assert(async_local.get() == 100);
+    }
+    for (auto& coroutine : coroutines) {
+        assert(coroutine.get_result() == 121);
+    }
+    assert(async_local.get() == 100);
+    
+    async_local.clear();
+    std::cout << "Coroutine keeps its own context test passed" << std::endl;
+}
+
+void test_captured_contexts_are_immutable() {
+    AsyncLocal<int> first;
+    AsyncLocal<int> second;
+    first.set(1);
+    
+    ExecutionContext captured = ExecutionContext::capture();
+    assert(!captured.is_default());
+    
+    first.set(10);
+    second.set(20);
+    
+    ExecutionContext::run(captured, [&]() {
+        assert(first.get() == 1);
+        assert(!second.has_value());
+        second.set(2);
+    });
+    assert(first.get() == 10);
+    assert(second.get() == 20);
+    
+    first.clear();
+    second.clear();
+    assert(!first.has_value() && !second.has_value());
+    
+    std::cout << "Captured contexts are immutable test passed" << std::endl;
+}
+
+void test_many_async_locals() {
+    // Well past the flat array, so the map becomes a trie
+    const int count = 200;
+    std::vector<std::unique_ptr<AsyncLocal<int>>> locals;
+    for (int i = 0; i < count; ++i) {
+        locals.push_back(std::make_unique<AsyncLocal<int>>());
+        locals.back()->set(i);
+    }
+    ExecutionContext snapshot = ExecutionContext::capture();
+    
+    for (int i = 0; i < count; ++i) {
+        assert(locals[i]->get() == i);
+        locals[i]->set(i * 2);
+    }
+    for (int i = 0; i < count; i += 2) {
+        locals[i]->clear();
+    }
+    for (int i = 0; i < count; ++i) {
+        assert(locals[i]->has_value() == (i % 2 == 1));
+        if (i % 2 == 1) {
+            assert(locals[i]->get() == i * 2);
+        }
+    }
+    
+    ExecutionContext::run(snapshot, [&]() {
+        for (int i = 0; i < count; ++i) {
+            assert(locals[i]->get() == i);
+        }
+    });
+    
+    // Shrinking back below the trie threshold keeps the remaining values
+    for (int i = 1; i < count - 4; i += 2) {
+        locals[i]->clear();
+    }
+    for (int i = 0; i < count; ++i) {
+        bool kept = i >= count - 4 && i % 2 == 1;
+        assert(locals[i]->has_value() == kept);
+    }
+    for (auto& local : locals) {
+        local->clear();
+        assert(!local->has_value());
+    }
+    
+    std::cout << "Many AsyncLocals test passed" << std::endl;
+}
+
 int main() {
     std::cout << "Running AsyncLocal tests..." << std::endl;
     
     test_basic_functionality();
     test_thread_isolation();
     test_value_factory();
+    test_flows_into_tasks();
+    test_task_changes_stay_local();
+    test_flows_across_await();
+    test_coroutine_keeps_its_own_context();
+    test_captured_contexts_are_immutable();
+    test_many_async_locals();
     
     std::cout << "All AsyncLocal tests passed!" << std::endl;
     return 0;
@@ -4,6 +4,7 @@
 #include <vector>
 #include <cassert>
 #include <chrono>
+#include <atomic>
 #include "../include/System/Threading/Barrier.hpp"
 
 using namespace System::Threading;
@@ -12,8 +13,9 @@ void test_basic_functionality() {
     const int num_participants = 3;
     Barrier barrier(num_participants);
     std::vector<std::thread> threads;
-    std::vector<bool> phase1_completed(num_participants, false);
-    std::vector<bool> phase2_completed(num_participants, false);
+    // char rather than bool: vector<bool> packs elements that threads write concurrently
+    std::vector<char> phase1_completed(num_participants, false);
+    std::vector<char> phase2_completed(num_participants, false);
     
     for (int i = 0; i < num_participants; ++i) {
         threads.emplace_back([&barrier, &phase1_completed, &phase2_completed, i]() {
@@ -102,6 +104,135 @@ void test_timeout() {
     std::cout << "Timeout test passed" << std::endl;
 }
 
+void test_timeout_withdraws_arrival() {
+    Barrier barrier(2);
+    
+    // The timed-out arrival is taken back, so the phase still needs two signals
+    assert(!barrier.signal_and_wait(10));
+    assert(barrier.get_participants_remaining() == 2);
+    assert(barrier.get_current_phase_number() == 0);
+    
+    std::thread other([&barrier]() {
+        barrier.signal_and_wait();
+    });
+    assert(barrier.signal_and_wait(5000));
+    other.join();
+    assert(barrier.get_current_phase_number() == 1);
+    
+    std::cout << "Timeout withdraws arrival test passed" << std::endl;
+}
+
+void test_timed_waits_across_phases() {
+    // Released timed waiters come straight back for the next phase; they must find
+    // the count re-armed rather than the spent word of the phase they just left
+    constexpr int participants = 6;
+    constexpr int phases = 1000;
+    std::atomic<bool> all_completed(true);
+    Barrier barrier(participants);
+    
+    std::vector<std::thread> threads;
+    for (int i = 0; i < participants; ++i) {
+        threads.emplace_back([&]() {
+            for (int phase = 0; phase < phases; ++phase) {
+                if (!barrier.signal_and_wait(5000)) {
+                    all_completed = false;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    assert(all_completed.load());
+    assert(barrier.get_current_phase_number() == phases);
+    
+    std::cout << "Timed waits across phases test passed" << std::endl;
+}
+
+void run_phases(BarrierMode mode, int participants, int phases) {
+    std::atomic<int> arrived(0);
+    std::atomic<bool> consistent(true);
+    Barrier barrier(participants, [&](Barrier& b) {
+        // Every participant has arrived, and nobody has moved on yet
+        if (arrived.load() != participants * (b.get_current_phase_number() + 1)) {
+            consistent = false;
+        }
+    }, mode);
+    
+    std::vector<std::thread> threads;
+    for (int i = 0; i < participants; ++i) {
+        threads.emplace_back([&]() {
+            for (int phase = 0; phase < phases; ++phase) {
+                arrived.fetch_add(1);
+                barrier.signal_and_wait();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    assert(consistent.load());
+    assert(barrier.get_current_phase_number() == phases);
+}
+
+void test_flat_and_tree_modes() {
+    run_phases(BarrierMode::Flat, 6, 300);
+    run_phases(BarrierMode::Tree, 40, 100);
+    
+    Barrier tree(40, nullptr, BarrierMode::Tree);
+    assert(tree.get_mode() == BarrierMode::Tree);
+    
+    std::cout << "Flat and tree modes test passed" << std::endl;
+}
+
+void test_remove_participant_completes_phase() {
+    Barrier barrier(2);
+    std::thread waiter([&barrier]() {
+        barrier.signal_and_wait();
+    });
+    while (barrier.get_participants_remaining() != 1) {
+        std::this_thread::yield();
+    }
+    
+    // The only participant still to arrive leaves, so the phase completes
+    barrier.remove_participant();
+    waiter.join();
+    assert(barrier.get_current_phase_number() == 1);
+    assert(barrier.get_participant_count() == 1);
+    
+    std::cout << "Remove participant completes phase test passed" << std::endl;
+}
+
+void test_remove_participant_racing_phases() {
+    // Participants leave while the others keep finishing phases; the phase number
+    // must still count every phase exactly once
+    constexpr int phases = 200;
+    for (int round = 0; round < 20; ++round) {
+        Barrier barrier(4);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&barrier, t]() {
+                int own = t < 2 ? phases : phases / (t + 1);
+                for (int i = 0; i < own; ++i) {
+                    barrier.signal_and_wait();
+                }
+                if (t >= 2) {
+                    barrier.remove_participant();
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        assert(barrier.get_current_phase_number() == phases);
+        assert(barrier.get_participant_count() == 2);
+    }
+    
+    std::cout << "Remove participant racing phases test passed" << std::endl;
+}
+
 int main() {
     std::cout << "Running Barrier tests..." << std::endl;
     
@@ -109,6 +240,11 @@ int main() {
     test_post_phase_action();
     test_add_remove_participants();
     test_timeout();
+    test_timeout_withdraws_arrival();
+    test_timed_waits_across_phases();
+    test_flat_and_tree_modes();
+    test_remove_participant_completes_phase();
+    test_remove_participant_racing_phases();
     
     std::cout << "All Barrier tests passed!" << std::endl;
     return 0;
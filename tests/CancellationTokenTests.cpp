@@ -3,6 +3,8 @@
 #include <thread>
 #include <cassert>
 #include <chrono>
+#include <atomic>
+#include <vector>
 #include "../include/System/Threading/CancellationToken.hpp"
 
 using namespace System::Threading;
@@ -161,6 +163,412 @@ void test_callback_with_already_canceled_token() {
     std::cout << "Callback with already canceled token test passed" << std::endl;
 }
 
+void test_cancel_after() {
+    CancellationTokenSource source;
+    auto token = source.get_token();
+    
+    source.cancel_after(50);
+    assert(!token.is_cancellation_requested());
+    
+    auto start_time = std::chrono::steady_clock::now();
+    while (!token.is_cancellation_requested() &&
+           std::chrono::steady_clock::now() - start_time < std::chrono::seconds(5)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    
+    assert(token.is_cancellation_requested());
+    assert(std::chrono::steady_clock::now() - start_time >= std::chrono::milliseconds(50));
+    
+    // Rescheduling and disposing stop the earlier request
+    CancellationTokenSource rescheduled;
+    auto rescheduled_token = rescheduled.get_token();
+    rescheduled.cancel_after(30);
+    rescheduled.cancel_after(-1);
+    
+    CancellationTokenSource disposed(30);
+    auto disposed_token = disposed.get_token();
+    disposed.dispose();
+    
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    assert(!rescheduled_token.is_cancellation_requested());
+    assert(!disposed_token.is_cancellation_requested());
+    
+    std::cout << "Cancel after test passed" << std::endl;
+}
+
+void test_token_identity() {
+    // none() is a null token: every copy compares equal to a default token
+    CancellationToken none = CancellationToken::none();
+    assert(none == CancellationToken());
+    assert(!none.is_cancellation_requested());
+    
+    bool ran = false;
+    auto registration = none.register_callback([&ran]() { ran = true; });
+    assert(!registration.is_valid());
+    
+    CancellationTokenSource source;
+    CancellationToken token = source.get_token();
+    CancellationToken copy = token;
+    CancellationToken moved = std::move(copy);
+    assert(moved == token);
+    assert(token != none);
+    
+    source.cancel();
+    assert(moved.is_cancellation_requested());
+    assert(!ran);
+    
+    std::cout << "Token identity test passed" << std::endl;
+}
+
+void test_disposed_callbacks_do_not_run() {
+    CancellationTokenSource source;
+    auto token = source.get_token();
+    
+    std::vector<int> order;
+    auto first = token.register_callback([&order]() { order.push_back(1); });
+    auto second = token.register_callback([&order]() { order.push_back(2); });
+    auto third = token.register_callback([&order]() { order.push_back(3); });
+    assert(second.is_valid());
+    second.dispose();
+    assert(!second.is_valid());
+    
+    // Enough register/dispose churn to sweep the list several times
+    int churned = 0;
+    for (int i = 0; i < 1000; ++i) {
+        auto transient = token.register_callback([&churned]() { ++churned; });
+    }
+    
+    source.cancel();
+    
+    // Newest first, as in .NET
+    assert((order == std::vector<int>{3, 1}));
+    assert(churned == 0);
+    
+    // Disposing after the callback ran is harmless
+    first.dispose();
+    third.dispose();
+    
+    std::cout << "Disposed callbacks do not run test passed" << std::endl;
+}
+
+void test_callback_disposing_itself() {
+    CancellationTokenSource source;
+    auto token = source.get_token();
+    
+    CancellationTokenRegistration registration;
+    bool ran = false;
+    registration = token.register_callback([&registration, &ran]() {
+        ran = true;
+        // Must not wait for itself to finish
+        registration.dispose();
+    });
+    
+    source.cancel();
+    assert(ran);
+    assert(!registration.is_valid());
+    
+    std::cout << "Callback disposing itself test passed" << std::endl;
+}
+
+void test_dispose_waits_for_running_callback() {
+    CancellationTokenSource source;
+    auto token = source.get_token();
+    
+    std::atomic<bool> started{false};
+    std::atomic<bool> finished{false};
+    auto registration = token.register_callback([&started, &finished]() {
+        started = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        finished = true;
+    });
+    
+    std::thread canceller([&source]() {
+        source.cancel();
+    });
+    while (!started) {
+        std::this_thread::yield();
+    }
+    registration.dispose();
+    assert(finished);
+    canceller.join();
+    
+    std::cout << "Dispose waits for running callback test passed" << std::endl;
+}
+
+void test_concurrent_registration_and_cancel() {
+    for (int round = 0; round < 20; ++round) {
+        CancellationTokenSource source;
+        auto token = source.get_token();
+        std::atomic<int> kept_ran{0};
+        std::atomic<int> disposed_ran{0};
+        std::atomic<int> kept{0};
+        std::atomic<bool> cancel_returned{false};
+        
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&]() {
+                std::vector<CancellationTokenRegistration> registrations;
+                for (int i = 0; i < 200; ++i) {
+                    if (i % 2 == 0) {
+                        registrations.push_back(token.register_callback([&kept_ran]() { ++kept_ran; }));
+                        ++kept;
+                    } else {
+                        std::atomic<bool> disposed{false};
+                        auto registration = token.register_callback([&disposed, &disposed_ran]() {
+                            if (disposed) {
+                                ++disposed_ran;
+                            }
+                        });
+                        registration.dispose();
+                        disposed = true;
+                    }
+                }
+                // Keep the registrations alive until cancel has run them; disposing
+                // one first would rightly keep its callback from running
+                while (!cancel_returned) {
+                    std::this_thread::yield();
+                }
+            });
+        }
+        
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        source.cancel();
+        cancel_returned = true;
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        
+        // Every kept callback ran exactly once, whether queued or registered late
+        assert(kept_ran == kept);
+        assert(disposed_ran == 0);
+    }
+    
+    std::cout << "Concurrent registration and cancel test passed" << std::endl;
+}
+
+void test_sweeps_racing_cancel() {
+    for (int round = 0; round < 20; ++round) {
+        CancellationTokenSource source;
+        auto token = source.get_token();
+        std::atomic<int> kept_ran{0};
+        std::atomic<int> disposed_ran{0};
+        std::atomic<bool> go{false};
+        
+        // Registered up front so that cancel has a long list to walk
+        std::vector<CancellationTokenRegistration> kept;
+        for (int i = 0; i < 500; ++i) {
+            kept.push_back(token.register_callback([&kept_ran]() { ++kept_ran; }));
+        }
+        
+        // Churners keep tombstoning nodes so sweeps run while cancel walks the list
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 2; ++t) {
+            threads.emplace_back([&]() {
+                while (!go) {
+                    std::this_thread::yield();
+                }
+                for (int i = 0; i < 2000 && !token.is_cancellation_requested(); ++i) {
+                    std::atomic<bool> disposed{false};
+                    auto registration = token.register_callback([&disposed, &disposed_ran]() {
+                        if (disposed) {
+                            ++disposed_ran;
+                        }
+                    });
+                    registration.dispose();
+                    disposed = true;
+                }
+            });
+        }
+        // Two cancels race; only the one that marks the state runs the list
+        for (int t = 0; t < 2; ++t) {
+            threads.emplace_back([&]() {
+                while (!go) {
+                    std::this_thread::yield();
+                }
+                std::this_thread::yield();
+                source.cancel();
+            });
+        }
+        
+        go = true;
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        // Every kept callback ran exactly once
+        assert(kept_ran == 500);
+        assert(disposed_ran == 0);
+    }
+    
+    std::cout << "Sweeps racing cancel test passed" << std::endl;
+}
+
+void test_linked_to_many_parents() {
+    CancellationTokenSource deadline;
+    CancellationTokenSource disconnect;
+    CancellationTokenSource shutdown;
+    
+    auto linked = CancellationTokenSource::create_linked_token_source(
+        deadline.get_token(), CancellationToken::none(), disconnect.get_token(), shutdown.get_token());
+    auto token = linked.get_token();
+    
+    bool ran = false;
+    auto registration = token.register_callback([&ran]() { ran = true; });
+    
+    disconnect.cancel();
+    assert(token.is_cancellation_requested());
+    assert(ran);
+    assert(!deadline.get_token().is_cancellation_requested());
+    
+    // Any number of parents chosen at run time
+    std::vector<CancellationTokenSource> parents(16);
+    std::vector<CancellationToken> parent_tokens;
+    for (auto& parent : parents) {
+        parent_tokens.push_back(parent.get_token());
+    }
+    auto from_vector = CancellationTokenSource::create_linked_token_source(parent_tokens);
+    parents[11].cancel();
+    assert(from_vector.get_token().is_cancellation_requested());
+    
+    // Linking to a canceled parent cancels at once
+    auto late = CancellationTokenSource::create_linked_token_source(disconnect.get_token());
+    assert(late.get_token().is_cancellation_requested());
+    
+    std::cout << "Linked to many parents test passed" << std::endl;
+}
+
+void test_disposed_linked_source_unlinks() {
+    CancellationTokenSource parent;
+    auto parent_token = parent.get_token();
+    
+    CancellationToken orphan;
+    {
+        auto linked = CancellationTokenSource::create_linked_token_source(parent_token);
+        orphan = linked.get_token();
+        linked.dispose();
+    }
+    
+    // Many short-lived linked sources do not pile up on the parent
+    for (int i = 0; i < 10000; ++i) {
+        auto transient = CancellationTokenSource::create_linked_token_source(parent_token);
+    }
+    
+    // A moved linked source stays linked
+    auto moved_from = CancellationTokenSource::create_linked_token_source(parent_token);
+    CancellationTokenSource moved = std::move(moved_from);
+    
+    parent.cancel();
+    assert(!orphan.is_cancellation_requested());
+    assert(moved.get_token().is_cancellation_requested());
+    
+    // A long chain that only the links keep alive is freed without recursing
+    {
+        CancellationTokenSource chain_root;
+        CancellationToken last = chain_root.get_token();
+        for (int i = 0; i < 100000; ++i) {
+            auto linked = CancellationTokenSource::create_linked_token_source(last);
+            last = linked.get_token();
+        }
+    }
+    
+    std::cout << "Disposed linked source unlinks test passed" << std::endl;
+}
+
+void test_cancellation_tree() {
+    // A root with 64 children of 64 grandchildren each, plus a long chain
+    CancellationTokenSource root;
+    std::vector<CancellationTokenSource> children;
+    std::vector<CancellationTokenSource> grandchildren;
+    std::atomic<int> callbacks{0};
+    std::vector<CancellationTokenRegistration> registrations;
+    
+    for (int i = 0; i < 64; ++i) {
+        children.push_back(CancellationTokenSource::create_linked_token_source(root.get_token()));
+        for (int j = 0; j < 64; ++j) {
+            grandchildren.push_back(CancellationTokenSource::create_linked_token_source(children.back().get_token()));
+            registrations.push_back(grandchildren.back().get_token().register_callback([&callbacks]() {
+                ++callbacks;
+            }));
+        }
+    }
+    
+    std::vector<CancellationTokenSource> chain;
+    chain.push_back(CancellationTokenSource::create_linked_token_source(root.get_token()));
+    for (int i = 0; i < 20000; ++i) {
+        chain.push_back(CancellationTokenSource::create_linked_token_source(chain.back().get_token()));
+    }
+    
+    root.cancel();
+    
+    for (auto& child : children) {
+        assert(child.get_token().is_cancellation_requested());
+    }
+    for (auto& grandchild : grandchildren) {
+        assert(grandchild.get_token().is_cancellation_requested());
+    }
+    assert(callbacks == 64 * 64);
+    assert(chain.back().get_token().is_cancellation_requested());
+    
+    std::cout << "Cancellation tree test passed" << std::endl;
+}
+
+void test_linked_children_cancel_once() {
+    for (int round = 0; round < 50; ++round) {
+        // Two roots share 32 children, and each child links to both roots and has a
+        // grandchild that also links to the other root: every state is reached twice
+        CancellationTokenSource left;
+        CancellationTokenSource right;
+        std::vector<CancellationTokenSource> children;
+        std::vector<CancellationTokenSource> grandchildren;
+        std::vector<std::atomic<int>> runs(64);
+        std::vector<CancellationTokenRegistration> registrations;
+        
+        for (int i = 0; i < 32; ++i) {
+            children.push_back(CancellationTokenSource::create_linked_token_source(left.get_token(), right.get_token()));
+            grandchildren.push_back(CancellationTokenSource::create_linked_token_source(
+                children.back().get_token(), i % 2 == 0 ? right.get_token() : left.get_token()));
+            registrations.push_back(children.back().get_token().register_callback([&runs, i]() { ++runs[i]; }));
+            registrations.push_back(grandchildren.back().get_token().register_callback([&runs, i]() { ++runs[32 + i]; }));
+        }
+        
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        threads.emplace_back([&]() {
+            while (!go) {
+                std::this_thread::yield();
+            }
+            left.cancel();
+            // Each link is marked when the pass reaches it, whichever pass marked it first;
+            // a grandchild marked below a child the other root got to may still be pending
+            for (auto& child : children) {
+                assert(child.get_token().is_cancellation_requested());
+            }
+        });
+        threads.emplace_back([&]() {
+            while (!go) {
+                std::this_thread::yield();
+            }
+            right.cancel();
+        });
+        threads.emplace_back([&]() {
+            while (!go) {
+                std::this_thread::yield();
+            }
+            // Cancelling a child directly races the links reaching it
+            children[round % 32].cancel();
+        });
+        
+        go = true;
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        for (auto& count : runs) {
+            assert(count == 1);
+        }
+    }
+    
+    std::cout << "Linked children cancel once test passed" << std::endl;
+}
+
 int main() {
     std::cout << "Running CancellationToken tests..." << std::endl;
     
@@ -172,6 +580,17 @@ int main() {
     test_callback_registration_disposal();
     test_linked_token_source();
     test_callback_with_already_canceled_token();
+    test_cancel_after();
+    test_token_identity();
+    test_disposed_callbacks_do_not_run();
+    test_callback_disposing_itself();
+    test_dispose_waits_for_running_callback();
+    test_concurrent_registration_and_cancel();
+    test_sweeps_racing_cancel();
+    test_linked_to_many_parents();
+    test_disposed_linked_source_unlinks();
+    test_cancellation_tree();
+    test_linked_children_cancel_once();
     
     std::cout << "All CancellationToken tests passed!" << std::endl;
     return 0;
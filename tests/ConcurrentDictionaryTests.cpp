@@ -0,0 +1,262 @@
+#include <iostream>
+#include <thread>
+#include <cassert>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include "../include/System/Collections/Concurrent/ConcurrentDictionary.h"
+
+using namespace System::Collections::Concurrent;
+
+void test_basic_operations() {
+    ConcurrentDictionary<std::string, int> dictionary;
+    assert(dictionary.GetIsEmpty());
+
+    assert(dictionary.TryAdd("one", 1));
+    assert(dictionary.TryAdd("two", 2));
+    assert(!dictionary.TryAdd("one", 10));
+    assert(dictionary.GetCount() == 2);
+    assert(dictionary.ContainsKey("two"));
+    assert(!dictionary.ContainsKey("three"));
+
+    int value = 0;
+    assert(dictionary.TryGetValue("one", value));
+    assert(value == 1);
+    assert(dictionary["two"] == 2);
+
+    bool threw = false;
+    try {
+        dictionary["three"];
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    assert(threw);
+
+    assert(!dictionary.TryUpdate("one", 11, 5));
+    assert(dictionary.TryUpdate("one", 11, 1));
+    assert(dictionary["one"] == 11);
+
+    dictionary.SetItem("three", 3);
+    dictionary.SetItem("three", 33);
+    assert(dictionary["three"] == 33);
+    assert(dictionary.GetCount() == 3);
+
+    assert(dictionary.TryRemove("two", value));
+    assert(value == 2);
+    assert(!dictionary.TryRemove("two", value));
+    assert(dictionary.GetCount() == 2);
+
+    auto keys = dictionary.GetKeys();
+    std::sort(keys.begin(), keys.end());
+    assert((keys == std::vector<std::string>{"one", "three"}));
+
+    std::cout << "Basic operations test passed" << std::endl;
+}
+
+void test_get_or_add_and_add_or_update() {
+    ConcurrentDictionary<int, int> dictionary;
+    int factory_calls = 0;
+
+    assert(dictionary.GetOrAdd(1, [&](const int& key) { ++factory_calls; return key * 10; }) == 10);
+    assert(dictionary.GetOrAdd(1, [&](const int& key) { ++factory_calls; return key * 100; }) == 10);
+    assert(factory_calls == 1);
+    assert(dictionary.GetOrAdd(2, 20) == 20);
+    assert(dictionary.GetOrAdd(2, 99) == 20);
+
+    auto increment = [](const int&, const int& current) { return current + 1; };
+    assert(dictionary.AddOrUpdate(3, 0, increment) == 0);
+    assert(dictionary.AddOrUpdate(3, 0, increment) == 1);
+    assert(dictionary.AddOrUpdate(4, [](const int& key) { return key; }, increment) == 4);
+    assert(dictionary.GetCount() == 4);
+
+    std::cout << "GetOrAdd/AddOrUpdate test passed" << std::endl;
+}
+
+void test_factories_run_outside_guard() {
+    using System::Threading::EpochReclaimer;
+    ConcurrentDictionary<int, int> dictionary;
+
+    // The epoch can only move on twice while no guard is held; a factory that ran
+    // inside one would hold it back for every thread
+    auto epoch_advances = []() {
+        std::uint64_t start = EpochReclaimer::GetEpoch();
+        for (int i = 0; i < 4; ++i) {
+            EpochReclaimer::Collect();
+        }
+        return EpochReclaimer::GetEpoch() >= start + 2;
+    };
+    assert(dictionary.GetOrAdd(1, [&](const int& key) {
+        assert(epoch_advances());
+        return key;
+    }) == 1);
+    assert(dictionary.AddOrUpdate(2, [&](const int& key) {
+        assert(epoch_advances());
+        return key;
+    }, [](const int&, const int& current) { return current; }) == 2);
+    assert(dictionary.AddOrUpdate(2, 0, [&](const int&, const int& current) {
+        assert(epoch_advances());
+        return current + 1;
+    }) == 3);
+
+    // An update whose value changed while the factory ran is retried
+    int calls = 0;
+    assert(dictionary.AddOrUpdate(2, 0, [&](const int&, const int& current) {
+        if (calls++ == 0) {
+            dictionary.SetItem(2, 10);
+        }
+        return current + 1;
+    }) == 11);
+    assert(calls == 2);
+    assert(dictionary[2] == 11);
+
+    std::cout << "Factories run outside guard test passed" << std::endl;
+}
+
+void test_resize_under_concurrent_access() {
+    constexpr int writers = 4;
+    constexpr int readers = 4;
+    constexpr int keys_per_writer = 20000;
+
+    ConcurrentDictionary<int, int> dictionary(16, 16);
+    std::atomic<bool> done{false};
+    std::atomic<bool> consistent{true};
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&]() {
+            // A key that is present always maps to its own double, whatever table it is in
+            while (!done.load()) {
+                for (int key = 0; key < writers * keys_per_writer; key += 97) {
+                    int value = 0;
+                    if (dictionary.TryGetValue(key, value) && value != key * 2) {
+                        consistent = false;
+                    }
+                }
+            }
+        });
+    }
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&, w]() {
+            for (int i = 0; i < keys_per_writer; ++i) {
+                int key = w * keys_per_writer + i;
+                dictionary.TryAdd(key, key * 2);
+                if (i % 8 == 0) {
+                    // Counters shared across writers exercise the striped update path
+                    dictionary.AddOrUpdate(-1 - (i / 8) % 4, 1, [](const int&, const int& current) { return current + 1; });
+                }
+            }
+        });
+    }
+    for (int t = readers; t < readers + writers; ++t) {
+        threads[t].join();
+    }
+    done = true;
+    for (int t = 0; t < readers; ++t) {
+        threads[t].join();
+    }
+
+    assert(consistent.load());
+    assert(dictionary.GetCount() == writers * keys_per_writer + 4);
+    for (int key = 0; key < writers * keys_per_writer; ++key) {
+        int value = 0;
+        assert(dictionary.TryGetValue(key, value));
+        assert(value == key * 2);
+    }
+
+    int updates = 0;
+    for (int counter = -4; counter <= -1; ++counter) {
+        updates += dictionary[counter];
+    }
+    assert(updates == writers * (keys_per_writer / 8));
+    assert(dictionary.ToArray().size() == static_cast<size_t>(writers * keys_per_writer + 4));
+
+    std::cout << "Resize under concurrent access test passed" << std::endl;
+}
+
+void test_clear() {
+    ConcurrentDictionary<int, std::string> dictionary;
+    for (int i = 0; i < 1000; ++i) {
+        dictionary.TryAdd(i, std::to_string(i));
+    }
+    assert(dictionary.GetCount() == 1000);
+
+    dictionary.Clear();
+    assert(dictionary.GetIsEmpty());
+    assert(!dictionary.ContainsKey(5));
+    assert(dictionary.GetValues().empty());
+
+    assert(dictionary.TryAdd(5, "five"));
+    assert(dictionary[5] == "five");
+    assert(dictionary.GetCount() == 1);
+
+    std::cout << "Clear test passed" << std::endl;
+}
+
+void test_clear_during_growth() {
+    constexpr int writers = 3;
+    constexpr int keys_per_writer = 20000;
+
+    // Small tables, so the inserts keep growing them while Clear runs
+    ConcurrentDictionary<int, int> dictionary(4, 16);
+    std::atomic<int> running{writers};
+    std::atomic<bool> consistent{true};
+    int clears = 0;
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&, w]() {
+            for (int i = 0; i < keys_per_writer; ++i) {
+                int key = w * keys_per_writer + i;
+                dictionary.TryAdd(key, key * 2);
+                int value = 0;
+                if (dictionary.TryGetValue(key, value) && value != key * 2) {
+                    consistent = false;
+                }
+            }
+            --running;
+        });
+    }
+    // A migration that completes while Clear holds the locks must not retire the
+    // table Clear is retiring
+    while (running.load() > 0) {
+        dictionary.Clear();
+        ++clears;
+        std::this_thread::yield();
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    assert(consistent.load());
+    assert(clears > 0);
+    auto items = dictionary.ToArray();
+    assert(dictionary.GetCount() == static_cast<int>(items.size()));
+    for (const auto& item : items) {
+        assert(item.second == item.first * 2);
+    }
+
+    dictionary.Clear();
+    assert(dictionary.GetIsEmpty());
+    for (int key = 0; key < 1000; ++key) {
+        assert(dictionary.TryAdd(key, key));
+    }
+    assert(dictionary.GetCount() == 1000);
+
+    std::cout << "Clear during growth test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running ConcurrentDictionary tests..." << std::endl;
+
+    test_basic_operations();
+    test_get_or_add_and_add_or_update();
+    test_factories_run_outside_guard();
+    test_resize_under_concurrent_access();
+    test_clear();
+    test_clear_during_growth();
+
+    std::cout << "All ConcurrentDictionary tests passed!" << std::endl;
+    return 0;
+}
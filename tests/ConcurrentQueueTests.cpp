@@ -0,0 +1,175 @@
+#include <iostream>
+#include <thread>
+#include <cassert>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include "../include/System/Collections/Concurrent/ConcurrentQueue.h"
+
+using namespace System::Collections::Concurrent;
+
+void test_fifo_order() {
+    ConcurrentQueue<int> queue;
+    assert(queue.GetIsEmpty());
+
+    // Enough items to span several segments
+    for (int i = 0; i < 1000; ++i) {
+        queue.Enqueue(i);
+    }
+    assert(queue.GetCount() == 1000);
+    assert(!queue.GetIsEmpty());
+
+    int peeked = -1;
+    assert(queue.TryPeek(peeked));
+    assert(peeked == 0);
+
+    for (int i = 0; i < 1000; ++i) {
+        int value = -1;
+        assert(queue.TryDequeue(value));
+        assert(value == i);
+    }
+
+    int value = -1;
+    assert(!queue.TryDequeue(value));
+    assert(queue.GetIsEmpty());
+    assert(queue.GetCount() == 0);
+
+    std::cout << "FIFO order test passed" << std::endl;
+}
+
+void test_bulk_dequeue() {
+    ConcurrentQueue<std::string> queue(std::vector<std::string>{"a", "b", "c", "d", "e"});
+
+    std::vector<std::string> batch(3);
+    assert(queue.TryDequeue(std::span<std::string>(batch)) == 3);
+    assert(batch[0] == "a" && batch[1] == "b" && batch[2] == "c");
+
+    assert(queue.TryDequeue(std::span<std::string>(batch)) == 2);
+    assert(batch[0] == "d" && batch[1] == "e");
+
+    assert(queue.TryDequeue(std::span<std::string>(batch)) == 0);
+
+    std::cout << "Bulk dequeue test passed" << std::endl;
+}
+
+void test_to_array_snapshot() {
+    ConcurrentQueue<std::shared_ptr<int>> queue;
+    for (int i = 0; i < 100; ++i) {
+        queue.Enqueue(std::make_shared<int>(i));
+    }
+
+    auto snapshot = queue.ToArray();
+    assert(snapshot.size() == 100);
+    for (int i = 0; i < 100; ++i) {
+        assert(*snapshot[i] == i);
+    }
+
+    // Items dequeued after the snapshot are still intact and in order
+    for (int i = 0; i < 50; ++i) {
+        std::shared_ptr<int> item;
+        assert(queue.TryDequeue(item));
+        assert(*item == i);
+    }
+    queue.Enqueue(std::make_shared<int>(100));
+
+    std::vector<std::shared_ptr<int>> copy(51);
+    queue.CopyTo(copy, 0);
+    assert(*copy.front() == 50);
+    assert(*copy.back() == 100);
+
+    std::cout << "ToArray snapshot test passed" << std::endl;
+}
+
+void test_concurrent_producers_consumers() {
+    constexpr int producers = 4;
+    constexpr int consumers = 4;
+    constexpr int items_per_producer = 50000;
+
+    ConcurrentQueue<long long> queue;
+    std::atomic<long long> consumed_sum{0};
+    std::atomic<int> consumed_count{0};
+    std::atomic<bool> ordered{true};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, p]() {
+            for (int i = 0; i < items_per_producer; ++i) {
+                queue.Enqueue(static_cast<long long>(p) * items_per_producer + i);
+            }
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&]() {
+            // Items of one producer must arrive in the order it enqueued them
+            std::vector<long long> last_seen(producers, -1);
+            long long batch[16];
+            while (consumed_count.load() < producers * items_per_producer) {
+                int taken = queue.TryDequeue(std::span<long long>(batch));
+                for (int i = 0; i < taken; ++i) {
+                    int producer = static_cast<int>(batch[i] / items_per_producer);
+                    if (batch[i] <= last_seen[producer]) {
+                        ordered = false;
+                    }
+                    last_seen[producer] = batch[i];
+                    consumed_sum.fetch_add(batch[i]);
+                }
+                consumed_count.fetch_add(taken);
+                if (taken == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    long long total = static_cast<long long>(producers) * items_per_producer;
+    assert(consumed_count.load() == total);
+    assert(consumed_sum.load() == total * (total - 1) / 2);
+    assert(ordered.load());
+    assert(queue.GetIsEmpty());
+
+    std::cout << "Concurrent producers/consumers test passed" << std::endl;
+}
+
+void test_reclaimer_does_not_strand_retirements() {
+    using System::Threading::EpochReclaimer;
+    static std::atomic<int> freed{0};
+    static int nodes[2];
+    EpochReclaimer::Deleter count_free = [](void*) { freed.fetch_add(1); };
+
+    // One large retirement and no more: leaving guards keeps collecting it
+    EpochReclaimer::Retire(&nodes[0], count_free, 1024 * 1024);
+    for (int i = 0; i < 4 && freed.load() == 0; ++i) {
+        EpochReclaimer::Guard guard;
+    }
+    assert(freed.load() == 1);
+
+    // A thread that exits before its retirement can be freed leaves it to the
+    // next thread that collects
+    std::thread([count_free]() {
+        EpochReclaimer::Retire(&nodes[1], count_free);
+    }).join();
+    for (int i = 0; i < 4 && freed.load() == 1; ++i) {
+        EpochReclaimer::Collect();
+    }
+    assert(freed.load() == 2);
+
+    std::cout << "Reclaimer does not strand retirements test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running ConcurrentQueue tests..." << std::endl;
+
+    test_fifo_order();
+    test_bulk_dequeue();
+    test_to_array_snapshot();
+    test_concurrent_producers_consumers();
+    test_reclaimer_does_not_strand_retirements();
+
+    std::cout << "All ConcurrentQueue tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <thread>
+#include <cassert>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "../include/System/Collections/Concurrent/ConcurrentStack.h"
+
+using namespace System::Collections::Concurrent;
+
+void test_lifo_order() {
+    ConcurrentStack<int> stack;
+    assert(stack.GetIsEmpty());
+
+    for (int i = 0; i < 100; ++i) {
+        stack.Push(i);
+    }
+    assert(stack.GetCount() == 100);
+
+    int peeked = -1;
+    assert(stack.TryPeek(peeked));
+    assert(peeked == 99);
+
+    for (int i = 99; i >= 0; --i) {
+        int value = -1;
+        assert(stack.TryPop(value));
+        assert(value == i);
+    }
+
+    int value = -1;
+    assert(!stack.TryPop(value));
+    assert(stack.GetIsEmpty());
+
+    std::cout << "LIFO order test passed" << std::endl;
+}
+
+void test_push_pop_range() {
+    ConcurrentStack<std::string> stack;
+    stack.PushRange({"a", "b", "c", "d"});
+    assert(stack.GetCount() == 4);
+
+    // The last item of the range ends up on top
+    auto snapshot = stack.ToArray();
+    assert((snapshot == std::vector<std::string>{"d", "c", "b", "a"}));
+
+    std::vector<std::string> popped(3);
+    assert(stack.TryPopRange(popped) == 3);
+    assert((popped == std::vector<std::string>{"d", "c", "b"}));
+
+    assert(stack.TryPopRange(popped, 1, 2) == 1);
+    assert(popped[1] == "a");
+    assert(stack.TryPopRange(popped) == 0);
+
+    stack.PushRange({"x", "y"});
+    stack.Clear();
+    assert(stack.GetIsEmpty());
+
+    std::cout << "Push/pop range test passed" << std::endl;
+}
+
+void test_concurrent_push_pop() {
+    constexpr int threads_count = 8;
+    constexpr int operations = 50000;
+
+    ConcurrentStack<int> stack;
+    std::atomic<long long> pushed_sum{0};
+    std::atomic<long long> popped_sum{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threads_count; ++t) {
+        threads.emplace_back([&, t]() {
+            std::vector<int> batch(4);
+            for (int i = 0; i < operations; ++i) {
+                int value = t * operations + i;
+                if (i % 16 == 0) {
+                    std::vector<int> range{value, value, value};
+                    stack.PushRange(range);
+                    pushed_sum.fetch_add(3LL * value);
+                } else {
+                    stack.Push(value);
+                    pushed_sum.fetch_add(value);
+                }
+
+                if (i % 16 == 8) {
+                    int taken = stack.TryPopRange(batch);
+                    for (int j = 0; j < taken; ++j) {
+                        popped_sum.fetch_add(batch[j]);
+                    }
+                } else {
+                    int popped = 0;
+                    if (stack.TryPop(popped)) {
+                        popped_sum.fetch_add(popped);
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    int remaining = 0;
+    while (stack.TryPop(remaining)) {
+        popped_sum.fetch_add(remaining);
+    }
+    assert(pushed_sum.load() == popped_sum.load());
+
+    std::cout << "Concurrent push/pop test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running ConcurrentStack tests..." << std::endl;
+
+    test_lifo_order();
+    test_push_pop_range();
+    test_concurrent_push_pop();
+
+    std::cout << "All ConcurrentStack tests passed!" << std::endl;
+    return 0;
+}
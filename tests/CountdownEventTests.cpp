@@ -4,6 +4,9 @@
 #include <vector>
 #include <cassert>
 #include <chrono>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
 #include "../include/System/Threading/CountdownEvent.hpp"
 
 using namespace System::Threading;
@@ -147,6 +150,104 @@ void test_reset() {
     std::cout << "Reset test passed" << std::endl;
 }
 
+void test_adaptive_spin() {
+    AdaptiveSpin spinner;
+    
+    // Waits that always end up blocking shrink the budget to a single spin
+    for (int i = 0; i < 2 * SpinWait::YIELD_THRESHOLD; ++i) {
+        assert(!spinner.spin_until([]() { return false; }));
+    }
+    assert(spinner.get_budget() == 1);
+    assert(spinner.spin_until([]() { return true; }));
+    
+    // A fan-in that completes while waiters spin or park
+    CountdownEvent countdown(64);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 64; ++i) {
+        workers.emplace_back([&countdown]() {
+            countdown.signal();
+        });
+    }
+    countdown.wait();
+    assert(countdown.is_set());
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    std::cout << "Adaptive spin test passed" << std::endl;
+}
+
+void test_fan_in() {
+    constexpr int items = 100000;
+    constexpr int workers_count = 8;
+    
+    CountdownEvent countdown(items);
+    std::atomic<int> processed{0};
+    
+    // Parked, timed and late waiters all see the same release
+    std::thread parked([&countdown, &processed]() {
+        countdown.wait();
+        assert(processed.load() == items);
+    });
+    std::thread timed([&countdown, &processed]() {
+        assert(countdown.wait(std::chrono::seconds(30)));
+        assert(processed.load() == items);
+    });
+    
+    std::vector<std::thread> workers;
+    for (int w = 0; w < workers_count; ++w) {
+        workers.emplace_back([&countdown, &processed, w]() {
+            for (int i = w; i < items; i += workers_count) {
+                processed.fetch_add(1, std::memory_order_relaxed);
+                assert(countdown.signal());
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    parked.join();
+    timed.join();
+    
+    assert(countdown.is_set());
+    assert(countdown.get_current_count() == 0);
+    assert(!countdown.signal());
+    assert(countdown.get_current_count() == 0);
+    assert(countdown.wait(0));
+    
+    std::cout << "Fan-in test passed" << std::endl;
+}
+
+void test_dispose_wakes_waiters() {
+    auto countdown = std::make_unique<CountdownEvent>(1);
+    std::atomic<int> disposed_seen{0};
+    
+    std::vector<std::thread> waiters;
+    waiters.emplace_back([&countdown, &disposed_seen]() {
+        try {
+            countdown->wait();
+        } catch (const std::runtime_error&) {
+            disposed_seen.fetch_add(1);
+        }
+    });
+    waiters.emplace_back([&countdown, &disposed_seen]() {
+        try {
+            countdown->wait(std::chrono::seconds(30));
+        } catch (const std::runtime_error&) {
+            disposed_seen.fetch_add(1);
+        }
+    });
+    
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    countdown->dispose();
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+    assert(disposed_seen.load() == 2);
+    
+    std::cout << "Dispose wakes waiters test passed" << std::endl;
+}
+
 int main() {
     std::cout << "Running CountdownEvent tests..." << std::endl;
     
@@ -157,6 +258,9 @@ int main() {
     test_add_count();
     test_try_add_count();
     test_reset();
+    test_adaptive_spin();
+    test_fan_in();
+    test_dispose_wakes_waiters();
     
     std::cout << "All CountdownEvent tests passed!" << std::endl;
     return 0;
@@ -0,0 +1,176 @@
+#include <iostream>
+#include <thread>
+#include <cassert>
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include "../include/System/Threading/ManualResetEventSlim.h"
+
+using namespace System::Threading;
+
+void test_set_and_reset() {
+    ManualResetEventSlim event;
+    assert(!event.GetIsSet());
+    assert(!event.Wait(0));
+
+    event.Set();
+    assert(event.GetIsSet());
+    event.Wait();
+    assert(event.Wait(0));
+
+    // Setting twice is harmless, and Reset makes waits block again
+    event.Set();
+    event.Reset();
+    assert(!event.GetIsSet());
+    assert(!event.Wait(0));
+
+    ManualResetEventSlim initially_set(true, 0);
+    assert(initially_set.GetIsSet());
+    assert(initially_set.GetSpinCount() == 0);
+    initially_set.Wait();
+
+    bool threw = false;
+    try {
+        ManualResetEventSlim bad(false, -1);
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    assert(threw);
+
+    std::cout << "Set and reset test passed" << std::endl;
+}
+
+void test_timed_wait() {
+    ManualResetEventSlim event(false, 1);
+
+    auto start = std::chrono::steady_clock::now();
+    assert(!event.Wait(50));
+    assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+
+    std::thread setter([&event]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        event.Set();
+    });
+    assert(event.Wait(System::TimeSpan::FromSeconds(30)));
+    setter.join();
+
+    std::cout << "Timed wait test passed" << std::endl;
+}
+
+void test_set_releases_parked_waiters() {
+    constexpr int waiters_count = 16;
+
+    ManualResetEventSlim event(false, 1);
+    std::atomic<int> released{0};
+
+    std::vector<std::thread> waiters;
+    for (int w = 0; w < waiters_count; ++w) {
+        waiters.emplace_back([&event, &released, w]() {
+            // Half park untimed, half block with a timeout
+            if (w % 2 == 0) {
+                event.Wait();
+            } else {
+                assert(event.Wait(30000));
+            }
+            released.fetch_add(1);
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    assert(released.load() == 0);
+    event.Set();
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+    assert(released.load() == waiters_count);
+
+    std::cout << "Set releases parked waiters test passed" << std::endl;
+}
+
+void test_destroy_after_wait() {
+    // The waiter owns the event and destroys it as soon as Wait returns,
+    // which must not race the tail of Set
+    for (int round = 0; round < 1000; ++round) {
+        auto event = std::make_unique<ManualResetEventSlim>(false, round % 2 == 0 ? 0 : 35);
+        std::thread setter([raw = event.get()]() {
+            raw->Set();
+        });
+        if (round % 3 == 0) {
+            assert(event->Wait(30000));
+        } else {
+            event->Wait();
+        }
+        event.reset();
+        setter.join();
+    }
+
+    std::cout << "Destroy after wait test passed" << std::endl;
+}
+
+void test_cancelable_wait() {
+    ManualResetEventSlim event(false, 1);
+    CancellationTokenSource cts;
+
+    std::thread canceler([&cts]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        cts.cancel();
+    });
+    bool threw = false;
+    try {
+        event.Wait(cts.get_token());
+    } catch (const OperationCanceledException&) {
+        threw = true;
+    }
+    assert(threw);
+    canceler.join();
+
+    // A token that cannot be canceled takes the plain timed path
+    assert(!event.Wait(10, CancellationToken::none()));
+    CancellationTokenSource unused;
+    std::thread setter([&event]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        event.Set();
+    });
+    assert(event.Wait(30000, unused.get_token()));
+    setter.join();
+
+    std::cout << "Cancelable wait test passed" << std::endl;
+}
+
+void test_wait_handle_follows_event() {
+    ManualResetEventSlim event;
+    WaitHandle* handle = event.GetWaitHandle();
+    assert(handle == event.GetWaitHandle());
+    assert(!handle->WaitOne(0));
+
+    std::thread setter([&event]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        event.Set();
+    });
+    assert(handle->WaitOne(30000));
+    setter.join();
+
+    event.Reset();
+    assert(!handle->WaitOne(0));
+    assert(WaitHandle::WaitAny({handle}, 10) == -1);
+    event.Set();
+    assert(WaitHandle::WaitAll({handle}, 0));
+
+    std::cout << "Wait handle follows event test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running ManualResetEventSlim tests..." << std::endl;
+
+    test_set_and_reset();
+    test_timed_wait();
+    test_set_releases_parked_waiters();
+    test_destroy_after_wait();
+    test_cancelable_wait();
+    test_wait_handle_follows_event();
+
+    std::cout << "All ManualResetEventSlim tests passed!" << std::endl;
+    return 0;
+}
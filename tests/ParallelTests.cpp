@@ -0,0 +1,501 @@
+#include <iostream>
+#include <thread>
+#include <cassert>
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <stdexcept>
+#include <functional>
+#include <limits>
+#include <climits>
+#include <utility>
+#include "../include/System/Threading/Tasks/Parallel.h"
+
+using namespace System::Threading::Tasks;
+
+ParallelOptions WithDegree(int degree) {
+    ParallelOptions options;
+    options.SetMaxDegreeOfParallelism(degree);
+    return options;
+}
+
+void test_for_covers_range() {
+    constexpr int count = 1000000;
+    std::vector<int> hits(count, 0);
+
+    ParallelLoopResult result = Parallel::For(0, count, WithDegree(4), [&hits](int i) {
+        hits[i] += 1;
+    });
+    assert(result.IsCompleted);
+    for (int i = 0; i < count; ++i) {
+        assert(hits[i] == 1);
+    }
+
+    // Long indices, a negative start, and std::function bodies still work
+    std::vector<std::atomic<int>> longHits(2000);
+    std::function<void(long)> body = [&longHits](long i) { longHits[static_cast<std::size_t>(i + 1000)].fetch_add(1); };
+    Parallel::For(-1000L, 1000L, WithDegree(3), body);
+    for (auto& hit : longHits) {
+        assert(hit.load() == 1);
+    }
+
+    // Empty and reversed ranges run nothing
+    assert(Parallel::For(5, 5, [](int) { assert(false); }).IsCompleted);
+    assert(Parallel::For(5, 1, [](int) { assert(false); }).IsCompleted);
+
+    std::cout << "For covers range test passed" << std::endl;
+}
+
+void test_imbalanced_work_is_stolen() {
+    // All the cost sits in the first worker's slice; the others must steal it
+    constexpr int count = 4000;
+    std::vector<std::atomic<int>> hits(count);
+
+    Parallel::For(0, count, WithDegree(4), [&](int i) {
+        if (i < count / 4) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        hits[i].fetch_add(1);
+    });
+
+    for (auto& hit : hits) {
+        assert(hit.load() == 1);
+    }
+
+    std::cout << "Imbalanced work is stolen test passed" << std::endl;
+}
+
+void test_max_degree_of_parallelism() {
+    std::atomic<int> active{0};
+    std::atomic<int> peak{0};
+
+    Parallel::For(0, 200, WithDegree(2), [&](int) {
+        int now = active.fetch_add(1) + 1;
+        int seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        active.fetch_sub(1);
+    });
+    assert(peak.load() <= 2);
+
+    bool threw = false;
+    try {
+        WithDegree(0);
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    assert(threw);
+
+    std::cout << "MaxDegreeOfParallelism test passed" << std::endl;
+}
+
+void test_stop_and_break() {
+    constexpr int count = 100000;
+
+    std::atomic<int> executed{0};
+    ParallelLoopResult stopped = Parallel::For(0, count, WithDegree(4), [&](int i, ParallelLoopState& state) {
+        executed.fetch_add(1);
+        if (i == 10) {
+            state.Stop();
+        }
+    });
+    assert(!stopped.IsCompleted);
+    assert(stopped.LowestBreakIteration == LONG_MAX);
+    assert(executed.load() < count);
+
+    // Every iteration below the break still runs
+    std::vector<std::atomic<int>> hits(count);
+    ParallelLoopResult broken = Parallel::For(0, count, WithDegree(4), [&](int i, ParallelLoopState& state) {
+        hits[i].fetch_add(1);
+        if (i == 5000) {
+            state.Break();
+        }
+    });
+    assert(!broken.IsCompleted);
+    assert(broken.LowestBreakIteration <= 5000);
+    for (long i = 0; i < broken.LowestBreakIteration; ++i) {
+        assert(hits[static_cast<std::size_t>(i)].load() == 1);
+    }
+
+    std::cout << "Stop and break test passed" << std::endl;
+}
+
+void test_exception_propagates() {
+    bool threw = false;
+    try {
+        Parallel::For(0, 10000, WithDegree(4), [](int i) {
+            if (i == 1234) {
+                throw std::runtime_error("body failed");
+            }
+        });
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    std::cout << "Exception propagates test passed" << std::endl;
+}
+
+void test_cancellation() {
+    using System::Threading::CancellationTokenSource;
+    using System::Threading::OperationCanceledException;
+
+    // A token canceled before the loop starts runs no iteration
+    CancellationTokenSource canceled;
+    canceled.cancel();
+    ParallelOptions options = WithDegree(4);
+    options.SetCancellationToken(canceled.get_token());
+    std::atomic<int> executed{0};
+    bool threw = false;
+    try {
+        Parallel::For(0, 1000, options, [&executed](int) { executed.fetch_add(1); });
+    } catch (const OperationCanceledException&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(executed.load() == 0);
+
+    // Canceling from inside stops the loop at the next chunk boundary
+    constexpr int count = 1000000;
+    CancellationTokenSource cts;
+    options.SetCancellationToken(cts.get_token());
+    threw = false;
+    try {
+        Parallel::For(0, count, options, [&](int i) {
+            executed.fetch_add(1);
+            if (i == 100) {
+                cts.cancel();
+            }
+        });
+    } catch (const OperationCanceledException&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(executed.load() < count);
+
+    std::cout << "Cancellation test passed" << std::endl;
+}
+
+void test_for_each_and_invoke() {
+    std::vector<int> values(10000);
+    for (int i = 0; i < static_cast<int>(values.size()); ++i) {
+        values[i] = i;
+    }
+
+    std::atomic<long long> sum{0};
+    Parallel::ForEach(values, WithDegree(4), [&sum](const int& value) {
+        sum.fetch_add(value);
+    });
+    assert(sum.load() == 10000LL * 9999 / 2);
+
+    std::atomic<int> invoked{0};
+    Parallel::Invoke({
+        [&invoked]() { invoked.fetch_add(1); },
+        [&invoked]() { invoked.fetch_add(10); },
+        [&invoked]() { invoked.fetch_add(100); },
+    });
+    assert(invoked.load() == 111);
+
+    std::cout << "ForEach and Invoke test passed" << std::endl;
+}
+
+void test_nested_loops() {
+    std::atomic<int> total{0};
+    Parallel::For(0, 16, WithDegree(4), [&total](int) {
+        Parallel::For(0, 1000, WithDegree(4), [&total](int) {
+            total.fetch_add(1, std::memory_order_relaxed);
+        });
+    });
+    assert(total.load() == 16000);
+
+    std::cout << "Nested loops test passed" << std::endl;
+}
+
+void test_for_with_local_state() {
+    constexpr int count = 1000000;
+    std::vector<int> values(count);
+    for (int i = 0; i < count; ++i) {
+        values[i] = i % 16;
+    }
+
+    // Per-worker histograms, merged without a lock
+    std::atomic<int> initialized{0};
+    int finalized = 0;
+    std::vector<long> histogram(16, 0);
+    ParallelLoopResult result = Parallel::For(0, count, WithDegree(4),
+        [&initialized]() {
+            initialized.fetch_add(1);
+            return std::vector<long>(16, 0);
+        },
+        [&values](int i, ParallelLoopState&, std::vector<long> local) {
+            ++local[values[i]];
+            return local;
+        },
+        [&histogram, &finalized](std::vector<long> local) {
+            ++finalized;
+            for (int bucket = 0; bucket < 16; ++bucket) {
+                histogram[bucket] += local[bucket];
+            }
+        });
+    assert(result.IsCompleted);
+    assert(finalized == initialized.load());
+    assert(finalized >= 1 && finalized <= 4);
+    for (int bucket = 0; bucket < 16; ++bucket) {
+        assert(histogram[bucket] == count / 16);
+    }
+
+    // Stop ends the loop early, but localFinally still sees what ran
+    long long seen = 0;
+    result = Parallel::For<long long>(0L, 1000000L, WithDegree(4),
+        []() { return 0LL; },
+        [](long i, ParallelLoopState& state, long long local) {
+            if (i == 500) {
+                state.Stop();
+            }
+            return local + 1;
+        },
+        [&seen](long long local) { seen += local; });
+    assert(!result.IsCompleted);
+    assert(seen >= 1 && seen < 1000000);
+
+    // Nothing runs for an empty range, not even localInit
+    bool called = false;
+    Parallel::For(5, 5, [&called]() { called = true; return 0; },
+        [](int, int local) { return local; },
+        [&called](int) { called = true; });
+    assert(!called);
+
+    // A failed loop drops the values
+    finalized = 0;
+    bool threw = false;
+    try {
+        Parallel::For(0, 10000, WithDegree(4), []() { return 0; },
+            [](int i, int local) {
+                if (i == 4321) {
+                    throw std::runtime_error("body failed");
+                }
+                return local + 1;
+            },
+            [&finalized](int) { ++finalized; });
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(finalized == 0);
+
+    std::cout << "For with local state test passed" << std::endl;
+}
+
+void test_local_state_partitions() {
+    struct Local {
+        long iterations = 0;
+        long long sum = 0;
+    };
+    constexpr long count = 200000;
+    std::thread::id caller = std::this_thread::get_id();
+
+    // The last quarter is slow, so its owner falls behind and the others steal
+    // from it; every iteration must still land in exactly one worker's value,
+    // seeded once per worker and written back across all of its chunks
+    std::atomic<int> initialized{0};
+    std::vector<Local> finals;
+    bool finalized_on_caller = true;
+    Parallel::For<Local>(0L, count, WithDegree(4),
+        [&initialized]() {
+            initialized.fetch_add(1);
+            return Local();
+        },
+        [](long i, Local local) {
+            if (i >= count / 4 * 3) {
+                volatile long spin = 0;
+                for (int k = 0; k < 200; ++k) {
+                    spin = spin + k;
+                }
+            }
+            ++local.iterations;
+            local.sum += i;
+            return local;
+        },
+        [&](Local local) {
+            finalized_on_caller = finalized_on_caller && std::this_thread::get_id() == caller;
+            finals.push_back(local);
+        });
+    assert(finalized_on_caller);
+    assert(static_cast<int>(finals.size()) == initialized.load());
+    assert(finals.size() >= 1 && finals.size() <= 4);
+    long iterations = 0;
+    long long sum = 0;
+    for (const Local& local : finals) {
+        assert(local.iterations > 0);
+        iterations += local.iterations;
+        sum += local.sum;
+    }
+    assert(iterations == count);
+    assert(sum == static_cast<long long>(count) * (count - 1) / 2);
+
+    // A canceled loop drops the values like a failed one
+    System::Threading::CancellationTokenSource cts;
+    ParallelOptions options = WithDegree(4);
+    options.SetCancellationToken(cts.get_token());
+    int finalized = 0;
+    bool threw = false;
+    try {
+        Parallel::For(0, 100000, options, []() { return 0; },
+            [&cts](int i, int local) {
+                if (i == 50) {
+                    cts.cancel();
+                }
+                return local + 1;
+            },
+            [&finalized](int) { ++finalized; });
+    } catch (const System::Threading::OperationCanceledException&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(finalized == 0);
+
+    std::cout << "Local state partitions test passed" << std::endl;
+}
+
+void test_reduce_and_transform_reduce() {
+    constexpr long count = 3000000;
+    std::vector<long long> values(static_cast<std::size_t>(count));
+    for (long i = 0; i < count; ++i) {
+        values[static_cast<std::size_t>(i)] = i;
+    }
+    long long expected = static_cast<long long>(count) * (count - 1) / 2;
+
+    assert(Parallel::Reduce(values, 0LL, std::plus<>()) == expected);
+    assert(Parallel::Reduce(values, WithDegree(3), 0LL, std::plus<>()) == expected);
+    assert(Parallel::Reduce(std::vector<long long>(), 7LL, std::plus<>()) == 7);
+
+    long long maximum = Parallel::Reduce(values, WithDegree(4), std::numeric_limits<long long>::min(),
+        [](long long a, long long b) { return a > b ? a : b; });
+    assert(maximum == count - 1);
+
+    long long squares = Parallel::TransformReduce(0, 1000, 0LL, std::plus<>(), [](long i) {
+        return static_cast<long long>(i) * i;
+    });
+    assert(squares == 999LL * 1000 * 1999 / 6);
+
+    long long evens = Parallel::TransformReduce(values, WithDegree(4), 0LL, std::plus<>(), [](long long value) {
+        return value % 2 == 0 ? 1LL : 0LL;
+    });
+    assert(evens == count / 2);
+
+    std::cout << "Reduce and TransformReduce test passed" << std::endl;
+}
+
+System::Coroutines::Generator<int> Numbers(int count) {
+    for (int i = 0; i < count; ++i) {
+        co_yield i;
+    }
+}
+
+void test_for_each_over_partitioners() {
+    using System::Collections::Concurrent::Partitioner;
+    constexpr int count = 200000;
+
+    // A generator is consumed in chunks, never copied whole
+    std::atomic<long long> sum{0};
+    ParallelLoopResult result = Parallel::ForEach(Numbers(count), WithDegree(4), [&sum](const int& value) {
+        sum.fetch_add(value, std::memory_order_relaxed);
+    });
+    assert(result.IsCompleted);
+    assert(sum.load() == static_cast<long long>(count) * (count - 1) / 2);
+
+    // Static ranges: one body call per range
+    std::vector<std::atomic<int>> seen(count);
+    Parallel::ForEach(Partitioner::Create(0, count), [&seen](const std::pair<int, int>& range) {
+        for (int i = range.first; i < range.second; ++i) {
+            seen[i].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    for (auto& value : seen) {
+        assert(value.load() == 1);
+    }
+
+    std::vector<int> values(count, 1);
+    std::atomic<int> total{0};
+    Parallel::ForEach(Partitioner::Create(values, true), WithDegree(3), [&total](const int& value) {
+        total.fetch_add(value, std::memory_order_relaxed);
+    });
+    assert(total.load() == count);
+
+    // Stop reaches every partition between elements
+    std::atomic<int> visited{0};
+    result = Parallel::ForEach(Numbers(count), WithDegree(4), [&visited](const int& value, ParallelLoopState& state) {
+        visited.fetch_add(1, std::memory_order_relaxed);
+        if (value == 100) {
+            state.Stop();
+        }
+    });
+    assert(!result.IsCompleted);
+    assert(result.LowestBreakIteration == LONG_MAX);
+    assert(visited.load() < count);
+
+    std::cout << "ForEach over partitioners test passed" << std::endl;
+}
+
+void test_preferred_node() {
+    using System::Threading::ThreadPool;
+
+    constexpr int count = 100000;
+    std::vector<int> hits(count, 0);
+    std::atomic<int> off_node{0};
+    ParallelOptions options;
+    options.SetPreferredNode(0);
+    Parallel::For(0, count, options, [&](int i) {
+        hits[i] += 1;
+        if (ThreadPool::GetIsThreadPoolThread() && ThreadPool::GetCurrentNode() != 0) {
+            off_node.fetch_add(1);
+        }
+    });
+    for (int i = 0; i < count; ++i) {
+        assert(hits[i] == 1);
+    }
+    // Other nodes may only join once they run dry, so only a one-node machine is exact
+    if (ThreadPool::GetNodeCount() == 1) {
+        assert(off_node.load() == 0);
+    }
+
+    // A node this machine does not have falls back to any worker
+    std::atomic<int> sum{0};
+    options.SetPreferredNode(ThreadPool::GetNodeCount() + 7);
+    Parallel::For(0, 1000, options, [&sum](int i) {
+        sum.fetch_add(i);
+    });
+    assert(sum.load() == 999 * 1000 / 2);
+
+    bool threw = false;
+    try {
+        options.SetPreferredNode(-2);
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    assert(threw);
+
+    std::cout << "Preferred node test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running Parallel tests..." << std::endl;
+
+    test_for_covers_range();
+    test_imbalanced_work_is_stolen();
+    test_max_degree_of_parallelism();
+    test_stop_and_break();
+    test_exception_propagates();
+    test_cancellation();
+    test_for_each_and_invoke();
+    test_nested_loops();
+    test_for_with_local_state();
+    test_local_state_partitions();
+    test_reduce_and_transform_reduce();
+    test_for_each_over_partitioners();
+    test_preferred_node();
+
+    std::cout << "All Parallel tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../include/System/Collections/Concurrent/Partitioner.h"
+
+using namespace System::Collections::Concurrent;
+
+// A stream of 0..count-1 that is produced on demand and never stored
+class CountingEnumerable : public System::Linq::IEnumerable<int> {
+public:
+    explicit CountingEnumerable(int count) : count_(count) {}
+
+    std::unique_ptr<System::Linq::IEnumerator<int>> GetEnumerator() override {
+        return std::make_unique<Enumerator>(count_);
+    }
+
+    std::unique_ptr<System::Linq::IEnumerator<int>> GetEnumerator() const override {
+        return std::make_unique<Enumerator>(count_);
+    }
+
+private:
+    class Enumerator : public System::Linq::IEnumerator<int> {
+    public:
+        explicit Enumerator(int count) : count_(count) {}
+        const int& Current() const override { return current_; }
+        int& Current() override { return current_; }
+        bool MoveNext() override { return ++current_ < count_; }
+        void Reset() override { current_ = -1; }
+
+    private:
+        int count_;
+        int current_ = -1;
+    };
+
+    int count_;
+};
+
+System::Coroutines::Generator<int> Numbers(int count) {
+    for (int i = 0; i < count; ++i) {
+        co_yield i;
+    }
+}
+
+System::Coroutines::Generator<int> Failing() {
+    co_yield 1;
+    throw std::runtime_error("generator failed");
+}
+
+// Drains every partition on its own thread and counts what each element was seen
+template<typename TPartitioner>
+std::vector<int> drain_concurrently(const TPartitioner& partitioner, int partitionCount, int count) {
+    auto partitions = partitioner.GetPartitions(partitionCount);
+    assert(static_cast<int>(partitions.size()) == partitionCount);
+
+    std::vector<std::atomic<int>> seen(static_cast<std::size_t>(count));
+    std::vector<std::thread> threads;
+    for (auto& partition : partitions) {
+        threads.emplace_back([&seen, &partition]() {
+            while (partition->MoveNext()) {
+                seen[static_cast<std::size_t>(partition->Current())].fetch_add(1);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int> result;
+    for (auto& value : seen) {
+        result.push_back(value.load());
+    }
+    return result;
+}
+
+bool each_once(const std::vector<int>& seen) {
+    for (int value : seen) {
+        if (value != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_range_partitioner() {
+    auto partitioner = Partitioner::Create(10L, 1010L, 64L);
+    auto partitions = partitioner.GetPartitions(3);
+
+    std::vector<int> seen(1000, 0);
+    for (auto& partition : partitions) {
+        while (partition->MoveNext()) {
+            std::pair<long, long> range = partition->Current();
+            assert(range.first < range.second && range.second - range.first <= 64);
+            for (long i = range.first; i < range.second; ++i) {
+                ++seen[static_cast<std::size_t>(i - 10)];
+            }
+        }
+    }
+    assert(each_once(seen));
+
+    // Ranges are dealt out round-robin
+    auto first = Partitioner::Create(0, 10, 2).GetPartitions(2);
+    assert(first[0]->MoveNext() && first[0]->Current() == std::make_pair(0, 2));
+    assert(first[0]->MoveNext() && first[0]->Current() == std::make_pair(4, 6));
+    assert(first[1]->MoveNext() && first[1]->Current() == std::make_pair(2, 4));
+
+    bool threw = false;
+    try {
+        Partitioner::Create(5, 5);
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    try {
+        partitioner.GetPartitions(0);
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    assert(threw);
+
+    std::cout << "Range partitioner test passed" << std::endl;
+}
+
+void test_vector_partitioner() {
+    constexpr int count = 100000;
+    std::vector<int> values(count);
+    for (int i = 0; i < count; ++i) {
+        values[i] = i;
+    }
+
+    assert(each_once(drain_concurrently(Partitioner::Create(values, false), 7, count)));
+    assert(each_once(drain_concurrently(Partitioner::Create(values, true), 7, count)));
+
+    // Elements are read in place
+    auto partitions = Partitioner::Create(values, true).GetPartitions(1);
+    assert(partitions[0]->MoveNext());
+    assert(&partitions[0]->Current() == &values[0]);
+
+    std::cout << "Vector partitioner test passed" << std::endl;
+}
+
+void test_enumerable_partitioner() {
+    constexpr int count = 100000;
+    CountingEnumerable source(count);
+
+    auto partitioner = Partitioner::Create(source);
+    assert(each_once(drain_concurrently(partitioner, 8, count)));
+    // Each GetPartitions enumerates the source again
+    assert(each_once(drain_concurrently(partitioner, 3, count)));
+
+    auto unbuffered = Partitioner::Create(source, EnumerablePartitionerOptions::NoBuffering);
+    assert(each_once(drain_concurrently(unbuffered, 4, count)));
+
+    std::cout << "Enumerable partitioner test passed" << std::endl;
+}
+
+void test_generator_partitioner() {
+    constexpr int count = 100000;
+    auto partitioner = Partitioner::Create(Numbers(count));
+    assert(each_once(drain_concurrently(partitioner, 8, count)));
+
+    // A generator only runs once
+    bool threw = false;
+    try {
+        partitioner.GetPartitions(2);
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // An exception from the generator reaches the partition that hit it, after
+    // which the stream is over for everyone
+    auto failing = Partitioner::Create(Failing()).GetPartitions(2);
+    assert(failing[0]->MoveNext() && failing[0]->Current() == 1);
+    threw = false;
+    try {
+        failing[1]->MoveNext();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(!failing[0]->MoveNext());
+
+    std::cout << "Generator partitioner test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running Partitioner tests..." << std::endl;
+
+    test_range_partitioner();
+    test_vector_partitioner();
+    test_enumerable_partitioner();
+    test_generator_partitioner();
+
+    std::cout << "All Partitioner tests passed!" << std::endl;
+    return 0;
+}
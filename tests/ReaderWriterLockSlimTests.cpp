@@ -1,9 +1,11 @@
 
 #include <iostream>
 #include <thread>
+#include <atomic>
 #include <vector>
 #include <cassert>
 #include <chrono>
+#include <algorithm>
 #include "../include/System/Threading/ReaderWriterLockSlim.hpp"
 
 using namespace System::Threading;
@@ -161,6 +163,97 @@ void test_recursion_policy_no_recursion() {
     std::cout << "No recursion policy test passed" << std::endl;
 }
 
+void test_upgrade_to_write_lock() {
+    ReaderWriterLockSlim lock;
+    int value = 0;
+    
+    // A reader on another thread holds the lock on the biased fast path
+    std::atomic<bool> reader_inside(false);
+    std::atomic<bool> release_reader(false);
+    std::thread reader([&]() {
+        lock.enter_read_lock();
+        reader_inside.store(true);
+        while (!release_reader.load()) {
+            std::this_thread::yield();
+        }
+        lock.exit_read_lock();
+    });
+    while (!reader_inside.load()) {
+        std::this_thread::yield();
+    }
+    
+    lock.enter_upgradeable_read_lock();
+    std::thread releaser([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        release_reader.store(true);
+    });
+    
+    // Waits for the reader, not for this thread's own upgradeable lock
+    lock.enter_write_lock();
+    assert(lock.is_write_lock_held());
+    assert(lock.get_current_read_count() == 1);
+    value = 1;
+    lock.exit_write_lock();
+    
+    assert(lock.is_upgradeable_read_lock_held());
+    lock.exit_upgradeable_read_lock();
+    reader.join();
+    releaser.join();
+    assert(value == 1);
+    
+    std::cout << "Upgrade to write lock test passed" << std::endl;
+}
+
+void test_concurrent_readers_and_writers() {
+    ReaderWriterLockSlim lock;
+    // Writers keep the two halves equal; a reader seeing them differ saw a torn write
+    long long first = 0;
+    long long second = 0;
+    std::atomic<bool> torn(false);
+    std::atomic<bool> stop(false);
+    // Spinning readers crowd out the writers when there are fewer cores than
+    // threads, so every write costs a time slice there; scale the work to the cores
+    int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int writes = 100 * std::min(cores, 16);
+    
+    std::vector<std::thread> threads;
+    for (int r = 0; r < 4; ++r) {
+        threads.emplace_back([&]() {
+            while (!stop.load()) {
+                lock.enter_read_lock();
+                if (first != second) {
+                    torn.store(true);
+                }
+                lock.exit_read_lock();
+            }
+        });
+    }
+    for (int w = 0; w < 2; ++w) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < writes; ++i) {
+                lock.enter_write_lock();
+                ++first;
+                std::this_thread::yield();
+                ++second;
+                lock.exit_write_lock();
+            }
+        });
+    }
+    
+    threads[4].join();
+    threads[5].join();
+    stop.store(true);
+    for (int r = 0; r < 4; ++r) {
+        threads[r].join();
+    }
+    
+    assert(!torn.load());
+    assert(first == 2 * writes && second == 2 * writes);
+    assert(lock.get_current_read_count() == 0);
+    
+    std::cout << "Concurrent readers and writers test passed" << std::endl;
+}
+
 int main() {
     std::cout << "Running ReaderWriterLockSlim tests..." << std::endl;
     
@@ -171,6 +264,8 @@ int main() {
     test_writer_exclusivity();
     test_try_locks();
     test_recursion_policy_no_recursion();
+    test_upgrade_to_write_lock();
+    test_concurrent_readers_and_writers();
     
     std::cout << "All ReaderWriterLockSlim tests passed!" << std::endl;
     return 0;
@@ -0,0 +1,236 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cassert>
+#include <chrono>
+#include <atomic>
+#include <stdexcept>
+#include "../include/System/Threading/SemaphoreSlim.hpp"
+
+using namespace System::Threading;
+
+void test_basic_functionality() {
+    SemaphoreSlim semaphore(2, 3);
+    assert(semaphore.get_current_count() == 2);
+    
+    // Permits are available: both waits complete synchronously
+    semaphore.wait();
+    TaskOf<bool> acquired = semaphore.wait_async(0);
+    assert(acquired.is_completed() && acquired.get_result());
+    assert(semaphore.get_current_count() == 0);
+    
+    assert(!semaphore.wait(0));
+    assert(!semaphore.wait_async(0).get_result());
+    
+    assert(semaphore.release() == 0);
+    assert(semaphore.release(2) == 1);
+    assert(semaphore.get_current_count() == 3);
+    
+    bool threw = false;
+    try {
+        semaphore.release();
+    } catch (const SemaphoreFullException&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(semaphore.get_current_count() == 3);
+    
+    threw = false;
+    try {
+        SemaphoreSlim invalid(2, 1);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    std::cout << "Basic functionality test passed" << std::endl;
+}
+
+void test_fifo_release() {
+    SemaphoreSlim semaphore(0);
+    
+    std::vector<Task> waiters;
+    for (int i = 0; i < 3; ++i) {
+        waiters.push_back(semaphore.wait_async());
+    }
+    for (auto& waiter : waiters) {
+        assert(!waiter.is_completed());
+    }
+    
+    // Permits go to the oldest waiters and never reach the count
+    assert(semaphore.release(2) == 0);
+    assert(waiters[0].is_completed_successfully());
+    assert(waiters[1].is_completed_successfully());
+    assert(!waiters[2].is_completed());
+    assert(semaphore.get_current_count() == 0);
+    
+    semaphore.release(2);
+    assert(waiters[2].is_completed_successfully());
+    assert(semaphore.get_current_count() == 1);
+    
+    std::cout << "FIFO release test passed" << std::endl;
+}
+
+void test_timeout_removes_waiter() {
+    SemaphoreSlim semaphore(0);
+    
+    TaskOf<bool> timed = semaphore.wait_async(20);
+    TaskOf<bool> untimed = semaphore.wait_async(-1);
+    assert(!timed.get_result());
+    
+    // The expired waiter left the queue: the permit goes to the one behind it
+    semaphore.release();
+    assert(untimed.get_result());
+    assert(semaphore.get_current_count() == 0);
+    
+    auto start = std::chrono::steady_clock::now();
+    assert(!semaphore.wait(std::chrono::milliseconds(30)));
+    assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(30));
+    
+    semaphore.release();
+    assert(semaphore.get_current_count() == 1);
+    
+    std::cout << "Timeout removes waiter test passed" << std::endl;
+}
+
+void test_cancellation_removes_waiter() {
+    SemaphoreSlim semaphore(0);
+    CancellationTokenSource source;
+    
+    Task canceled = semaphore.wait_async(source.get_token());
+    TaskOf<bool> behind = semaphore.wait_async(-1);
+    source.cancel();
+    assert(canceled.is_canceled());
+    
+    semaphore.release();
+    assert(behind.get_result());
+    
+    // A blocking wait is canceled from another thread
+    CancellationTokenSource blocking_source;
+    std::thread canceler([&blocking_source]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        blocking_source.cancel();
+    });
+    bool threw = false;
+    try {
+        semaphore.wait(blocking_source.get_token());
+    } catch (const OperationCanceledException&) {
+        threw = true;
+    }
+    canceler.join();
+    assert(threw);
+    
+    // Already canceled: no permit is taken even though one is available
+    semaphore.release();
+    Task precanceled = semaphore.wait_async(blocking_source.get_token());
+    assert(precanceled.is_canceled());
+    assert(semaphore.get_current_count() == 1);
+    
+    std::cout << "Cancellation removes waiter test passed" << std::endl;
+}
+
+void test_throttling() {
+    constexpr int logical_waiters = 10000;
+    constexpr int limit = 4;
+    
+    SemaphoreSlim semaphore(limit);
+    std::atomic<int> active{0};
+    std::atomic<int> peak{0};
+    std::atomic<int> finished{0};
+    
+    // Every waiter is a queued task, not a blocked thread; each one that gets
+    // a permit does its work and passes the permit on
+    std::vector<Task> tasks;
+    tasks.reserve(logical_waiters);
+    for (int i = 0; i < logical_waiters; ++i) {
+        TaskOf<bool> acquired = semaphore.wait_async(-1);
+        tasks.push_back(acquired.continue_with([&](TaskOf<bool>&) {
+            int now = active.fetch_add(1) + 1;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+            }
+            active.fetch_sub(1);
+            finished.fetch_add(1);
+            semaphore.release();
+        }));
+    }
+    Task::wait_all(tasks);
+    
+    assert(finished.load() == logical_waiters);
+    assert(peak.load() <= limit);
+    assert(semaphore.get_current_count() == limit);
+    
+    // Blocking waiters on several threads share the same queue
+    std::vector<std::thread> threads;
+    std::atomic<int> blocking_finished{0};
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 1000; ++i) {
+                semaphore.wait();
+                blocking_finished.fetch_add(1);
+                semaphore.release();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    assert(blocking_finished.load() == 8000);
+    assert(semaphore.get_current_count() == limit);
+    
+    std::cout << "Throttling test passed" << std::endl;
+}
+
+void test_blocking_handoff() {
+    // Two threads pass one permit back and forth, so most waits find it released
+    // while they spin; none may be lost or taken twice
+    constexpr int rounds = 5000;
+    SemaphoreSlim ping(0, 1);
+    SemaphoreSlim pong(0, 1);
+    int value = 0;
+    
+    std::thread partner([&]() {
+        for (int i = 0; i < rounds; ++i) {
+            ping.wait();
+            ++value;
+            pong.release();
+        }
+    });
+    for (int i = 0; i < rounds; ++i) {
+        ping.release();
+        assert(pong.wait(30000));
+        assert(value == i + 1);
+    }
+    partner.join();
+    assert(ping.get_current_count() == 0);
+    assert(pong.get_current_count() == 0);
+    
+    // A cancellation seen while spinning throws without queueing
+    SemaphoreSlim empty(0);
+    CancellationTokenSource cts;
+    cts.cancel_after(20);
+    bool threw = false;
+    try {
+        empty.wait(cts.get_token());
+    } catch (const OperationCanceledException&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(empty.get_current_count() == 0);
+    
+    std::cout << "Blocking handoff test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running SemaphoreSlim tests..." << std::endl;
+    
+    test_basic_functionality();
+    test_fifo_release();
+    test_timeout_removes_waiter();
+    test_cancellation_removes_waiter();
+    test_throttling();
+    test_blocking_handoff();
+    
+    std::cout << "All SemaphoreSlim tests passed!" << std::endl;
+    return 0;
+}
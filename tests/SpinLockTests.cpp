@@ -0,0 +1,155 @@
+#include <iostream>
+#include <thread>
+#include <cassert>
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <stdexcept>
+#include "../include/System/Threading/SpinLock.h"
+
+using namespace System::Threading;
+
+void test_basic_enter_exit() {
+    SpinLock lock(true);
+    assert(!lock.GetIsHeld());
+
+    bool taken = false;
+    lock.Enter(taken);
+    assert(taken);
+    assert(lock.GetIsHeld());
+    assert(lock.GetIsHeldByCurrentThread());
+
+    // Owner tracking rejects recursion and a stale lockTaken
+    bool threw = false;
+    try {
+        bool again = false;
+        lock.Enter(again);
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    lock.Exit();
+    assert(!lock.GetIsHeld());
+    assert(!lock.GetIsHeldByCurrentThread());
+
+    threw = false;
+    try {
+        lock.Exit();
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // Without tracking, exiting a lock nobody holds is still rejected
+    SpinLock untracked(false);
+    threw = false;
+    try {
+        untracked.Exit();
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(!untracked.GetIsHeld());
+
+    std::cout << "Basic enter/exit test passed" << std::endl;
+}
+
+void test_try_enter_timeout() {
+    SpinLock lock(false);
+    bool taken = false;
+    lock.Enter(taken);
+
+    std::thread other([&lock]() {
+        bool other_taken = false;
+        assert(!lock.TryEnter(other_taken));
+        assert(!lock.TryEnter(20, other_taken));
+        assert(!other_taken);
+    });
+    other.join();
+    lock.Exit();
+
+    std::thread later([&lock]() {
+        bool later_taken = false;
+        assert(lock.TryEnter(System::TimeSpan::FromMilliseconds(20), later_taken));
+        assert(later_taken);
+        lock.Exit();
+    });
+    later.join();
+
+    std::cout << "TryEnter timeout test passed" << std::endl;
+}
+
+void test_mutual_exclusion_and_statistics() {
+    constexpr int threads_count = 8;
+    constexpr int iterations = 20000;
+
+    SpinLock lock(false, true);
+    long long counter = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threads_count; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < iterations; ++i) {
+                bool taken = false;
+                lock.Enter(taken);
+                ++counter;
+                lock.Exit();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    assert(counter == static_cast<long long>(threads_count) * iterations);
+    SpinLockStatistics statistics = lock.GetStatistics();
+    assert(statistics.Acquisitions == counter);
+    assert(statistics.ContendedAcquisitions <= statistics.Acquisitions);
+
+    lock.ResetStatistics();
+    assert(lock.GetStatistics().Acquisitions == 0);
+
+    std::cout << "Mutual exclusion and statistics test passed" << std::endl;
+}
+
+void test_fifo_handoff() {
+    SpinLock lock(true);
+    bool taken = false;
+    lock.Enter(taken);
+
+    // Waiters queue up one at a time while the lock is held...
+    constexpr int waiters = 4;
+    std::vector<int> order;
+    std::vector<std::thread> threads;
+    for (int w = 0; w < waiters; ++w) {
+        threads.emplace_back([&lock, &order, w]() {
+            bool waiter_taken = false;
+            lock.Enter(waiter_taken);
+            order.push_back(w);
+            lock.Exit();
+        });
+        // ...and are only released in that order once it is
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    lock.Exit();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    assert((order == std::vector<int>{0, 1, 2, 3}));
+
+    std::cout << "FIFO hand-off test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running SpinLock tests..." << std::endl;
+
+    test_basic_enter_exit();
+    test_try_enter_timeout();
+    test_mutual_exclusion_and_statistics();
+    test_fifo_handoff();
+
+    std::cout << "All SpinLock tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,273 @@
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include "../include/System/Threading/SingleThreadSynchronizationContext.h"
+#include "../include/System/Threading/Task.hpp"
+#include "../include/System/Threading/TaskCompletionSource.hpp"
+
+using namespace System::Threading;
+
+void test_run_until_complete() {
+    auto context = std::make_shared<SingleThreadSynchronizationContext>();
+    const int producers = 4;
+    const int per_producer = 10000;
+
+    // Only the loop's thread touches these, so plain ints suffice
+    std::vector<int> last_seen(producers, -1);
+    int ran = 0;
+    bool in_order = true;
+    std::thread::id loop_thread;
+    std::atomic<bool> off_thread{false};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < per_producer; ++i) {
+                context->Post([&, p, i](void*) {
+                    if (std::this_thread::get_id() != loop_thread) {
+                        off_thread = true;
+                    }
+                    in_order = in_order && last_seen[p] == i - 1;
+                    last_seen[p] = i;
+                    ++ran;
+                }, nullptr);
+            }
+        });
+    }
+
+    std::thread completer([&threads, context]() {
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        context->Complete();
+    });
+
+    loop_thread = std::this_thread::get_id();
+    context->Run();
+    completer.join();
+
+    assert(ran == producers * per_producer);
+    assert(in_order);
+    assert(!off_thread);
+    assert(!context->IsOwnerThread());
+
+    std::cout << "Run until complete test passed" << std::endl;
+}
+
+TaskOf<int> sum_on_loop(std::vector<TaskCompletionSource<int>>& sources, std::thread::id loop_thread,
+                      std::atomic<int>& off_thread) {
+    int sum = 0;
+    for (auto& source : sources) {
+        sum += co_await source.get_task();
+        if (std::this_thread::get_id() != loop_thread) {
+            off_thread.fetch_add(1);
+        }
+    }
+    co_return sum;
+}
+
+TaskOf<int> sum_anywhere(std::vector<TaskCompletionSource<int>>& sources, std::thread::id loop_thread,
+                       std::atomic<int>& off_thread) {
+    int sum = 0;
+    for (auto& source : sources) {
+        sum += co_await source.get_task().configure_await(false);
+        if (std::this_thread::get_id() != loop_thread) {
+            off_thread.fetch_add(1);
+        }
+    }
+    co_return sum;
+}
+
+void test_run_until_task() {
+    auto context = std::make_shared<SingleThreadSynchronizationContext>();
+    const int count = 100;
+    std::vector<TaskCompletionSource<int>> captured(count);
+    std::vector<TaskCompletionSource<int>> uncaptured(count);
+    std::atomic<int> captured_off_thread{0};
+    std::atomic<int> uncaptured_off_thread{0};
+
+    // Continuations capture the context that is current when the coroutine awaits
+    SynchronizationContext::SetSynchronizationContext(context);
+    auto on_loop = sum_on_loop(captured, std::this_thread::get_id(), captured_off_thread);
+    auto anywhere = sum_anywhere(uncaptured, std::this_thread::get_id(), uncaptured_off_thread);
+
+    std::thread completer([&]() {
+        for (int i = 0; i < count; ++i) {
+            captured[i].set_result(i);
+            uncaptured[i].set_result(i);
+        }
+    });
+
+    context->RunUntil(on_loop);
+    completer.join();
+    assert(SynchronizationContext::Current() == context);
+    SynchronizationContext::SetSynchronizationContext(nullptr);
+
+    assert(on_loop.get_result() == count * (count - 1) / 2);
+    assert(captured_off_thread.load() == 0);
+    assert(anywhere.get_result() == count * (count - 1) / 2);
+    assert(uncaptured_off_thread.load() == count);
+
+    // A completed task only lets what is already queued run
+    int ran = 0;
+    context->Post([&ran](void*) { ++ran; }, nullptr);
+    context->RunUntil(Task::from_result(0));
+    assert(ran == 1);
+
+    std::cout << "Run until task test passed" << std::endl;
+}
+
+void tick(SingleThreadSynchronizationContext& context, int& ticks) {
+    context.Post([&context, &ticks](void*) {
+        ++ticks;
+        tick(context, ticks);
+    }, nullptr);
+}
+
+void test_reposting_callback() {
+    auto context = std::make_shared<SingleThreadSynchronizationContext>();
+    TaskCompletionSource<int> stop;
+    std::atomic<bool> started{false};
+    int ticks = 0;
+
+    // Always has work queued, so only batching lets the loop see the task complete
+    context->Post([&](void*) {
+        started = true;
+        tick(*context, ticks);
+    }, nullptr);
+    std::thread stopper([&]() {
+        while (!started) {
+            std::this_thread::yield();
+        }
+        stop.set_result(0);
+    });
+
+    context->RunUntil(stop.get_task());
+    stopper.join();
+    assert(ticks > 0);
+
+    std::cout << "Reposting callback test passed" << std::endl;
+}
+
+void test_wakes_sleeping_loop() {
+    auto context = std::make_shared<SingleThreadSynchronizationContext>();
+    const int rounds = 50;
+    TaskCompletionSource<int> done;
+    std::vector<int> order;
+
+    // Posts arrive one at a time with gaps, so the loop goes to sleep before each
+    // one; each callback also posts from the loop's own thread
+    std::thread producer([&]() {
+        for (int i = 0; i < rounds; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            context->Post([&, i](void*) {
+                order.push_back(2 * i);
+                context->Post([&, i](void*) {
+                    order.push_back(2 * i + 1);
+                    if (i == rounds - 1) {
+                        done.set_result(0);
+                    }
+                }, nullptr);
+            }, nullptr);
+        }
+    });
+
+    context->RunUntil(done.get_task());
+    producer.join();
+
+    // Each producer's posts run in order, and a local post after the one that made it
+    assert(order.size() == 2 * rounds);
+    std::vector<int> position(2 * rounds, -1);
+    for (int i = 0; i < 2 * rounds; ++i) {
+        position[order[i]] = i;
+    }
+    for (int i = 0; i < rounds; ++i) {
+        assert(position[2 * i] < position[2 * i + 1]);
+        assert(i == 0 || position[2 * (i - 1)] < position[2 * i]);
+    }
+
+    std::cout << "Wakes sleeping loop test passed" << std::endl;
+}
+
+void test_send() {
+    auto context = std::make_shared<SingleThreadSynchronizationContext>();
+    std::thread::id loop_thread = std::this_thread::get_id();
+    std::atomic<bool> sent_on_loop{false};
+    std::atomic<bool> rethrown{false};
+
+    std::thread sender([&]() {
+        int value = 0;
+        context->Send([&](void* state) {
+            sent_on_loop = std::this_thread::get_id() == loop_thread;
+            *static_cast<int*>(state) = 42;
+        }, &value);
+        assert(value == 42);
+
+        try {
+            context->Send([](void*) { throw std::runtime_error("send"); }, nullptr);
+        } catch (const std::runtime_error&) {
+            rethrown = true;
+        }
+        context->Complete();
+    });
+
+    context->Run();
+    sender.join();
+    assert(sent_on_loop);
+    assert(rethrown);
+
+    // On the loop's own thread Send runs inline instead of waiting on itself
+    bool inline_ran = false;
+    context->Post([&](void*) {
+        context->Send([&](void*) { inline_ran = true; }, nullptr);
+    }, nullptr);
+    context->Run();
+    assert(inline_ran);
+
+    std::cout << "Send test passed" << std::endl;
+}
+
+void test_callback_exception() {
+    auto context = std::make_shared<SingleThreadSynchronizationContext>();
+    bool later_ran = false;
+    context->Post([](void*) { throw std::runtime_error("post"); }, nullptr);
+    context->Post([&later_ran](void*) { later_ran = true; }, nullptr);
+
+    bool thrown = false;
+    try {
+        context->RunUntil(Task::from_result(0));
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    assert(!later_ran);
+    assert(!SynchronizationContext::Current());
+    assert(!context->IsOwnerThread());
+
+    // The loop can be entered again and picks up where it stopped
+    context->Complete();
+    context->Run();
+    assert(later_ran);
+
+    std::cout << "Callback exception test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running SynchronizationContext tests..." << std::endl;
+
+    test_run_until_complete();
+    test_run_until_task();
+    test_reposting_callback();
+    test_wakes_sleeping_loop();
+    test_send();
+    test_callback_exception();
+
+    std::cout << "All SynchronizationContext tests passed!" << std::endl;
+    return 0;
+}
@@ -2,7 +2,12 @@
 #include <iostream>
 #include <cassert>
 #include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <functional>
 #include "../include/System/Threading/Task.hpp"
+#include "../include/System/Threading/TaskCompletionSource.hpp"
 
 using namespace System::Threading;
 
@@ -57,7 +62,7 @@ void test_task_continuation() {
         return 10;
     });
     
-    auto task2 = task1.continue_with<int>([](Task<int>& antecedent) {
+    auto task2 = task1.continue_with<int>([](TaskOf<int>& antecedent) {
         int result = antecedent.get_result();
         return result * 2;
     });
@@ -68,6 +73,78 @@ void test_task_continuation() {
     std::cout << "Task continuation test passed" << std::endl;
 }
 
+void test_continuation_chain() {
+    auto task = Task::run([]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return 1;
+    });
+    
+    // Every link registers before its antecedent completes; none of them may
+    // block a thread while waiting
+    auto add_one = [](TaskOf<int>& antecedent) {
+        return antecedent.get_result() + 1;
+    };
+    auto second = task.continue_with<int>(add_one);
+    auto third = second.continue_with<int>(add_one);
+    auto fourth = third.continue_with<int>(add_one);
+    
+    assert(fourth.get_result() == 4);
+    assert(second.is_completed_successfully());
+    assert(third.is_completed_successfully());
+    
+    std::cout << "Continuation chain test passed" << std::endl;
+}
+
+void test_continuations_racing_completion() {
+    // Registrations race the antecedent's completion: each continuation lands on the
+    // list before it is drained or sees the task completed, and runs exactly once
+    constexpr int registrars = 4;
+    constexpr int per_registrar = 250;
+    for (int round = 0; round < 20; ++round) {
+        TaskCompletionSource<int> source;
+        TaskOf<int> antecedent = source.get_task();
+        std::atomic<int> ran{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        for (int r = 0; r < registrars; ++r) {
+            threads.emplace_back([&]() {
+                while (!go.load()) {
+                    std::this_thread::yield();
+                }
+                for (int i = 0; i < per_registrar; ++i) {
+                    antecedent.continue_with([&ran](TaskOf<int>&) {
+                        ran.fetch_add(1);
+                    }, TaskContinuationOptions::ExecuteSynchronously);
+                }
+            });
+        }
+        go = true;
+        source.set_result(round);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        assert(ran.load() == registrars * per_registrar);
+    }
+    
+    std::cout << "Continuations racing completion test passed" << std::endl;
+}
+
+void test_execute_synchronously_continuation() {
+    auto task = Task::run([]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return std::this_thread::get_id();
+    });
+    
+    auto continuation = task.continue_with<std::thread::id>([](TaskOf<std::thread::id>&) {
+        return std::this_thread::get_id();
+    }, TaskContinuationOptions::ExecuteSynchronously);
+    
+    // Runs on the thread that completed the antecedent
+    assert(continuation.get_result() == task.get_result());
+    
+    std::cout << "ExecuteSynchronously continuation test passed" << std::endl;
+}
+
 void test_task_delay() {
     auto start_time = std::chrono::steady_clock::now();
     
@@ -102,6 +179,26 @@ void test_from_result() {
     std::cout << "From result test passed" << std::endl;
 }
 
+void test_cached_completed_tasks() {
+    auto first = Task::from_result(true);
+    auto second = Task::from_result(true);
+    assert(first.get_result() && second.get_result());
+    assert(Task::from_result(7).get_result() == 7);
+    assert(Task::from_result(1000).get_result() == 1000);
+    
+    // Copies share the same completion
+    TaskCompletionSource<int> tcs;
+    auto task = tcs.get_task();
+    auto copy = task;
+    assert(!copy.is_completed());
+    tcs.set_result(5);
+    assert(task.get_result() == 5);
+    assert(copy.get_result() == 5);
+    assert(!tcs.try_set_result(6));
+    
+    std::cout << "Cached completed tasks test passed" << std::endl;
+}
+
 void test_from_exception() {
     auto exception = std::make_exception_ptr(std::runtime_error("Test error"));
     auto task = Task::from_exception(exception);
@@ -132,6 +229,266 @@ void test_wait_timeout() {
     std::cout << "Wait timeout test passed" << std::endl;
 }
 
+void test_wait_any() {
+    std::vector<Task> tasks;
+    tasks.push_back(Task::delay(500));
+    tasks.push_back(Task::delay(20));
+    
+    auto start_time = std::chrono::steady_clock::now();
+    int index = Task::wait_any(tasks);
+    auto elapsed = std::chrono::steady_clock::now() - start_time;
+    
+    assert(index == 1);
+    assert(elapsed < std::chrono::milliseconds(400));
+    
+    // Timeout reports -1
+    std::vector<Task> slow;
+    slow.push_back(Task::delay(200));
+    assert(Task::wait_any(slow, 20) == -1);
+    
+    std::cout << "Wait any test passed" << std::endl;
+}
+
+void test_wait_all() {
+    std::atomic<int> counter{0};
+    std::vector<Task> tasks;
+    for (int i = 0; i < 8; ++i) {
+        tasks.push_back(Task::run([&counter]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            ++counter;
+        }));
+    }
+    
+    Task::wait_all(tasks);
+    assert(counter == 8);
+    
+    std::vector<Task> slow;
+    slow.push_back(Task::delay(200));
+    assert(!Task::wait_all(slow, 20));
+    
+    // Timed and untimed overloads rethrow the same fault once everything has completed
+    std::vector<Task> with_fault;
+    with_fault.push_back(Task::delay(10));
+    with_fault.push_back(Task::from_exception(std::make_exception_ptr(std::runtime_error("Test error"))));
+    int rethrown = 0;
+    CancellationTokenSource cts;
+    std::vector<std::function<void()>> waits = {
+        [&]() { Task::wait_all(with_fault); },
+        [&]() { Task::wait_all(with_fault, 1000); },
+        [&]() { Task::wait_all(with_fault, cts.get_token()); },
+        [&]() { Task::wait_all(with_fault, 1000, cts.get_token()); },
+    };
+    for (auto& wait : waits) {
+        try {
+            wait();
+        } catch (const std::runtime_error& e) {
+            assert(std::string(e.what()) == "Test error");
+            ++rethrown;
+        }
+    }
+    assert(rethrown == 4);
+    
+    std::cout << "Wait all test passed" << std::endl;
+}
+
+void test_wait_all_cancellation() {
+    CancellationTokenSource cts;
+    std::vector<Task> tasks;
+    tasks.push_back(Task::delay(500));
+    
+    auto canceler = Task::run([&cts]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        cts.cancel();
+    });
+    
+    try {
+        Task::wait_all(tasks, cts.get_token());
+        assert(false); // Should not reach here
+    } catch (const OperationCanceledException&) {
+        // Expected
+    }
+    
+    canceler.wait();
+    
+    std::cout << "Wait all cancellation test passed" << std::endl;
+}
+
+void test_when_all() {
+    std::vector<Task> tasks;
+    tasks.push_back(Task::delay(20));
+    tasks.push_back(Task::completed_task());
+    
+    auto all = Task::when_all(tasks);
+    all.wait();
+    assert(all.is_completed_successfully());
+    
+    std::vector<Task> with_fault;
+    with_fault.push_back(Task::delay(10));
+    with_fault.push_back(Task::from_exception(std::make_exception_ptr(std::runtime_error("Test error"))));
+    
+    auto faulted = Task::when_all(with_fault);
+    try {
+        faulted.wait();
+        assert(false); // Should not reach here
+    } catch (const std::runtime_error& e) {
+        assert(std::string(e.what()) == "Test error");
+    }
+    
+    std::cout << "When all test passed" << std::endl;
+}
+
+void test_when_any() {
+    std::vector<Task> tasks;
+    tasks.push_back(Task::delay(500));
+    tasks.push_back(Task::delay(10));
+    
+    auto any = Task::when_any(tasks);
+    assert(any.get_result() == 1);
+    
+    std::cout << "When any test passed" << std::endl;
+}
+
+TaskOf<int> add_after(TaskOf<int> antecedent, int amount) {
+    int value = co_await antecedent;
+    co_return value + amount;
+}
+
+TaskOf<int> await_chain(TaskOf<int> leaf, int depth) {
+    if (depth == 0) {
+        co_return co_await leaf;
+    }
+    int inner = co_await await_chain(leaf, depth - 1);
+    co_return inner + 1;
+}
+
+Task throw_after(Task antecedent) {
+    co_await antecedent;
+    throw std::runtime_error("Coroutine error");
+}
+
+TaskOf<int> resume_on(TaskOf<int> antecedent, bool continue_on_captured_context) {
+    co_return co_await antecedent.configure_await(continue_on_captured_context);
+}
+
+TaskOf<int> sum_of_runs(int count) {
+    int sum = 0;
+    for (int i = 0; i < count; ++i) {
+        sum += co_await Task::run([i]() { return i; });
+    }
+    co_return sum;
+}
+
+Task count_after(Task antecedent, std::atomic<int>& finished) {
+    co_await antecedent;
+    finished.fetch_add(1);
+}
+
+class CountingContext : public SynchronizationContext {
+public:
+    std::atomic<int> posts{0};
+    
+    void Post(std::function<void(void*)> callback, void* state) override {
+        posts.fetch_add(1);
+        SynchronizationContext::Post(std::move(callback), state);
+    }
+};
+
+void test_coroutine_await() {
+    // Completed antecedent: runs to completion without suspending
+    auto immediate = add_after(Task::from_result(1), 1);
+    assert(immediate.is_completed_successfully());
+    assert(immediate.get_result() == 2);
+    
+    TaskCompletionSource<int> tcs;
+    auto task = add_after(tcs.get_task(), 2);
+    assert(!task.is_completed());
+    tcs.set_result(40);
+    assert(task.get_result() == 42);
+    
+    std::cout << "Coroutine await test passed" << std::endl;
+}
+
+void test_coroutine_exception() {
+    TaskCompletionSource<void> tcs;
+    auto task = throw_after(tcs.get_task());
+    tcs.set_result();
+    
+    assert(task.is_faulted());
+    try {
+        task.wait();
+        assert(false); // Should not reach here
+    } catch (const std::runtime_error& e) {
+        assert(std::string(e.what()) == "Coroutine error");
+    }
+    
+    // A faulted antecedent rethrows at the await
+    TaskCompletionSource<int> faulted;
+    faulted.set_exception(std::runtime_error("Inner"));
+    auto propagated = add_after(faulted.get_task(), 1);
+    assert(propagated.is_faulted());
+    
+    std::cout << "Coroutine exception test passed" << std::endl;
+}
+
+void test_coroutine_deep_chain() {
+    constexpr int depth = 1000;
+    TaskCompletionSource<int> tcs;
+    auto top = await_chain(tcs.get_task(), depth);
+    assert(!top.is_completed());
+    
+    // The whole chain unwinds on this thread before set_result returns
+    tcs.set_result(1);
+    assert(top.is_completed());
+    assert(top.get_result() == depth + 1);
+    
+    std::cout << "Coroutine deep chain test passed" << std::endl;
+}
+
+void test_coroutine_across_threads() {
+    // Each await resumes on whichever pool thread completed the awaited task
+    constexpr int coroutines = 64;
+    constexpr int awaits = 50;
+    std::vector<TaskOf<int>> sums;
+    for (int i = 0; i < coroutines; ++i) {
+        sums.push_back(sum_of_runs(awaits));
+    }
+    for (auto& sum : sums) {
+        assert(sum.get_result() == awaits * (awaits - 1) / 2);
+    }
+    
+    // A coroutine whose task nobody holds keeps its frame until it finishes
+    std::atomic<int> finished{0};
+    TaskCompletionSource<void> gate;
+    for (int i = 0; i < coroutines; ++i) {
+        count_after(gate.get_task(), finished);
+    }
+    assert(finished.load() == 0);
+    gate.set_result();
+    assert(finished.load() == coroutines);
+    
+    std::cout << "Coroutine across threads test passed" << std::endl;
+}
+
+void test_configure_await() {
+    auto context = std::make_shared<CountingContext>();
+    SynchronizationContext::SetSynchronizationContext(context);
+    TaskCompletionSource<int> captured_source;
+    TaskCompletionSource<int> uncaptured_source;
+    auto captured = resume_on(captured_source.get_task(), true);
+    auto uncaptured = resume_on(uncaptured_source.get_task(), false);
+    SynchronizationContext::SetSynchronizationContext(nullptr);
+    
+    uncaptured_source.set_result(1);
+    assert(uncaptured.is_completed());
+    assert(context->posts.load() == 0);
+    
+    captured_source.set_result(2);
+    assert(captured.get_result() == 2);
+    assert(context->posts.load() == 1);
+    
+    std::cout << "Configure await test passed" << std::endl;
+}
+
 int main() {
     std::cout << "Running Task tests..." << std::endl;
     
@@ -139,11 +496,25 @@ int main() {
     test_void_task();
     test_task_exception();
     test_task_continuation();
+    test_continuation_chain();
+    test_continuations_racing_completion();
+    test_execute_synchronously_continuation();
     test_task_delay();
     test_completed_task();
     test_from_result();
+    test_cached_completed_tasks();
     test_from_exception();
     test_wait_timeout();
+    test_wait_any();
+    test_wait_all();
+    test_wait_all_cancellation();
+    test_when_all();
+    test_when_any();
+    test_coroutine_await();
+    test_coroutine_exception();
+    test_coroutine_deep_chain();
+    test_coroutine_across_threads();
+    test_configure_await();
     
     std::cout << "All Task tests passed!" << std::endl;
     return 0;
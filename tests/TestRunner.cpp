@@ -87,13 +87,13 @@ using namespace System::Threading;
 void test_basic_compilation() {
     // Just test that everything compiles and basic functionality works
     AsyncLocal<int> async_local;
-    ThreadLocal<std::string> thread_local;
+    ThreadLocal<std::string> thread_local_value;
     
     async_local.set(42);
     ASSERT_EQ(42, async_local.get());
     
-    thread_local.set("test");
-    ASSERT_EQ("test", thread_local.get());
+    thread_local_value.set("test");
+    ASSERT_EQ("test", thread_local_value.get());
 }
 
 void test_task_basic() {
@@ -3,40 +3,44 @@
 #include <thread>
 #include <vector>
 #include <cassert>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include "../include/System/Threading/ThreadLocal.hpp"
 
 using namespace System::Threading;
 
 void test_basic_functionality() {
-    ThreadLocal<int> thread_local;
+    ThreadLocal<int> local;
     
     // Initially should not be created
-    assert(!thread_local.is_value_created());
+    assert(!local.is_value_created());
     
     // Access should create default value
-    int& value = thread_local.get();
-    assert(thread_local.is_value_created());
+    int& value = local.get();
+    assert(local.is_value_created());
     assert(value == 0); // Default int value
     
     // Set a value
-    thread_local.set(42);
-    assert(thread_local.get() == 42);
+    local.set(42);
+    assert(local.get() == 42);
     
     std::cout << "Basic functionality test passed" << std::endl;
 }
 
 void test_thread_isolation() {
-    ThreadLocal<int> thread_local;
+    ThreadLocal<int> local;
     std::vector<std::thread> threads;
     std::vector<bool> results(5, false);
     
     for (int i = 0; i < 5; ++i) {
-        threads.emplace_back([&thread_local, &results, i]() {
+        threads.emplace_back([&local, &results, i]() {
             // Each thread sets its own value
-            thread_local.set(i * 10);
+            local.set(i * 10);
             
             // Verify the value is correct for this thread
-            if (thread_local.get() == i * 10) {
+            if (local.get() == i * 10) {
                 results[i] = true;
             }
         });
@@ -55,26 +59,26 @@ void test_thread_isolation() {
 }
 
 void test_value_factory() {
-    ThreadLocal<std::string> thread_local([]() {
+    ThreadLocal<std::string> local([]() {
         return std::string("factory_value");
     });
     
     // Should get the factory value on first access
-    assert(thread_local.get() == "factory_value");
+    assert(local.get() == "factory_value");
     
     // Set a different value
-    thread_local.set("custom_value");
-    assert(thread_local.get() == "custom_value");
+    local.set("custom_value");
+    assert(local.get() == "custom_value");
     
     std::cout << "Value factory test passed" << std::endl;
 }
 
 void test_operators() {
-    ThreadLocal<int> thread_local;
+    ThreadLocal<int> local;
     
     // Test dereference operator
-    *thread_local = 100;
-    assert(*thread_local == 100);
+    *local = 100;
+    assert(*local == 100);
     
     // Test arrow operator (with a struct)
     struct TestStruct {
@@ -89,6 +93,132 @@ void test_operators() {
     std::cout << "Operators test passed" << std::endl;
 }
 
+// Counts live instances so the tests can see when values are destroyed
+struct Tracked {
+    static std::atomic<int> live;
+    int value = 0;
+
+    Tracked() { live.fetch_add(1); }
+    Tracked(const Tracked& other) : value(other.value) { live.fetch_add(1); }
+    Tracked& operator=(const Tracked&) = default;
+    ~Tracked() { live.fetch_sub(1); }
+};
+
+std::atomic<int> Tracked::live{0};
+
+void test_values_across_threads() {
+    ThreadLocal<long> counters(nullptr, true);
+    std::vector<std::thread> threads;
+    for (int t = 1; t <= 8; ++t) {
+        threads.emplace_back([&counters, t]() {
+            for (int i = 0; i < 1000 * t; ++i) {
+                ++counters.get();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // The workers have exited, but their counts are kept
+    std::vector<long> values = counters.values();
+    assert(values.size() == 8);
+    long total = 0;
+    for (long value : values) {
+        total += value;
+    }
+    assert(total == 1000L * (1 + 2 + 3 + 4 + 5 + 6 + 7 + 8));
+
+    // Values that cannot be copied are visited in place
+    ThreadLocal<std::atomic<int>> hits(nullptr, true);
+    hits.get().fetch_add(3);
+    std::thread([&hits]() { hits.get().fetch_add(4); }).join();
+    int visited = 0;
+    hits.for_each_value([&visited](const std::atomic<int>& value) {
+        visited += value.load();
+    });
+    assert(visited == 7);
+
+    // Enumeration is opt-in, as the untracked values go away with their threads
+    ThreadLocal<int> untracked;
+    bool threw = false;
+    try {
+        untracked.values();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    std::cout << "Values across threads test passed" << std::endl;
+}
+
+void test_values_are_destroyed() {
+    {
+        ThreadLocal<Tracked> local;
+        std::thread([&local]() {
+            local.get().value = 1;
+            assert(Tracked::live.load() == 1);
+        }).join();
+        // Untracked values go when their thread exits
+        assert(Tracked::live.load() == 0);
+
+        local.get().value = 2;
+        assert(Tracked::live.load() == 1);
+    }
+    // ...and the rest when the instance goes
+    assert(Tracked::live.load() == 0);
+
+    {
+        ThreadLocal<Tracked> tracked(nullptr, true);
+        std::thread([&tracked]() { tracked.get(); }).join();
+        assert(Tracked::live.load() == 1);
+        assert(tracked.values().size() == 1);
+    }
+    assert(Tracked::live.load() == 0);
+
+    // An instance destroyed while other threads still hold values frees them too
+    std::atomic<int> stage{0};
+    auto local = std::make_unique<ThreadLocal<Tracked>>();
+    std::thread holder([&local, &stage]() {
+        local->get();
+        stage.store(1);
+        while (stage.load() != 2) {
+            std::this_thread::yield();
+        }
+    });
+    while (stage.load() != 1) {
+        std::this_thread::yield();
+    }
+    assert(Tracked::live.load() == 1);
+    local.reset();
+    assert(Tracked::live.load() == 0);
+    stage.store(2);
+    holder.join();
+
+    std::cout << "Values are destroyed test passed" << std::endl;
+}
+
+void test_slots_are_recycled() {
+    // A recycled slot starts out empty on every thread, even one that had a
+    // value in it for the previous instance
+    for (int round = 0; round < 100; ++round) {
+        ThreadLocal<int> local([round]() { return round; });
+        assert(!local.is_value_created());
+        assert(local.get() == round);
+    }
+
+    std::vector<std::unique_ptr<ThreadLocal<int>>> many;
+    for (int i = 0; i < 100; ++i) {
+        many.push_back(std::make_unique<ThreadLocal<int>>());
+        many.back()->set(i);
+    }
+    for (int i = 0; i < 100; ++i) {
+        assert(many[i]->get() == i);
+    }
+
+    std::cout << "Slots are recycled test passed" << std::endl;
+}
+
 int main() {
     std::cout << "Running ThreadLocal tests..." << std::endl;
     
@@ -96,6 +226,9 @@ int main() {
     test_thread_isolation();
     test_value_factory();
     test_operators();
+    test_values_across_threads();
+    test_values_are_destroyed();
+    test_slots_are_recycled();
     
     std::cout << "All ThreadLocal tests passed!" << std::endl;
     return 0;
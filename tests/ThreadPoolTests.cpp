@@ -0,0 +1,336 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include "../include/System/Threading/ThreadPool.h"
+#include "../include/System/Threading/CpuTopology.h"
+
+using namespace System::Threading;
+
+namespace {
+
+// Blocks the calling thread until the counter reaches the expected value.
+void wait_for_count(std::atomic<int>& counter, int expected) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (counter.load() < expected) {
+        assert(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+} // namespace
+
+void test_basic_work_item() {
+    std::atomic<int> counter{0};
+
+    bool queued = ThreadPool::QueueUserWorkItem([&counter](System::Object*) {
+        counter.fetch_add(1);
+    });
+
+    assert(queued);
+    wait_for_count(counter, 1);
+
+    std::cout << "Basic work item test passed" << std::endl;
+}
+
+void test_state_is_passed() {
+    System::Object state;
+    std::atomic<System::Object*> seen{nullptr};
+    std::atomic<int> done{0};
+
+    ThreadPool::QueueUserWorkItem([&seen, &done](System::Object* s) {
+        seen.store(s);
+        done.fetch_add(1);
+    }, &state);
+
+    wait_for_count(done, 1);
+    assert(seen.load() == &state);
+
+    std::cout << "State passing test passed" << std::endl;
+}
+
+void test_many_work_items_from_many_producers() {
+    const int producers = 8;
+    const int items_per_producer = 20000;
+    std::atomic<int> counter{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&counter]() {
+            for (int i = 0; i < items_per_producer; ++i) {
+                ThreadPool::QueueUserWorkItem([&counter](System::Object*) {
+                    counter.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    wait_for_count(counter, producers * items_per_producer);
+
+    std::cout << "Many producers test passed" << std::endl;
+}
+
+void test_nested_work_items_use_local_queue() {
+    const int fan_out = 1000;
+    std::atomic<int> counter{0};
+    std::atomic<int> on_pool_thread{0};
+
+    ThreadPool::QueueUserWorkItem([&](System::Object*) {
+        assert(ThreadPool::GetIsThreadPoolThread());
+        for (int i = 0; i < fan_out; ++i) {
+            ThreadPool::QueueUserWorkItem([&](System::Object*) {
+                if (ThreadPool::GetIsThreadPoolThread()) {
+                    on_pool_thread.fetch_add(1);
+                }
+                counter.fetch_add(1);
+            });
+        }
+    });
+
+    wait_for_count(counter, fan_out);
+    assert(on_pool_thread.load() == fan_out);
+    assert(!ThreadPool::GetIsThreadPoolThread());
+
+    std::cout << "Nested work items test passed" << std::endl;
+}
+
+void test_blocked_worker_items_are_stolen() {
+    // One worker blocks after queuing follow-up work to its own deque; the
+    // follow-up items must still run because idle workers steal them.
+    if (ThreadPool::GetThreadCount() < 2) {
+        std::cout << "Work stealing test skipped (single worker)" << std::endl;
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool release = false;
+    std::atomic<int> counter{0};
+
+    ThreadPool::QueueUserWorkItem([&](System::Object*) {
+        for (int i = 0; i < 100; ++i) {
+            ThreadPool::QueueUserWorkItem([&counter](System::Object*) {
+                counter.fetch_add(1);
+            });
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&release]() { return release; });
+    });
+
+    wait_for_count(counter, 100);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    condition.notify_all();
+
+    std::cout << "Work stealing test passed" << std::endl;
+}
+
+void test_workers_blocked_on_own_items() {
+    // Every worker blocks on an item it queued to its own deque. Nothing is queued
+    // after that, so only the periodic starvation check can add the thread that
+    // steals and runs those items.
+    const int workers = ThreadPool::GetThreadCount();
+    std::atomic<int> started{0};
+    std::atomic<int> inner_ran{0};
+    std::atomic<int> finished{0};
+
+    for (int i = 0; i < workers; ++i) {
+        ThreadPool::QueueUserWorkItem([&, workers](System::Object*) {
+            started.fetch_add(1);
+            wait_for_count(started, workers);
+            ThreadPool::QueueUserWorkItem([&inner_ran](System::Object*) {
+                inner_ran.fetch_add(1);
+            });
+            wait_for_count(inner_ran, workers);
+            finished.fetch_add(1);
+        });
+    }
+
+    wait_for_count(finished, workers);
+
+    std::cout << "Workers blocked on own items test passed" << std::endl;
+}
+
+void test_min_max_threads() {
+    int min_workers = 0, min_io = 0, max_workers = 0, max_io = 0;
+    ThreadPool::GetMinThreads(min_workers, min_io);
+    ThreadPool::GetMaxThreads(max_workers, max_io);
+
+    assert(min_workers >= 1);
+    assert(max_workers >= min_workers);
+
+    // Max below min is rejected
+    assert(!ThreadPool::SetMaxThreads(min_workers - 1, max_io));
+    // Min above max is rejected
+    assert(!ThreadPool::SetMinThreads(max_workers + 1, min_io));
+
+    assert(ThreadPool::SetMinThreads(min_workers + 1, min_io));
+    assert(ThreadPool::GetThreadCount() >= min_workers + 1);
+
+    int check_workers = 0, check_io = 0;
+    ThreadPool::GetMinThreads(check_workers, check_io);
+    assert(check_workers == min_workers + 1);
+
+    assert(ThreadPool::SetMinThreads(min_workers, min_io));
+
+    int available_workers = 0, available_io = 0;
+    ThreadPool::GetAvailableThreads(available_workers, available_io);
+    assert(available_workers <= max_workers);
+    assert(available_workers >= 0);
+
+    std::cout << "Min/max threads test passed" << std::endl;
+}
+
+void test_cpu_list_parsing() {
+    assert(CpuTopology::ParseCpuList("0-3,8,10-11\n") == (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    assert(CpuTopology::ParseCpuList("5") == std::vector<int>{5});
+    assert(CpuTopology::ParseCpuList("").empty());
+
+    for (const char* malformed : {"3-1", "a", "1-", "1,,2", "-4"}) {
+        bool threw = false;
+        try {
+            CpuTopology::ParseCpuList(malformed);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    std::cout << "CPU list parsing test passed" << std::endl;
+}
+
+void write_file(const std::filesystem::path& path, const std::string& contents) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path) << contents << "\n";
+}
+
+void test_topology_from_sysfs() {
+    std::filesystem::path root = std::filesystem::temp_directory_path() / "ThreadPoolTests_sysfs";
+    std::filesystem::remove_all(root);
+    write_file(root / "node" / "node0" / "cpulist", "0-3");
+    write_file(root / "node" / "node1" / "cpulist", "4-7");
+    // Memory only, and outside the allowed CPUs: both dropped
+    write_file(root / "node" / "node2" / "cpulist", "");
+    write_file(root / "node" / "node3" / "cpulist", "8-9");
+    write_file(root / "node" / "online", "0-3");
+    write_file(root / "cpu" / "online", "0-9");
+
+    CpuTopology all = CpuTopology::Read(root.string(), {});
+    assert(all.GetNodeCount() == 3);
+    assert(all.GetProcessorCount() == 10);
+    assert(all.GetNode(2).id == 3);
+    assert(all.GetNodeOfCpu(9) == 2);
+
+    CpuTopology allowed = CpuTopology::Read(root.string(), {6, 0, 1, 4, 5, 7});
+    assert(allowed.GetNodeCount() == 2);
+    assert(allowed.GetNode(0).cpus == (std::vector<int>{0, 1}));
+    assert(allowed.GetNode(1).id == 1);
+    assert(allowed.GetNode(1).cpus == (std::vector<int>{4, 5, 6, 7}));
+    assert(allowed.GetNodeOfCpu(5) == 1);
+    assert(allowed.GetNodeOfCpu(2) == -1);
+    assert(allowed.GetNodeOfCpu(100) == -1);
+
+    // No NUMA information: one node of the online CPUs
+    std::filesystem::remove_all(root / "node");
+    CpuTopology flat = CpuTopology::Read(root.string(), {1, 2, 30});
+    assert(flat.GetNodeCount() == 1);
+    assert(flat.GetNode(0).cpus == (std::vector<int>{1, 2}));
+
+    std::filesystem::remove_all(root);
+
+    const CpuTopology& current = CpuTopology::GetCurrent();
+    assert(current.GetNodeCount() >= 1);
+    assert(current.GetProcessorCount() >= 1);
+
+    std::cout << "Topology from sysfs test passed" << std::endl;
+}
+
+void test_queue_on_node() {
+    int nodes = ThreadPool::GetNodeCount();
+    assert(nodes == CpuTopology::GetCurrent().GetNodeCount());
+    assert(!ThreadPool::QueueUserWorkItemOnNode([](System::Object*) {}, nullptr, nodes));
+    assert(!ThreadPool::QueueUserWorkItemOnNode([](System::Object*) {}, nullptr, -1));
+
+    std::atomic<int> counter{0};
+    std::atomic<int> bad_node{0};
+    for (int node = 0; node < nodes; ++node) {
+        for (int i = 0; i < 100; ++i) {
+            assert(ThreadPool::QueueUserWorkItemOnNode([&counter, &bad_node, nodes](System::Object*) {
+                int current = ThreadPool::GetCurrentNode();
+                if (current < 0 || current >= nodes) {
+                    bad_node.fetch_add(1);
+                }
+                counter.fetch_add(1);
+            }, nullptr, node));
+        }
+    }
+    wait_for_count(counter, nodes * 100);
+    assert(bad_node.load() == 0);
+
+    std::cout << "Queue on node test passed" << std::endl;
+}
+
+void test_worker_affinity() {
+    assert(ThreadPool::GetWorkerAffinity() == ThreadPool::WorkerAffinity::Node);
+
+    // Applied before the next item a worker runs, so the items see it
+    auto affinity_seen = [](ThreadPool::WorkerAffinity affinity) {
+        ThreadPool::SetWorkerAffinity(affinity);
+        std::atomic<int> done{0};
+        std::vector<int> seen;
+        int node = -1;
+        ThreadPool::QueueUserWorkItem([&](System::Object*) {
+            seen = CpuTopology::GetCurrentThreadAffinity();
+            node = ThreadPool::GetCurrentNode();
+            done.fetch_add(1);
+        });
+        wait_for_count(done, 1);
+        return std::make_pair(seen, node);
+    };
+
+    auto [core, core_node] = affinity_seen(ThreadPool::WorkerAffinity::Core);
+    auto [pinned, pinned_node] = affinity_seen(ThreadPool::WorkerAffinity::Node);
+    ThreadPool::SetWorkerAffinity(ThreadPool::WorkerAffinity::Node);
+
+#if defined(__linux__)
+    assert(core.size() == 1);
+    assert(CpuTopology::GetCurrent().GetNodeOfCpu(core[0]) == core_node);
+    assert(pinned == CpuTopology::GetCurrent().GetNode(pinned_node).cpus);
+#endif
+
+    std::cout << "Worker affinity test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running ThreadPool tests..." << std::endl;
+
+    test_basic_work_item();
+    test_state_is_passed();
+    test_many_work_items_from_many_producers();
+    test_nested_work_items_use_local_queue();
+    test_blocked_worker_items_are_stolen();
+    test_workers_blocked_on_own_items();
+    test_min_max_threads();
+    test_cpu_list_parsing();
+    test_topology_from_sysfs();
+    test_queue_on_node();
+    test_worker_affinity();
+
+    std::cout << "All ThreadPool tests passed!" << std::endl;
+    return 0;
+}
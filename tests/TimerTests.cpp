@@ -0,0 +1,121 @@
+#include <iostream>
+#include <thread>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include "../include/System/Threading/Timer.h"
+#include "../include/System/Threading/TimerWheel.hpp"
+
+using namespace System::Threading;
+
+namespace {
+
+// Blocks the calling thread until the counter reaches the expected value.
+void wait_for_count(std::atomic<int>& counter, int expected) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (counter.load() < expected) {
+        assert(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+} // namespace
+
+void test_one_shot_timer() {
+    std::atomic<int> counter{0};
+    auto start_time = std::chrono::steady_clock::now();
+
+    Timer timer([&counter](System::Object*) {
+        counter.fetch_add(1);
+    }, nullptr, 50, Timer::Infinite);
+
+    wait_for_count(counter, 1);
+    assert(std::chrono::steady_clock::now() - start_time >= std::chrono::milliseconds(50));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    assert(counter.load() == 1);
+
+    std::cout << "One-shot timer test passed" << std::endl;
+}
+
+void test_periodic_timer() {
+    std::atomic<int> counter{0};
+
+    Timer timer([&counter](System::Object*) {
+        counter.fetch_add(1);
+    }, nullptr, 0, 10);
+
+    wait_for_count(counter, 5);
+    timer.Dispose();
+
+    int after_dispose = counter.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // At most one callback was already on its way to the ThreadPool
+    assert(counter.load() <= after_dispose + 1);
+
+    std::cout << "Periodic timer test passed" << std::endl;
+}
+
+void test_change_and_dispose() {
+    std::atomic<int> counter{0};
+
+    Timer timer([&counter](System::Object*) {
+        counter.fetch_add(1);
+    }, nullptr, Timer::Infinite, Timer::Infinite);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    assert(counter.load() == 0);
+
+    assert(timer.Change(10, Timer::Infinite));
+    wait_for_count(counter, 1);
+
+    timer.Dispose();
+    assert(!timer.Change(10, Timer::Infinite));
+
+    std::cout << "Change and dispose test passed" << std::endl;
+}
+
+void test_many_timers_share_the_wheel() {
+    constexpr int timer_count = 10000;
+    std::atomic<int> counter{0};
+
+    for (int i = 0; i < timer_count; ++i) {
+        TimerWheel::instance().schedule([&counter]() {
+            counter.fetch_add(1);
+        }, i % 200);
+    }
+
+    wait_for_count(counter, timer_count);
+    assert(TimerWheel::instance().get_pending_count() == 0);
+
+    std::cout << "Many timers test passed" << std::endl;
+}
+
+void test_canceled_entry_does_not_fire() {
+    std::atomic<int> counter{0};
+
+    auto entry = TimerWheel::instance().schedule([&counter]() {
+        counter.fetch_add(1);
+    }, 30);
+
+    assert(TimerWheel::instance().cancel(entry));
+    assert(!TimerWheel::instance().cancel(entry));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    assert(counter.load() == 0);
+
+    std::cout << "Canceled entry test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running Timer tests..." << std::endl;
+
+    test_one_shot_timer();
+    test_periodic_timer();
+    test_change_and_dispose();
+    test_many_timers_share_the_wheel();
+    test_canceled_entry_does_not_fire();
+
+    std::cout << "All Timer tests passed!" << std::endl;
+    return 0;
+}